@@ -0,0 +1,136 @@
+#pragma once
+
+#include <stdint.h>
+
+// ---------- Hardware seam ----------
+// Ο πυρήνας του windlass (WindlassCore) μιλάει με το υλικό μόνο μέσα από
+// αυτές τις συναρτήσεις. Στο ESP32 είναι inline wrappers του Arduino API.
+// Χωρίς ARDUINO (Linux/native) τις υλοποιεί ένα προσομοιωμένο board με
+// εικονικό ρολόι, ώστε το tick() να τρέχει πολύ πιο γρήγορα από real time.
+
+#ifdef ARDUINO
+
+#include <Arduino.h>
+
+namespace hal {
+
+inline uint32_t millis() { return ::millis(); }
+inline uint32_t micros() { return ::micros(); }
+inline int  digitalRead(int pin) { return ::digitalRead(pin); }
+inline void digitalWrite(int pin, int level) { ::digitalWrite(pin, level); }
+inline void pinMode(int pin, int mode) { ::pinMode(pin, mode); }
+
+inline void attachChangeInterrupt(int pin, void (*isr)(void*), void* arg) {
+  attachInterruptArg(digitalPinToInterrupt(pin), isr, arg, CHANGE);
+}
+inline void detachChangeInterrupt(int pin) { detachInterrupt(digitalPinToInterrupt(pin)); }
+
+// CPU cycle counter (CCOUNT) for cheap stage timing.
+inline uint32_t cycles() { return ESP.getCycleCount(); }
+inline uint32_t cycles_per_us() { return ESP.getCpuFreqMHz(); }
+
+}  // namespace hal
+
+#else  // native / simulated board
+
+#include <stddef.h>
+
+#ifndef HIGH
+#define HIGH 1
+#define LOW 0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define INPUT_PULLUP 0x05
+#endif
+#ifndef IRAM_ATTR
+#define IRAM_ATTR
+#endif
+#ifndef TAG
+#define TAG "ARDUINO"
+#endif
+#ifndef ESP_LOGI
+#define ESP_LOGE(tag, ...) ((void)0)
+#define ESP_LOGW(tag, ...) ((void)0)
+#define ESP_LOGI(tag, ...) ((void)0)
+#define ESP_LOGD(tag, ...) ((void)0)
+#define ESP_LOGV(tag, ...) ((void)0)
+#endif
+
+namespace hal {
+
+// Simulated GPIO bank and virtual clock. Time only moves when advance_us()
+// is called; input changes fire the attached CHANGE interrupt synchronously,
+// exactly like the ISR would preempt the loop on target.
+struct SimBoard {
+  static constexpr int kPins = 40;
+
+  uint64_t now_us = 0;
+  uint8_t  level[kPins] = {0};
+  uint8_t  mode[kPins] = {0};
+  void   (*isr[kPins])(void*) = {nullptr};
+  void*    isr_arg[kPins] = {nullptr};
+  uint32_t writes = 0;
+
+  // Optional observer for every output write (relay timing checks).
+  void   (*on_write)(void* ctx, int pin, int level, uint64_t t_us) = nullptr;
+  void*    on_write_ctx = nullptr;
+
+  void advance_us(uint64_t us) { now_us += us; }
+  void advance_ms(uint64_t ms) { now_us += ms * 1000ULL; }
+
+  // Drive an input pin from the outside world (reed switch, buttons).
+  void set_input(int pin, int v) {
+    if (pin < 0 || pin >= kPins) return;
+    const uint8_t nv = v ? HIGH : LOW;
+    if (level[pin] == nv) return;
+    level[pin] = nv;
+    if (isr[pin]) isr[pin](isr_arg[pin]);
+  }
+
+  void reset() { *this = SimBoard(); }
+};
+
+inline SimBoard& sim() {
+  static SimBoard board;
+  return board;
+}
+
+inline uint32_t millis() { return (uint32_t)(sim().now_us / 1000ULL); }
+inline uint32_t micros() { return (uint32_t)sim().now_us; }
+inline uint32_t cycles() { return (uint32_t)(sim().now_us * 240ULL); }
+inline uint32_t cycles_per_us() { return 240; }
+
+inline int digitalRead(int pin) {
+  return (pin >= 0 && pin < SimBoard::kPins) ? sim().level[pin] : LOW;
+}
+
+inline void digitalWrite(int pin, int v) {
+  SimBoard& b = sim();
+  if (pin < 0 || pin >= SimBoard::kPins) return;
+  b.level[pin] = v ? HIGH : LOW;
+  b.writes++;
+  if (b.on_write) b.on_write(b.on_write_ctx, pin, b.level[pin], b.now_us);
+}
+
+inline void pinMode(int pin, int m) {
+  SimBoard& b = sim();
+  if (pin < 0 || pin >= SimBoard::kPins) return;
+  b.mode[pin] = (uint8_t)m;
+  if (m == INPUT_PULLUP) b.level[pin] = HIGH;
+}
+
+inline void attachChangeInterrupt(int pin, void (*fn)(void*), void* arg) {
+  if (pin < 0 || pin >= SimBoard::kPins) return;
+  sim().isr[pin] = fn;
+  sim().isr_arg[pin] = arg;
+}
+
+inline void detachChangeInterrupt(int pin) {
+  if (pin < 0 || pin >= SimBoard::kPins) return;
+  sim().isr[pin] = nullptr;
+  sim().isr_arg[pin] = nullptr;
+}
+
+}  // namespace hal
+
+#endif
@@ -0,0 +1,342 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+// ---------- Anchor watch ----------
+// Drag alarm στη συσκευή, από τα fixes του navigation.position και τη
+// μέτρηση της αλυσίδας:
+//
+//   άγκυρα        η θέση του σκάφους όταν η αλυσίδα περνάει τα kAnchorUpM
+//                 κατεβαίνοντας (ή από το NVS μετά από reboot, ή από το
+//                 κέντρο του κύκλου αν δεν υπάρχει τίποτα από τα δύο)
+//   ακτίνα        οριζόντια απόσταση της αλυσίδας + margin (GPS offset,
+//                 μήκος σκάφους): √(chain² − κάθετη²) με γνωστό βάθος,
+//                 αλλιώς ολόκληρη η chain_out
+//   drag          fix πιο μακριά από την ακτίνα, στο ίδιο fix
+//
+// Swing circle: ένα fix ανά kRingIntervalMs σε ένα ring kFixes θέσεων
+// (~10 λεπτά, όσο κάνει το σκάφος να γυρίσει με τον άνεμο), σε μέτρα γύρω
+// από ένα origin (ισοορθογώνια προβολή). Κρατάμε τα αθροίσματα των x, y και των
+// γινομένων τους ως 3ης τάξης, οπότε κάθε fix προσθέτει το νέο και αφαιρεί
+// αυτό που βγαίνει από το ring, και το circle fit (Kåsa, ελάχιστα
+// τετράγωνα στο x² + y²) λύνεται από τα αθροίσματα με ένα 2x2 σύστημα.
+// O(1) ανά fix, χωρίς δεσμεύσεις. Το fit μετράει μόνο όταν το σκάφος έχει
+// διαγράψει τόξο (διασπορά κάθετα στην κύρια διεύθυνση).
+//
+// Τα αθροίσματα είναι σε double: 64 fixes × (1km)³ χωρίς αισθητό σφάλμα από
+// τις αφαιρέσεις. Χτίζεται και στο host (tools/anchor_watch_replay.cpp).
+
+class AnchorWatch {
+ public:
+  static constexpr int      kFixes = 64;
+  static constexpr uint32_t kRingIntervalMs = 10000;
+  static constexpr int      kMinFitFixes = 16;
+  static constexpr float    kMinArcSpreadM = 1.5f;    // std κάθετα στο τόξο
+  static constexpr float    kMaxFitRadiusM = 500.0f;
+  static constexpr float    kAnchorUpM = 1.0f;        // λιγότερη αλυσίδα = άγκυρα πάνω
+  static constexpr float    kClearHysteresisM = 2.0f;
+  static constexpr float    kMaxSpeedMps = 15.0f;     // ταχύτερο = GPS glitch
+  static constexpr int      kMaxRejects = 3;          // μετά από τόσα το fix γίνεται δεκτό
+  static constexpr uint32_t kFixTimeoutMs = 30000;
+  static constexpr float    kReoriginM = 5000.0f;
+
+  enum State : uint8_t { kOff, kWaiting, kPaused, kWatching, kNoFix, kDrag };
+  enum Source : uint8_t { kNone, kDropped, kRestored, kFitted };
+  enum Events : uint8_t { kEvAnchor = 1, kEvState = 2 };
+
+  static const char* stateName(State s) {
+    switch (s) {
+      case kOff:      return "off";
+      case kWaiting:  return "waiting";
+      case kPaused:   return "paused";
+      case kWatching: return "watching";
+      case kNoFix:    return "no_fix";
+      case kDrag:     return "drag";
+    }
+    return "";
+  }
+
+  static const char* sourceName(Source s) {
+    switch (s) {
+      case kNone:     return "none";
+      case kDropped:  return "dropped";
+      case kRestored: return "restored";
+      case kFitted:   return "fitted";
+    }
+    return "";
+  }
+
+  void configure(bool enabled, float margin_m) {
+    enabled_ = enabled;
+    margin_m_ = margin_m < 0.0f ? 0.0f : margin_m;
+  }
+
+  // Βάθος + ύψος πλώρης (scope_calc.h), NAN = άγνωστο
+  void set_vertical_m(float vertical_m) { vertical_m_ = vertical_m; }
+
+  // Θέση από το NVS (reboot με την άγκυρα κάτω)
+  void restore_anchor(double lat, double lon) { setAnchor_(lat, lon, kRestored); }
+
+  // Ανά pass του loop: αλυσίδα του windlass, αν κινείται, timeout του GPS
+  void update(float chain_out_m, bool running, uint32_t now_ms) {
+    chain_m_ = chain_out_m;
+    running_ = running;
+    now_ms_ = now_ms;
+    if (chain_out_m <= kAnchorUpM) {
+      up_seen_ = true;
+      drop_pending_ = false;
+      if (source_ != kNone) {
+        source_ = kNone;
+        distance_m_ = NAN;
+        events_ |= kEvAnchor;
+      }
+    } else if (source_ == kNone && up_seen_) {
+      up_seen_ = false;
+      if (fresh_()) setAnchor_(last_lat_, last_lon_, kDropped);
+      else drop_pending_ = true;  // με το πρώτο fix
+    }
+    if (running || source_ == kNone) dragging_ = false;
+    setState_(state_of_());
+  }
+
+  // Ένα fix (loop task, από τον listener του navigation.position)
+  void on_fix(double lat, double lon, uint32_t now_ms) {
+    if (!has_origin_) {
+      lat0_ = lat;
+      lon0_ = lon;
+      m_per_deg_lon_ = kMPerDegLat * cos(lat * M_PI / 180.0);
+      has_origin_ = true;
+    }
+    float x = (float)((lon - lon0_) * m_per_deg_lon_);
+    float y = (float)((lat - lat0_) * kMPerDegLat);
+
+    // Ένα fix που απέχει περισσότερο από όσο επιτρέπει η ταχύτητα από το
+    // προηγούμενο είναι glitch. Αν επιμένει, το σκάφος όντως είναι εκεί.
+    if (has_fix_) {
+      const float dx = x - last_x_, dy = y - last_y_;
+      const float dt = (float)(now_ms - last_fix_ms_) / 1000.0f;
+      if (dx * dx + dy * dy > sq_(kMaxSpeedMps * (dt > 1.0f ? dt : 1.0f)) &&
+          ++rejects_ <= kMaxRejects) {
+        rejected_++;
+        return;
+      }
+    }
+    rejects_ = 0;
+    if (fabsf(x) > kReoriginM || fabsf(y) > kReoriginM) {
+      reorigin_(lat, lon);
+      x = y = 0.0f;
+    }
+    fixes_++;
+    has_fix_ = true;
+    last_lat_ = lat;
+    last_lon_ = lon;
+    last_x_ = x;
+    last_y_ = y;
+    last_fix_ms_ = now_ms;
+    now_ms_ = now_ms;
+
+    if (n_ == 0 || now_ms - ring_ms_ >= kRingIntervalMs) {
+      ring_ms_ = now_ms;
+      push_(x, y);
+      fit_();
+    }
+
+    if (drop_pending_) {
+      drop_pending_ = false;
+      setAnchor_(lat, lon, kDropped);
+    } else if (source_ == kNone && chain_m_ > kAnchorUpM && fit_valid_ && n_ == kFixes &&
+               fit_r_ <= alarm_radius_m()) {
+      // Άγνωστη άγκυρα: το κέντρο, μόνο με γεμάτο ring (ένα μικρό τόξο
+      // δίνει κέντρο προς τα μέσα)
+      setAnchor_(lat0_ + (double)fit_y_ / kMPerDegLat, lon0_ + (double)fit_x_ / m_per_deg_lon_,
+                 kFitted);
+    }
+
+    distance_m_ = source_ != kNone ? sqrtf(sq_(x - ax_) + sq_(y - ay_)) : NAN;
+    if (source_ != kNone && !running_) {
+      const float r = alarm_radius_m();
+      if (distance_m_ > r) dragging_ = true;
+      else if (distance_m_ < r - kClearHysteresisM) dragging_ = false;
+    }
+    setState_(state_of_());
+  }
+
+  // Τι άλλαξε από την τελευταία κλήση (kEvAnchor | kEvState)
+  uint8_t take_events() {
+    const uint8_t e = events_;
+    events_ = 0;
+    return e;
+  }
+
+  State  state() const { return state_; }
+  Source source() const { return source_; }
+  bool   has_anchor() const { return source_ != kNone; }
+  double anchor_lat() const { return anchor_lat_; }
+  double anchor_lon() const { return anchor_lon_; }
+  // Η ευθεία αλυσίδα είναι το άνω όριο της απόστασης (η καμπύλη είναι
+  // μικρότερη), άρα χωρίς ψευδείς συναγερμούς
+  float  alarm_radius_m() const {
+    if (isnan(vertical_m_) || vertical_m_ <= 0.0f) return chain_m_ + margin_m_;
+    const float h2 = sq_(chain_m_) - sq_(vertical_m_);
+    return (h2 > 0.0f ? sqrtf(h2) : 0.0f) + margin_m_;
+  }
+  float  distance_m() const { return distance_m_; }          // NAN χωρίς άγκυρα
+  bool   fit_valid() const { return fit_valid_; }
+  float  swing_radius_m() const { return fit_valid_ ? fit_r_ : NAN; }
+  // Απόσταση του κέντρου του κύκλου από την άγκυρα (μεγαλώνει όταν σέρνει)
+  float swing_offset_m() const {
+    return fit_valid_ && source_ != kNone ? sqrtf(sq_(fit_x_ - ax_) + sq_(fit_y_ - ay_)) : NAN;
+  }
+  uint32_t fixes() const { return fixes_; }
+  uint32_t rejected() const { return rejected_; }
+
+ private:
+  static constexpr double kMPerDegLat = 111194.93;  // R·π/180, R = 6371km
+
+  static float sq_(float v) { return v * v; }
+
+  bool fresh_() const { return has_fix_ && now_ms_ - last_fix_ms_ <= kFixTimeoutMs; }
+
+  State state_of_() const {
+    if (!enabled_ || chain_m_ <= kAnchorUpM) return kOff;
+    if (source_ == kNone) return kWaiting;
+    if (!fresh_()) return kNoFix;
+    if (running_) return kPaused;
+    return dragging_ ? kDrag : kWatching;
+  }
+
+  void setState_(State s) {
+    if (s == state_) return;
+    state_ = s;
+    events_ |= kEvState;
+  }
+
+  void setAnchor_(double lat, double lon, Source src) {
+    anchor_lat_ = lat;
+    anchor_lon_ = lon;
+    source_ = src;
+    dragging_ = false;
+    if (!has_origin_) {
+      lat0_ = lat;
+      lon0_ = lon;
+      m_per_deg_lon_ = kMPerDegLat * cos(lat * M_PI / 180.0);
+      has_origin_ = true;
+    }
+    ax_ = (float)((lon - lon0_) * m_per_deg_lon_);
+    ay_ = (float)((lat - lat0_) * kMPerDegLat);
+    events_ |= kEvAnchor;
+  }
+
+  // Πολύ μακριά από το origin: νέο origin, άδειο ring
+  void reorigin_(double lat, double lon) {
+    lat0_ = lat;
+    lon0_ = lon;
+    m_per_deg_lon_ = kMPerDegLat * cos(lat * M_PI / 180.0);
+    n_ = 0;
+    head_ = 0;
+    sx_ = sy_ = sxx_ = syy_ = sxy_ = sxxx_ = sxxy_ = sxyy_ = syyy_ = 0.0;
+    has_fix_ = false;
+    fit_valid_ = false;
+    if (source_ != kNone) {
+      ax_ = (float)((anchor_lon_ - lon0_) * m_per_deg_lon_);
+      ay_ = (float)((anchor_lat_ - lat0_) * kMPerDegLat);
+    }
+  }
+
+  void accumulate_(float fx, float fy, double sign) {
+    const double x = fx, y = fy;
+    const double xx = x * x, yy = y * y, xy = x * y;
+    sx_ += sign * x;
+    sy_ += sign * y;
+    sxx_ += sign * xx;
+    syy_ += sign * yy;
+    sxy_ += sign * xy;
+    sxxx_ += sign * xx * x;
+    sxxy_ += sign * xx * y;
+    sxyy_ += sign * x * yy;
+    syyy_ += sign * yy * y;
+  }
+
+  void push_(float x, float y) {
+    if (n_ == kFixes) accumulate_(ring_x_[head_], ring_y_[head_], -1.0);
+    else n_++;
+    ring_x_[head_] = x;
+    ring_y_[head_] = y;
+    head_ = (head_ + 1) % kFixes;
+    accumulate_(x, y, 1.0);
+  }
+
+  // Kåsa fit με κεντραρισμένες ροπές (u = x - mx, v = y - my):
+  //   [Suu Suv] [uc]   1 [Suuu + Suvv]
+  //   [Suv Svv] [vc] = - [Svvv + Suuv]
+  //                    2
+  // κέντρο (mx + uc, my + vc), r² = uc² + vc² + (Suu + Svv) / n
+  void fit_() {
+    fit_valid_ = false;
+    if (n_ < kMinFitFixes) return;
+    const double n = n_, a = sx_ / n, b = sy_ / n;
+    const double suu = sxx_ - n * a * a;
+    const double svv = syy_ - n * b * b;
+    const double suv = sxy_ - n * a * b;
+    // Μικρότερη ιδιοτιμή της συνδιακύμανσης: πόσο "τόξο" έχουν τα fixes
+    const double half = (suu - svv) / 2.0;
+    const double minor = ((suu + svv) / 2.0 - sqrt(half * half + suv * suv)) / n;
+    if (minor < (double)kMinArcSpreadM * kMinArcSpreadM) return;
+    const double suuu = sxxx_ - 3.0 * a * sxx_ + 2.0 * n * a * a * a;
+    const double svvv = syyy_ - 3.0 * b * syy_ + 2.0 * n * b * b * b;
+    const double suvv = sxyy_ - 2.0 * b * sxy_ - a * syy_ + 2.0 * n * a * b * b;
+    const double suuv = sxxy_ - 2.0 * a * sxy_ - b * sxx_ + 2.0 * n * a * a * b;
+    const double det = suu * svv - suv * suv;
+    const double r1 = (suuu + suvv) / 2.0, r2 = (svvv + suuv) / 2.0;
+    const double uc = (r1 * svv - r2 * suv) / det;
+    const double vc = (r2 * suu - r1 * suv) / det;
+    const double r = sqrt(uc * uc + vc * vc + (suu + svv) / n);
+    if (!(r <= kMaxFitRadiusM)) return;
+    fit_x_ = (float)(a + uc);
+    fit_y_ = (float)(b + vc);
+    fit_r_ = (float)r;
+    fit_valid_ = true;
+  }
+
+  bool     enabled_ = true;
+  float    margin_m_ = 10.0f;
+  float    chain_m_ = 0.0f;
+  float    vertical_m_ = NAN;
+  bool     running_ = false;
+  uint32_t now_ms_ = 0;
+  bool     up_seen_ = false;
+  bool     drop_pending_ = false;
+  bool     dragging_ = false;
+  State    state_ = kOff;
+  uint8_t  events_ = 0;
+
+  // Origin της προβολής και η άγκυρα
+  bool   has_origin_ = false;
+  double lat0_ = 0.0, lon0_ = 0.0;
+  double m_per_deg_lon_ = kMPerDegLat;
+  Source source_ = kNone;
+  double anchor_lat_ = 0.0, anchor_lon_ = 0.0;
+  float  ax_ = 0.0f, ay_ = 0.0f;
+
+  // Τελευταίο fix
+  bool     has_fix_ = false;
+  double   last_lat_ = 0.0, last_lon_ = 0.0;
+  float    last_x_ = 0.0f, last_y_ = 0.0f;
+  uint32_t last_fix_ms_ = 0;
+  float    distance_m_ = NAN;
+  int      rejects_ = 0;
+  uint32_t fixes_ = 0;
+  uint32_t rejected_ = 0;
+
+  // Ring και αθροίσματα του fit
+  float  ring_x_[kFixes] = {};
+  float  ring_y_[kFixes] = {};
+  int    head_ = 0;
+  int    n_ = 0;
+  uint32_t ring_ms_ = 0;
+  double sx_ = 0.0, sy_ = 0.0, sxx_ = 0.0, syy_ = 0.0, sxy_ = 0.0;
+  double sxxx_ = 0.0, sxxy_ = 0.0, sxyy_ = 0.0, syyy_ = 0.0;
+  bool   fit_valid_ = false;
+  float  fit_x_ = 0.0f, fit_y_ = 0.0f, fit_r_ = 0.0f;
+};
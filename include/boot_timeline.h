@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+// ---------- Boot timeline ----------
+// Πότε (ms από το boot) έφτασε το firmware σε κάθε ορόσημο της εκκίνησης.
+// Μετράει μόνο η πρώτη φορά: ένα reconnect αργότερα δεν αλλάζει το
+// wsConnected. Τα ορόσημα σημαδεύονται από διάφορα tasks (setup, WiFi
+// events, loop), γι' αυτό atomics. 0 = δεν έχει γίνει ακόμα.
+#define BOOT_MILESTONES(X)                      \
+  X(kBootRelaysSafe,   "relaysSafe")            \
+  X(kBootConfigLoaded, "configLoaded")          \
+  X(kBootWifiUp,       "wifiUp")                \
+  X(kBootWsConnected,  "wsConnected")           \
+  X(kBootReady,        "readyForCommands")
+
+enum BootMilestone : uint8_t {
+#define X(id, name) id,
+  BOOT_MILESTONES(X)
+#undef X
+  kBootMilestoneCount
+};
+
+class BootTimeline {
+ public:
+  static const char* name(int m) {
+    static const char* const kNames[kBootMilestoneCount] = {
+#define X(id, name) name,
+      BOOT_MILESTONES(X)
+#undef X
+    };
+    return m >= 0 && m < kBootMilestoneCount ? kNames[m] : "";
+  }
+
+  // true μόνο την πρώτη φορά για κάθε ορόσημο
+  bool mark(BootMilestone m, uint32_t ms) {
+    uint32_t none = 0;
+    return at_[m].compare_exchange_strong(none, ms ? ms : 1, std::memory_order_relaxed);
+  }
+
+  bool reached(int m) const { return at_[m].load(std::memory_order_relaxed) != 0; }
+  uint32_t at(int m) const { return at_[m].load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint32_t> at_[kBootMilestoneCount] = {};
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+// ---------- Chain speed & coast-down ----------
+// ChainSpeedEstimator: EWMA της περιόδου των μετρημένων παλμών (α = 1/4).
+// Ένα update ανά παλμό, μερικές πράξεις ακεραίων - O(1) χρόνος και μνήμη.
+// Όταν οι παλμοί σταματούν, η ταχύτητα πέφτει με το 1/ηλικία του τελευταίου
+// παλμού, οπότε ένα σταματημένο windlass δεν φαίνεται να κινείται.
+class ChainSpeedEstimator {
+ public:
+  static constexpr uint32_t kMaxGapUs = 3000000;  // μεγαλύτερο κενό = νέα εκκίνηση
+
+  void reset() {
+    has_last_ = false;
+    period_us_ = 0;
+  }
+
+  void on_pulse(uint32_t t_us) {
+    updates_++;
+    if (has_last_) {
+      const uint32_t dt = t_us - last_us_;
+      if (dt > kMaxGapUs) {
+        period_us_ = 0;
+      } else if (period_us_ == 0) {
+        period_us_ = dt;
+      } else {
+        period_us_ = (uint32_t)((int32_t)period_us_ + ((int32_t)(dt - period_us_) >> 2));
+      }
+    }
+    last_us_ = t_us;
+    has_last_ = true;
+  }
+
+  // Μέτρα/δευτερόλεπτο, 0 αν δεν υπάρχει πρόσφατη εκτίμηση.
+  float speed(uint32_t now_us, float meters_per_pulse) const {
+    if (!has_last_ || period_us_ == 0) return 0.0f;
+    const uint32_t age = now_us - last_us_;
+    if (age > kMaxGapUs) return 0.0f;
+    const uint32_t p = age > period_us_ ? age : period_us_;
+    return meters_per_pulse * 1e6f / (float)p;
+  }
+
+  uint32_t period_us() const { return period_us_; }
+  uint32_t last_us() const { return last_us_; }
+  bool     has_pulse() const { return has_last_; }
+  uint32_t updates() const { return updates_; }
+
+ private:
+  uint32_t last_us_ = 0;
+  uint32_t period_us_ = 0;
+  uint32_t updates_ = 0;
+  bool     has_last_ = false;
+};
+
+// CoastLearner: πόσα μέτρα κυλάει ακόμα η αλυσίδα αφού κοπεί το ρελέ, ανά
+// κατεύθυνση (0 = κάτω, 1 = πάνω). Μετράει τους παλμούς μέσα σε ένα
+// παράθυρο μετά το stop (που ανανεώνεται με κάθε παλμό) και κρατάει EWMA
+// (α = 1/4) των δειγμάτων.
+class CoastLearner {
+ public:
+  static constexpr uint32_t kQuietMs = 1000;  // χωρίς παλμό τόσο = σταμάτησε
+  static constexpr uint32_t kMaxMs = 5000;
+
+  void begin(int dir, int32_t pulses, uint32_t now_ms, bool moving) {
+    active_ = true;
+    dir_ = dir;
+    start_pulses_ = pulses;
+    start_ms_ = now_ms;
+    until_ms_ = now_ms + kQuietMs;
+    moving_ = moving;
+  }
+
+  // Κάθε παλμός μέσα στο παράθυρο το παρατείνει.
+  void on_pulse(uint32_t now_ms) {
+    if (!active_) return;
+    const uint32_t until = now_ms + kQuietMs;
+    until_ms_ = (until - start_ms_ > kMaxMs) ? start_ms_ + kMaxMs : until;
+  }
+
+  bool active() const { return active_; }
+  int  dir() const { return dir_; }
+  bool expired(uint32_t now_ms) const { return active_ && (int32_t)(now_ms - until_ms_) >= 0; }
+  uint32_t ms_left(uint32_t now_ms) const {
+    return (int32_t)(until_ms_ - now_ms) > 0 ? until_ms_ - now_ms : 0;
+  }
+
+  // Κλείνει το παράθυρο. Αν learn, ενημερώνει την εκτίμηση και επιστρέφει
+  // το δείγμα σε μέτρα (αλλιώς -1).
+  float finish(int32_t pulses, float meters_per_pulse, bool learn) {
+    if (!active_) return -1.0f;
+    active_ = false;
+    if (!learn || !moving_) return -1.0f;
+    int32_t d = pulses - start_pulses_;
+    if (d < 0) d = -d;
+    const float sample = (float)d * meters_per_pulse;
+    float& est = coast_m_[dir_ ? 1 : 0];
+    est = samples_[dir_ ? 1 : 0]++ ? est + (sample - est) * 0.25f : sample;
+    return sample;
+  }
+
+  float coast_m(int dir) const { return coast_m_[dir ? 1 : 0]; }
+  // Seeds a persisted estimate; it counts as one sample.
+  void set_coast_m(int dir, float m) {
+    const bool ok = m > 0.0f && !isnan(m);
+    coast_m_[dir ? 1 : 0] = ok ? m : 0.0f;
+    samples_[dir ? 1 : 0] = ok ? 1 : 0;
+  }
+  uint32_t samples(int dir) const { return samples_[dir ? 1 : 0]; }
+
+ private:
+  bool     active_ = false;
+  bool     moving_ = false;
+  int      dir_ = 0;
+  int32_t  start_pulses_ = 0;
+  uint32_t start_ms_ = 0;
+  uint32_t until_ms_ = 0;
+  float    coast_m_[2] = {0.0f, 0.0f};
+  uint32_t samples_[2] = {0, 0};
+};
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <stdint.h>
+
+// One captured transition of the chain sensor input (from the GPIO ISR).
+struct ChainEdge {
+  uint32_t t_us;   // micros() at the interrupt
+  uint8_t  level;  // pin level read inside the ISR
+};
+
+// ---------- Pulse filter stage ----------
+// Παίρνει τα edges του ISR με τη σειρά που πιάστηκαν και βγάζει έναν
+// "καθαρό" παλμό ανά κρίκο. Η σταθερή στάθμη κρατιέται εδώ, το πότε
+// θεωρείται σταθερή και ποιοι παλμοί απορρίπτονται το αποφασίζει η
+// υλοποίηση. Δεν εξαρτάται από Arduino, οπότε τρέχει και στο host.
+class PulseFilter {
+ public:
+  virtual ~PulseFilter() {}
+
+  virtual const char* name() const = 0;
+
+  virtual void reset(bool level, uint32_t now_us) {
+    pending_level_ = level;
+    stable_level_ = level;
+    pending_since_us_ = now_us;
+    has_last_pulse_ = false;
+  }
+
+  // Commit a pending level once it has been stable long enough. Call after
+  // draining the edge queue with the current time. Returns true and sets
+  // pulse_us when a pulse is accepted.
+  virtual bool poll(uint32_t now_us, uint32_t& pulse_us) = 0;
+
+  // Feed one edge in capture order. At most one pulse can complete per edge.
+  bool feed(const ChainEdge& e, uint32_t& pulse_us) {
+    const bool got = poll(e.t_us, pulse_us);
+    // Same level twice means the ISR missed a short glitch: still not stable.
+    pending_level_ = e.level != 0;
+    pending_since_us_ = e.t_us;
+    return got;
+  }
+
+  bool     stable_level() const { return stable_level_; }
+  // A level change is waiting for its stability window (poll() is due).
+  bool     settling() const { return pending_level_ != stable_level_; }
+  uint32_t accepted() const { return accepted_; }
+  uint32_t rejected() const { return rejected_; }
+  uint32_t last_rejected_gap_us() const { return last_rejected_gap_us_; }
+
+ protected:
+  // True when the pending level has been stable for window_us and the
+  // resulting stable transition is LOW→HIGH; rise_us is the commit time.
+  bool settle_(uint32_t now_us, uint32_t window_us, uint32_t& rise_us) {
+    if (pending_level_ == stable_level_) return false;
+    // Signed difference: an edge captured after now_us was sampled must not
+    // look like it has been stable for ~71 minutes.
+    if ((int32_t)(now_us - pending_since_us_) < (int32_t)window_us) return false;
+
+    const bool old_stable = stable_level_;
+    stable_level_ = pending_level_;
+    if (old_stable || !stable_level_) return false;  // only LOW→HIGH counts
+    rise_us = pending_since_us_ + window_us;
+    return true;
+  }
+
+  void accept_(uint32_t t_us) {
+    has_last_pulse_ = true;
+    last_pulse_us_ = t_us;
+    accepted_++;
+  }
+
+  void reject_(uint32_t gap_us) {
+    rejected_++;
+    last_rejected_gap_us_ = gap_us;
+  }
+
+  bool     pending_level_ = true;
+  bool     stable_level_ = true;
+  uint32_t pending_since_us_ = 0;
+  bool     has_last_pulse_ = false;
+  uint32_t last_pulse_us_ = 0;
+  uint32_t accepted_ = 0;
+  uint32_t rejected_ = 0;
+  uint32_t last_rejected_gap_us_ = 0;
+};
+
+// ---------- Fixed debounce (αρχική συμπεριφορά) ----------
+//  - η στάθμη πρέπει να μείνει σταθερή για debounce_us,
+//  - παλμοί πιο κοντά από 2×debounce στον προηγούμενο απορρίπτονται.
+// Με 150ms σταματάει γύρω στους ~3 παλμούς/s.
+class FixedPulseFilter : public PulseFilter {
+ public:
+  const char* name() const override { return "fixed"; }
+
+  void set_debounce_us(uint32_t us) { debounce_us_ = us; }
+  uint32_t debounce_us() const { return debounce_us_; }
+
+  bool poll(uint32_t now_us, uint32_t& pulse_us) override {
+    uint32_t t;
+    if (!settle_(now_us, debounce_us_, t)) return false;
+    if (has_last_pulse_ && (t - last_pulse_us_) < debounce_us_ * 2) {
+      reject_(t - last_pulse_us_);
+      return false;
+    }
+    accept_(t);
+    pulse_us = t;
+    return true;
+  }
+
+ private:
+  uint32_t debounce_us_ = 150000;
+};
+
+// ---------- Adaptive period-tracking filter ----------
+// Παρακολουθεί την περίοδο των παλμών (EWMA) και προσαρμόζει το παράθυρο
+// σταθερότητας στο 1/10 της περιόδου, μέσα σε [min_window, max_window].
+// Το contact bounce (< 1ms) κόβεται από το ελάχιστο παράθυρο, ενώ σε
+// freefall το παράθυρο μικραίνει όσο επιταχύνει η αλυσίδα. Διπλοί παλμοί
+// απορρίπτονται αν έρθουν πριν το 40% της αναμενόμενης περιόδου.
+// Μετά από idle_reset χωρίς παλμό το tracker ξεκινάει από την αρχή.
+class AdaptivePulseFilter : public PulseFilter {
+ public:
+  const char* name() const override { return "adaptive"; }
+
+  void set_limits(uint32_t min_window_us, uint32_t start_window_us,
+                  uint32_t max_window_us) {
+    min_window_us_ = min_window_us;
+    start_window_us_ = start_window_us;
+    max_window_us_ = max_window_us;
+  }
+
+  void reset(bool level, uint32_t now_us) override {
+    PulseFilter::reset(level, now_us);
+    period_us_ = 0;
+    last_interval_us_ = 0;
+  }
+
+  bool poll(uint32_t now_us, uint32_t& pulse_us) override {
+    if (period_us_ != 0 && has_last_pulse_ &&
+        (int32_t)(now_us - last_pulse_us_) > (int32_t)idle_reset_us_) {
+      period_us_ = 0;  // η αλυσίδα σταμάτησε - νέο run
+      last_interval_us_ = 0;
+    }
+
+    uint32_t t;
+    if (!settle_(now_us, window_us(), t)) return false;
+
+    if (has_last_pulse_) {
+      const uint32_t gap = t - last_pulse_us_;
+      const uint32_t ref = reference_period_();
+      if (ref != 0 ? gap < ref * 2 / 5 : gap < start_window_us_ * 2) {
+        reject_(gap);
+        return false;
+      }
+      if (gap <= idle_reset_us_) {
+        last_interval_us_ = gap;
+        // EWMA α=1/2: φτάνει τη νέα περίοδο σε 2-3 παλμούς
+        period_us_ = period_us_ == 0 ? gap : (period_us_ + gap) / 2;
+      }
+    }
+    accept_(t);
+    pulse_us = t;
+    return true;
+  }
+
+  // Current stability window.
+  uint32_t window_us() const {
+    const uint32_t ref = reference_period_();
+    if (ref == 0) return start_window_us_;
+    uint32_t w = ref / 10;
+    if (w < min_window_us_) w = min_window_us_;
+    if (w > max_window_us_) w = max_window_us_;
+    return w;
+  }
+
+  // Tracked pulse period, 0 while not locked.
+  uint32_t period_us() const { return period_us_; }
+
+ private:
+  // Η μικρότερη από εκτίμηση και τελευταίο διάστημα - ακολουθεί την επιτάχυνση.
+  uint32_t reference_period_() const {
+    if (period_us_ == 0) return 0;
+    return last_interval_us_ < period_us_ ? last_interval_us_ : period_us_;
+  }
+
+  uint32_t min_window_us_ = 2000;
+  uint32_t start_window_us_ = 30000;
+  uint32_t max_window_us_ = 150000;
+  uint32_t idle_reset_us_ = 2000000;
+  uint32_t period_us_ = 0;
+  uint32_t last_interval_us_ = 0;
+};
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ---------- Chain counter journal ----------
+// Append-only ημερολόγιο για την κατάσταση του μετρητή, πάνω σε raw flash
+// (partition "chainlog"). Κάθε εγγραφή είναι 16 bytes με sequence number
+// και CRC, γράφεται μία φορά σε σβησμένη (0xFF) θέση και ποτέ δεν ξαναγράφεται.
+//
+// Layout: N sectors σε δακτύλιο. Η θέση 0 κάθε sector είναι header με το
+// sequence του sector. Όταν γεμίσει ένα sector, σβήνεται το επόμενο (το
+// παλαιότερο), γράφεται νέο header και αντιγράφεται η τελευταία εγγραφή -
+// έτσι το νεότερο sector περιέχει πάντα την τρέχουσα κατάσταση (compaction).
+//
+// Recovery: διαβάζονται τα N headers, μετά το πολύ δύο sectors εγγραφών.
+// Μια μισογραμμένη εγγραφή (torn write) αποτυγχάνει στο CRC και
+// προσπερνιέται· η επόμενη εγγραφή πάει στην αμέσως επόμενη θέση.
+//
+// Channels: ένα journal για όλα τα windlass. Το high nibble του state
+// είναι το channel (παλιές εγγραφές = channel 0) και το compaction
+// αντιγράφει την τελευταία εγγραφή κάθε channel.
+
+// Flash backend. Offsets are relative to the start of the journal region.
+class JournalFlash {
+ public:
+  virtual ~JournalFlash() {}
+  virtual bool read(uint32_t offset, void* dst, size_t len) = 0;
+  virtual bool write(uint32_t offset, const void* src, size_t len) = 0;
+  virtual bool erase_sector(uint32_t offset) = 0;
+  virtual uint32_t size() const = 0;
+  static constexpr uint32_t kSectorSize = 4096;
+};
+
+struct CounterRecord {
+  uint32_t seq;      // 0xFFFFFFFF = σβησμένο
+  int32_t  pulses;
+  float    meters;
+  uint8_t  kind;     // kData / kSectorHeader
+  uint8_t  state;    // RunState τη στιγμή της εγγραφής (low nibble) + channel (high)
+  uint16_t crc;      // CRC-16/CCITT των πρώτων 14 bytes
+
+  static constexpr uint8_t kData = 0xA5;
+  static constexpr uint8_t kSectorHeader = 0x5A;
+
+  uint8_t channel() const { return state >> 4; }
+  uint8_t run_state() const { return state & 0x0F; }
+};
+static_assert(sizeof(CounterRecord) == 16, "CounterRecord must stay 16 bytes");
+
+class CounterJournal {
+ public:
+  static constexpr uint32_t kSlotsPerSector = JournalFlash::kSectorSize / sizeof(CounterRecord);
+  static constexpr int      kMaxChannels = 4;
+
+  struct Stats {
+    uint32_t appends;
+    uint32_t sector_erases;
+    uint32_t torn_records;  // bad CRC found during recovery
+    uint32_t write_errors;
+  };
+
+  static uint16_t crc16(const uint8_t* p, size_t n) {
+    uint16_t crc = 0xFFFF;
+    while (n--) {
+      crc ^= (uint16_t)(*p++) << 8;
+      for (int i = 0; i < 8; i++) crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+  }
+
+  // Scans the region and positions the head. Returns true if a valid
+  // record was found (out holds the latest one of any channel; per channel
+  // see latest()).
+  bool recover(JournalFlash* flash, CounterRecord& out) {
+    flash_ = flash;
+    sectors_ = flash_ ? flash_->size() / JournalFlash::kSectorSize : 0;
+    stats_ = Stats();
+    for (int c = 0; c < kMaxChannels; c++) has_latest_[c] = false;
+    if (sectors_ < 2) return false;
+
+    // 1) Νεότερο sector = μεγαλύτερο έγκυρο header seq
+    int newest = -1;
+    uint32_t newest_seq = 0;
+    for (uint32_t s = 0; s < sectors_; s++) {
+      CounterRecord h;
+      if (!read_slot_(s, 0, h) || !valid_(h) || h.kind != CounterRecord::kSectorHeader) continue;
+      if (newest < 0 || (int32_t)(h.seq - newest_seq) > 0) {
+        newest = (int)s;
+        newest_seq = h.seq;
+      }
+    }
+    if (newest < 0) {
+      // Καθαρό (ή κατεστραμμένο) region: ξεκίνα από sector 0
+      head_sector_ = sectors_ - 1;
+      head_slot_ = kSlotsPerSector;  // το πρώτο append θα ανοίξει νέο sector
+      next_seq_ = 1;
+      sector_seq_ = 0;
+      return false;
+    }
+
+    head_sector_ = (uint32_t)newest;
+    sector_seq_ = newest_seq;
+    next_seq_ = newest_seq + 1;
+
+    // 2) Το προηγούμενο sector πρώτα: ένα carry-over που κόπηκε (torn πριν
+    //    αντιγραφούν όλα τα channels) αφήνει εκεί την τελευταία εγγραφή
+    const uint32_t prev = (head_sector_ + sectors_ - 1) % sectors_;
+    CounterRecord h;
+    if (read_slot_(prev, 0, h) && valid_(h) && h.kind == CounterRecord::kSectorHeader &&
+        h.seq == newest_seq - 1) {
+      scan_sector_(prev);
+    }
+    head_slot_ = scan_sector_(head_sector_);
+
+    int newest_ch = -1;
+    for (int c = 0; c < kMaxChannels; c++) {
+      if (!has_latest_[c]) continue;
+      if ((int32_t)(latest_[c].seq + 1 - next_seq_) > 0) next_seq_ = latest_[c].seq + 1;
+      if (newest_ch < 0 || (int32_t)(latest_[c].seq - latest_[newest_ch].seq) > 0) newest_ch = c;
+    }
+    if (newest_ch < 0) return false;
+    out = latest_[newest_ch];
+    return true;
+  }
+
+  // Η τελευταία εγγραφή ενός channel μετά το recover()/append().
+  bool latest(int channel, CounterRecord& out) const {
+    if (channel < 0 || channel >= kMaxChannels || !has_latest_[channel]) return false;
+    out = latest_[channel];
+    return true;
+  }
+
+  // Appends one state record; erases/compacts into the next sector when full.
+  // Typical cost: one 16-byte flash write; on rollover one sector erase.
+  bool append(int32_t pulses, float meters, uint8_t state, uint8_t channel = 0) {
+    if (!flash_ || sectors_ < 2 || channel >= kMaxChannels) return false;
+    if (head_slot_ >= kSlotsPerSector && !open_next_sector_()) return false;
+
+    CounterRecord r;
+    r.seq = next_seq_;
+    r.pulses = pulses;
+    r.meters = meters;
+    r.kind = CounterRecord::kData;
+    r.state = (uint8_t)((channel << 4) | (state & 0x0F));
+    seal_(r);
+    const bool ok = write_slot_(head_sector_, head_slot_, r);
+    head_slot_++;  // ακόμα κι αν απέτυχε, η θέση δεν είναι πια σβησμένη
+    if (!ok) {
+      stats_.write_errors++;
+      return false;
+    }
+    next_seq_++;
+    latest_[channel] = r;
+    has_latest_[channel] = true;
+    stats_.appends++;
+    return true;
+  }
+
+  const Stats& stats() const { return stats_; }
+  uint32_t sectors() const { return sectors_; }
+  uint32_t head_sector() const { return head_sector_; }
+  uint32_t head_slot() const { return head_slot_; }
+
+ private:
+  static bool erased_(const CounterRecord& r) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&r);
+    for (size_t i = 0; i < sizeof(r); i++)
+      if (p[i] != 0xFF) return false;
+    return true;
+  }
+  static bool valid_(const CounterRecord& r) {
+    return !erased_(r) && r.crc == crc16(reinterpret_cast<const uint8_t*>(&r), 14) &&
+           (r.kind == CounterRecord::kData || r.kind == CounterRecord::kSectorHeader);
+  }
+  static void seal_(CounterRecord& r) {
+    r.crc = crc16(reinterpret_cast<const uint8_t*>(&r), 14);
+  }
+
+  bool read_slot_(uint32_t sector, uint32_t slot, CounterRecord& r) {
+    return flash_->read(sector * JournalFlash::kSectorSize + slot * sizeof(CounterRecord), &r,
+                        sizeof(r));
+  }
+  bool write_slot_(uint32_t sector, uint32_t slot, const CounterRecord& r) {
+    return flash_->write(sector * JournalFlash::kSectorSize + slot * sizeof(CounterRecord), &r,
+                         sizeof(r));
+  }
+
+  // Returns the first erased slot (append position); keeps the last valid
+  // record of each channel.
+  uint32_t scan_sector_(uint32_t sector) {
+    uint32_t slot = 1;
+    for (; slot < kSlotsPerSector; slot++) {
+      CounterRecord r;
+      if (!read_slot_(sector, slot, r)) break;
+      if (erased_(r)) break;
+      if (!valid_(r) || r.kind != CounterRecord::kData) {
+        stats_.torn_records++;
+        continue;
+      }
+      if (r.channel() >= kMaxChannels) continue;
+      latest_[r.channel()] = r;
+      has_latest_[r.channel()] = true;
+    }
+    return slot;
+  }
+
+  bool open_next_sector_() {
+    const uint32_t next = (head_sector_ + 1) % sectors_;
+    if (!flash_->erase_sector(next * JournalFlash::kSectorSize)) {
+      stats_.write_errors++;
+      return false;
+    }
+    stats_.sector_erases++;
+    sector_seq_++;
+    CounterRecord h;
+    memset(&h, 0, sizeof(h));
+    h.seq = sector_seq_;
+    h.kind = CounterRecord::kSectorHeader;
+    seal_(h);
+    if (!write_slot_(next, 0, h)) {
+      stats_.write_errors++;
+      return false;
+    }
+    head_sector_ = next;
+    head_slot_ = 1;
+    // Compaction: η τρέχουσα κατάσταση κάθε channel ζει πάντα στο νεότερο sector
+    for (int c = 0; c < kMaxChannels; c++) {
+      if (!has_latest_[c]) continue;
+      CounterRecord r = latest_[c];
+      r.seq = next_seq_++;
+      seal_(r);
+      if (write_slot_(head_sector_, head_slot_, r)) latest_[c] = r;
+      head_slot_++;
+    }
+    return true;
+  }
+
+  JournalFlash* flash_ = nullptr;
+  uint32_t sectors_ = 0;
+  uint32_t head_sector_ = 0;
+  uint32_t head_slot_ = 0;
+  uint32_t sector_seq_ = 0;
+  uint32_t next_seq_ = 1;
+  CounterRecord latest_[kMaxChannels] = {};
+  bool has_latest_[kMaxChannels] = {};
+  Stats stats_ = {};
+};
+
+// Η κατάσταση των μετρητών πριν από ένα restart που κάνει το ίδιο το
+// firmware (watchdog σύνδεσης, OTA). Ζει στη RTC μνήμη (RTC_NOINIT στο
+// firmware), οπότε το επόμενο boot τη βρίσκει χωρίς να διαβάσει flash.
+// Μετά από power-on η μνήμη είναι σκουπίδια, γι' αυτό magic + CRC. Το boot
+// την καταναλώνει (invalidate) ώστε ένα μεταγενέστερο crash να μη φέρει
+// πίσω παλιές τιμές.
+struct CounterRtcRecord {
+  enum Reason : uint8_t { kNone, kWsWatchdog, kOtaReboot, kOtaRollback };
+
+  struct Channel {
+    int32_t pulses;
+    float   meters;
+    uint8_t state;    // RunState
+    uint8_t reserved[3];
+  };
+
+  uint32_t magic;
+  uint8_t  channels;
+  uint8_t  reason;
+  uint16_t reserved;
+  uint32_t uptime_ms;
+  Channel  ch[CounterJournal::kMaxChannels];
+  uint16_t reserved2;
+  uint16_t crc;
+
+  static constexpr uint32_t kMagic = 0x434E5452;  // "CNTR"
+
+  static const char* reasonName(uint8_t r) {
+    switch (r) {
+      case kWsWatchdog:  return "ws_watchdog";
+      case kOtaReboot:   return "ota_reboot";
+      case kOtaRollback: return "ota_rollback";
+    }
+    return "none";
+  }
+
+  uint16_t compute_crc() const {
+    return CounterJournal::crc16((const uint8_t*)this, offsetof(CounterRtcRecord, crc));
+  }
+  bool valid() const {
+    return magic == kMagic && channels <= CounterJournal::kMaxChannels && crc == compute_crc();
+  }
+  void seal() {
+    magic = kMagic;
+    reserved = 0;
+    reserved2 = 0;
+    crc = compute_crc();
+  }
+  void invalidate() { magic = 0; }
+};
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ---------- Motor current monitor ----------
+// Ρεύμα του μοτέρ από έναν αισθητήρα Hall (π.χ. ACS758) στο ADC, με
+// σταθερό ρυθμό kSampleHz. Ανά δείγμα, όλα σε ακέραιους:
+//
+//   raw ADC → mA      (raw - zero) * scale (Q16 mA ανά count)
+//   low-pass          y += (x - y) >> kFilterShift (θόρυβος μεταγωγής/PWM)
+//   RMS παραθύρου     άθροισμα τετραγώνων των τελευταίων kWindow δειγμάτων
+//   peak              max |y| από την αρχή της κίνησης (telemetry)
+//
+// Ανίχνευση:
+//   overload  |y| >= overload_ma για overload_samples συνεχόμενα δείγματα
+//             (βραχυκύκλωμα, ισχύει και στο inrush)
+//   stall     RMS >= stall_ma για stall_samples, μετά τα πρώτα
+//             inrush_samples της κίνησης (το ρεύμα εκκίνησης μοιάζει με stall)
+//   locked    μέσα στο blanking: RMS >= lock_ma για lock_samples, μετά τα
+//             πρώτα lock_settle_samples, χωρίς κανέναν παλμό αλυσίδας από την
+//             αρχή της κίνησης (note_rotation). Ένα μοτέρ που γυρίζει πέφτει
+//             γρήγορα κάτω από το όριο καθώς ανεβαίνει το back-EMF· ένα
+//             μπλοκαρισμένο μένει στο ρεύμα εκκίνησης. Trip ως stall.
+//
+// Το stall συγκρίνεται χωρίς τετραγωνική ρίζα (sum >= stall² * kWindow).
+// Χτίζεται και στο host (tools/current_bench.cpp).
+
+struct CurrentConfig {
+  int32_t  zero_counts;       // ADC counts στα 0A
+  int32_t  scale_q16;         // mA ανά count, Q16
+  int32_t  stall_ma;          // 0 = χωρίς stall detection
+  int32_t  overload_ma;       // 0 = χωρίς overload detection
+  int32_t  lock_ma;           // 0 = χωρίς locked rotor detection
+  uint16_t inrush_samples;
+  uint16_t stall_samples;
+  uint16_t overload_samples;
+  uint16_t lock_settle_samples;
+  uint16_t lock_samples;
+};
+
+class CurrentMonitor {
+ public:
+  static constexpr uint32_t kSampleHz = 1000;
+  static constexpr int      kWindow = 16;        // δείγματα RMS (16ms)
+  static constexpr int      kWindowShift = 4;
+  static constexpr int      kFilterShift = 1;    // ~2 δείγματα time constant
+
+  enum Trip : uint8_t { kNone, kStall, kOverload };
+
+  static const char* tripReason(Trip t) {
+    switch (t) {
+      case kStall:    return "safety:stall";
+      case kOverload: return "safety:overload";
+      case kNone:     break;
+    }
+    return "";
+  }
+
+  // Defaults για τα χρονικά όρια σε δείγματα (kSampleHz)
+  static CurrentConfig makeConfig(int32_t zero_counts, float ma_per_count, float stall_a,
+                                  float overload_a) {
+    CurrentConfig c;
+    c.zero_counts = zero_counts;
+    c.scale_q16 = (int32_t)(ma_per_count * 65536.0f + 0.5f);
+    c.stall_ma = stall_a > 0.0f ? (int32_t)(stall_a * 1000.0f) : 0;
+    c.overload_ma = overload_a > 0.0f ? (int32_t)(overload_a * 1000.0f) : 0;
+    c.lock_ma = c.stall_ma + c.stall_ma / 4;  // 1.25 × stall
+    c.inrush_samples = 300;
+    c.stall_samples = 40;
+    c.overload_samples = 3;
+    c.lock_settle_samples = 60;
+    c.lock_samples = 20;
+    return c;
+  }
+
+  void configure(const CurrentConfig& c) {
+    cfg_ = c;
+    stall_sum_ = (int64_t)c.stall_ma * c.stall_ma * kWindow;
+    lock_sum_ = (int64_t)c.lock_ma * c.lock_ma * kWindow;
+  }
+  const CurrentConfig& config() const { return cfg_; }
+
+  // Τα ρελέ μόλις έκλεισαν: νέο παράθυρο, inrush blanking, νέο peak
+  void start_run() {
+    running_ = true;
+    samples_ = 0;
+    filtered_ = 0;
+    sum_sq_ = 0;
+    pos_ = 0;
+    for (int i = 0; i < kWindow; i++) window_[i] = 0;
+    peak_ma_ = 0;
+    stall_count_ = 0;
+    overload_count_ = 0;
+    lock_count_ = 0;
+    rotated_ = false;
+  }
+  void stop_run() { running_ = false; }
+  // Παλμός αλυσίδας σε αυτή την κίνηση: το μοτέρ γυρίζει
+  void note_rotation() { rotated_ = true; }
+  bool running() const { return running_; }
+
+  // Ένα δείγμα. Επιστρέφει το trip τη στιγμή που ανιχνεύεται (μία φορά).
+  Trip feed(uint16_t raw) {
+    if (!running_) return kNone;
+    const int32_t x = (int32_t)(((int64_t)((int32_t)raw - cfg_.zero_counts) * cfg_.scale_q16) >> 16);
+    filtered_ += (x - filtered_) >> kFilterShift;
+    const int32_t y = filtered_;
+    const int32_t mag = y < 0 ? -y : y;
+    if (mag > peak_ma_) peak_ma_ = mag;
+
+    const int32_t old = window_[pos_];
+    window_[pos_] = y;
+    pos_ = (pos_ + 1) & (kWindow - 1);
+    sum_sq_ += (int64_t)y * y - (int64_t)old * old;
+    if (samples_ < 0xFFFFFFFFu) samples_++;
+
+    if (cfg_.overload_ma && mag >= cfg_.overload_ma) {
+      if (++overload_count_ >= cfg_.overload_samples) return trip_(kOverload);
+    } else {
+      overload_count_ = 0;
+    }
+    if (cfg_.stall_ma && samples_ > cfg_.inrush_samples && sum_sq_ >= stall_sum_) {
+      if (++stall_count_ >= cfg_.stall_samples) return trip_(kStall);
+    } else {
+      stall_count_ = 0;
+    }
+    if (cfg_.lock_ma && !rotated_ && samples_ > cfg_.lock_settle_samples &&
+        samples_ <= cfg_.inrush_samples && sum_sq_ >= lock_sum_) {
+      if (++lock_count_ >= cfg_.lock_samples) return trip_(kStall);
+    } else {
+      lock_count_ = 0;
+    }
+    return kNone;
+  }
+
+  // RMS του παραθύρου σε mA (για telemetry, όχι για την ανίχνευση)
+  int32_t rms_ma() const { return (int32_t)isqrt64_((uint64_t)(sum_sq_ >> kWindowShift)); }
+  int32_t peak_ma() const { return peak_ma_; }
+  uint32_t samples() const { return samples_; }
+  uint32_t trips() const { return trips_; }
+
+ private:
+  Trip trip_(Trip t) {
+    trips_++;
+    running_ = false;
+    return t;
+  }
+
+  static uint32_t isqrt64_(uint64_t v) {
+    uint64_t r = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+      if (v >= r + bit) {
+        v -= r + bit;
+        r = (r >> 1) + bit;
+      } else {
+        r >>= 1;
+      }
+      bit >>= 2;
+    }
+    return (uint32_t)r;
+  }
+
+  CurrentConfig cfg_ = {};
+  int64_t  stall_sum_ = 0;
+  int64_t  lock_sum_ = 0;
+  bool     running_ = false;
+  bool     rotated_ = false;
+  uint32_t samples_ = 0;
+  int32_t  filtered_ = 0;
+  int32_t  window_[kWindow] = {};
+  int      pos_ = 0;
+  int64_t  sum_sq_ = 0;
+  int32_t  peak_ma_ = 0;
+  uint16_t stall_count_ = 0;
+  uint16_t overload_count_ = 0;
+  uint16_t lock_count_ = 0;
+  uint32_t trips_ = 0;
+};
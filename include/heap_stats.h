@@ -0,0 +1,113 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+
+#include "counter_journal.h"
+
+// ---------- Heap accounting ----------
+// Μετράει δεσμεύσεις ανά υποσύστημα. Το firmware τυλίγει malloc/calloc/
+// realloc/free (-Wl,--wrap, βλ. platformio.ini) και καλεί on_alloc() με το
+// tag του τρέχοντος scope. Τα scopes (AllocScope) μπαίνουν μόνο στο loop
+// task: ό,τι δεσμεύεται σε άλλα tasks (WS client, http server, WiFi) πάει
+// στο kAllocOther. Ένα atomic increment ανά δέσμευση, χωρίς locks.
+#define ALLOC_SUBSYSTEMS(X)          \
+  X(kAllocOther,     "other")        \
+  X(kAllocEventLoop, "eventLoop")    \
+  X(kAllocCommands,  "commands")     \
+  X(kAllocTelemetry, "telemetry")    \
+  X(kAllocTimers,    "timers")
+
+enum AllocSubsystem : uint8_t {
+#define X(id, name) id,
+  ALLOC_SUBSYSTEMS(X)
+#undef X
+  kAllocSubsystemCount
+};
+
+class HeapStats {
+ public:
+  static const char* name(int s) {
+    static const char* const kNames[kAllocSubsystemCount] = {
+#define X(id, name) name,
+      ALLOC_SUBSYSTEMS(X)
+#undef X
+    };
+    return s >= 0 && s < kAllocSubsystemCount ? kNames[s] : "";
+  }
+
+  // Από τους wrappers (οποιοδήποτε task): μόνο relaxed increments
+  inline void on_alloc(uint8_t subsystem, size_t bytes) __attribute__((always_inline)) {
+    if (subsystem >= kAllocSubsystemCount) subsystem = kAllocOther;
+    allocs_[subsystem].fetch_add(1, std::memory_order_relaxed);
+    bytes_[subsystem].fetch_add((uint32_t)bytes, std::memory_order_relaxed);
+  }
+  inline void on_free() __attribute__((always_inline)) {
+    frees_.fetch_add(1, std::memory_order_relaxed);
+  }
+  inline void on_failed() __attribute__((always_inline)) {
+    failed_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  uint32_t allocs(int s) const { return allocs_[s].load(std::memory_order_relaxed); }
+  uint32_t bytes(int s) const { return bytes_[s].load(std::memory_order_relaxed); }
+  uint32_t frees() const { return frees_.load(std::memory_order_relaxed); }
+  uint32_t failed() const { return failed_.load(std::memory_order_relaxed); }
+
+  // Τρέχον tag του loop task. Γράφεται μόνο από αυτό, αλλά οι wrappers
+  // το διαβάζουν από όλα τα tasks: atomic, relaxed.
+  std::atomic<uint8_t> current{kAllocOther};
+
+ private:
+  std::atomic<uint32_t> allocs_[kAllocSubsystemCount] = {};
+  std::atomic<uint32_t> bytes_[kAllocSubsystemCount] = {};
+  std::atomic<uint32_t> frees_{0};
+  std::atomic<uint32_t> failed_{0};
+};
+
+// Δίνει tag στις δεσμεύσεις ενός block του loop task. Τα scopes φωλιάζουν
+// (π.χ. commands μέσα στο eventLoop) και επαναφέρουν το προηγούμενο tag.
+class AllocScope {
+ public:
+  AllocScope(HeapStats& s, AllocSubsystem tag)
+      : stats_(s), prev_(s.current.load(std::memory_order_relaxed)) {
+    s.current.store(tag, std::memory_order_relaxed);
+  }
+  ~AllocScope() { stats_.current.store(prev_, std::memory_order_relaxed); }
+
+ private:
+  HeapStats& stats_;
+  uint8_t    prev_;
+};
+
+// Στιγμιότυπο του heap που επιβιώνει από reset (RTC_NOINIT στο firmware):
+// μετά από ένα απρόσμενο restart δείχνει σε τι κατάσταση ήταν το heap λίγο
+// πριν. Μετά από power-on η μνήμη είναι σκουπίδια, γι' αυτό magic + CRC.
+struct HeapRtcRecord {
+  uint32_t magic;
+  uint32_t boots;           // πόσες φορές έχει ξεκινήσει χωρίς power-on
+  uint32_t uptime_s;
+  uint32_t free_bytes;
+  uint32_t min_free_bytes;
+  uint32_t largest_block;
+  uint32_t allocs[kAllocSubsystemCount];
+  uint32_t frees;
+  uint32_t failed;
+  uint16_t reserved;
+  uint16_t crc;
+
+  static constexpr uint32_t kMagic = 0x48454150;  // "HEAP"
+
+  uint16_t compute_crc() const {
+    return CounterJournal::crc16((const uint8_t*)this, offsetof(HeapRtcRecord, crc));
+  }
+  bool valid() const { return magic == kMagic && crc == compute_crc(); }
+  void seal() {
+    magic = kMagic;
+    reserved = 0;
+    crc = compute_crc();
+  }
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ---------- Loop latency histograms ----------
+// Log2 buckets με 2 υπο-buckets ανά οκτάβα πάνω σε CPU cycles: ένα clz,
+// ένα shift και ένα increment ανά μέτρηση, σταθερή μνήμη (~200 bytes ανά
+// histogram). Αρκετά φθηνό για να μένει ανοιχτό στην παραγωγή.
+class LatencyHistogram {
+ public:
+  static constexpr int kMinShift = 6;   // < 64 cycles (~0.3us @240MHz) → bucket 0
+  static constexpr int kOctaves = 26;   // έως ~2^32 cycles
+  static constexpr int kBuckets = kOctaves * 2;
+
+  void record(uint32_t cycles) {
+    buckets_[index_(cycles)]++;
+    count_++;
+    if (cycles > max_) max_ = cycles;
+  }
+
+  void reset() { memset(this, 0, sizeof(*this)); }
+
+  uint32_t count() const { return count_; }
+  uint32_t max() const { return max_; }
+
+  // Upper bound (in cycles) of the bucket holding the p-th percentile.
+  uint32_t percentile(uint8_t p) const {
+    if (count_ == 0) return 0;
+    const uint32_t rank = (uint32_t)(((uint64_t)count_ * p + 99) / 100);
+    uint32_t seen = 0;
+    for (int i = 0; i < kBuckets; i++) {
+      seen += buckets_[i];
+      if (seen >= rank) {
+        const uint32_t hi = upper_(i);
+        return hi < max_ ? hi : max_;
+      }
+    }
+    return max_;
+  }
+
+ private:
+  static int index_(uint32_t v) {
+    if (v < (1u << kMinShift)) return 0;
+    const int msb = 31 - __builtin_clz(v);
+    const int half = (v >> (msb - 1)) & 1;  // κάτω/πάνω μισό της οκτάβας
+    int i = (msb - kMinShift + 1) * 2 + half - 1;
+    return i < kBuckets ? i : kBuckets - 1;
+  }
+  static uint32_t upper_(int i) {
+    if (i == 0) return (1u << kMinShift) - 1;
+    const int msb = (i + 1) / 2 + kMinShift - 1;
+    const int half = (i + 1) % 2;
+    const uint64_t base = 1ull << msb;
+    const uint64_t hi = half ? (base << 1) - 1 : base + (base >> 1) - 1;
+    return hi > 0xFFFFFFFFull ? 0xFFFFFFFFu : (uint32_t)hi;
+  }
+
+  uint32_t buckets_[kBuckets];
+  uint32_t count_;
+  uint32_t max_;
+};
+
+// Times consecutive stages of one loop pass. Usage:
+//   perf.start(cycles()); stage A; perf.lap(kA, cycles()); ... perf.finish(cycles());
+// The total of the pass goes to the last stage index (Stages - 1).
+template <size_t Stages>
+class LoopProfiler {
+ public:
+  struct Summary {
+    uint32_t count;
+    uint32_t p50_us;
+    uint32_t p95_us;
+    uint32_t p99_us;
+    uint32_t max_us;
+  };
+
+  void set_cycles_per_us(uint32_t c) { cycles_per_us_ = c ? c : 1; }
+
+  inline void start(uint32_t now_cycles) {
+    pass_start_ = now_cycles;
+    lap_start_ = now_cycles;
+  }
+  inline void lap(size_t stage, uint32_t now_cycles) {
+    window_[stage].record(now_cycles - lap_start_);
+    lap_start_ = now_cycles;
+  }
+  inline void finish(uint32_t now_cycles) {
+    window_[Stages - 1].record(now_cycles - pass_start_);
+  }
+  // A duration measured elsewhere (e.g. on another core), in the same units.
+  inline void record(size_t stage, uint32_t cycles) { window_[stage].record(cycles); }
+
+  // Closes the current window: its histograms become the published ones.
+  void roll() {
+    memcpy(last_, window_, sizeof(window_));
+    for (size_t i = 0; i < Stages; i++) window_[i].reset();
+    windows_++;
+  }
+
+  Summary summary(size_t stage) const { return summarize(last_[stage]); }
+
+  // Same conversion for a histogram kept outside the windows (e.g. since boot).
+  Summary summarize(const LatencyHistogram& h) const {
+    Summary s;
+    s.count = h.count();
+    s.p50_us = h.percentile(50) / cycles_per_us_;
+    s.p95_us = h.percentile(95) / cycles_per_us_;
+    s.p99_us = h.percentile(99) / cycles_per_us_;
+    s.max_us = h.max() / cycles_per_us_;
+    return s;
+  }
+
+  uint32_t windows() const { return windows_; }
+
+ private:
+  LatencyHistogram window_[Stages] = {};
+  LatencyHistogram last_[Stages] = {};
+  uint32_t cycles_per_us_ = 240;
+  uint32_t pass_start_ = 0;
+  uint32_t lap_start_ = 0;
+  uint32_t windows_ = 0;
+};
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "seqlock.h"
+#include "spsc_ring.h"
+#include "windlass_core.h"
+
+// ---------- Network side ↔ motor task ----------
+// Το motor task είναι ο μόνος owner του WindlassCore. Η πλευρά του δικτύου
+// (loop task, SK listeners, config UI) δεν αγγίζει ποτέ πεδία του:
+//  - εντολές πάνε με το commands (SPSC, producer = loop task),
+//  - οι ρυθμίσεις με το config (Seqlock) + kApplyConfig,
+//  - η κατάσταση γυρνάει με το snapshot (Seqlock, writer = motor task),
+//  - τα lastCommand reasons με το events (SPSC, producer = motor task),
+//  - τα acks των εντολών με το acks (SPSC, producer = motor task),
+//  - εντολές και acks του UDP task με τα udp_commands / udp_acks.
+// Χτίζεται και στο host (std::atomic μόνο).
+
+struct MotorCommand {
+  // Από πού ήρθε: για το latency εντολή → ρελέ
+  enum Source : uint8_t { kSrcInternal, kSrcListener, kSrcPut, kSrcUdp };
+
+  enum Type : uint8_t {
+    kFsm,               // arg = WindlassFsm::Command
+    kStop,              // reason
+    kSetTarget,         // value = meters (<0 clears)
+    kSetChainOut,       // value = meters
+    kResetCounter,
+    kApplyConfig,       // read MotorLink::config
+  };
+  Type        type;
+  uint8_t     arg;
+  Source      source;
+  float       value;
+  const char* reason;  // string literal only
+  uint32_t    t_us;    // micros() όταν έφτασε η εντολή
+  uint32_t    id;      // 0 = χωρίς ack (εσωτερική)
+};
+
+// Επιβεβαίωση μιας εντολής με id, από το motor task μόλις εφαρμοστεί.
+struct CommandAck {
+  uint32_t id;
+  MotorCommand::Type   type;
+  uint8_t              arg;
+  MotorCommand::Source source;
+  bool     actuated;        // άλλαξαν τα ρελέ
+  WindlassCore::Outcome outcome;  // εφαρμόστηκε, στην ουρά, αγνοήθηκε, απορρίφθηκε
+  WindlassFsm::RunState state;  // κατάσταση μετά την εντολή
+  uint32_t received_us;
+  uint32_t actuated_us;     // έγκυρο μόνο αν actuated
+};
+
+// Ό,τι χρειάζεται η πλευρά του δικτύου για telemetry, LED και persistence.
+struct MotorSnapshot {
+  uint32_t seq;               // αυξάνει σε κάθε δημοσίευση (= wakeups του motor task)
+  uint32_t save_seq;          // αλλάζει όταν κάτι πρέπει να σωθεί στο config
+  WindlassFsm::RunState state;
+  bool     relays_on;
+  bool     has_target;
+  int32_t  chain_pulse_count;
+  float    chain_out_meters;
+  float    chain_target_m;
+  float    target_eta_s;
+  float    chain_speed;
+  float    coast_down_m;
+  float    coast_up_m;
+  uint32_t target_stops;
+  int32_t  current_ma;        // RMS του παραθύρου όσο κινείται, αλλιώς 0
+  int32_t  current_peak_ma;   // της τρέχουσας/τελευταίας κίνησης
+  uint32_t stall_trips;
+  uint32_t overload_trips;
+  uint32_t last_step_us;      // διάρκεια του τελευταίου βήματος
+  uint32_t max_step_us;       // χειρότερο βήμα από την εκκίνηση
+};
+
+struct MotorLink {
+  SpscRing<MotorCommand, 16> commands;
+  SpscRing<const char*, 16>  events;
+  SpscRing<CommandAck, 8>    acks;
+  SpscRing<MotorCommand, 8>  udp_commands;  // producer = UDP task
+  SpscRing<CommandAck, 8>    udp_acks;      // consumer = UDP task
+  Seqlock<WindlassConfig>    config;
+  Seqlock<MotorSnapshot>     snapshot;
+
+  // Γράφονται από το loop task, διαβάζονται από το motor task
+  std::atomic<bool>     link_up{false};
+  std::atomic<uint32_t> loop_alive_ms{0};
+
+  // Ξυπνάει την πλευρά του δικτύου όταν το snapshot αλλάζει ουσιαστικά
+  // (νέος παλμός, κατάσταση, event). Το στήνει η πλευρά του δικτύου.
+  void (*wake_network)(void* ctx) = nullptr;
+  void* wake_ctx = nullptr;
+
+  static MotorCommand make(MotorCommand::Type type, uint8_t arg = 0, float value = 0.0f,
+                           const char* reason = nullptr,
+                           MotorCommand::Source source = MotorCommand::kSrcInternal,
+                           uint32_t id = 0) {
+    MotorCommand c;
+    c.id = id;
+    c.type = type;
+    c.arg = arg;
+    c.source = source;
+    c.value = value;
+    c.reason = reason;
+    c.t_us = hal::micros();
+    return c;
+  }
+
+  bool post(MotorCommand::Type type, uint8_t arg = 0, float value = 0.0f,
+            const char* reason = nullptr) {
+    return commands.push(make(type, arg, value, reason));
+  }
+  bool post(const MotorCommand& c) { return commands.push(c); }
+};
+
+// Ένα βήμα του motor task: εντολές → safety → tickCore_() → snapshot.
+// Τρέχει μόνο στο motor task (ή inline πριν αυτό ξεκινήσει).
+class MotorDriver {
+ public:
+  // Χωρίς σημείο ζωής από το loop task για τόσο, η κίνηση σταματάει.
+  static constexpr uint32_t kLoopStallMs = 5000;
+
+  MotorDriver(WindlassCore& core, MotorLink& link) : core_(core), link_(link) {}
+
+  void step(uint32_t now_ms) {
+    const uint32_t t0 = hal::micros();
+    MotorCommand c;
+    while (link_.udp_commands.pop(c)) apply(c);
+    while (link_.commands.pop(c)) apply(c);
+
+    if (running_()) {
+      if (!link_.link_up.load(std::memory_order_acquire)) {
+        core_.stopNow_("safety:not_connected");
+      } else if (now_ms - link_.loop_alive_ms.load(std::memory_order_acquire) > kLoopStallMs) {
+        core_.stopNow_("safety:loop_stalled");
+      }
+    }
+
+    core_.tickCore_(now_ms);
+    publish(hal::micros() - t0);
+
+    if (link_.wake_network &&
+        (core_.chain_pulse_count != woke_pulses_ || core_.state != woke_state_ ||
+         !link_.events.empty() || !link_.acks.empty() || save_seq_ != woke_save_seq_)) {
+      woke_pulses_ = core_.chain_pulse_count;
+      woke_state_ = core_.state;
+      woke_save_seq_ = save_seq_;
+      link_.wake_network(link_.wake_ctx);
+    }
+  }
+
+  void apply(const MotorCommand& c) {
+    const uint32_t actuations = core_.relay_actuations_;
+    const WindlassCore::Outcome outcome = applyCommand_(c);
+    if (!c.id) return;
+    // Ack: χρόνος άφιξης και, αν άλλαξαν τα ρελέ, χρόνος του digitalWrite
+    CommandAck a;
+    a.id = c.id;
+    a.type = c.type;
+    a.arg = c.arg;
+    a.source = c.source;
+    a.actuated = core_.relay_actuations_ != actuations;
+    a.outcome = outcome;
+    a.state = core_.state;
+    a.received_us = c.t_us;
+    a.actuated_us = a.actuated ? core_.relay_actuated_us_ : 0;
+    (c.source == MotorCommand::kSrcUdp ? link_.udp_acks : link_.acks).push(a);
+  }
+
+  void publish(uint32_t step_us = 0) {
+    const uint32_t now_us = hal::micros();
+    MotorSnapshot s;
+    s.seq = ++seq_;
+    s.save_seq = save_seq_;
+    s.state = core_.state;
+    s.relays_on = core_.relays_on_;
+    s.has_target = core_.hasChainTarget();
+    s.chain_pulse_count = core_.chain_pulse_count;
+    s.chain_out_meters = core_.chain_out_meters;
+    s.chain_target_m = core_.chain_target_m;
+    s.target_eta_s = core_.targetEtaSeconds(now_us);
+    s.chain_speed = core_.chainSpeed(now_us);
+    s.coast_down_m = core_.coast_.coast_m(0);
+    s.coast_up_m = core_.coast_.coast_m(1);
+    s.target_stops = core_.target_stops_;
+    s.current_ma = core_.current_.running() ? core_.current_.rms_ma() : 0;
+    s.current_peak_ma = core_.current_.peak_ma();
+    s.stall_trips = core_.current_trips_[CurrentMonitor::kStall];
+    s.overload_trips = core_.current_trips_[CurrentMonitor::kOverload];
+    if (step_us > max_step_us_) max_step_us_ = step_us;
+    s.last_step_us = step_us;
+    s.max_step_us = max_step_us_;
+    link_.snapshot.write(s);
+  }
+
+  // Από τα hooks του core (motor task context)
+  void requestSave() { save_seq_++; }
+  void event(const char* what) { link_.events.push(what); }
+
+ private:
+  WindlassCore::Outcome applyCommand_(const MotorCommand& c) {
+    switch (c.type) {
+      case MotorCommand::kFsm: {
+        // Κίνηση χωρίς σύνδεση θα σταματούσε στο ίδιο step
+        // (safety:not_connected) αφού τα ρελέ είχαν ήδη κλείσει
+        const WindlassFsm::Command cmd = (WindlassFsm::Command)c.arg;
+        const WindlassFsm::Action act = WindlassFsm::transition(core_.state, cmd).action;
+        const bool moves = act == WindlassFsm::kActStart || act == WindlassFsm::kActExtend ||
+                           act == WindlassFsm::kActReverse;
+        if (moves && !link_.link_up.load(std::memory_order_acquire)) {
+          return WindlassCore::kOutcomeRefused;
+        }
+        return core_.handleCommand(cmd);
+      }
+      case MotorCommand::kStop:
+        if (running_()) core_.stopNow_(c.reason ? c.reason : "stop");
+        break;
+      case MotorCommand::kSetTarget:
+        core_.setChainTarget(c.value);
+        break;
+      case MotorCommand::kSetChainOut:
+        core_.chain_out_meters = c.value < 0.0f ? 0.0f : c.value;
+        core_.chain_pulse_count = (int)(core_.chain_out_meters / core_.chain_calibration);
+        ESP_LOGI(TAG, "Chain counter SET to %.1fm (%d pulses)", core_.chain_out_meters,
+                 core_.chain_pulse_count);
+        if (c.arg) requestSave();
+        core_.onChainChanged_();
+        break;
+      case MotorCommand::kResetCounter:
+        core_.resetChainCounter();
+        break;
+      case MotorCommand::kApplyConfig: {
+        WindlassConfig cfg;
+        link_.config.read(cfg);
+        core_.applyConfig(cfg);
+        break;
+      }
+    }
+    return WindlassCore::kOutcomeDone;
+  }
+
+  bool running_() const {
+    return core_.state == WindlassFsm::RUNNING_UP || core_.state == WindlassFsm::RUNNING_DOWN;
+  }
+
+  WindlassCore& core_;
+  MotorLink&    link_;
+  uint32_t      seq_ = 0;
+  uint32_t      save_seq_ = 0;
+  uint32_t      max_step_us_ = 0;
+  int32_t       woke_pulses_ = 0;
+  WindlassFsm::RunState woke_state_ = WindlassFsm::IDLE;
+  uint32_t      woke_save_seq_ = 0;
+};
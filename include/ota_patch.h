@@ -0,0 +1,394 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ---------- Delta OTA patches ----------
+// Μια νέα έκδοση του firmware διαφέρει από την τρέχουσα σε λίγα σημεία,
+// αλλά ό,τι μετακινήθηκε αλλάζει και διευθύνσεις γύρω του. Το patch
+// (bsdiff-like) περιγράφει το νέο image ως μπλοκ "διαφορών" πάνω σε μια
+// ευθυγράμμιση του παλιού image και μπλοκ νέων bytes:
+//
+//   header  : "AOP1", u32 source_size, u32 source_crc, u32 target_size,
+//             u32 target_crc (little endian, CRC-32/ISO-HDLC)
+//   control : varint diff_len, varint extra_len, zigzag seek
+//   diff    : diff_len bytes (new - old, mod 256) σε tokens
+//             varint zeros, varint lits, lits bytes
+//             (zeros = ίδια bytes με το παλιό, αντιγράφονται από αυτό)
+//   extra   : extra_len νέα bytes
+//
+// Μετά από κάθε control η θέση στο παλιό image προχωράει κατά diff_len και
+// μετά κατά seek. Το patch τελειώνει όταν γραφτούν target_size bytes.
+//
+// Ο DeltaPatcher εφαρμόζει το patch όπως φτάνει (chunks οποιουδήποτε
+// μεγέθους), διαβάζοντας το παλιό image από ένα OtaSource και γράφοντας το
+// νέο σε ένα OtaSink με σταθερούς buffers - χωρίς heap. Ο generator είναι
+// στο tools/ota_diff.cpp.
+
+namespace ota_patch {
+
+static constexpr uint8_t kMagic[4] = {'A', 'O', 'P', '1'};
+static constexpr size_t  kHeaderBytes = 20;
+
+// CRC-32 (zlib/esp_rom_crc32_le), 16-entry table: αρκετά γρήγορο για ~1.5MB.
+inline uint32_t crc32(uint32_t crc, const uint8_t* p, size_t n) {
+  static const uint32_t kTable[16] = {
+      0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+      0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+      0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+  crc = ~crc;
+  for (size_t i = 0; i < n; i++) {
+    crc ^= p[i];
+    crc = (crc >> 4) ^ kTable[crc & 15];
+    crc = (crc >> 4) ^ kTable[crc & 15];
+  }
+  return ~crc;
+}
+
+inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+inline int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+inline void put_u32(uint8_t* p, uint32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+inline uint32_t get_u32(const uint8_t* p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+struct Header {
+  uint32_t source_size;
+  uint32_t source_crc;
+  uint32_t target_size;
+  uint32_t target_crc;
+};
+
+}  // namespace ota_patch
+
+// Το τρέχον image (στο firmware: το partition που τρέχει).
+class OtaSource {
+ public:
+  virtual ~OtaSource() {}
+  virtual bool read(uint32_t offset, void* dst, size_t len) = 0;
+};
+
+// Το νέο image (στο firmware: esp_ota_write στο ανενεργό slot).
+class OtaSink {
+ public:
+  virtual ~OtaSink() {}
+  virtual bool write(const void* src, size_t len) = 0;
+};
+
+class DeltaPatcher {
+ public:
+  enum Status : uint8_t {
+    kRunning,        // θέλει κι άλλα bytes
+    kDone,           // target_size bytes γράφτηκαν και το CRC ταιριάζει
+    kBadMagic,
+    kWrongSource,    // το patch φτιάχτηκε για άλλο image
+    kCorrupt,        // control εκτός ορίων ή δεδομένα μετά το τέλος
+    kSourceError,
+    kSinkError,
+    kBadTargetCrc,
+  };
+
+  static const char* statusName(Status s) {
+    switch (s) {
+      case kRunning:      return "running";
+      case kDone:         return "done";
+      case kBadMagic:     return "bad_magic";
+      case kWrongSource:  return "wrong_source";
+      case kCorrupt:      return "corrupt";
+      case kSourceError:  return "source_error";
+      case kSinkError:    return "sink_error";
+      case kBadTargetCrc: return "bad_target_crc";
+    }
+    return "";
+  }
+
+  // source_size: πόσα bytes του OtaSource υπάρχουν (μέγεθος του partition).
+  // Με check_source το CRC του παλιού image ελέγχεται πριν γραφτεί τίποτα.
+  void begin(OtaSource* source, uint32_t source_size, OtaSink* sink, bool check_source = true) {
+    source_ = source;
+    source_limit_ = source_size;
+    sink_ = sink;
+    check_source_ = check_source;
+    status_ = kRunning;
+    state_ = kHeader;
+    header_fill_ = 0;
+    varint_ = 0;
+    varint_shift_ = 0;
+    ctrl_field_ = 0;
+    old_pos_ = 0;
+    written_ = 0;
+    out_len_ = 0;
+    crc_ = 0;
+    patch_bytes_ = 0;
+    header_ = ota_patch::Header();
+  }
+
+  // Τροφοδοτεί το επόμενο κομμάτι του patch. Επιστρέφει kRunning μέχρι να
+  // τελειώσει ή να αποτύχει.
+  Status feed(const uint8_t* p, size_t n) {
+    patch_bytes_ += n;
+    while (n && status_ == kRunning) {
+      switch (state_) {
+        case kHeader: {
+          const size_t take = min_(n, ota_patch::kHeaderBytes - header_fill_);
+          memcpy(header_buf_ + header_fill_, p, take);
+          header_fill_ += take;
+          p += take;
+          n -= take;
+          if (header_fill_ == ota_patch::kHeaderBytes) start_();
+          break;
+        }
+        case kCtrl:
+        case kZeros:
+        case kLits:
+          varint_byte_(*p++);
+          n--;
+          break;
+        case kLitBytes:
+        case kExtra: {
+          const size_t take = (size_t)min_(n, remaining_);
+          if (state_ == kLitBytes) {
+            if (!emit_diff_(p, take)) break;
+          } else if (!emit_(p, take)) {
+            break;
+          }
+          p += take;
+          n -= take;
+          remaining_ -= take;
+          if (!remaining_) next_after_block_();
+          break;
+        }
+        case kEnd:
+          status_ = kCorrupt;
+          break;
+      }
+    }
+    if (status_ == kRunning && state_ == kEnd) finish_();
+    return status_;
+  }
+
+  Status status() const { return status_; }
+  const ota_patch::Header& header() const { return header_; }
+  bool header_ready() const { return state_ != kHeader; }
+  uint32_t written() const { return written_; }
+  uint32_t patch_bytes() const { return patch_bytes_; }
+
+ private:
+  enum State : uint8_t { kHeader, kCtrl, kZeros, kLits, kLitBytes, kExtra, kEnd };
+
+  static size_t min_(size_t a, size_t b) { return a < b ? a : b; }
+
+  void start_() {
+    if (memcmp(header_buf_, ota_patch::kMagic, 4) != 0) {
+      status_ = kBadMagic;
+      return;
+    }
+    header_.source_size = ota_patch::get_u32(header_buf_ + 4);
+    header_.source_crc = ota_patch::get_u32(header_buf_ + 8);
+    header_.target_size = ota_patch::get_u32(header_buf_ + 12);
+    header_.target_crc = ota_patch::get_u32(header_buf_ + 16);
+    if (header_.source_size > source_limit_) {
+      status_ = kWrongSource;
+      return;
+    }
+    if (check_source_) {
+      uint32_t crc = 0;
+      for (uint32_t off = 0; off < header_.source_size; off += sizeof(src_buf_)) {
+        const size_t len = min_(sizeof(src_buf_), header_.source_size - off);
+        if (!source_->read(off, src_buf_, len)) {
+          status_ = kSourceError;
+          return;
+        }
+        crc = ota_patch::crc32(crc, src_buf_, len);
+      }
+      if (crc != header_.source_crc) {
+        status_ = kWrongSource;
+        return;
+      }
+    }
+    next_ctrl_();
+  }
+
+  void next_ctrl_() {
+    state_ = written_ + out_len_ >= header_.target_size ? kEnd : kCtrl;
+    ctrl_field_ = 0;
+  }
+
+  void varint_byte_(uint8_t b) {
+    if (varint_shift_ > 28) {
+      status_ = kCorrupt;
+      return;
+    }
+    varint_ |= (uint32_t)(b & 0x7F) << varint_shift_;
+    varint_shift_ += 7;
+    if (b & 0x80) return;
+    const uint32_t v = varint_;
+    varint_ = 0;
+    varint_shift_ = 0;
+    on_varint_(v);
+  }
+
+  void on_varint_(uint32_t v) {
+    switch (state_) {
+      case kCtrl:
+        if (ctrl_field_ == 0) {
+          diff_len_ = v;
+        } else if (ctrl_field_ == 1) {
+          extra_len_ = v;
+        } else {
+          seek_ = ota_patch::unzigzag(v);
+          const uint32_t out = written_ + out_len_;
+          if ((uint64_t)out + diff_len_ + extra_len_ > header_.target_size ||
+              (uint64_t)old_pos_ + diff_len_ > header_.source_size) {
+            status_ = kCorrupt;
+            return;
+          }
+          diff_left_ = diff_len_;
+          begin_block_();
+          return;
+        }
+        ctrl_field_++;
+        break;
+      case kZeros:
+        if (v > diff_left_ || !copy_source_(v)) {
+          if (status_ == kRunning) status_ = kCorrupt;
+          return;
+        }
+        diff_left_ -= v;
+        state_ = kLits;
+        break;
+      case kLits:
+        if (v > diff_left_) {
+          status_ = kCorrupt;
+          return;
+        }
+        diff_left_ -= v;
+        remaining_ = v;
+        if (v) state_ = kLitBytes;
+        else next_after_block_();
+        break;
+      default:
+        break;
+    }
+  }
+
+  // Μετά από ένα control ή ένα token: επόμενο token, το extra ή νέο control
+  void begin_block_() {
+    if (diff_left_) {
+      state_ = kZeros;
+      return;
+    }
+    // Τέλος του diff: θέση στο παλιό image μετά το seek, μετά τα extra bytes
+    const int64_t pos = (int64_t)old_pos_ + seek_;
+    if (pos < 0 || pos > (int64_t)header_.source_size) {
+      status_ = kCorrupt;
+      return;
+    }
+    old_pos_ = (uint32_t)pos;
+    seek_ = 0;
+    remaining_ = extra_len_;
+    extra_len_ = 0;
+    if (remaining_) state_ = kExtra;
+    else next_ctrl_();
+  }
+
+  void next_after_block_() {
+    if (state_ == kExtra) {
+      next_ctrl_();
+      return;
+    }
+    begin_block_();
+  }
+
+  // zeros: ίδια bytes με το παλιό image
+  bool copy_source_(uint32_t n) {
+    while (n) {
+      const size_t len = min_(n, sizeof(src_buf_));
+      if (!source_->read(old_pos_, src_buf_, len)) {
+        status_ = kSourceError;
+        return false;
+      }
+      if (!emit_(src_buf_, len)) return false;
+      old_pos_ += len;
+      n -= len;
+    }
+    return true;
+  }
+
+  // lits: new = old + diff
+  bool emit_diff_(const uint8_t* diff, size_t n) {
+    while (n) {
+      const size_t len = min_(n, sizeof(src_buf_));
+      if (!source_->read(old_pos_, src_buf_, len)) {
+        status_ = kSourceError;
+        return false;
+      }
+      for (size_t i = 0; i < len; i++) src_buf_[i] = (uint8_t)(src_buf_[i] + diff[i]);
+      if (!emit_(src_buf_, len)) return false;
+      old_pos_ += len;
+      diff += len;
+      n -= len;
+    }
+    return true;
+  }
+
+  bool emit_(const uint8_t* p, size_t n) {
+    while (n) {
+      const size_t take = min_(n, sizeof(out_buf_) - out_len_);
+      memcpy(out_buf_ + out_len_, p, take);
+      out_len_ += take;
+      p += take;
+      n -= take;
+      if (out_len_ == sizeof(out_buf_) && !flush_()) return false;
+    }
+    return true;
+  }
+
+  bool flush_() {
+    if (!out_len_) return true;
+    crc_ = ota_patch::crc32(crc_, out_buf_, out_len_);
+    if (!sink_->write(out_buf_, out_len_)) {
+      status_ = kSinkError;
+      return false;
+    }
+    written_ += out_len_;
+    out_len_ = 0;
+    return true;
+  }
+
+  void finish_() {
+    if (!flush_()) return;
+    status_ = crc_ == header_.target_crc && written_ == header_.target_size ? kDone : kBadTargetCrc;
+  }
+
+  OtaSource* source_ = nullptr;
+  OtaSink*   sink_ = nullptr;
+  uint32_t   source_limit_ = 0;
+  bool       check_source_ = true;
+  Status     status_ = kRunning;
+  State      state_ = kHeader;
+  ota_patch::Header header_ = {};
+  uint8_t    header_buf_[ota_patch::kHeaderBytes];
+  size_t     header_fill_ = 0;
+
+  uint32_t varint_ = 0;
+  uint8_t  varint_shift_ = 0;
+  uint8_t  ctrl_field_ = 0;
+  uint32_t diff_len_ = 0;
+  uint32_t extra_len_ = 0;
+  int32_t  seek_ = 0;
+  uint32_t diff_left_ = 0;
+  size_t   remaining_ = 0;
+  uint32_t old_pos_ = 0;
+
+  uint8_t  src_buf_[256];
+  uint8_t  out_buf_[4096];  // esp_ota_write γράφει καλύτερα σε ολόκληρα sectors
+  size_t   out_len_ = 0;
+  uint32_t written_ = 0;
+  uint32_t crc_ = 0;
+  uint32_t patch_bytes_ = 0;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdint.h>
+
+// ---------- Reconnect backoff ----------
+// Πότε να ξαναδοκιμάσει το firmware να συνδεθεί στον Signal K. Η πρώτη
+// προσπάθεια γίνεται σε κλάσματα του δευτερολέπτου και κάθε αποτυχία
+// διπλασιάζει το όριο μέχρι το max. Η καθυστέρηση είναι τυχαία στο [όριο/2,
+// όριο] (jitter), ώστε πολλές συσκευές μετά από ένα reboot του router ή
+// του server να μην ξαναχτυπάνε όλες μαζί.
+//
+// Μετράει προσπάθειες, επανασυνδέσεις και διάρκειες διακοπών. Το restart
+// αποφασίζεται από τη συνολική διάρκεια της διακοπής, όχι από τον αριθμό
+// των προσπαθειών. Χτίζεται και στο host.
+
+class ReconnectBackoff {
+ public:
+  struct Stats {
+    uint32_t attempts;           // από το boot
+    uint32_t reconnects;         // διακοπές που έληξαν με σύνδεση
+    uint32_t last_outage_ms;
+    uint32_t longest_outage_ms;
+  };
+
+  ReconnectBackoff(uint32_t base_ms, uint32_t max_ms) : base_ms_(base_ms), max_ms_(max_ms) {}
+
+  void seed(uint32_t s) { rng_ = s ? s : 0x9E3779B9u; }
+
+  // Η σύνδεση έπεσε (ή δεν έγινε ποτέ): επιστρέφει σε πόσο να γίνει η
+  // πρώτη προσπάθεια
+  uint32_t on_disconnected(uint32_t now_ms) {
+    if (!down_) {
+      down_ = true;
+      down_since_ms_ = now_ms;
+      attempt_ = 0;
+    }
+    return delay_();
+  }
+
+  // Μια προσπάθεια μόλις ξεκίνησε: επιστρέφει σε πόσο να γίνει η επόμενη
+  // αν ούτε αυτή πετύχει
+  uint32_t on_attempt() {
+    stats_.attempts++;
+    if (attempt_ < 31) attempt_++;
+    return delay_();
+  }
+
+  void on_connected(uint32_t now_ms) {
+    if (down_ && started_) {
+      stats_.reconnects++;
+      stats_.last_outage_ms = now_ms - down_since_ms_;
+      if (stats_.last_outage_ms > stats_.longest_outage_ms) {
+        stats_.longest_outage_ms = stats_.last_outage_ms;
+      }
+    }
+    started_ = true;  // η πρώτη σύνδεση μετά το boot δεν είναι επανασύνδεση
+    down_ = false;
+    attempt_ = 0;
+  }
+
+  bool down() const { return down_; }
+  uint32_t outage_ms(uint32_t now_ms) const { return down_ ? now_ms - down_since_ms_ : 0; }
+  uint8_t attempt() const { return attempt_; }
+  uint32_t last_delay_ms() const { return last_delay_ms_; }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  uint32_t delay_() {
+    uint32_t cap = max_ms_;
+    if (attempt_ < 31 && (base_ms_ << attempt_) >> attempt_ == base_ms_ &&
+        (base_ms_ << attempt_) < max_ms_) {
+      cap = base_ms_ << attempt_;
+    }
+    last_delay_ms_ = cap / 2 + next_() % (cap / 2 + 1);
+    return last_delay_ms_;
+  }
+
+  // xorshift32: αρκετό για jitter
+  uint32_t next_() {
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 17;
+    rng_ ^= rng_ << 5;
+    return rng_;
+  }
+
+  const uint32_t base_ms_;
+  const uint32_t max_ms_;
+  uint32_t rng_ = 0x9E3779B9u;
+  bool     down_ = false;
+  bool     started_ = false;
+  uint8_t  attempt_ = 0;
+  uint32_t down_since_ms_ = 0;
+  uint32_t last_delay_ms_ = 0;
+  Stats    stats_ = {};
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+
+// ---------- Scope ----------
+// Scope = αλυσίδα ÷ (βάθος + ύψος πλώρης). Το βάθος έρχεται από το Signal K
+// (environment.depth.belowSurface, ή belowKeel + βύθισμα) με τον ρυθμό του
+// sounder, η αλυσίδα αλλάζει σε κάθε παλμό. Γι' αυτό ό,τι εξαρτάται μόνο από
+// το βάθος υπολογίζεται όταν αλλάζει το φιλτραρισμένο βάθος, και ο παλμός
+// κοστίζει έναν πολλαπλασιασμό και μία αφαίρεση.
+
+// DepthFilter: median των τελευταίων kSamples δειγμάτων. Οι sounders βγάζουν
+// μεμονωμένα spikes (ψάρια, φυσαλίδες, χαμένος βυθός = 0) που ένας μέσος
+// όρος θα τραβούσε· το median τα αγνοεί και ακολουθεί την παλίρροια με
+// καθυστέρηση kSamples/2 δειγμάτων. Σταθερό ring, χωρίς δεσμεύσεις.
+//
+// Δύο πηγές: το belowSurface προτιμάται. Τα belowKeel (ήδη με το βύθισμα)
+// μετράνε μόνο αν δεν έχει έρθει belowSurface για kPreferMs. Αλλαγή πηγής
+// αδειάζει το ring (άλλη αναφορά, άλλο offset).
+class DepthFilter {
+ public:
+  static constexpr int      kSamples = 9;
+  static constexpr uint32_t kStaleMs = 30000;    // χωρίς δείγμα = άγνωστο βάθος
+  static constexpr uint32_t kPreferMs = 10000;
+  static constexpr float    kMaxDepthM = 200.0f;  // πέρα από αυτό δεν αγκυροβολεί κανείς
+
+  enum Source : uint8_t { kNone, kSurface, kKeel };
+
+  static const char* sourceName(Source s) {
+    switch (s) {
+      case kNone:    return "none";
+      case kSurface: return "belowSurface";
+      case kKeel:    return "belowKeel";
+    }
+    return "";
+  }
+
+  // true αν άλλαξε το φιλτραρισμένο βάθος
+  bool add(Source src, float depth_m, uint32_t now_ms) {
+    if (src == kSurface) surface_ms_ = now_ms;
+    if (src == kKeel && has_surface_ && now_ms - surface_ms_ < kPreferMs) return false;
+    if (src == kSurface) has_surface_ = true;
+    if (isnan(depth_m) || depth_m <= 0.0f || depth_m > kMaxDepthM) {
+      rejected_++;
+      return false;
+    }
+    if (src != source_) {
+      source_ = src;
+      n_ = 0;
+      head_ = 0;
+    }
+    ring_[head_] = depth_m;
+    head_ = (uint8_t)((head_ + 1) % kSamples);
+    if (n_ < kSamples) n_++;
+    last_ms_ = now_ms;
+    samples_++;
+
+    // Insertion sort σε αντίγραφο: ≤ 9 στοιχεία
+    float s[kSamples];
+    for (int i = 0; i < n_; i++) {
+      const float v = ring_[i];
+      int j = i;
+      while (j > 0 && s[j - 1] > v) {
+        s[j] = s[j - 1];
+        j--;
+      }
+      s[j] = v;
+    }
+    const float m = (n_ & 1) ? s[n_ / 2] : 0.5f * (s[n_ / 2 - 1] + s[n_ / 2]);
+    const bool changed = m != depth_;
+    depth_ = m;
+    return changed;
+  }
+
+  // NAN αν δεν υπάρχει πρόσφατο δείγμα
+  float depth_m(uint32_t now_ms) const {
+    if (n_ == 0 || now_ms - last_ms_ > kStaleMs) return NAN;
+    return depth_;
+  }
+
+  Source   source() const { return source_; }
+  uint32_t samples() const { return samples_; }
+  uint32_t rejected() const { return rejected_; }
+
+ private:
+  float    ring_[kSamples] = {};
+  float    depth_ = NAN;
+  uint32_t last_ms_ = 0;
+  uint32_t surface_ms_ = 0;
+  uint32_t samples_ = 0;
+  uint32_t rejected_ = 0;
+  uint8_t  n_ = 0;
+  uint8_t  head_ = 0;
+  Source   source_ = kNone;
+  bool     has_surface_ = false;
+};
+
+// ScopeCalc: ανά windlass (δικό του ύψος ράουλου και στόχος scope).
+// set_depth() όταν αλλάζει το βάθος, update() με κάθε μέτρηση αλυσίδας.
+// Χωρίς βάθος όλα είναι NAN.
+class ScopeCalc {
+ public:
+  void configure(float bow_height_m, float target_ratio) {
+    bow_height_m_ = bow_height_m < 0.0f ? 0.0f : bow_height_m;
+    target_ratio_ = target_ratio < 1.0f ? 1.0f : target_ratio;
+    recompute_();
+  }
+
+  void set_depth(float depth_m) {
+    if (depth_m == depth_m_ || (isnan(depth_m) && isnan(depth_m_))) return;
+    depth_m_ = depth_m;
+    recompute_();
+  }
+
+  void update(float chain_m) {
+    chain_m_ = chain_m;
+    if (isnan(inv_vertical_)) {
+      scope_ = NAN;
+      remaining_m_ = NAN;
+      return;
+    }
+    scope_ = chain_m * inv_vertical_;
+    const float r = recommended_m_ - chain_m;
+    remaining_m_ = r > 0.0f ? r : 0.0f;
+  }
+
+  float scope() const { return scope_; }
+  float recommended_m() const { return recommended_m_; }
+  float remaining_m() const { return remaining_m_; }
+  // Από τον βυθό ως το ράουλο: η κάθετη πλευρά της αλυσίδας (NAN = άγνωστη)
+  float vertical_m() const { return vertical_m_; }
+
+ private:
+  void recompute_() {
+    if (isnan(depth_m_)) {
+      vertical_m_ = NAN;
+      inv_vertical_ = NAN;
+      recommended_m_ = NAN;
+    } else {
+      vertical_m_ = depth_m_ + bow_height_m_;
+      inv_vertical_ = 1.0f / vertical_m_;
+      recommended_m_ = target_ratio_ * vertical_m_;
+    }
+    update(chain_m_);
+  }
+
+  float bow_height_m_ = 1.0f;
+  float target_ratio_ = 5.0f;
+  float depth_m_ = NAN;
+  float vertical_m_ = NAN;
+  float inv_vertical_ = NAN;
+  float recommended_m_ = NAN;
+  float chain_m_ = 0.0f;
+  float scope_ = NAN;
+  float remaining_m_ = NAN;
+};
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <atomic>
+
+#ifdef ARDUINO
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#else
+#include <thread>
+#endif
+
+// ---------- Single-writer seqlock ----------
+// Ο writer (π.χ. το motor task) δημοσιεύει ένα αντίγραφο του T χωρίς lock
+// και χωρίς να περιμένει ποτέ. Οι readers ξαναδιαβάζουν αν έπεσαν πάνω σε
+// εγγραφή (μονός αριθμός ή αλλαγμένο sequence). Τα δεδομένα κρατιούνται σε
+// atomic words, οπότε δεν υπάρχει data race ούτε στο host με std::thread.
+// Το T πρέπει να είναι trivially copyable.
+//
+// read() γυρίζει χωρίς όριο: μόνο όταν ο writer δεν μπορεί να διακοπεί από
+// τον reader (άλλος πυρήνας ή μεγαλύτερη προτεραιότητα, π.χ. το snapshot
+// του motor task). Ένας reader που μπορεί να προλάβει τον writer στη μέση
+// της εγγραφής στον ίδιο πυρήνα (web server πάνω από το loop task) θέλει
+// read_yielding(): αλλιώς γυρίζει για πάντα και ο writer δεν ξανατρέχει.
+template <typename T>
+class Seqlock {
+  static constexpr size_t kWords = (sizeof(T) + 3) / 4;
+
+ public:
+  Seqlock() {
+    for (size_t i = 0; i < kWords; i++) words_[i].store(0, std::memory_order_relaxed);
+  }
+
+  // Writer side only.
+  void write(const T& v) {
+    uint32_t tmp[kWords] = {};
+    memcpy(tmp, &v, sizeof(T));
+    const uint32_t s = seq_.load(std::memory_order_relaxed);
+    seq_.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWords; i++) words_[i].store(tmp[i], std::memory_order_relaxed);
+    seq_.store(s + 2, std::memory_order_release);
+  }
+
+  // One attempt; false if a write was in progress (the caller retries).
+  bool try_read(T& out) const {
+    const uint32_t s1 = seq_.load(std::memory_order_acquire);
+    if (s1 & 1) return false;
+    uint32_t tmp[kWords];
+    for (size_t i = 0; i < kWords; i++) tmp[i] = words_[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seq_.load(std::memory_order_relaxed) != s1) return false;
+    memcpy(&out, tmp, sizeof(T));
+    return true;
+  }
+
+  // Spins until a consistent copy is read. Only for readers the writer
+  // cannot be preempted by (see above).
+  void read(T& out) const {
+    while (!try_read(out)) {
+      retries_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // A few spins, then one tick of sleep between attempts so a preempted
+  // lower-priority writer can finish. false (out unchanged) after
+  // max_tries, about max_tries ms.
+  bool read_yielding(T& out, uint32_t max_tries = kYieldTries) const {
+    for (uint32_t i = 0; i < max_tries; i++) {
+      if (try_read(out)) return true;
+      retries_.fetch_add(1, std::memory_order_relaxed);
+      if (i >= kSpinTries) yield_();
+    }
+    return false;
+  }
+
+  // Even number of completed writes × 2; 0 before the first write.
+  uint32_t version() const { return seq_.load(std::memory_order_acquire); }
+  uint32_t retries() const { return retries_.load(std::memory_order_relaxed); }
+
+  static constexpr uint32_t kSpinTries = 8;
+  static constexpr uint32_t kYieldTries = kSpinTries + 100;
+
+ private:
+  static void yield_() {
+#ifdef ARDUINO
+    vTaskDelay(1);
+#else
+    std::this_thread::yield();
+#endif
+  }
+
+  std::atomic<uint32_t> seq_{0};
+  std::atomic<uint32_t> words_[kWords];
+  mutable std::atomic<uint32_t> retries_{0};
+};
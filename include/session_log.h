@@ -0,0 +1,332 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ---------- Anchoring session log ----------
+// Δυαδικό ημερολόγιο κινήσεων: έναρξη κάθε run (κατεύθυνση, μετρητής),
+// κάθε παλμός αλυσίδας με timestamp και το stop με τον λόγο του.
+//
+// Αποθήκευση: segments (αρχεία στο SPIFFS) των ~kSegmentBytes. Όταν
+// ξεπεραστούν τα kMaxSegments σβήνεται το παλαιότερο, οπότε ο χώρος είναι
+// φραγμένος. Κάθε segment αποκωδικοποιείται μόνο του:
+//
+//   header  : "ASL1" + u32 segment id (little endian)
+//   records : tag (low nibble = type, high nibble = dir) + payload
+//     kClock    varint uptime_ms, varint epoch_s (0 = άγνωστο), zigzag pulses
+//               (ο μετρητής πριν από την επόμενη εγγραφή)
+//     kRunStart zigzag dt_us, zigzag pulses
+//     kPulse    zigzag dt_us
+//     kStop     zigzag dt_us, zigzag pulses, u8 len, reason
+//
+// Οι χρόνοι είναι διαφορές micros() από την προηγούμενη εγγραφή (ένας
+// παλμός κοστίζει 3-4 bytes). Ένα kClock ανοίγει κάθε segment και
+// ξαναγράφεται μετά από κενό kResyncMs, πριν τυλίξει το micros().
+
+struct SessionEvent {
+  enum Type : uint8_t { kRunStart, kPulse, kStop };
+  Type        type;
+  uint8_t     dir;       // 1 = up, 2 = down (WindlassFsm::RunState)
+  int32_t     pulses;    // μετρητής μετά το event
+  uint32_t    t_us;      // micros() του event (για παλμό: του edge)
+  uint32_t    t_ms;      // millis() του event
+  const char* reason;    // kStop: string literal
+  uint8_t     channel;   // windlass channel: επιλέγει το log, δεν γράφεται
+};
+
+// Segment backend. Ids are increasing; a missing id reads as < 0.
+class SessionStore {
+ public:
+  virtual ~SessionStore() {}
+  // Oldest and newest segment ids; false if the log is empty.
+  virtual bool range(uint32_t& first, uint32_t& last) = 0;
+  virtual bool append(uint32_t id, const void* src, size_t len) = 0;
+  // Bytes read (0 at the end of the segment), < 0 if the segment is gone.
+  virtual int32_t read(uint32_t id, uint32_t offset, void* dst, size_t len) = 0;
+  virtual bool remove(uint32_t id) = 0;
+};
+
+namespace session_log {
+
+static constexpr uint8_t  kMagic[4] = {'A', 'S', 'L', '1'};
+static constexpr size_t   kHeaderBytes = 8;
+static constexpr uint32_t kResyncMs = 10UL * 60UL * 1000UL;  // << 71 λεπτά του micros()
+static constexpr size_t   kMaxReason = 31;
+
+enum Tag : uint8_t { kClock = 1, kRunStart = 2, kPulse = 3, kStop = 4 };
+
+inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+inline int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+inline size_t put_varint(uint8_t* p, uint32_t v) {
+  size_t n = 0;
+  while (v >= 0x80) {
+    p[n++] = (uint8_t)(v | 0x80);
+    v >>= 7;
+  }
+  p[n++] = (uint8_t)v;
+  return n;
+}
+
+// false αν τα bytes τελειώσουν ή το varint είναι πάνω από 5 bytes.
+inline bool get_varint(const uint8_t* p, size_t n, size_t& pos, uint32_t& out) {
+  uint32_t v = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    if (pos >= n) return false;
+    const uint8_t b = p[pos++];
+    v |= (uint32_t)(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      out = v;
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace session_log
+
+// Encoder + segment rotation. Single-threaded: ένα task κάνει append/flush.
+class SessionLogWriter {
+ public:
+  static constexpr uint32_t kSegmentBytes = 16 * 1024;
+  static constexpr uint32_t kMaxSegments = 16;       // 256 KiB συνολικά
+  static constexpr size_t   kBufferBytes = 256;      // ένα append στο store ανά γέμισμα
+  // header + kClock + το μεγαλύτερο record (kStop)
+  static constexpr size_t   kMaxRecordBytes =
+      session_log::kHeaderBytes + 16 + 12 + session_log::kMaxReason;
+
+  struct Stats {
+    uint32_t events;
+    uint32_t bytes;
+    uint32_t segments_opened;
+    uint32_t segments_evicted;
+    uint32_t write_errors;
+  };
+
+  // Κάθε begin() (δηλαδή κάθε boot) ανοίγει νέο segment. max_segments:
+  // το μερίδιο αυτού του log στο SPIFFS (όταν το μοιράζονται πολλά logs).
+  void begin(SessionStore* store, uint32_t max_segments = kMaxSegments) {
+    store_ = store;
+    max_segments_ = max_segments ? max_segments : 1;
+    stats_ = Stats();
+    len_ = 0;
+    has_count_ = false;
+    uint32_t first = 0, last = 0;
+    if (store_ && store_->range(first, last)) {
+      first_ = first;
+      seg_ = last + 1;
+    } else {
+      first_ = seg_ = 1;
+    }
+    open_ = false;
+  }
+
+  // Κωδικοποιεί ένα event στο buffer. epoch_s = 0 αν η ώρα είναι άγνωστη.
+  void append(const SessionEvent& ev, uint32_t epoch_s) {
+    if (!store_) return;
+    if (len_ + kMaxRecordBytes > kBufferBytes) flush();
+    if (!open_) open_segment_();
+    if (!has_clock_ || ev.t_ms - last_ms_ > session_log::kResyncMs) {
+      buf_[len_++] = session_log::kClock;
+      len_ += session_log::put_varint(buf_ + len_, ev.t_ms);
+      len_ += session_log::put_varint(buf_ + len_, epoch_s);
+      len_ += session_log::put_varint(buf_ + len_, session_log::zigzag(count_before_(ev)));
+      last_us_ = ev.t_us;
+      has_clock_ = true;
+    }
+    count_ = ev.pulses;
+    has_count_ = true;
+    last_ms_ = ev.t_ms;
+    const uint32_t dt = session_log::zigzag((int32_t)(ev.t_us - last_us_));
+    last_us_ = ev.t_us;
+    const uint8_t dir = (uint8_t)(ev.dir << 4);
+    switch (ev.type) {
+      case SessionEvent::kRunStart:
+        buf_[len_++] = session_log::kRunStart | dir;
+        len_ += session_log::put_varint(buf_ + len_, dt);
+        len_ += session_log::put_varint(buf_ + len_, session_log::zigzag(ev.pulses));
+        break;
+      case SessionEvent::kPulse:
+        buf_[len_++] = session_log::kPulse | dir;
+        len_ += session_log::put_varint(buf_ + len_, dt);
+        break;
+      case SessionEvent::kStop: {
+        buf_[len_++] = session_log::kStop | dir;
+        len_ += session_log::put_varint(buf_ + len_, dt);
+        len_ += session_log::put_varint(buf_ + len_, session_log::zigzag(ev.pulses));
+        size_t n = ev.reason ? strnlen(ev.reason, session_log::kMaxReason) : 0;
+        buf_[len_++] = (uint8_t)n;
+        memcpy(buf_ + len_, ev.reason, n);
+        len_ += n;
+        break;
+      }
+    }
+    stats_.events++;
+  }
+
+  // Γράφει ό,τι έχει το buffer και κλείνει το segment αν γέμισε.
+  void flush() {
+    if (!store_ || len_ == 0) return;
+    if (store_->append(seg_, buf_, len_)) {
+      seg_bytes_ += len_;
+      stats_.bytes += len_;
+    } else {
+      stats_.write_errors++;
+    }
+    len_ = 0;
+    if (seg_bytes_ >= kSegmentBytes) {
+      seg_++;
+      open_ = false;
+    }
+  }
+
+  size_t   buffered() const { return len_; }
+  uint32_t first_segment() const { return first_; }
+  uint32_t current_segment() const { return seg_; }
+  const Stats& stats() const { return stats_; }
+
+ private:
+  void open_segment_() {
+    // Πρώτα χώρος: το νέο segment δεν πρέπει να ξεπεράσει το όριο
+    while (seg_ - first_ >= max_segments_) {
+      store_->remove(first_++);
+      stats_.segments_evicted++;
+    }
+    memcpy(buf_ + len_, session_log::kMagic, 4);
+    for (int i = 0; i < 4; i++) buf_[len_ + 4 + i] = (uint8_t)(seg_ >> (8 * i));
+    len_ += session_log::kHeaderBytes;
+    seg_bytes_ = 0;
+    has_clock_ = false;
+    open_ = true;
+    stats_.segments_opened++;
+  }
+
+  // Ο μετρητής πριν από το ev: ο τελευταίος γνωστός, αλλιώς από τον ίδιο τον παλμό.
+  int32_t count_before_(const SessionEvent& ev) const {
+    if (has_count_) return count_;
+    if (ev.type != SessionEvent::kPulse) return ev.pulses;
+    const int32_t before = ev.pulses + (ev.dir == 2 ? -1 : 1);
+    return before < 0 ? 0 : before;
+  }
+
+  SessionStore* store_ = nullptr;
+  uint8_t  buf_[kBufferBytes];
+  size_t   len_ = 0;
+  uint32_t first_ = 1;
+  uint32_t seg_ = 1;
+  uint32_t seg_bytes_ = 0;
+  uint32_t max_segments_ = kMaxSegments;
+  bool     open_ = false;
+  bool     has_clock_ = false;
+  uint32_t last_us_ = 0;
+  uint32_t last_ms_ = 0;
+  int32_t  count_ = 0;
+  bool     has_count_ = false;
+  Stats    stats_ = Stats();
+};
+
+// Αποκωδικοποιεί ένα export (segments στη σειρά). Ό,τι δεν διαβάζεται
+// (μισογραμμένο τέλος segment) προσπερνιέται μέχρι το επόμενο header.
+class SessionDecoder {
+ public:
+  struct Record {
+    uint8_t  tag;        // session_log::Tag
+    uint8_t  dir;
+    uint32_t segment;
+    uint64_t t_us;       // από το uptime του τελευταίου kClock
+    uint32_t wall_s;     // epoch seconds από το τελευταίο kClock (0 = άγνωστο)
+    int32_t  pulses;     // kClock / kRunStart / kStop
+    char     reason[session_log::kMaxReason + 1];
+  };
+
+  SessionDecoder(const uint8_t* p, size_t n) : p_(p), n_(n) {}
+
+  bool next(Record& r) {
+    using namespace session_log;
+    for (;;) {
+      if (pos_ >= n_) return false;
+      if (at_header_()) {
+        segment_ = (uint32_t)p_[pos_ + 4] | (uint32_t)p_[pos_ + 5] << 8 |
+                   (uint32_t)p_[pos_ + 6] << 16 | (uint32_t)p_[pos_ + 7] << 24;
+        pos_ += kHeaderBytes;
+        in_segment_ = true;
+        has_clock_ = false;
+        continue;
+      }
+      if (!in_segment_ || !parse_(r)) {
+        skipped_++;
+        resync_();
+        continue;
+      }
+      return true;
+    }
+  }
+
+  uint32_t skipped() const { return skipped_; }
+
+ private:
+  bool at_header_() const {
+    return pos_ + session_log::kHeaderBytes <= n_ && memcmp(p_ + pos_, session_log::kMagic, 4) == 0;
+  }
+
+  void resync_() {
+    in_segment_ = false;
+    pos_++;
+    while (pos_ < n_ && !at_header_()) pos_++;
+  }
+
+  bool parse_(Record& r) {
+    using namespace session_log;
+    size_t pos = pos_;
+    const uint8_t tag = p_[pos++];
+    r.tag = tag & 0x0F;
+    r.dir = tag >> 4;
+    r.segment = segment_;
+    r.reason[0] = '\0';
+    uint32_t a, b, c;
+    if (r.tag == kClock) {
+      if (!get_varint(p_, n_, pos, a) || !get_varint(p_, n_, pos, b) ||
+          !get_varint(p_, n_, pos, c))
+        return false;
+      t_us_ = (uint64_t)a * 1000ULL;
+      clock_us_ = t_us_;
+      epoch_s_ = b;
+      has_clock_ = true;
+      r.pulses = unzigzag(c);
+    } else {
+      if (!has_clock_ || !get_varint(p_, n_, pos, a)) return false;
+      t_us_ += (int64_t)unzigzag(a);
+      r.pulses = 0;
+      if (r.tag == kRunStart || r.tag == kStop) {
+        if (!get_varint(p_, n_, pos, b)) return false;
+        r.pulses = unzigzag(b);
+      }
+      if (r.tag == kStop) {
+        if (pos >= n_) return false;
+        const size_t len = p_[pos++];
+        if (len > kMaxReason || pos + len > n_) return false;
+        memcpy(r.reason, p_ + pos, len);
+        r.reason[len] = '\0';
+        pos += len;
+      } else if (r.tag != kRunStart && r.tag != kPulse) {
+        return false;
+      }
+    }
+    r.t_us = t_us_;
+    r.wall_s = epoch_s_ ? epoch_s_ + (uint32_t)((t_us_ - clock_us_) / 1000000ULL) : 0;
+    pos_ = pos;
+    return true;
+  }
+
+  const uint8_t* p_;
+  size_t   n_;
+  size_t   pos_ = 0;
+  bool     in_segment_ = false;
+  bool     has_clock_ = false;
+  uint32_t segment_ = 0;
+  uint64_t t_us_ = 0;
+  uint64_t clock_us_ = 0;
+  uint32_t epoch_s_ = 0;
+  uint32_t skipped_ = 0;
+};
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// ---------- Signal K delta encoder ----------
+// Γράφει delta frames κατευθείαν σε προδεσμευμένο buffer - κανένα
+// JsonDocument, κανένα String, καμία δέσμευση στο heap ανά αποστολή.
+// Τα σταθερά κομμάτια (context, source label, path keys) συνενώνονται
+// στο compile time από string literals.
+
+#define SK_SOURCE_LABEL "signalk-anchoralarm-akat"
+#define SK_ANCHOR_PREFIX "sensors.akat.anchor."
+
+// Precomputed `{"path":"<path>","value":` key for a literal path.
+struct SkPath {
+  const char* key;
+  uint8_t     len;
+};
+#define SK_PATH_KEY(literal_path) \
+  SkPath { "{\"path\":\"" literal_path "\",\"value\":", sizeof("{\"path\":\"" literal_path "\",\"value\":") - 1 }
+#define SK_ANCHOR_PATH(leaf) SK_PATH_KEY(SK_ANCHOR_PREFIX leaf)
+
+// Keys για paths που ξέρουμε μόνο στο runtime (prefix ανά windlass channel).
+// Χτίζονται μία φορά στο boot και ζουν όσο το arena.
+template <size_t N>
+class SkPathArena {
+ public:
+  // prefix + leaf → SkPath. len = 0 όταν δεν χωράει.
+  SkPath make(const char* prefix, const char* leaf) {
+    SkPath p = {"", 0};
+    const size_t room = N - used_;
+    const int n = snprintf(buf_ + used_, room, "{\"path\":\"%s%s\",\"value\":", prefix, leaf);
+    if (n < 0 || (size_t)n >= room || n > 255) return p;
+    p.key = buf_ + used_;
+    p.len = (uint8_t)n;
+    used_ += (size_t)n + 1;
+    return p;
+  }
+  size_t used() const { return used_; }
+
+ private:
+  char   buf_[N];
+  size_t used_ = 0;
+};
+
+// ISO-8601 UTC timestamp, re-rendered only when the second changes.
+class SkTimestampCache {
+ public:
+  const char* render(time_t now) {
+    if (now == cached_at_ && buf_[0] != '\0') return buf_;
+    cached_at_ = now;
+    struct tm tm_info;
+    gmtime_r(&now, &tm_info);
+    char* p = buf_;
+    p = put_(p, tm_info.tm_year + 1900, 4); *p++ = '-';
+    p = put_(p, tm_info.tm_mon + 1, 2);     *p++ = '-';
+    p = put_(p, tm_info.tm_mday, 2);        *p++ = 'T';
+    p = put_(p, tm_info.tm_hour, 2);        *p++ = ':';
+    p = put_(p, tm_info.tm_min, 2);         *p++ = ':';
+    p = put_(p, tm_info.tm_sec, 2);         *p++ = 'Z';
+    *p = '\0';
+    renders_++;
+    return buf_;
+  }
+  uint32_t renders() const { return renders_; }
+
+  // Με χιλιοστά, για μεμονωμένα γεγονότα (ack εντολών): out >= kMsLen + 1.
+  static constexpr size_t kMsLen = 24;  // 2026-01-01T00:00:00.000Z
+  static const char* render_ms(char* out, time_t secs, uint32_t ms) {
+    struct tm tm_info;
+    gmtime_r(&secs, &tm_info);
+    char* p = out;
+    p = put_(p, tm_info.tm_year + 1900, 4); *p++ = '-';
+    p = put_(p, tm_info.tm_mon + 1, 2);     *p++ = '-';
+    p = put_(p, tm_info.tm_mday, 2);        *p++ = 'T';
+    p = put_(p, tm_info.tm_hour, 2);        *p++ = ':';
+    p = put_(p, tm_info.tm_min, 2);         *p++ = ':';
+    p = put_(p, tm_info.tm_sec, 2);         *p++ = '.';
+    p = put_(p, (int)(ms % 1000), 3);       *p++ = 'Z';
+    *p = '\0';
+    return out;
+  }
+
+ private:
+  static char* put_(char* p, int v, int digits) {
+    for (int i = digits - 1; i >= 0; i--) {
+      p[i] = (char)('0' + v % 10);
+      v /= 10;
+    }
+    return p + digits;
+  }
+  char     buf_[24] = {0};
+  time_t   cached_at_ = (time_t)-1;
+  uint32_t renders_ = 0;
+};
+
+template <size_t N>
+class SkDeltaEncoder {
+ public:
+  // Starts a frame: context, one update, optional source label, values array.
+  void begin(bool with_source = true) {
+    len_ = 0;
+    overflow_ = false;
+    first_value_ = true;
+    if (with_source) {
+      static constexpr char kHead[] =
+          "{\"context\":\"vessels.self\",\"updates\":[{\"source\":{\"label\":\"" SK_SOURCE_LABEL
+          "\"},\"values\":[";
+      raw_(kHead, sizeof(kHead) - 1);
+    } else {
+      static constexpr char kHead[] = "{\"context\":\"vessels.self\",\"updates\":[{\"values\":[";
+      raw_(kHead, sizeof(kHead) - 1);
+    }
+  }
+
+  void add(const SkPath& p, float v)       { key_(p); number_(v); close_value_(); }
+  void add(const SkPath& p, int32_t v)     { key_(p); integer_(v); close_value_(); }
+  void add(const SkPath& p, uint32_t v)    { key_(p); uinteger_(v); close_value_(); }
+  void add(const SkPath& p, bool v)        { key_(p); boolean_(v); close_value_(); }
+  void add(const SkPath& p, const char* v) { key_(p); string_(v); close_value_(); }
+
+  // Object value: begin_object(path), member()..., end_object().
+  void begin_object(const SkPath& p) {
+    key_(p);
+    ch_('{');
+    first_member_ = true;
+  }
+  void member(const char* name, uint32_t v) { member_key_(name); uinteger_(v); }
+  void member(const char* name, const char* v) {
+    member_key_(name);
+    if (v) string_(v);
+    else raw_("null", 4);
+  }
+  // Συντεταγμένες: σταθερά δεκαδικά (7 = ~1cm), NAN = null
+  void member_fixed(const char* name, double v, int decimals) {
+    member_key_(name);
+    if (isnan(v) || isinf(v)) {
+      raw_("null", 4);
+      return;
+    }
+    char tmp[32];
+    const int n = snprintf(tmp, sizeof(tmp), "%.*f", decimals, v);
+    if (n > 0) raw_(tmp, (size_t)n < sizeof(tmp) ? (size_t)n : sizeof(tmp) - 1);
+  }
+  // Έτοιμο JSON (π.χ. ένας σταθερός πίνακας)
+  void member_raw(const char* name, const char* json) {
+    member_key_(name);
+    raw_(json, strlen(json));
+  }
+  void end_object() { ch_('}'); close_value_(); }
+
+  // Runtime paths (not known at compile time).
+  void add(const char* path, float v)       { key_(path); number_(v); close_value_(); }
+  void add(const char* path, bool v)        { key_(path); boolean_(v); close_value_(); }
+  void add(const char* path, const char* v) { key_(path); string_(v); close_value_(); }
+
+  // Closes the frame. Returns nullptr if the buffer was too small.
+  const char* finish() {
+    raw_("]}]}", 4);
+    if (overflow_) return nullptr;
+    buf_[len_] = '\0';
+    frames_++;
+    bytes_ += len_;
+    return buf_;
+  }
+
+  const char* c_str() const { return buf_; }
+  size_t length() const { return len_; }
+  bool overflowed() const { return overflow_; }
+  bool empty() const { return first_value_; }
+  static constexpr size_t capacity() { return N - 1; }
+  // Bytes left before finish() would overflow (its closing included).
+  size_t remaining() const { return overflow_ || len_ + 4 > N - 1 ? 0 : N - 1 - len_ - 4; }
+
+  uint32_t frames() const { return frames_; }
+  uint32_t bytes() const { return bytes_; }
+
+ private:
+  void raw_(const char* s, size_t n) {
+    if (len_ + n > N - 1) {
+      overflow_ = true;
+      return;
+    }
+    memcpy(buf_ + len_, s, n);
+    len_ += n;
+  }
+  void ch_(char c) { raw_(&c, 1); }
+
+  void sep_() {
+    if (!first_value_) ch_(',');
+    first_value_ = false;
+  }
+  void key_(const SkPath& p) {
+    sep_();
+    raw_(p.key, p.len);
+  }
+  void key_(const char* path) {
+    sep_();
+    raw_("{\"path\":", 8);
+    string_(path);
+    raw_(",\"value\":", 9);
+  }
+  void close_value_() { ch_('}'); }
+  void member_key_(const char* name) {
+    if (!first_member_) ch_(',');
+    first_member_ = false;
+    string_(name);
+    ch_(':');
+  }
+
+  void boolean_(bool v) { v ? raw_("true", 4) : raw_("false", 5); }
+
+  void uinteger_(uint32_t v) {
+    char tmp[10];
+    int n = 0;
+    do {
+      tmp[n++] = (char)('0' + v % 10);
+      v /= 10;
+    } while (v);
+    while (n) ch_(tmp[--n]);
+  }
+  void integer_(int32_t v) {
+    if (v < 0) {
+      ch_('-');
+      uinteger_((uint32_t)(-(int64_t)v));
+    } else {
+      uinteger_((uint32_t)v);
+    }
+  }
+
+  // Up to 3 decimals, trailing zeros trimmed (ArduinoJson-like output).
+  void number_(float v) {
+    if (isnan(v) || isinf(v)) {
+      raw_("null", 4);
+      return;
+    }
+    if (fabsf(v) >= 4.0e6f) {
+      char tmp[24];
+      int n = snprintf(tmp, sizeof(tmp), "%g", (double)v);
+      if (n > 0) raw_(tmp, (size_t)n);
+      return;
+    }
+    if (v < 0) {
+      ch_('-');
+      v = -v;
+    }
+    uint32_t milli = (uint32_t)(v * 1000.0f + 0.5f);
+    uinteger_(milli / 1000);
+    uint32_t frac = milli % 1000;
+    if (frac == 0) return;
+    char d[3] = {(char)('0' + frac / 100), (char)('0' + frac / 10 % 10), (char)('0' + frac % 10)};
+    size_t n = 3;
+    while (n > 1 && d[n - 1] == '0') n--;
+    ch_('.');
+    raw_(d, n);
+  }
+
+  void string_(const char* s) {
+    ch_('"');
+    for (; s && *s; s++) {
+      const char c = *s;
+      if (c == '"' || c == '\\') {
+        ch_('\\');
+        ch_(c);
+      } else if ((unsigned char)c < 0x20) {
+        char esc[7];
+        snprintf(esc, sizeof(esc), "\\u%04x", (unsigned)c);
+        raw_(esc, 6);
+      } else {
+        ch_(c);
+      }
+    }
+    ch_('"');
+  }
+
+  char     buf_[N];
+  size_t   len_ = 0;
+  bool     overflow_ = false;
+  bool     first_value_ = true;
+  bool     first_member_ = true;
+  uint32_t frames_ = 0;
+  uint32_t bytes_ = 0;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+
+// ---------- Lock-free single-producer / single-consumer ring ----------
+// Ο producer είναι συνήθως ISR, ο consumer το loop task. Κανένα lock,
+// καμία δέσμευση μνήμης - μόνο δύο atomic μετρητές. Το N πρέπει να είναι
+// δύναμη του 2 ώστε το index να βγαίνει με mask.
+template <typename T, size_t N>
+class SpscRing {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+ public:
+  // Producer side only. Returns false (and counts an overflow) when full.
+  inline bool push(const T& v) __attribute__((always_inline)) {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    const uint32_t tail = tail_.load(std::memory_order_acquire);
+    if (head - tail >= N) {
+      overflows_.store(overflows_.load(std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+      return false;
+    }
+    buf_[head & (N - 1)] = v;
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side only.
+  inline bool pop(T& out) {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    const uint32_t head = head_.load(std::memory_order_acquire);
+    if (head == tail) return false;
+    out = buf_[tail & (N - 1)];
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t size() const {
+    return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+  }
+  bool empty() const { return size() == 0; }
+  static constexpr size_t capacity() { return N; }
+
+  // Total items rejected because the consumer fell behind.
+  uint32_t overflows() const { return overflows_.load(std::memory_order_relaxed); }
+
+  // Only safe while the producer is stopped (e.g. interrupt detached).
+  void clear() {
+    tail_.store(head_.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+ private:
+  T buf_[N];
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+  std::atomic<uint32_t> overflows_{0};
+};
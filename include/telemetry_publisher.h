@@ -0,0 +1,272 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "sk_delta_encoder.h"
+
+// ---------- Coalescing telemetry publisher ----------
+// Οι producers απλώς σημαδεύουν τιμές ως dirty. Το poll() μαζεύει ό,τι
+// εκκρεμεί σε ΕΝΑ delta frame ανά window_ms, παραλείπει τιμές που δεν
+// άλλαξαν από την τελευταία αποστολή και ξαναστέλνει κάθε τιμή το πολύ
+// κάθε keepalive_ms ώστε ο server να μη τη θεωρεί stale. Όταν φεύγει ένα
+// frame, τιμές που πλησιάζουν το keepalive τους (>= μισό) μπαίνουν κι αυτές,
+// ώστε τα keepalives να μη σκορπίζονται σε πολλά μικρά frames. Ό,τι δεν
+// χωράει στο frame (π.χ. όλες οι τιμές μετά από reconnect) φεύγει στο
+// αμέσως επόμενο poll.
+template <size_t Slots, size_t FrameN>
+class TelemetryPublisher {
+ public:
+  enum Kind : uint8_t { kFloat, kInt, kBool, kString, kTimestamp };
+  enum Flags : uint8_t {
+    kOnChange      = 0,
+    kKeepaliveOnly = 1,  // never sent just because it changed (counters, lastUpdate)
+    kManual        = 2,  // only sent when force()d (periodic snapshots)
+  };
+  static constexpr size_t kMaxString = 24;
+  // keepalive_ms του add() για τιμές που φεύγουν μόνο όταν αλλάζουν
+  static constexpr uint32_t kNoKeepalive = UINT32_MAX;
+
+  void configure(uint32_t window_ms, uint32_t keepalive_ms) {
+    window_ms_ = window_ms;
+    keepalive_ms_ = keepalive_ms;
+  }
+  uint32_t window_ms() const { return window_ms_; }
+  uint32_t keepalive_ms() const { return keepalive_ms_; }
+
+  // Registers a path. keepalive_ms = 0 uses the publisher default,
+  // kNoKeepalive sends it only on change.
+  // Returns its id, or -1 when all slots are taken.
+  int8_t add(const SkPath& path, Kind kind, uint8_t flags = kOnChange,
+             uint32_t keepalive_ms = 0) {
+    if (count_ >= Slots) return -1;
+    Slot& s = slots_[count_];
+    memset(&s, 0, sizeof(s));
+    s.path = path;
+    s.kind = kind;
+    s.flags = flags;
+    s.keepalive_ms = keepalive_ms;
+    return (int8_t)count_++;
+  }
+
+  // Setting the value it already holds is a no-op, so producers may call
+  // these on every pass.
+  void set_float(int8_t id, float v, bool urgent = false) {
+    if (!valid_(id) || (slots_[id].has_value && same_float_(slots_[id].cur.f, v))) return;
+    slots_[id].cur.f = v;
+    mark_(id, urgent);
+  }
+  void set_int(int8_t id, int32_t v, bool urgent = false) {
+    if (!valid_(id) || (slots_[id].has_value && slots_[id].cur.i == v)) return;
+    slots_[id].cur.i = v;
+    mark_(id, urgent);
+  }
+  void set_bool(int8_t id, bool v, bool urgent = false) {
+    if (!valid_(id) || (slots_[id].has_value && slots_[id].cur.b == v)) return;
+    slots_[id].cur.b = v;
+    mark_(id, urgent);
+  }
+  void set_string(int8_t id, const char* v, bool urgent = false) {
+    if (!valid_(id)) return;
+    if (slots_[id].has_value && strncmp(slots_[id].str, v ? v : "", kMaxString - 1) == 0) return;
+    strncpy(slots_[id].str, v ? v : "", kMaxString - 1);
+    slots_[id].str[kMaxString - 1] = '\0';
+    mark_(id, urgent);
+  }
+
+  // Send on the next flush even if unchanged.
+  void force(int8_t id, bool urgent = false) {
+    if (!valid_(id)) return;
+    slots_[id].forced = true;
+    schedule_(urgent);
+  }
+
+  // Everything is resent on the next poll (e.g. after a reconnect).
+  void invalidate() {
+    for (size_t i = 0; i < count_; i++) slots_[i].forced = true;
+    pending_ = true;
+    urgent_ = true;
+  }
+
+  // Builds and sends at most one frame. send(const char* frame, size_t len)
+  // is only called when there is something to say. Returns true if sent.
+  template <typename Send>
+  bool poll(uint32_t now_ms, time_t wall, Send&& send) {
+    last_poll_ms_ = now_ms;
+    const bool window_done = pending_ && (urgent_ || now_ms - first_mark_ms_ >= window_ms_);
+    if (!window_done && !keepalive_due_(now_ms)) return false;
+
+    enc_.begin();
+    bool more = false;
+    for (size_t i = 0; i < count_; i++) {
+      Slot& s = slots_[i];
+      const uint32_t ka = keepalive_of_(s);
+      const bool near_stale = ka && (!s.has_sent || now_ms - s.last_sent_ms >= ka / 2);
+      bool include = s.forced || near_stale;
+      if (!include && s.dirty && !(s.flags & (kKeepaliveOnly | kManual))) {
+        include = !s.has_sent || changed_(s);
+        if (!include) skipped_unchanged_++;
+      }
+      s.dirty = false;
+      if (!include) continue;
+      if (enc_.remaining() < worst_case_(s)) {
+        s.forced = true;
+        more = true;
+        continue;
+      }
+      encode_(s, wall);
+      s.forced = false;
+      s.has_sent = true;
+      s.last_sent_ms = now_ms;
+      s.sent = s.cur;
+      if (s.kind == kString) memcpy(s.sent_str, s.str, kMaxString);
+      values_sent_++;
+    }
+    pending_ = more;
+    urgent_ = more;
+
+    if (enc_.empty()) return false;
+    const char* frame = enc_.finish();
+    if (!frame) {
+      overflows_++;
+      return false;
+    }
+    frames_sent_++;
+    bytes_sent_ += enc_.length();
+    send(frame, enc_.length());
+    return true;
+  }
+
+  // How long until poll() has work to do (for callers that can sleep).
+  uint32_t ms_until_due(uint32_t now_ms) const {
+    uint32_t wait = UINT32_MAX;
+    if (pending_) {
+      if (urgent_) return 0;
+      const uint32_t elapsed = now_ms - first_mark_ms_;
+      wait = elapsed >= window_ms_ ? 0 : window_ms_ - elapsed;
+    }
+    for (size_t i = 0; i < count_; i++) {
+      const Slot& s = slots_[i];
+      const uint32_t ka = keepalive_of_(s);
+      if (!ka) continue;
+      if (!s.has_sent) return 0;
+      const uint32_t age = now_ms - s.last_sent_ms;
+      const uint32_t left = age >= ka ? 0 : ka - age;
+      if (left < wait) wait = left;
+    }
+    return wait;
+  }
+
+  uint32_t frames_sent() const { return frames_sent_; }
+  uint32_t bytes_sent() const { return bytes_sent_; }
+  uint32_t values_sent() const { return values_sent_; }
+  uint32_t marks() const { return marks_; }
+  uint32_t skipped_unchanged() const { return skipped_unchanged_; }
+  uint32_t overflows() const { return overflows_; }
+
+ private:
+  union Value {
+    float   f;
+    int32_t i;
+    bool    b;
+  };
+  struct Slot {
+    SkPath   path;
+    Kind     kind;
+    uint8_t  flags;
+    bool     dirty;
+    bool     forced;
+    bool     has_sent;
+    bool     has_value;
+    uint32_t last_sent_ms;
+    uint32_t keepalive_ms;
+    Value    cur;
+    Value    sent;
+    char     str[kMaxString];
+    char     sent_str[kMaxString];
+  };
+
+  bool valid_(int8_t id) const { return id >= 0 && (size_t)id < count_; }
+
+  // NAN (null στο Signal K) ίσο με NAN, αλλιώς θα ξαναστελνόταν κάθε φορά
+  static bool same_float_(float a, float b) { return a == b || (a != a && b != b); }
+
+  void mark_(int8_t id, bool urgent) {
+    slots_[id].has_value = true;
+    slots_[id].dirty = true;
+    marks_++;
+    // Keepalive-only values ride along with the next frame, never start one.
+    if (slots_[id].flags & (kKeepaliveOnly | kManual)) return;
+    schedule_(urgent);
+  }
+
+  void schedule_(bool urgent) {
+    if (!pending_) first_mark_ms_ = now_hint_();
+    pending_ = true;
+    if (urgent) urgent_ = true;
+  }
+
+  // The publisher does not own a clock; the window starts at the last poll
+  // time, which is at most one loop pass behind the real mark.
+  uint32_t now_hint_() const { return last_poll_ms_; }
+
+  uint32_t keepalive_of_(const Slot& s) const {
+    if ((s.flags & kManual) || s.keepalive_ms == kNoKeepalive) return 0;
+    return s.keepalive_ms ? s.keepalive_ms : keepalive_ms_;
+  }
+
+  bool keepalive_due_(uint32_t now_ms) const {
+    for (size_t i = 0; i < count_; i++) {
+      const Slot& s = slots_[i];
+      const uint32_t ka = keepalive_of_(s);
+      if (ka && (!s.has_sent || now_ms - s.last_sent_ms >= ka)) return true;
+    }
+    return false;
+  }
+
+  bool changed_(const Slot& s) const {
+    switch (s.kind) {
+      case kFloat:     return !same_float_(s.cur.f, s.sent.f);
+      case kInt:       return s.cur.i != s.sent.i;
+      case kBool:      return s.cur.b != s.sent.b;
+      case kString:    return strncmp(s.str, s.sent_str, kMaxString) != 0;
+      case kTimestamp: return true;
+    }
+    return true;
+  }
+
+  // Μέγιστο μήκος μιας τιμής στο frame: ',' + key + value + '}'
+  static size_t worst_case_(const Slot& s) {
+    return s.path.len + 2 + (s.kind == kString ? kMaxString * 6 + 2 : 24);
+  }
+
+  void encode_(const Slot& s, time_t wall) {
+    switch (s.kind) {
+      case kFloat:     enc_.add(s.path, s.cur.f); break;
+      case kInt:       enc_.add(s.path, s.cur.i); break;
+      case kBool:      enc_.add(s.path, s.cur.b); break;
+      case kString:    enc_.add(s.path, (const char*)s.str); break;
+      case kTimestamp: enc_.add(s.path, ts_cache_.render(wall)); break;
+    }
+  }
+
+  Slot             slots_[Slots];
+  size_t           count_ = 0;
+  SkDeltaEncoder<FrameN> enc_;
+  SkTimestampCache ts_cache_;
+
+  uint32_t window_ms_ = 250;
+  uint32_t keepalive_ms_ = 2000;
+  bool     pending_ = false;
+  bool     urgent_ = false;
+  uint32_t first_mark_ms_ = 0;
+  uint32_t last_poll_ms_ = 0;
+
+  uint32_t frames_sent_ = 0;
+  uint32_t bytes_sent_ = 0;
+  uint32_t values_sent_ = 0;
+  uint32_t marks_ = 0;
+  uint32_t skipped_unchanged_ = 0;
+  uint32_t overflows_ = 0;
+};
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ---------- Hierarchical timer wheel ----------
+// Τρία επίπεδα των 64 slots με tick kTickMs: 640ms, ~41s και ~43min.
+// Οι timers είναι intrusive (ο caller κατέχει τη μνήμη), οπότε schedule /
+// cancel είναι O(1) χωρίς δέσμευση μνήμης. Ένας timer που λήγει μακριά
+// κατεβαίνει επίπεδο (cascade) όταν το wheel περάσει από το slot του.
+// Το ms_until_next() λέει στο loop πόσο μπορεί να κοιμηθεί.
+
+struct WheelTimer {
+  void (*fn)(void* ctx) = nullptr;
+  void*       ctx = nullptr;
+  WheelTimer* next = nullptr;
+  WheelTimer* prev = nullptr;
+  uint32_t    expires = 0;  // σε ticks
+  uint8_t     level = 0;
+  bool        pending = false;
+
+  WheelTimer() {}
+  WheelTimer(void (*f)(void*), void* c) : fn(f), ctx(c) {}
+};
+
+class TimerWheel {
+ public:
+  static constexpr uint32_t kTickMs = 10;
+  static constexpr int      kBits = 6;
+  static constexpr uint32_t kSlots = 1u << kBits;
+  static constexpr int      kLevels = 3;
+  static constexpr uint32_t kMaxTicks = (1u << (kBits * kLevels)) - 1;
+
+  void begin(uint32_t now_ms) {
+    for (int l = 0; l < kLevels; l++) {
+      occupied_[l] = 0;
+      for (uint32_t i = 0; i < kSlots; i++) slots_[l][i] = nullptr;
+    }
+    now_tick_ = now_ms / kTickMs;
+    pending_ = 0;
+  }
+
+  // (Re)arms t to fire delay_ms from the last run() time. delay 0 fires on
+  // the next run().
+  void schedule(WheelTimer& t, uint32_t delay_ms) {
+    if (t.pending) unlink_(t);
+    uint32_t ticks = (delay_ms + kTickMs - 1) / kTickMs;
+    if (ticks > kMaxTicks) ticks = kMaxTicks;
+    t.expires = now_tick_ + ticks;
+    link_(t);
+  }
+
+  void cancel(WheelTimer& t) {
+    if (t.pending) unlink_(t);
+  }
+
+  // Fires every timer due at now_ms, in expiry order per tick. Callbacks
+  // may schedule or cancel any timer, including their own.
+  uint32_t run(uint32_t now_ms) {
+    const uint32_t target = now_ms / kTickMs;
+    uint32_t fired = 0;
+    while ((int32_t)(target - now_tick_) >= 0) {
+      // Τίποτα σε κανένα επίπεδο: πήδα κατευθείαν στο target
+      if (!pending_) {
+        now_tick_ = target + 1;
+        break;
+      }
+      const uint32_t idx = now_tick_ & (kSlots - 1);
+      if (idx == 0 && !cascade_(1)) cascade_(2);
+      WheelTimer* list = slots_[0][idx];
+      slots_[0][idx] = nullptr;
+      occupied_[0] &= ~(1ull << idx);
+      now_tick_++;
+      while (list) {
+        WheelTimer* t = list;
+        list = t->next;
+        t->next = t->prev = nullptr;
+        t->pending = false;
+        pending_--;
+        fired++;
+        if (t->fn) t->fn(t->ctx);
+      }
+    }
+    fired_ += fired;
+    return fired;
+  }
+
+  // How long the caller may sleep: the next level-0 expiry, or the next
+  // cascade boundary if that comes first. UINT32_MAX if nothing is pending.
+  uint32_t ms_until_next(uint32_t now_ms) const {
+    if (!pending_) return UINT32_MAX;
+    const uint32_t base = now_tick_;  // το επόμενο tick που θα τρέξει
+    uint32_t ticks = UINT32_MAX;
+    const int d0 = next_set_(occupied_[0], base & (kSlots - 1));
+    if (d0 >= 0) ticks = (uint32_t)d0;
+    // Timers των πάνω επιπέδων μπορεί να λήγουν αμέσως μετά το επόμενο
+    // cascade, πριν από όσους περιμένουν στο level 0
+    if (occupied_[1] | occupied_[2]) {
+      const uint32_t idx = base & (kSlots - 1);
+      const uint32_t boundary = idx ? kSlots - idx : 0;
+      if (boundary < ticks) ticks = boundary;
+    }
+    const uint32_t due_ms = (base + ticks) * kTickMs;
+    return (int32_t)(due_ms - now_ms) > 0 ? due_ms - now_ms : 0;
+  }
+
+  uint32_t pending() const { return pending_; }
+  uint32_t fired() const { return fired_; }
+
+ private:
+  void link_(WheelTimer& t) {
+    uint32_t delta = t.expires - now_tick_;
+    int level;
+    uint32_t idx;
+    if ((int32_t)delta < 0) {
+      delta = 0;
+      t.expires = now_tick_;
+    }
+    if (delta < kSlots) {
+      level = 0;
+      idx = t.expires & (kSlots - 1);
+    } else if (delta < (1u << (2 * kBits))) {
+      level = 1;
+      idx = (t.expires >> kBits) & (kSlots - 1);
+    } else {
+      level = 2;
+      idx = (t.expires >> (2 * kBits)) & (kSlots - 1);
+    }
+    WheelTimer*& head = slots_[level][idx];
+    t.prev = nullptr;
+    t.next = head;
+    if (head) head->prev = &t;
+    head = &t;
+    occupied_[level] |= 1ull << idx;
+    t.pending = true;
+    pending_++;
+    t.level = (uint8_t)level;
+  }
+
+  void unlink_(WheelTimer& t) {
+    const int level = t.level;
+    const uint32_t idx = level == 0 ? (t.expires & (kSlots - 1))
+                                    : (t.expires >> (kBits * level)) & (kSlots - 1);
+    if (t.prev) {
+      t.prev->next = t.next;
+    } else {
+      slots_[level][idx] = t.next;
+      if (!t.next) occupied_[level] &= ~(1ull << idx);
+    }
+    if (t.next) t.next->prev = t.prev;
+    t.next = t.prev = nullptr;
+    t.pending = false;
+    pending_--;
+  }
+
+  // Ξαναμοιράζει ένα slot του level στα χαμηλότερα. Επιστρέφει true αν το
+  // index του level δεν είναι 0 (άρα δεν χρειάζεται cascade από πάνω).
+  bool cascade_(int level) {
+    const uint32_t idx = (now_tick_ >> (kBits * level)) & (kSlots - 1);
+    WheelTimer* list = slots_[level][idx];
+    slots_[level][idx] = nullptr;
+    occupied_[level] &= ~(1ull << idx);
+    while (list) {
+      WheelTimer* t = list;
+      list = t->next;
+      pending_--;
+      link_(*t);
+    }
+    return idx != 0;
+  }
+
+  // Απόσταση (σε slots) από το from μέχρι το επόμενο occupied, -1 αν κανένα.
+  static int next_set_(uint64_t mask, uint32_t from) {
+    if (!mask) return -1;
+    const uint64_t rot = (mask >> from) | (from ? mask << (kSlots - from) : 0);
+    return __builtin_ctzll(rot);
+  }
+
+  WheelTimer* slots_[kLevels][kSlots] = {};
+  uint64_t    occupied_[kLevels] = {};
+  uint32_t    now_tick_ = 0;
+  uint32_t    pending_ = 0;
+  uint32_t    fired_ = 0;
+};
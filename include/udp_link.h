@@ -0,0 +1,647 @@
+#pragma once
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "loop_profiler.h"
+#include "motor_link.h"
+
+// ---------- UDP transport ----------
+// Δεύτερος δρόμος για τις εντολές και την κατάσταση του windlass, δίπλα
+// στο WebSocket του SensESP. Ένα datagram δεν περιμένει retransmission
+// ενός TCP stream που κόλλησε στο WiFi της μαρίνας: το stop φτάνει με το
+// πρώτο πακέτο που περνάει.
+//
+// Frame (little endian):
+//   0  'A' 'K'  version  type
+//   4  seq        αυξάνει σε κάθε frame του αποστολέα
+//   8  session    τυχαίο ανά client (ανά boot για τη συσκευή)
+//  12  payload
+//  ..  MAC        SipHash-2-4 (8 bytes) όλων των παραπάνω με το κοινό κλειδί
+//
+//   kHello    client → συσκευή, χωρίς payload. Γίνεται subscriber και
+//             παίρνει αμέσως kStatus με το nonce για τις εντολές του.
+//   kCommand  nonce u32, cmd_id u32, channel u8, op u8, arg u8, 0, value f32
+//   kAck      cmd_id u32, channel u8, op u8, result u8, state u8, flags u8,
+//             0 0 0, latency_us u32 (εντολή → ρελέ, αν flags & kAckActuated).
+//             kIgnored / kRefused: το motor task δεν εκτέλεσε την εντολή
+//             (debounce, ήδη σε αυτή την κίνηση / disabled, χωρίς Signal K).
+//             kOk με kAckQueued: η κίνηση ξεκινάει μετά το neutral delay.
+//   kStatus   uptime_ms u32, nonce u32, channels u8, flags u8, 0 0 και ανά
+//             channel: state u8, flags u8, 0 0, pulses i32, chain_out f32,
+//             target f32 (NaN = χωρίς), speed f32, current_ma i32
+//
+// Εντολές:
+//  - idempotent: ο client ξαναστέλνει με το ίδιο cmd_id (και νέο seq) μέχρι
+//    να πάρει ack. Ένα cmd_id που έχει ήδη δει η συσκευή δεν εκτελείται
+//    δεύτερη φορά, ξαναστέλνεται το ίδιο ack (kAckDuplicate).
+//  - replay: ανά client session το seq πρέπει να ανεβαίνει. Το nonce της
+//    εντολής είναι αυτό που έδωσε η συσκευή σε αυτό το session, οπότε ένα
+//    παλιό πακέτο άλλου session ή προηγούμενου boot απορρίπτεται.
+//  - χωρίς κλειδί (κενό passphrase) περνάει μόνο το status.
+//
+// Το WebSocket μένει ο έλεγχος σύνδεσης του motor task: μια κίνηση από
+// UDP χωρίς Signal K σταματάει όπως και πριν (safety:not_connected).
+// Η κλάση δεν ξέρει από sockets (send callback), χτίζεται και στο host.
+
+namespace udp_wire {
+
+inline void put_u32(uint8_t* p, uint32_t v) {
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+  p[2] = (uint8_t)(v >> 16);
+  p[3] = (uint8_t)(v >> 24);
+}
+inline void put_f32(uint8_t* p, float f) {
+  uint32_t v;
+  memcpy(&v, &f, 4);
+  put_u32(p, v);
+}
+inline uint32_t get_u32(const uint8_t* p) {
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+inline float get_f32(const uint8_t* p) {
+  const uint32_t v = get_u32(p);
+  float f;
+  memcpy(&f, &v, 4);
+  return f;
+}
+
+// SipHash-2-4: 64-bit MAC με 128-bit κλειδί, λίγες δεκάδες ns ανά frame
+inline uint64_t siphash(const uint8_t key[16], const uint8_t* p, size_t n) {
+  uint64_t k0 = 0, k1 = 0;
+  for (int i = 7; i >= 0; i--) {
+    k0 = k0 << 8 | key[i];
+    k1 = k1 << 8 | key[8 + i];
+  }
+  uint64_t v0 = 0x736f6d6570736575ULL ^ k0, v1 = 0x646f72616e646f6dULL ^ k1;
+  uint64_t v2 = 0x6c7967656e657261ULL ^ k0, v3 = 0x7465646279746573ULL ^ k1;
+#define UDP_SIPROUND                                                          \
+  do {                                                                        \
+    v0 += v1; v1 = v1 << 13 | v1 >> 51; v1 ^= v0; v0 = v0 << 32 | v0 >> 32;  \
+    v2 += v3; v3 = v3 << 16 | v3 >> 48; v3 ^= v2;                             \
+    v0 += v3; v3 = v3 << 21 | v3 >> 43; v3 ^= v0;                             \
+    v2 += v1; v1 = v1 << 17 | v1 >> 47; v1 ^= v2; v2 = v2 << 32 | v2 >> 32;  \
+  } while (0)
+  const size_t blocks = n / 8;
+  for (size_t b = 0; b < blocks; b++) {
+    uint64_t m = 0;
+    for (int i = 7; i >= 0; i--) m = m << 8 | p[b * 8 + i];
+    v3 ^= m;
+    UDP_SIPROUND;
+    UDP_SIPROUND;
+    v0 ^= m;
+  }
+  uint64_t last = (uint64_t)(n & 0xFF) << 56;
+  for (size_t i = 0; i < (n & 7); i++) last |= (uint64_t)p[blocks * 8 + i] << (8 * i);
+  v3 ^= last;
+  UDP_SIPROUND;
+  UDP_SIPROUND;
+  v0 ^= last;
+  v2 ^= 0xFF;
+  UDP_SIPROUND;
+  UDP_SIPROUND;
+  UDP_SIPROUND;
+  UDP_SIPROUND;
+#undef UDP_SIPROUND
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// Κλειδί από το passphrase του config (ίδιο στη συσκευή και στον client)
+inline void derive_key(const char* passphrase, uint8_t key[16]) {
+  static const uint8_t kSalt[16] = {'a', 'n', 'c', 'h', 'o', 'r', '-', 'u',
+                                    'd', 'p', '-', 'k', 'e', 'y', '-', '1'};
+  const size_t n = passphrase ? strlen(passphrase) : 0;
+  const uint64_t a = siphash(kSalt, reinterpret_cast<const uint8_t*>(passphrase), n);
+  uint8_t salt2[16];
+  memcpy(salt2, kSalt, 16);
+  salt2[15] = '2';
+  const uint64_t b = siphash(salt2, reinterpret_cast<const uint8_t*>(passphrase), n);
+  for (int i = 0; i < 8; i++) {
+    key[i] = (uint8_t)(a >> (8 * i));
+    key[8 + i] = (uint8_t)(b >> (8 * i));
+  }
+}
+
+}  // namespace udp_wire
+
+struct UdpFrame {
+  static constexpr uint8_t kVersion = 1;
+  static constexpr size_t  kHeaderLen = 12;
+  static constexpr size_t  kMacLen = 8;
+  static constexpr size_t  kCommandLen = 16;
+  static constexpr size_t  kAckLen = 16;
+  static constexpr size_t  kStatusLen = 12;
+  static constexpr size_t  kStatusChannelLen = 24;
+
+  enum Type : uint8_t { kHello = 1, kCommand, kAck, kStatus };
+  enum Op : uint8_t { kOpFsm = 1, kOpStop, kOpSetTarget, kOpSetChainOut, kOpResetCounter };
+  enum Result : uint8_t {
+    kOk, kBadChannel, kBadOp, kBusy, kUnauthorized, kBadNonce, kIgnored, kRefused
+  };
+  enum AckFlags : uint8_t { kAckActuated = 1, kAckDuplicate = 2, kAckQueued = 4 };
+  enum StatusFlags : uint8_t { kStWsConnected = 1, kStCommands = 2 };
+  enum ChannelFlags : uint8_t { kChRelaysOn = 1, kChHasTarget = 2 };
+
+  struct Header {
+    uint8_t  type;
+    uint32_t seq;
+    uint32_t session;
+  };
+  struct Command {
+    uint32_t nonce;
+    uint32_t cmd_id;
+    uint8_t  channel;
+    uint8_t  op;
+    uint8_t  arg;
+    float    value;
+  };
+  struct Ack {
+    uint32_t cmd_id;
+    uint8_t  channel;
+    uint8_t  op;
+    uint8_t  result;
+    uint8_t  state;
+    uint8_t  flags;
+    uint32_t latency_us;
+  };
+  struct ChannelStatus {
+    uint8_t state;
+    uint8_t flags;
+    int32_t pulses;
+    float   chain_out;
+    float   target;
+    float   speed;
+    int32_t current_ma;
+  };
+
+  static const char* resultName(uint8_t r) {
+    switch (r) {
+      case kOk:           return "ok";
+      case kBadChannel:   return "bad_channel";
+      case kBadOp:        return "bad_op";
+      case kBusy:         return "busy";
+      case kUnauthorized: return "unauthorized";
+      case kBadNonce:     return "bad_nonce";
+      case kIgnored:      return "ignored";
+      case kRefused:      return "refused";
+    }
+    return "?";
+  }
+
+  static size_t header(uint8_t* p, Type type, uint32_t seq, uint32_t session) {
+    p[0] = 'A';
+    p[1] = 'K';
+    p[2] = kVersion;
+    p[3] = type;
+    udp_wire::put_u32(p + 4, seq);
+    udp_wire::put_u32(p + 8, session);
+    return kHeaderLen;
+  }
+
+  // Προσθέτει το MAC, επιστρέφει το συνολικό μήκος
+  static size_t seal(const uint8_t key[16], uint8_t* p, size_t len) {
+    const uint64_t mac = udp_wire::siphash(key, p, len);
+    for (int i = 0; i < 8; i++) p[len + i] = (uint8_t)(mac >> (8 * i));
+    return len + kMacLen;
+  }
+
+  // Έλεγχος magic/version/MAC. Επιστρέφει το μήκος του payload ή -1.
+  static int open(const uint8_t key[16], const uint8_t* p, size_t len, Header& h) {
+    if (len < kHeaderLen + kMacLen || p[0] != 'A' || p[1] != 'K' || p[2] != kVersion) return -1;
+    const size_t body = len - kMacLen;
+    const uint64_t mac = udp_wire::siphash(key, p, body);
+    uint8_t diff = 0;
+    for (int i = 0; i < 8; i++) diff |= p[body + i] ^ (uint8_t)(mac >> (8 * i));
+    if (diff) return -1;
+    h.type = p[3];
+    h.seq = udp_wire::get_u32(p + 4);
+    h.session = udp_wire::get_u32(p + 8);
+    return (int)(body - kHeaderLen);
+  }
+
+  static size_t putCommand(uint8_t* p, const Command& c) {
+    udp_wire::put_u32(p, c.nonce);
+    udp_wire::put_u32(p + 4, c.cmd_id);
+    p[8] = c.channel;
+    p[9] = c.op;
+    p[10] = c.arg;
+    p[11] = 0;
+    udp_wire::put_f32(p + 12, c.value);
+    return kCommandLen;
+  }
+  static void getCommand(const uint8_t* p, Command& c) {
+    c.nonce = udp_wire::get_u32(p);
+    c.cmd_id = udp_wire::get_u32(p + 4);
+    c.channel = p[8];
+    c.op = p[9];
+    c.arg = p[10];
+    c.value = udp_wire::get_f32(p + 12);
+  }
+
+  static size_t putAck(uint8_t* p, const Ack& a) {
+    udp_wire::put_u32(p, a.cmd_id);
+    p[4] = a.channel;
+    p[5] = a.op;
+    p[6] = a.result;
+    p[7] = a.state;
+    p[8] = a.flags;
+    p[9] = p[10] = p[11] = 0;
+    udp_wire::put_u32(p + 12, a.latency_us);
+    return kAckLen;
+  }
+  static void getAck(const uint8_t* p, Ack& a) {
+    a.cmd_id = udp_wire::get_u32(p);
+    a.channel = p[4];
+    a.op = p[5];
+    a.result = p[6];
+    a.state = p[7];
+    a.flags = p[8];
+    a.latency_us = udp_wire::get_u32(p + 12);
+  }
+
+  static size_t putChannel(uint8_t* p, const ChannelStatus& s) {
+    p[0] = s.state;
+    p[1] = s.flags;
+    p[2] = p[3] = 0;
+    udp_wire::put_u32(p + 4, (uint32_t)s.pulses);
+    udp_wire::put_f32(p + 8, s.chain_out);
+    udp_wire::put_f32(p + 12, s.target);
+    udp_wire::put_f32(p + 16, s.speed);
+    udp_wire::put_u32(p + 20, (uint32_t)s.current_ma);
+    return kStatusChannelLen;
+  }
+  static void getChannel(const uint8_t* p, ChannelStatus& s) {
+    s.state = p[0];
+    s.flags = p[1];
+    s.pulses = (int32_t)udp_wire::get_u32(p + 4);
+    s.chain_out = udp_wire::get_f32(p + 8);
+    s.target = udp_wire::get_f32(p + 12);
+    s.speed = udp_wire::get_f32(p + 16);
+    s.current_ma = (int32_t)udp_wire::get_u32(p + 20);
+  }
+};
+
+// ---------- Device side ----------
+// Τρέχει σε ένα task (on_datagram/poll), γράφει εντολές στο udp_commands
+// κάθε channel και διαβάζει τα udp_acks και τα snapshots. Δεν αγγίζει τίποτα
+// από το loop task.
+class UdpLink {
+ public:
+  static constexpr int      kMaxChannels = 4;
+  static constexpr int      kMaxPeers = 4;
+  static constexpr int      kDedupe = 16;           // τελευταίες εντολές (idempotency)
+  static constexpr uint32_t kPeerTimeoutMs = 10000; // χωρίς frame τόσο = όχι subscriber
+  static constexpr uint32_t kStatusRunMs = 100;     // όσο κινείται κάποιο channel
+  static constexpr uint32_t kStatusIdleMs = 1000;
+  static constexpr uint32_t kAckPollMs = 2;         // όσο περιμένει ack από το motor task
+  static constexpr uint32_t kLatencyUnitsPerUs = 16;
+  static constexpr size_t   kMaxFrame = UdpFrame::kHeaderLen + UdpFrame::kStatusLen +
+                                        kMaxChannels * UdpFrame::kStatusChannelLen +
+                                        UdpFrame::kMacLen;
+
+  struct Stats {
+    uint32_t rx;          // έγκυρα frames
+    uint32_t bad;         // MAC/μορφή
+    uint32_t replayed;    // παλιό seq στο ίδιο session
+    uint32_t commands;    // εκτελέστηκαν
+    uint32_t duplicates;  // ίδιο cmd_id, ξανά το ack
+    uint32_t rejected;    // channel/op/nonce/κλειδί
+    uint32_t busy;        // γεμάτο mailbox, ο client ξαναστέλνει
+    uint32_t not_run;     // το motor task την αγνόησε ή την απέρριψε
+    uint32_t acks;
+    uint32_t status;
+  };
+
+  typedef void (*SendFn)(void* ctx, uint32_t addr, uint16_t port, const uint8_t* p, size_t n);
+  typedef void (*NotifyFn)(void* ctx);   // μετά από κάθε εντολή (ξυπνάει το motor task)
+  typedef uint32_t (*RandomFn)();
+
+  void begin(const uint8_t key[16], bool commands, MotorLink* const* links, int channels,
+             SendFn send, NotifyFn notify, RandomFn random, void* ctx) {
+    memcpy(key_, key, 16);
+    commands_ = commands;
+    channels_ = channels < kMaxChannels ? channels : kMaxChannels;
+    for (int i = 0; i < channels_; i++) links_[i] = links[i];
+    send_ = send;
+    notify_ = notify;
+    random_ = random;
+    ctx_ = ctx;
+    session_ = random_();
+  }
+
+  void on_datagram(uint32_t addr, uint16_t port, const uint8_t* p, size_t n, uint32_t now_ms) {
+    UdpFrame::Header h;
+    const int len = UdpFrame::open(key_, p, n, h);
+    if (len < 0) {
+      stats_.bad++;
+      return;
+    }
+    Peer* peer = peer_(addr, port, h.session, now_ms);
+    if (!peer->fresh && (int32_t)(h.seq - peer->last_seq) <= 0) {
+      stats_.replayed++;
+      return;
+    }
+    peer->fresh = false;
+    peer->last_seq = h.seq;
+    peer->heard_ms = now_ms;
+    stats_.rx++;
+    const uint8_t* body = p + UdpFrame::kHeaderLen;
+    switch (h.type) {
+      case UdpFrame::kHello:
+        sendStatus_(peer, now_ms);
+        break;
+      case UdpFrame::kCommand:
+        if (len < (int)UdpFrame::kCommandLen) {
+          stats_.bad++;
+          break;
+        }
+        UdpFrame::Command c;
+        UdpFrame::getCommand(body, c);
+        onCommand_(*peer, c);
+        break;
+      default:
+        stats_.bad++;
+        break;
+    }
+  }
+
+  // Acks από το motor task και status στους subscribers
+  void poll(uint32_t now_ms, bool ws_connected) {
+    ws_connected_ = ws_connected;
+    for (int ch = 0; ch < channels_; ch++) {
+      CommandAck a;
+      while (links_[ch]->udp_acks.pop(a)) onMotorAck_(a);
+    }
+    if ((int32_t)(now_ms - next_status_ms_) < 0) return;
+    bool running = false;
+    for (int ch = 0; ch < channels_; ch++) {
+      MotorSnapshot s;
+      links_[ch]->snapshot.read(s);
+      running |= s.relays_on;
+    }
+    next_status_ms_ = now_ms + (running ? kStatusRunMs : kStatusIdleMs);
+    for (int i = 0; i < kMaxPeers; i++) {
+      Peer& peer = peers_[i];
+      if (!peer.used) continue;
+      if (now_ms - peer.heard_ms > kPeerTimeoutMs) {
+        peer.used = false;
+        continue;
+      }
+      sendStatus_(&peer, now_ms);
+    }
+  }
+
+  // Πόσο μπορεί να μπλοκάρει το recv πριν χρειαστεί poll()
+  uint32_t ms_until_due(uint32_t now_ms) const {
+    if (pending_) return kAckPollMs;
+    const int32_t left = (int32_t)(next_status_ms_ - now_ms);
+    return left > 0 ? (uint32_t)left : 0;
+  }
+
+  uint32_t session() const { return session_; }
+  int peers() const {
+    int n = 0;
+    for (int i = 0; i < kMaxPeers; i++) n += peers_[i].used;
+    return n;
+  }
+  const Stats& stats() const { return stats_; }
+  // Εντολή → ρελέ για τις εντολές από UDP, σε 1/kLatencyUnitsPerUs us
+  const LatencyHistogram& latency() const { return latency_; }
+
+ private:
+  struct Peer {
+    bool     used;
+    bool     fresh;      // πρώτο frame του session, το seq δεν συγκρίνεται
+    uint32_t addr;
+    uint16_t port;
+    uint32_t session;
+    uint32_t nonce;      // δίνεται με το status, το επιστρέφουν οι εντολές
+    uint32_t last_seq;
+    uint32_t heard_ms;
+  };
+
+  struct Recent {
+    bool     used;
+    bool     pending;    // περιμένει το ack του motor task
+    uint32_t addr;
+    uint16_t port;
+    uint32_t session;
+    uint32_t internal_id;
+    UdpFrame::Ack ack;
+  };
+
+  // Νέο session από την ίδια διεύθυνση αντικαθιστά το παλιό. Γεμάτος
+  // πίνακας: φεύγει ο client που ακούστηκε παλαιότερα.
+  Peer* peer_(uint32_t addr, uint16_t port, uint32_t session, uint32_t now_ms) {
+    Peer* slot = nullptr;
+    for (int i = 0; i < kMaxPeers; i++) {
+      Peer& p = peers_[i];
+      if (p.used && p.addr == addr && p.port == port) {
+        if (p.session == session) return &p;
+        slot = &p;
+        break;
+      }
+    }
+    for (int i = 0; !slot && i < kMaxPeers; i++) {
+      if (!peers_[i].used) slot = &peers_[i];
+    }
+    if (!slot) {
+      slot = &peers_[0];
+      for (int i = 1; i < kMaxPeers; i++) {
+        if (now_ms - peers_[i].heard_ms > now_ms - slot->heard_ms) slot = &peers_[i];
+      }
+    }
+    slot->used = true;
+    slot->fresh = true;
+    slot->addr = addr;
+    slot->port = port;
+    slot->session = session;
+    slot->nonce = random_() | 1;
+    slot->last_seq = 0;
+    slot->heard_ms = now_ms;
+    return slot;
+  }
+
+  Recent* findRecent_(const Peer& peer, uint32_t cmd_id) {
+    for (int i = 0; i < kDedupe; i++) {
+      Recent& r = recent_[i];
+      if (r.used && r.ack.cmd_id == cmd_id && r.session == peer.session && r.addr == peer.addr &&
+          r.port == peer.port) {
+        return &r;
+      }
+    }
+    return nullptr;
+  }
+
+  void onCommand_(const Peer& peer, const UdpFrame::Command& c) {
+    if (Recent* r = findRecent_(peer, c.cmd_id)) {
+      stats_.duplicates++;
+      if (r->pending) return;  // το ack φεύγει μόλις έρθει
+      UdpFrame::Ack a = r->ack;
+      a.flags |= UdpFrame::kAckDuplicate;
+      sendAck_(peer.addr, peer.port, a);
+      return;
+    }
+    UdpFrame::Ack a = {};
+    a.cmd_id = c.cmd_id;
+    a.channel = c.channel;
+    a.op = c.op;
+    MotorCommand m;
+    if (!commands_) {
+      a.result = UdpFrame::kUnauthorized;
+    } else if (c.nonce != peer.nonce) {
+      a.result = UdpFrame::kBadNonce;
+    } else if (c.channel >= channels_) {
+      a.result = UdpFrame::kBadChannel;
+    } else if (!toMotor_(c, m)) {
+      a.result = UdpFrame::kBadOp;
+    } else {
+      m.id = 0x80000000u | (next_id_++ & 0x7FFFFFFFu);
+      if (!links_[c.channel]->udp_commands.push(m)) {
+        a.result = UdpFrame::kBusy;
+        stats_.busy++;
+      } else {
+        if (notify_) notify_(ctx_);
+        stats_.commands++;
+        Recent& r = recent_[next_recent_];
+        next_recent_ = (next_recent_ + 1) % kDedupe;
+        if (r.used && r.pending) pending_--;
+        r.used = true;
+        r.pending = true;
+        r.addr = peer.addr;
+        r.port = peer.port;
+        r.session = peer.session;
+        r.internal_id = m.id;
+        r.ack = a;
+        pending_++;
+        return;
+      }
+    }
+    if (a.result != UdpFrame::kBusy) stats_.rejected++;
+    sendAck_(peer.addr, peer.port, a);
+  }
+
+  static bool toMotor_(const UdpFrame::Command& c, MotorCommand& m) {
+    MotorCommand::Type type;
+    uint8_t arg = 0;
+    float value = 0.0f;
+    const char* reason = nullptr;
+    switch (c.op) {
+      case UdpFrame::kOpFsm:
+        if (c.arg >= WindlassFsm::kCmdUnknown) return false;
+        type = MotorCommand::kFsm;
+        arg = c.arg;
+        break;
+      case UdpFrame::kOpStop:
+        type = MotorCommand::kStop;
+        reason = "idle:udp";
+        break;
+      case UdpFrame::kOpSetTarget:
+        type = MotorCommand::kSetTarget;
+        value = c.value;
+        break;
+      case UdpFrame::kOpSetChainOut:
+        if (isnan(c.value)) return false;
+        type = MotorCommand::kSetChainOut;
+        arg = 1;  // save
+        value = c.value;
+        break;
+      case UdpFrame::kOpResetCounter:
+        type = MotorCommand::kResetCounter;
+        break;
+      default:
+        return false;
+    }
+    m = MotorLink::make(type, arg, value, reason, MotorCommand::kSrcUdp);
+    return true;
+  }
+
+  void onMotorAck_(const CommandAck& ca) {
+    for (int i = 0; i < kDedupe; i++) {
+      Recent& r = recent_[i];
+      if (!r.used || !r.pending || r.internal_id != ca.id) continue;
+      r.pending = false;
+      pending_--;
+      r.ack.result = resultOf_(ca.outcome);
+      if (r.ack.result != UdpFrame::kOk) stats_.not_run++;
+      r.ack.state = (uint8_t)ca.state;
+      r.ack.flags = (ca.actuated ? UdpFrame::kAckActuated : 0) |
+                    (ca.outcome == WindlassCore::kOutcomeQueued ? UdpFrame::kAckQueued : 0);
+      r.ack.latency_us = ca.actuated ? ca.actuated_us - ca.received_us : 0;
+      if (ca.actuated) latency_.record(r.ack.latency_us * kLatencyUnitsPerUs);
+      sendAck_(r.addr, r.port, r.ack);
+      return;
+    }
+  }
+
+  static UdpFrame::Result resultOf_(WindlassCore::Outcome o) {
+    switch (o) {
+      case WindlassCore::kOutcomeDone:
+      case WindlassCore::kOutcomeQueued:  return UdpFrame::kOk;
+      case WindlassCore::kOutcomeIgnored: return UdpFrame::kIgnored;
+      case WindlassCore::kOutcomeRefused: return UdpFrame::kRefused;
+    }
+    return UdpFrame::kRefused;
+  }
+
+  void sendAck_(uint32_t addr, uint16_t port, const UdpFrame::Ack& a) {
+    uint8_t buf[UdpFrame::kHeaderLen + UdpFrame::kAckLen + UdpFrame::kMacLen];
+    size_t n = UdpFrame::header(buf, UdpFrame::kAck, ++seq_, session_);
+    n += UdpFrame::putAck(buf + n, a);
+    n = UdpFrame::seal(key_, buf, n);
+    send_(ctx_, addr, port, buf, n);
+    stats_.acks++;
+  }
+
+  void sendStatus_(Peer* peer, uint32_t now_ms) {
+    uint8_t buf[kMaxFrame];
+    size_t n = UdpFrame::header(buf, UdpFrame::kStatus, ++seq_, session_);
+    udp_wire::put_u32(buf + n, now_ms);
+    udp_wire::put_u32(buf + n + 4, peer->nonce);
+    buf[n + 8] = (uint8_t)channels_;
+    buf[n + 9] = (ws_connected_ ? UdpFrame::kStWsConnected : 0) |
+                 (commands_ ? UdpFrame::kStCommands : 0);
+    buf[n + 10] = buf[n + 11] = 0;
+    n += UdpFrame::kStatusLen;
+    for (int ch = 0; ch < channels_; ch++) {
+      MotorSnapshot s;
+      links_[ch]->snapshot.read(s);
+      UdpFrame::ChannelStatus cs;
+      cs.state = (uint8_t)s.state;
+      cs.flags = (s.relays_on ? UdpFrame::kChRelaysOn : 0) |
+                 (s.has_target ? UdpFrame::kChHasTarget : 0);
+      cs.pulses = s.chain_pulse_count;
+      cs.chain_out = s.chain_out_meters;
+      cs.target = s.has_target ? s.chain_target_m : NAN;
+      cs.speed = s.chain_speed;
+      cs.current_ma = s.current_ma;
+      n += UdpFrame::putChannel(buf + n, cs);
+    }
+    n = UdpFrame::seal(key_, buf, n);
+    send_(ctx_, peer->addr, peer->port, buf, n);
+    stats_.status++;
+  }
+
+  uint8_t    key_[16] = {};
+  bool       commands_ = false;
+  bool       ws_connected_ = false;
+  int        channels_ = 0;
+  MotorLink* links_[kMaxChannels] = {};
+  SendFn     send_ = nullptr;
+  NotifyFn   notify_ = nullptr;
+  RandomFn   random_ = nullptr;
+  void*      ctx_ = nullptr;
+  uint32_t   session_ = 0;
+  uint32_t   seq_ = 0;
+  uint32_t   next_id_ = 1;
+  uint32_t   next_status_ms_ = 0;
+  Peer       peers_[kMaxPeers] = {};
+  Recent     recent_[kDedupe] = {};
+  int        next_recent_ = 0;
+  int        pending_ = 0;
+  Stats      stats_ = {};
+  LatencyHistogram latency_ = {};
+};
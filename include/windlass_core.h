@@ -0,0 +1,652 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <math.h>
+
+#include <atomic>
+
+#include "anchor_hal.h"
+#include "chain_motion.h"
+#include "chain_pulse_filter.h"
+#include "current_monitor.h"
+#include "session_log.h"
+#include "spsc_ring.h"
+#include "windlass_fsm.h"
+
+// Όλες οι ρυθμίσεις του πυρήνα σε ένα trivially copyable struct, ώστε να
+// περνάνε στο motor task ολόκληρες (Seqlock) αντί για πεδίο-πεδίο.
+struct WindlassConfig {
+  int   relay_up_pin;
+  int   relay_down_pin;
+  bool  relays_active_high;
+  bool  enabled;
+  bool  chain_sensor_pullup;
+  bool  chain_filter_adaptive;
+  float default_chain_seconds;
+  int   neutral_ms;
+  int   chain_sensor_pin;
+  float chain_calibration;
+  float coast_down_m;
+  float coast_up_m;
+  int   current_sensor_pin;
+  int   current_zero;
+  float current_ma_per_count;
+  float stall_current_a;
+  float overload_current_a;
+};
+
+// ---------- Windlass core: relays, timers, chain counter ----------
+// Όλη η λογική που κινεί το μοτέρ, χωρίς SensESP/Signal K. Μιλάει με το
+// υλικό μόνο μέσω του hal::, οπότε χτίζεται και στο host. Ο
+// AnchorController προσθέτει από πάνω config, Signal K και telemetry
+// μέσα από τα virtual hooks. Οι εντολές περνούν από τον πίνακα του
+// WindlassFsm (handleCommand).
+class WindlassCore : public WindlassFsm {
+ public:
+  virtual ~WindlassCore() {}
+
+  // Τι έγινε με μια εντολή (στο ack της)
+  enum Outcome : uint8_t {
+    kOutcomeDone,     // εφαρμόστηκε, ή η κατάσταση ήταν ήδη αυτή (idle σε idle)
+    kOutcomeQueued,   // η κίνηση ξεκινάει μετά το neutral delay
+    kOutcomeIgnored,  // debounce, ήδη σε αυτή την κίνηση, άγνωστη εντολή
+    kOutcomeRefused,  // windlass disabled ή χωρίς σύνδεση (MotorDriver)
+  };
+  static const char* outcomeName(Outcome o) {
+    switch (o) {
+      case kOutcomeDone:    return "done";
+      case kOutcomeQueued:  return "queued";
+      case kOutcomeIgnored: return "ignored";
+      case kOutcomeRefused: return "refused";
+    }
+    return "?";
+  }
+
+  // Configuration (visible in UI)
+  int  relay_up_pin        = 26;
+  int  relay_down_pin      = 27;
+  bool relays_active_high  = true;
+  bool enabled             = true;
+  float default_chain_seconds = 5.0f;
+  int   neutral_ms            = 400;
+
+  // Chain counter configuration
+  int  chain_sensor_pin    = 25;       // GPIO για την μαγνητική επαφή
+  bool chain_sensor_pullup = true;     // Ενεργοποίηση εσωτερικού pull-up
+  float chain_calibration  = 1.0f;     // Μέτρα ανά παλμό (συνήθως 1 μέτρο/κρίκος)
+  bool chain_filter_adaptive = true;   // Adaptive period tracker αντί για σταθερό debounce
+
+  // Chain counter state
+  float chain_out_meters   = 0.0f;     // Πόσα μέτρα αλυσίδα έχουν βγει
+  int   chain_pulse_count  = 0;        // Μετρητής παλμών
+  const unsigned long pulse_debounce_ms = 150; // Debounce 150ms (αυξημένο)
+
+  // Interrupt capture: το ISR γράφει timestamps, το tick() τα αδειάζει
+  SpscRing<ChainEdge, 64> chain_edges_;
+  FixedPulseFilter    fixed_filter_;
+  AdaptivePulseFilter adaptive_filter_;
+  PulseFilter*        pulse_filter_ = &adaptive_filter_;
+  int      attached_sensor_pin_ = -1;
+  uint32_t reported_edge_overflows_ = 0;
+  uint32_t reported_pulse_rejects_ = 0;
+  // Ξυπνάει τον consumer μετά από κάθε edge (καλείται μέσα στο ISR)
+  void   (*edge_notify_)(void* ctx) = nullptr;
+  void*    edge_notify_ctx_ = nullptr;
+
+  // Ρεύμα μοτέρ: ο sampler (esp_timer, kSampleHz) γράφει raw ADC counts,
+  // το tickCore_() τα περνάει από το CurrentMonitor. -1 = χωρίς αισθητήρα.
+  int   current_sensor_pin   = -1;     // ADC1 GPIO (32-39), το ADC2 το κρατάει το WiFi
+  int   current_zero         = 2048;   // counts στα 0A
+  float current_ma_per_count = 100.0f; // ±200A αισθητήρας σε 0-3.3V / 12 bit
+  float stall_current_a      = 120.0f; // 0 = χωρίς stall cutoff
+  float overload_current_a   = 180.0f; // 0 = χωρίς overload cutoff
+  SpscRing<uint16_t, 128> current_samples_;
+  CurrentMonitor current_;
+  std::atomic<int> current_adc_pin_{-1};  // ό,τι διαβάζει ο sampler
+  uint32_t current_trips_[3] = {};        // ανά CurrentMonitor::Trip
+  uint32_t reported_sample_overflows_ = 0;
+
+  // Target length: αυτόματο stop όταν η αλυσίδα (μαζί με το coast) φτάσει
+  // το chain_target_m. NAN = χωρίς στόχο. Ισχύει για μία κίνηση.
+  float    chain_target_m = NAN;
+  RunState target_dir_ = IDLE;     // κατεύθυνση προς τον στόχο
+  ChainSpeedEstimator chain_speed_;
+  CoastLearner        coast_;
+  bool     target_stop_eval_ = false;
+  float    target_stop_at_m_ = 0.0f;
+  uint32_t target_stops_ = 0;
+  float    last_target_error_m_ = NAN; // τελική θέση - στόχος μετά το coast
+
+  // Runtime state (RunState από το WindlassFsm)
+  RunState state = IDLE;
+
+  // Timers
+  unsigned long op_end_ms = 0;
+  unsigned long op_start_ms = 0;
+  bool          neutral_waiting = false;
+  unsigned long neutral_until_ms = 0;
+  RunState      queued_dir_ = IDLE;
+  float         queued_dur_s_ = 0.0f;
+  bool          relays_on_ = false;
+  // Πραγματική αλλαγή ρελέ (όχι off πάνω σε off): για το ack των εντολών
+  uint32_t      relay_actuations_ = 0;
+  uint32_t      relay_actuated_us_ = 0;
+
+  // Command debouncing
+  unsigned long last_command_ms_ = 0;
+  const unsigned long command_debounce_ms_ = 250;
+  bool     has_last_command_ = false;
+  RunState last_command_dir_ = IDLE;
+  bool processing_command_ = false;
+
+  // ---- Configuration ----
+  WindlassConfig config() const {
+    WindlassConfig c;
+    c.relay_up_pin = relay_up_pin;
+    c.relay_down_pin = relay_down_pin;
+    c.relays_active_high = relays_active_high;
+    c.enabled = enabled;
+    c.chain_sensor_pullup = chain_sensor_pullup;
+    c.chain_filter_adaptive = chain_filter_adaptive;
+    c.default_chain_seconds = default_chain_seconds;
+    c.neutral_ms = neutral_ms;
+    c.chain_sensor_pin = chain_sensor_pin;
+    c.chain_calibration = chain_calibration;
+    c.coast_down_m = coast_.coast_m(0);
+    c.coast_up_m = coast_.coast_m(1);
+    c.current_sensor_pin = current_sensor_pin;
+    c.current_zero = current_zero;
+    c.current_ma_per_count = current_ma_per_count;
+    c.stall_current_a = stall_current_a;
+    c.overload_current_a = overload_current_a;
+    return c;
+  }
+
+  // Εφαρμόζει νέες ρυθμίσεις. Τα pins ξαναστήνονται μόνο αν άλλαξε κάτι
+  // που τα αφορά (το setupPins() σβήνει τα ρελέ). Επιστρέφει true τότε.
+  bool applyConfig(const WindlassConfig& c) {
+    const bool pins = c.relay_up_pin != relay_up_pin || c.relay_down_pin != relay_down_pin ||
+                      c.relays_active_high != relays_active_high ||
+                      c.chain_sensor_pin != chain_sensor_pin ||
+                      c.chain_sensor_pullup != chain_sensor_pullup ||
+                      c.chain_filter_adaptive != chain_filter_adaptive;
+    if (pins && (state == RUNNING_UP || state == RUNNING_DOWN)) stopNow_("config:pins");
+    relay_up_pin = c.relay_up_pin;
+    relay_down_pin = c.relay_down_pin;
+    relays_active_high = c.relays_active_high;
+    enabled = c.enabled;
+    chain_sensor_pullup = c.chain_sensor_pullup;
+    chain_filter_adaptive = c.chain_filter_adaptive;
+    default_chain_seconds = c.default_chain_seconds;
+    neutral_ms = c.neutral_ms;
+    chain_sensor_pin = c.chain_sensor_pin;
+    chain_calibration = c.chain_calibration;
+    if (c.coast_down_m != coast_.coast_m(0)) coast_.set_coast_m(0, c.coast_down_m);
+    if (c.coast_up_m != coast_.coast_m(1)) coast_.set_coast_m(1, c.coast_up_m);
+    current_sensor_pin = c.current_sensor_pin;
+    current_zero = c.current_zero;
+    current_ma_per_count = c.current_ma_per_count;
+    stall_current_a = c.stall_current_a;
+    overload_current_a = c.overload_current_a;
+    setupCurrent_();
+    if (pins) setupPins();
+    return pins;
+  }
+
+  // ---- Pin IO ----
+  void setupPins() {
+    // Relay pins: πρώτα το επίπεδο "off", μετά έξοδος
+    relaysOff_();
+    hal::pinMode(relay_up_pin, OUTPUT);
+    hal::pinMode(relay_down_pin, OUTPUT);
+    setupChainSensor();
+  }
+
+  // Chain counter sensor pin. Το interrupt δένεται στον πυρήνα του task που
+  // το καλεί, γι' αυτό το motor task το ξανακαλεί μόνο του (χωρίς τα ρελέ).
+  void setupChainSensor() {
+    if (attached_sensor_pin_ >= 0) {
+      hal::detachChangeInterrupt(attached_sensor_pin_);
+      attached_sensor_pin_ = -1;
+    }
+    if (chain_sensor_pullup) {
+      hal::pinMode(chain_sensor_pin, INPUT_PULLUP);
+    } else {
+      hal::pinMode(chain_sensor_pin, INPUT);
+    }
+    chain_edges_.clear();
+    fixed_filter_.set_debounce_us(pulse_debounce_ms * 1000UL);
+    adaptive_filter_.set_limits(2000, 30000, pulse_debounce_ms * 1000UL);
+    pulse_filter_ = chain_filter_adaptive ? static_cast<PulseFilter*>(&adaptive_filter_)
+                                          : static_cast<PulseFilter*>(&fixed_filter_);
+    pulse_filter_->reset(hal::digitalRead(chain_sensor_pin) == HIGH, hal::micros());
+    reported_pulse_rejects_ = pulse_filter_->rejected();
+    attached_sensor_pin_ = chain_sensor_pin;
+    hal::attachChangeInterrupt(chain_sensor_pin, &WindlassCore::chainSensorIsr_, this);
+
+    ESP_LOGI(TAG, "Chain counter initialized: pin=%d, pullup=%d, cal=%.2fm/pulse, filter=%s",
+             chain_sensor_pin, chain_sensor_pullup, chain_calibration, pulse_filter_->name());
+  }
+
+  // Τα όρια ισχύουν από την επόμενη κίνηση, ο αισθητήρας αμέσως
+  void setupCurrent_() {
+    const bool running = current_.running();
+    current_.configure(CurrentMonitor::makeConfig(current_zero, current_ma_per_count,
+                                                  stall_current_a, overload_current_a));
+    if (running) current_.start_run();
+    current_adc_pin_.store(current_sensor_pin, std::memory_order_relaxed);
+  }
+
+  inline void relaysOff_() {
+    hal::digitalWrite(relay_up_pin,   relays_active_high ? LOW : HIGH);
+    hal::digitalWrite(relay_down_pin, relays_active_high ? LOW : HIGH);
+    if (relays_on_) markActuated_();
+    relays_on_ = false;
+    current_.stop_run();
+  }
+
+  inline void relayUpOn_() {
+    hal::digitalWrite(relay_down_pin, relays_active_high ? LOW : HIGH);
+    hal::digitalWrite(relay_up_pin,   relays_active_high ? HIGH : LOW);
+    relays_on_ = true;
+    markActuated_();
+    startCurrentRun_();
+  }
+
+  inline void relayDownOn_() {
+    hal::digitalWrite(relay_up_pin,   relays_active_high ? LOW : HIGH);
+    hal::digitalWrite(relay_down_pin, relays_active_high ? HIGH : LOW);
+    relays_on_ = true;
+    markActuated_();
+    startCurrentRun_();
+  }
+
+  inline void markActuated_() {
+    relay_actuated_us_ = hal::micros();
+    relay_actuations_++;
+  }
+
+  // ---- Motor current ----
+  // Νέα κίνηση: τα δείγματα με τα ρελέ ανοιχτά (ή της προηγούμενης
+  // κατεύθυνσης) πετιούνται, το inrush μετράει από τώρα
+  void startCurrentRun_() {
+    uint16_t raw;
+    while (current_samples_.pop(raw)) {}
+    if (current_sensor_pin >= 0) current_.start_run();
+  }
+
+  // Από τον sampler (όχι ISR, το esp_timer task)
+  void pushCurrentSample_(uint16_t raw) { current_samples_.push(raw); }
+
+  // Αδειάζει τα δείγματα του sampler. Stall/overload → stop αμέσως, με
+  // το δικό του reason (lastCommand, session log).
+  void updateCurrent_() {
+    uint16_t raw;
+    size_t drained = 0;
+    while (drained < current_samples_.capacity() && current_samples_.pop(raw)) {
+      drained++;
+      const CurrentMonitor::Trip trip = current_.feed(raw);
+      if (trip == CurrentMonitor::kNone) continue;
+      current_trips_[trip]++;
+      ESP_LOGW(TAG, "SAFETY: motor %s (rms %dmA, peak %dmA) - stopping",
+               trip == CurrentMonitor::kStall ? "stall" : "overload", (int)current_.rms_ma(),
+               (int)current_.peak_ma());
+      stopNow_(CurrentMonitor::tripReason(trip));
+      while (current_samples_.pop(raw)) {}
+      break;
+    }
+    if (current_samples_.overflows() != reported_sample_overflows_) {
+      ESP_LOGW(TAG, "Current sample queue overflow (%u samples dropped)",
+               (unsigned)(current_samples_.overflows() - reported_sample_overflows_));
+      reported_sample_overflows_ = current_samples_.overflows();
+    }
+  }
+
+  // ---- Chain Counter Logic ----
+  // Τρέχει σε interrupt context: μόνο timestamp + στάθμη στην ουρά.
+  static void IRAM_ATTR chainSensorIsr_(void* arg) {
+    auto* self = static_cast<WindlassCore*>(arg);
+    ChainEdge e;
+    e.t_us = hal::micros();
+    e.level = (uint8_t)hal::digitalRead(self->attached_sensor_pin_);
+    self->chain_edges_.push(e);
+    if (self->edge_notify_) self->edge_notify_(self->edge_notify_ctx_);
+  }
+
+  void updateChainCounter() {
+    // Άδειασε την ουρά του ISR σε batch - η μέτρηση δεν εξαρτάται πλέον
+    // από το πόσο κρατάει ένα πέρασμα του loop().
+    ChainEdge e;
+    uint32_t pulse_us;
+    size_t drained = 0;
+    while (drained < chain_edges_.capacity() && chain_edges_.pop(e)) {
+      if (pulse_filter_->feed(e, pulse_us)) countChainPulse_(pulse_us);
+      drained++;
+    }
+    // Αν έμειναν edges στην ουρά, το poll θα τα προσπερνούσε
+    if (chain_edges_.empty()) {
+      if (pulse_filter_->poll(hal::micros(), pulse_us)) countChainPulse_(pulse_us);
+    }
+
+    if (pulse_filter_->rejected() != reported_pulse_rejects_) {
+      reported_pulse_rejects_ = pulse_filter_->rejected();
+      ESP_LOGW(TAG, "Chain pulse ignored (too soon: %lums)",
+               (unsigned long)(pulse_filter_->last_rejected_gap_us() / 1000UL));
+    }
+    if (chain_edges_.overflows() != reported_edge_overflows_) {
+      ESP_LOGW(TAG, "Chain edge queue overflow (%u edges dropped)",
+               (unsigned)(chain_edges_.overflows() - reported_edge_overflows_));
+      reported_edge_overflows_ = chain_edges_.overflows();
+    }
+  }
+
+  void countChainPulse_(uint32_t pulse_us) {
+    // Μέτρησε ανάλογα με την κατεύθυνση. Μετά από stop η αλυσίδα κυλάει
+    // ακόμα λίγο: αυτοί οι παλμοί μετράνε στην κατεύθυνση που είχε.
+    RunState dir = state;
+    if (dir != RUNNING_UP && dir != RUNNING_DOWN && coast_.active()) {
+      dir = coast_.dir() ? RUNNING_UP : RUNNING_DOWN;
+      coast_.on_pulse(hal::millis());
+    }
+    if (dir == RUNNING_DOWN) {
+      // Κατέβασμα αγκύρας → αύξηση μέτρων
+      chain_out_meters += chain_calibration;
+      chain_pulse_count++;
+      chain_speed_.on_pulse(pulse_us);
+      ESP_LOGI(TAG, "Chain OUT: %.1fm (pulse #%d)", chain_out_meters, chain_pulse_count);
+    } else if (dir == RUNNING_UP) {
+      // Ανέβασμα αγκύρας → μείωση μέτρων
+      chain_out_meters -= chain_calibration;
+      if (chain_out_meters < 0.0f) chain_out_meters = 0.0f;
+      chain_pulse_count--;
+      if (chain_pulse_count < 0) chain_pulse_count = 0;
+      chain_speed_.on_pulse(pulse_us);
+      ESP_LOGI(TAG, "Chain IN: %.1fm (pulse #%d)", chain_out_meters, chain_pulse_count);
+    }
+
+    if (dir == RUNNING_DOWN || dir == RUNNING_UP) {
+      logSession_(SessionEvent::kPulse, dir, pulse_us);
+    }
+    if (state == RUNNING_UP || state == RUNNING_DOWN) current_.note_rotation();
+    onChainChanged_();
+  }
+
+  // ---- Target length ----
+  bool hasChainTarget() const { return !isnan(chain_target_m); }
+
+  // NAN ή αρνητική τιμή καθαρίζει τον στόχο.
+  void setChainTarget(float meters) {
+    if (isnan(meters) || meters < 0.0f) {
+      chain_target_m = NAN;
+      target_dir_ = IDLE;
+    } else {
+      chain_target_m = meters;
+      target_dir_ = meters >= chain_out_meters ? RUNNING_DOWN : RUNNING_UP;
+      ESP_LOGI(TAG, "Chain target %.1fm (%s)", meters,
+               target_dir_ == RUNNING_DOWN ? "down" : "up");
+    }
+    onTargetChanged_();
+  }
+
+  // Απόσταση μέχρι τον στόχο στην κατεύθυνση της κίνησης, με παρεμβολή
+  // ανάμεσα στους παλμούς (το πολύ ένας κρίκος). <0 αν δεν κινείται προς αυτόν.
+  float targetRemaining_(uint32_t now_us) const {
+    if (!hasChainTarget() || state != target_dir_) return -1.0f;
+    const float speed = chain_speed_.speed(now_us, chain_calibration);
+    float travel = chain_speed_.has_pulse()
+                       ? speed * (float)(now_us - chain_speed_.last_us()) * 1e-6f
+                       : 0.0f;
+    if (travel > chain_calibration) travel = chain_calibration;
+    const float rem = state == RUNNING_DOWN ? chain_target_m - chain_out_meters
+                                            : chain_out_meters - chain_target_m;
+    return rem - travel;
+  }
+
+  // Δευτερόλεπτα μέχρι το αυτόματο stop, NAN αν δεν υπάρχει εκτίμηση.
+  float targetEtaSeconds(uint32_t now_us) const {
+    const float rem = targetRemaining_(now_us);
+    if (rem < 0.0f) return NAN;
+    const float speed = chain_speed_.speed(now_us, chain_calibration);
+    if (speed <= 0.0f) return NAN;
+    const float left = rem - coast_.coast_m(state == RUNNING_UP);
+    return left > 0.0f ? left / speed : 0.0f;
+  }
+
+  float chainSpeed(uint32_t now_us) const { return chain_speed_.speed(now_us, chain_calibration); }
+
+  // Κόβει το ρελέ όταν το υπόλοιπο φτάσει το coast που έχει μάθει.
+  void checkTarget_(uint32_t now_us) {
+    if (neutral_waiting || (state != RUNNING_DOWN && state != RUNNING_UP)) return;
+    const float rem = targetRemaining_(now_us);
+    if (rem < 0.0f && state != target_dir_) return;
+    if (rem > coast_.coast_m(state == RUNNING_UP)) return;
+    target_stops_++;
+    target_stop_eval_ = true;
+    target_stop_at_m_ = chain_target_m;
+    const bool up = state == RUNNING_UP;
+    chain_target_m = NAN;
+    target_dir_ = IDLE;
+    stopNow_(up ? "up:target" : "down:target");
+    onTargetChanged_();
+  }
+
+  // Κλείνει το παράθυρο coast και ενημερώνει την εκτίμηση.
+  void finishCoast_() {
+    const float sample = coast_.finish(chain_pulse_count, chain_calibration, true);
+    if (target_stop_eval_) {
+      target_stop_eval_ = false;
+      last_target_error_m_ = chain_out_meters - target_stop_at_m_;
+      ESP_LOGI(TAG, "Target stop: landed %.2fm from target (coast %.2fm)",
+               last_target_error_m_, sample);
+    }
+    if (sample >= 0.0f) onCoastLearned_();
+  }
+
+  void resetChainCounter() {
+    chain_out_meters = 0.0f;
+    chain_pulse_count = 0;
+    ESP_LOGI(TAG, "Chain counter reset to 0");
+    onChainChanged_();
+  }
+
+  // ---- Core operations ----
+  void stopNow_(const char* reason = "stop") {
+    if (state == RUNNING_UP || state == RUNNING_DOWN) {
+      coast_.begin(state == RUNNING_UP, chain_pulse_count, hal::millis(),
+                   chainSpeed(hal::micros()) > 0.0f);
+      logSession_(SessionEvent::kStop, state, hal::micros(), reason);
+    }
+    relaysOff_();
+    state = IDLE;
+    op_end_ms = 0;
+    op_start_ms = 0;
+    neutral_waiting = false;
+    onRunStateChanged_(reason);
+  }
+
+  void startRun_(RunState dir, float seconds) {
+    const unsigned long now_ms = hal::millis();
+    // Νέα κίνηση πριν ηρεμήσει η αλυσίδα: το δείγμα coast δεν είναι καθαρό
+    if (coast_.active()) {
+      coast_.finish(chain_pulse_count, chain_calibration, false);
+      target_stop_eval_ = false;
+    }
+    chain_speed_.reset();
+    op_start_ms = now_ms;
+    op_end_ms = now_ms + (unsigned long)(seconds * 1000.0f);
+    if (dir == RUNNING_UP) {
+      relayUpOn_();
+      state = RUNNING_UP;
+    } else {
+      relayDownOn_();
+      state = RUNNING_DOWN;
+    }
+    logSession_(SessionEvent::kRunStart, state, hal::micros());
+    onRunStateChanged_(dir == RUNNING_UP ? "up:run" : "down:run");
+  }
+
+  void logSession_(SessionEvent::Type type, RunState dir, uint32_t t_us,
+                   const char* reason = nullptr) {
+    SessionEvent ev;
+    ev.type = type;
+    ev.dir = (uint8_t)dir;
+    ev.pulses = chain_pulse_count;
+    ev.t_us = t_us;
+    ev.t_ms = hal::millis();
+    ev.reason = reason;
+    ev.channel = 0;
+    onSessionEvent_(ev);
+  }
+
+  // Signal K command → transition table. Σταθερός χρόνος, χωρίς heap.
+  Outcome handleCommand(Command cmd) {
+    const Transition& t = transition(state, cmd);
+    switch (t.action) {
+      case kActNone:
+        return cmd == kCmdIdle ? kOutcomeDone : kOutcomeIgnored;
+      case kActStop:
+        stopNow_(t.reason);
+        return kOutcomeDone;
+      case kActResetCounter:
+        resetChainCounter();
+        return kOutcomeDone;
+      case kActStart:
+      case kActExtend:
+      case kActReverse:
+        return runDirection_(t);
+    }
+    return kOutcomeIgnored;
+  }
+
+  Outcome runDirection_(const Transition& t) {
+    if (!enabled) return kOutcomeRefused;
+
+    if (processing_command_) {
+      ESP_LOGD(TAG, "Ignoring command - already processing");
+      return kOutcomeIgnored;
+    }
+    processing_command_ = true;
+
+    const RunState dir = t.dir;
+    const unsigned long now_ms = hal::millis();
+    if (has_last_command_ && dir == last_command_dir_ &&
+        (now_ms - last_command_ms_ < command_debounce_ms_)) {
+      processing_command_ = false;
+      return kOutcomeIgnored;
+    }
+    Outcome outcome = kOutcomeDone;
+    last_command_ms_ = now_ms;
+    last_command_dir_ = dir;
+    has_last_command_ = true;
+
+    float dur = (float)t.seconds;
+    if (dur <= 0.0f) dur = default_chain_seconds;
+
+    switch (t.action) {
+      case kActReverse:
+        // Change direction → neutral pause
+        relaysOff_();
+        neutral_waiting = true;
+        neutral_until_ms = now_ms + (unsigned long)neutral_ms;
+        queued_dir_ = dir;
+        queued_dur_s_ = dur;
+        outcome = kOutcomeQueued;
+        break;
+
+      case kActExtend: {
+        // Same direction → extend time
+        unsigned long remaining = (op_end_ms > now_ms) ? (op_end_ms - now_ms) : 0;
+        unsigned long add_ms = (unsigned long)(dur * 1000.0f);
+        unsigned long new_total = remaining + add_ms;
+
+        op_end_ms = now_ms + new_total;
+
+        ESP_LOGI(TAG, "Extended runtime: new end in %.1fs", new_total / 1000.0f);
+        break;
+      }
+
+      default:
+        // Queued due to neutral wait
+        if (neutral_waiting && now_ms < neutral_until_ms) {
+          queued_dir_ = dir;
+          queued_dur_s_ = dur;
+          outcome = kOutcomeQueued;
+          break;
+        }
+        startRun_(dir, dur);
+        break;
+    }
+    processing_command_ = false;
+    return outcome;
+  }
+
+  // Πόσο μπορεί να περιμένει ο caller μέχρι το επόμενο tickCore_() χωρίς
+  // να αργήσει κάποια προθεσμία. 0 = τώρα, UINT32_MAX = μόνο σε νέο edge.
+  // Όσο κινείται (ή πλησιάζει στόχο) επιστρέφει το πολύ run_period_ms.
+  uint32_t msUntilDue(unsigned long now_ms, uint32_t run_period_ms) const {
+    if (!chain_edges_.empty()) return 0;
+    if (current_samples_.size() >= current_samples_.capacity() / 2) return 0;
+    uint32_t wait = UINT32_MAX;
+    // Σε κίνηση: counter, target και safety θέλουν κάθε period
+    if (state == RUNNING_UP || state == RUNNING_DOWN) wait = run_period_ms;
+    if (neutral_waiting) {
+      const uint32_t left = (long)(neutral_until_ms - now_ms) > 0
+                                ? (uint32_t)(neutral_until_ms - now_ms) : 0;
+      if (left < wait) wait = left;
+    }
+    if (pulse_filter_->settling() && run_period_ms < wait) wait = run_period_ms;
+    if (coast_.active()) {
+      const uint32_t left = coast_.ms_left((uint32_t)now_ms);
+      if (left < wait) wait = left;
+    }
+    return wait;
+  }
+
+  // Counter, neutral queue and run timeout. Returns false when a queued run
+  // was just started (the caller skips the rest of its pass, as before).
+  bool tickCore_(unsigned long now_ms) {
+    // Update chain counter (ανεξάρτητα από την κατάσταση σύνδεσης)
+    updateChainCounter();
+    updateCurrent_();
+    if (coast_.expired((uint32_t)now_ms)) finishCoast_();
+
+    // Process neutral wait queue
+    if (neutral_waiting && now_ms >= neutral_until_ms) {
+      neutral_waiting = false;
+      if (queued_dir_ != IDLE) {
+        auto qdir = queued_dir_;
+        float qdur = queued_dur_s_;
+        queued_dir_ = IDLE;
+        queued_dur_s_ = 0.0f;
+        startRun_(qdir, qdur);
+        return false;
+      }
+    }
+
+    // Target length (πριν από το timeout)
+    if (hasChainTarget()) checkTarget_(hal::micros());
+
+    // Check for operation timeout
+    if ((state == RUNNING_UP || state == RUNNING_DOWN) && now_ms >= op_end_ms) {
+      stopNow_(state == RUNNING_UP ? "up:done" : "down:done");
+    }
+    return true;
+  }
+
+ protected:
+  friend class MotorDriver;
+
+  // Hooks for the Signal K side. Called from the context that runs
+  // tickCore_()/applyConfig(): the pinned motor task on the device, or the
+  // loop task before it starts (and on the host). Never from the ISR.
+  // Implementations must not block or touch loop-task state: only queue
+  // (SPSC rings, latest-wins mailboxes) or set flags for the loop task.
+  virtual void onChainChanged_() {}
+  virtual void onRunStateChanged_(const char* what) { (void)what; }
+  virtual void onTargetChanged_() {}
+  virtual void onCoastLearned_() {}
+  // Runs, παλμοί και stops για το session log (ίδιο context με το tickCore_)
+  virtual void onSessionEvent_(const SessionEvent& ev) { (void)ev; }
+};
@@ -0,0 +1,168 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// ---------- Windlass state machine ----------
+// Οι εντολές του Signal K ("running_up", "freefall", ...) γίνονται enum με
+// ένα strnlen + ένα memcmp (κάθε όνομα έχει διαφορετικό μήκος), και η
+// αντίδραση βγαίνει από constexpr πίνακα RunState × Command. Καμία
+// δέσμευση μνήμης, σταθερός χρόνος dispatch. Τα static_assert στο τέλος
+// ελέγχουν εξαντλητικά τον πίνακα στο compile time.
+struct WindlassFsm {
+  enum RunState : uint8_t { IDLE, RUNNING_UP, RUNNING_DOWN, FAULT };
+  static constexpr int kStates = 4;
+
+  enum Command : uint8_t {
+    kCmdRunUp,         // "running_up"
+    kCmdRunDown,       // "running_down"
+    kCmdFreefall,      // "freefall"
+    kCmdIdle,          // "idle"
+    kCmdResetCounter,  // "reset_counter"
+    kCmdUnknown,
+  };
+  static constexpr int kCommands = 6;
+  static constexpr size_t kMaxCommandLen = 13;
+
+  enum Action : uint8_t {
+    kActNone,
+    kActStart,         // relays on in dir (or queue behind a neutral pause)
+    kActExtend,        // same direction: add seconds to the running op
+    kActReverse,       // opposite direction: relays off, neutral pause, queue dir
+    kActStop,
+    kActResetCounter,
+  };
+
+  struct Transition {
+    Action      action;
+    RunState    dir;
+    uint16_t    seconds;  // 0 = default_chain_seconds
+    const char* reason;   // stop reason for kActStop
+  };
+
+  static inline Command parseCommand(const char* s);
+  static inline const char* commandName(Command c);
+  static inline const char* stateName(RunState s);
+  static inline const Transition& transition(RunState s, Command c);
+};
+
+namespace windlass_fsm {
+
+typedef WindlassFsm F;
+
+// Χρόνος "κράτησης" για running_up/running_down: τρέχει μέχρι να έρθει idle
+static constexpr uint16_t kHoldSeconds = 3600;
+
+static constexpr const char* kCommandNames[F::kCommands] = {
+  "running_up", "running_down", "freefall", "idle", "reset_counter", "",
+};
+
+#define WF_T(act, dir, secs) { F::act, F::dir, secs, nullptr }
+#define WF_NONE              { F::kActNone, F::IDLE, 0, nullptr }
+#define WF_STOP              { F::kActStop, F::IDLE, 0, "idle:remote" }
+#define WF_RESET             { F::kActResetCounter, F::IDLE, 0, nullptr }
+
+// Γραμμή = τρέχουσα κατάσταση, στήλη = εντολή (σειρά του enum Command).
+static constexpr F::Transition kTable[F::kStates][F::kCommands] = {
+  // IDLE
+  { WF_T(kActStart, RUNNING_UP, kHoldSeconds), WF_T(kActStart, RUNNING_DOWN, kHoldSeconds),
+    WF_T(kActStart, RUNNING_DOWN, 0), WF_NONE, WF_RESET, WF_NONE },
+  // RUNNING_UP
+  { WF_NONE, WF_T(kActReverse, RUNNING_DOWN, kHoldSeconds),
+    WF_T(kActReverse, RUNNING_DOWN, 0), WF_STOP, WF_RESET, WF_NONE },
+  // RUNNING_DOWN
+  { WF_T(kActReverse, RUNNING_UP, kHoldSeconds), WF_NONE,
+    WF_T(kActExtend, RUNNING_DOWN, 0), WF_STOP, WF_RESET, WF_NONE },
+  // FAULT
+  { WF_T(kActStart, RUNNING_UP, kHoldSeconds), WF_T(kActStart, RUNNING_DOWN, kHoldSeconds),
+    WF_T(kActStart, RUNNING_DOWN, 0), WF_STOP, WF_RESET, WF_NONE },
+};
+
+#undef WF_T
+#undef WF_NONE
+#undef WF_STOP
+#undef WF_RESET
+
+// ---- Compile-time checks (C++11 constexpr: μία return ανά συνάρτηση) ----
+constexpr size_t len_(const char* s) { return *s ? 1 + len_(s + 1) : 0; }
+
+constexpr bool lengths_distinct_(int i, int j) {
+  return i >= F::kCmdUnknown ? true
+       : j >= F::kCmdUnknown ? lengths_distinct_(i + 1, i + 2)
+       : (len_(kCommandNames[i]) != len_(kCommandNames[j]) &&
+          len_(kCommandNames[i]) <= F::kMaxCommandLen && lengths_distinct_(i, j + 1));
+}
+
+constexpr bool is_run_(F::Action a) {
+  return a == F::kActStart || a == F::kActExtend || a == F::kActReverse;
+}
+constexpr bool opposite_(F::RunState a, F::RunState b) {
+  return (a == F::RUNNING_UP && b == F::RUNNING_DOWN) ||
+         (a == F::RUNNING_DOWN && b == F::RUNNING_UP);
+}
+
+// Κανόνες που πρέπει να ισχύουν για κάθε κελί του πίνακα.
+constexpr bool cell_ok_(F::RunState s, F::Command c, const F::Transition& t) {
+  return
+      // Οι run ενέργειες έχουν πάντα κατεύθυνση κίνησης
+      (!is_run_(t.action) || t.dir == F::RUNNING_UP || t.dir == F::RUNNING_DOWN) &&
+      // Αντίθετη κατεύθυνση περνάει ΠΑΝΤΑ από neutral pause
+      (!(is_run_(t.action) && opposite_(s, t.dir)) || t.action == F::kActReverse) &&
+      (t.action != F::kActReverse || opposite_(s, t.dir)) &&
+      // Extend μόνο στην ίδια κατεύθυνση
+      (t.action != F::kActExtend || s == t.dir) &&
+      // Stop πάντα με λόγο, άγνωστη εντολή δεν κάνει τίποτα
+      (t.action != F::kActStop || t.reason != nullptr) &&
+      (c != F::kCmdUnknown || t.action == F::kActNone) &&
+      (c != F::kCmdResetCounter || t.action == F::kActResetCounter) &&
+      // Το idle σταματάει κάθε κατάσταση εκτός από IDLE
+      (c != F::kCmdIdle || t.action == (s == F::IDLE ? F::kActNone : F::kActStop));
+}
+
+constexpr bool table_ok_(int i) {
+  return i >= F::kStates * F::kCommands
+             ? true
+             : cell_ok_((F::RunState)(i / F::kCommands), (F::Command)(i % F::kCommands),
+                        kTable[i / F::kCommands][i % F::kCommands]) &&
+                   table_ok_(i + 1);
+}
+
+static_assert(lengths_distinct_(0, 1), "command names need distinct lengths <= kMaxCommandLen");
+static_assert(table_ok_(0), "windlass transition table violates a safety rule");
+
+}  // namespace windlass_fsm
+
+inline WindlassFsm::Command WindlassFsm::parseCommand(const char* s) {
+  if (!s) return kCmdUnknown;
+  size_t n = 0;
+  while (n <= kMaxCommandLen && s[n]) n++;
+  Command c = kCmdUnknown;
+  switch (n) {
+    case 10: c = kCmdRunUp; break;
+    case 12: c = kCmdRunDown; break;
+    case 8:  c = kCmdFreefall; break;
+    case 4:  c = kCmdIdle; break;
+    case 13: c = kCmdResetCounter; break;
+    default: return kCmdUnknown;
+  }
+  return memcmp(s, windlass_fsm::kCommandNames[c], n) == 0 ? c : kCmdUnknown;
+}
+
+inline const char* WindlassFsm::commandName(Command c) {
+  return c < kCmdUnknown ? windlass_fsm::kCommandNames[c] : "unknown";
+}
+
+inline const char* WindlassFsm::stateName(RunState s) {
+  switch (s) {
+    case IDLE: return "idle";
+    case RUNNING_UP: return "running_up";
+    case RUNNING_DOWN: return "running_down";
+    case FAULT: return "fault";
+  }
+  return "idle";
+}
+
+inline const WindlassFsm::Transition& WindlassFsm::transition(RunState s, Command c) {
+  return windlass_fsm::kTable[s < kStates ? s : FAULT][c < kCommands ? c : kCmdUnknown];
+}
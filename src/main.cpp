@@ -1,489 +1,942 @@
 #include <Arduino.h>
 #include <time.h>
+#include <sys/time.h>
 #include <ArduinoJson.h>
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <esp_wifi.h>
+#include <lwip/sockets.h>
+#include <Preferences.h>
+#include <SPIFFS.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 
 #include "sensesp/signalk/signalk_value_listener.h"
+#include "sensesp/signalk/signalk_put_request_listener.h"
 #include "sensesp/ui/config_item.h"
 #include "sensesp_app_builder.h"
 #include "sensesp/system/saveable.h"
 #include "sensesp/system/lambda_consumer.h"
 #include "sensesp/signalk/signalk_ws_client.h"
+#include "sensesp/net/http_server.h"
+#include "sensesp/types/position.h"
+
+#include "windlass_core.h"
+#include "motor_link.h"
+#include "telemetry_publisher.h"
+#include "loop_profiler.h"
+#include "counter_journal.h"
+#include "session_log.h"
+#include "timer_wheel.h"
+#include "boot_timeline.h"
+#include "reconnect_backoff.h"
+#include "heap_stats.h"
+#include "ota_patch.h"
+#include "udp_link.h"
+#include "anchor_watch.h"
+#include "scope_calc.h"
+
+#if CONFIG_PM_ENABLE
+#include <esp_pm.h>
+#endif
 
 using namespace sensesp;
 
-// ---------- Helpers ----------
-static String isoTimestamp() {
-  time_t now; time(&now);
-  struct tm* tm_info = gmtime(&now);
-  char buf[30];
-  strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", tm_info);
-  return String(buf);
+// ---------- Loop instrumentation ----------
+// Κάθε στάδιο του loop() χρονομετριέται με τον cycle counter. Το total
+// πρέπει να είναι τελευταίο (LoopProfiler::finish).
+#define LOOP_PERF_STAGES(X)         \
+  X(kPerfEventLoop,  "eventLoop")   \
+  X(kPerfAnchorTick, "anchorTick")  \
+  X(kPerfTimers,     "timers")      \
+  X(kPerfTotal,      "total")
+
+enum LoopPerfStage {
+#define X(id, name) id,
+  LOOP_PERF_STAGES(X)
+#undef X
+  kPerfStageCount
+};
+
+static const char* const kPerfStageNames[kPerfStageCount] = {
+#define X(id, name) name,
+  LOOP_PERF_STAGES(X)
+#undef X
+};
+
+static constexpr unsigned long kPerfWindowMs = 60000;  // ένα histogram window
+LoopProfiler<kPerfStageCount> g_loop_perf;
+
+// Latency εντολής → ρελέ ανά πηγή: μετριέται στο motor task, καταγράφεται
+// εδώ σε 1/16 us (τα histograms ξεκινούν από 64 μονάδες). Ίδια windows με
+// το g_loop_perf.
+#define CMD_LATENCY_SOURCES(X)       \
+  X(kCmdLatListener, "listener")     \
+  X(kCmdLatPut,      "put")
+
+enum CmdLatencySource {
+#define X(id, name) id,
+  CMD_LATENCY_SOURCES(X)
+#undef X
+  kCmdLatCount
+};
+
+static const char* const kCmdLatencyNames[kCmdLatCount] = {
+#define X(id, name) name,
+  CMD_LATENCY_SOURCES(X)
+#undef X
+};
+
+static constexpr uint32_t kCmdLatencyUnitsPerUs = 16;
+LoopProfiler<kCmdLatCount> g_cmd_latency;
+LatencyHistogram g_cmd_latency_boot[kCmdLatCount];  // από την εκκίνηση, για το p95 στο πεδίο
+
+// ---------- Loop scheduling ----------
+// Οι περιοδικές δουλειές του loop task (heartbeat μετά το connect, WiFi log,
+// WS watchdog, perf roll, LED) είναι timers στο g_timers. Το loop() κοιμάται
+// μέχρι την επόμενη προθεσμία ή μέχρι να το ξυπνήσει το motor task.
+//
+// Το ReactESP event loop του SensESP (listeners, PUTs, WS client) έχει
+// δικούς του timers που δεν φαίνονται από έξω, και το SKWSClient δεν
+// δίνει hook στη λήψη για να μας ξυπνήσει, άρα το ξυπνάμε εμείς: κάθε
+// kEventLoopActivePollMs όσο το WebSocket είναι συνδεδεμένο (κάθε frame
+// listener ή PUT μπορεί να είναι stop) ή κάτι συμβαίνει (ρελέ κλειστά,
+// εντολή ή αλλαγή σύνδεσης τα τελευταία kEventLoopActiveMs). Μόνο χωρίς
+// σύνδεση, όπου εντολές έρχονται μόνο από UDP (κατευθείαν στο motor
+// task), αραιώνει στα kEventLoopIdlePollMs.
+static constexpr uint32_t kEventLoopActivePollMs = 10;
+static constexpr uint32_t kEventLoopIdlePollMs = 100;
+static constexpr uint32_t kEventLoopActiveMs = 10000;
+TimerWheel g_timers;
+uint32_t   g_loop_wakeups = 0;
+uint32_t   g_loop_activity_ms = 0;  // τελευταία εντολή ή αλλαγή σύνδεσης
+
+// ---------- Heap accounting ----------
+// Κάθε malloc/calloc/realloc/free του firmware περνάει από τους wrappers
+// (HEAP_STATS_WRAP + -Wl,--wrap στο platformio.ini). Ένα στιγμιότυπο κάθε
+// kHeapSampleMs μένει στη RTC μνήμη και διαβάζεται στο επόμενο boot.
+static constexpr uint32_t kHeapSampleMs = 60000;
+HeapStats g_heap_stats;                // constant-initialized: έτοιμο πριν από κάθε malloc
+static TaskHandle_t g_alloc_task = nullptr;  // το loop task, το μόνο με AllocScopes
+RTC_NOINIT_ATTR HeapRtcRecord g_heap_rtc;
+HeapRtcRecord g_heap_prev = {};        // του προηγούμενου boot, αν επιβίωσε
+bool          g_heap_prev_valid = false;
+esp_reset_reason_t g_reset_reason = ESP_RST_UNKNOWN;
+
+#if HEAP_STATS_WRAP
+extern "C" {
+void* __real_malloc(size_t n);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* p, size_t n);
+void  __real_free(void* p);
+
+// Σε IRAM όπως και ο allocator: μπορεί να κληθεί με την cache κλειστή
+static inline uint8_t IRAM_ATTR allocTag_() {
+  return g_alloc_task && xTaskGetCurrentTaskHandle() == g_alloc_task
+             ? g_heap_stats.current.load(std::memory_order_relaxed)
+             : (uint8_t)kAllocOther;
 }
 
-// ---------- AnchorController with Chain Counter ----------
-class AnchorController : public FileSystemSaveable {
- public:
-  AnchorController() : FileSystemSaveable("/sensors/akat/anchor") {}
-  
-  // Configuration (visible in UI)
-  int  relay_up_pin        = 26;
-  int  relay_down_pin      = 27;
-  bool relays_active_high  = true;
-  bool enabled             = true;
-  float default_chain_seconds = 5.0f;
-  int   neutral_ms            = 400;
-  
-  // Chain counter configuration
-  int  chain_sensor_pin    = 25;       // GPIO για την μαγνητική επαφή
-  bool chain_sensor_pullup = true;     // Ενεργοποίηση εσωτερικού pull-up
-  float chain_calibration  = 1.0f;     // Μέτρα ανά παλμό (συνήθως 1 μέτρο/κρίκος)
-  
-  // Chain counter state
-  float chain_out_meters   = 0.0f;     // Πόσα μέτρα αλυσίδα έχουν βγει
-  int   chain_pulse_count  = 0;        // Μετρητής παλμών
-  bool  last_sensor_state  = HIGH;     // Προηγούμενη κατάσταση αισθητήρα
-  unsigned long last_pulse_ms = 0;     // Τελευταίος παλμός (για debounce)
-  unsigned long sensor_stable_since = 0; // Πότε σταθεροποιήθηκε η κατάσταση
-  bool  sensor_stable_state = HIGH;    // Σταθερή κατάσταση μετά debounce
-  const unsigned long pulse_debounce_ms = 150; // Debounce 150ms (αυξημένο)
-
-  // Runtime state
-  enum RunState { IDLE, RUNNING_UP, RUNNING_DOWN, FAULT };
-  RunState state = IDLE;
-
-  // SK Listeners
-  StringSKListener* sk_state_listener = nullptr;
+void* IRAM_ATTR __wrap_malloc(size_t n) {
+  void* p = __real_malloc(n);
+  if (p) g_heap_stats.on_alloc(allocTag_(), n);
+  else g_heap_stats.on_failed();
+  return p;
+}
+
+void* IRAM_ATTR __wrap_calloc(size_t n, size_t size) {
+  void* p = __real_calloc(n, size);
+  if (p) g_heap_stats.on_alloc(allocTag_(), n * size);
+  else g_heap_stats.on_failed();
+  return p;
+}
 
-  // Timers
-  unsigned long op_end_ms = 0;
-  unsigned long op_start_ms = 0;
-  bool          neutral_waiting = false;
-  unsigned long neutral_until_ms = 0;
-  RunState      queued_dir_ = IDLE;
-  float         queued_dur_s_ = 0.0f;
+// Ένα realloc που πέτυχε είναι free του παλιού block και δέσμευση του νέου
+// (ίσως στην ίδια θέση): έτσι allocs - frees μένει ο αριθμός των ζωντανών
+// blocks. Αν αποτύχει, το παλιό block μένει.
+void* IRAM_ATTR __wrap_realloc(void* ptr, size_t n) {
+  void* p = __real_realloc(ptr, n);
+  if (!n) {
+    if (ptr) g_heap_stats.on_free();
+  } else if (p) {
+    if (ptr) g_heap_stats.on_free();
+    g_heap_stats.on_alloc(allocTag_(), n);
+  } else {
+    g_heap_stats.on_failed();
+  }
+  return p;
+}
 
-  // Periodic tasks & LED state
-  unsigned long last_sk_update_ms_ = 0;
-  unsigned long last_led_toggle_ms_ = 0;
-  bool          led_state_ = false;
-  bool          relays_on_ = false;
-
-  // Command debouncing
-  unsigned long last_command_ms_ = 0;
-  const unsigned long command_debounce_ms_ = 250;
-  String last_command_state_ = "";
-  bool processing_command_ = false;
-
-  // ---- Pin IO ----
-  void setupPins() {
-    // Relay pins
-    pinMode(relay_up_pin, OUTPUT);
-    pinMode(relay_down_pin, OUTPUT);
-    relaysOff_();
-    
-    // Chain counter sensor pin
-    if (chain_sensor_pullup) {
-      pinMode(chain_sensor_pin, INPUT_PULLUP);
-    } else {
-      pinMode(chain_sensor_pin, INPUT);
+void IRAM_ATTR __wrap_free(void* p) {
+  if (p) g_heap_stats.on_free();
+  __real_free(p);
+}
+}
+#endif
+
+// ---------- Windlass channels ----------
+// Ένα ή περισσότερα windlass (π.χ. πλώρη και πρύμνη), δηλωμένα στο compile
+// time με -D WINDLASS_CHANNELS=N. Κάθε channel έχει δικά του pins,
+// calibration, state machine, Signal K paths και config. Κοινά: ένα motor
+// task, ένα tick, ένας telemetry publisher, ένα journal. Το channel 0 κρατάει
+// τα paths και το config path της έκδοσης με ένα windlass.
+#ifndef WINDLASS_CHANNELS
+#define WINDLASS_CHANNELS 1
+#endif
+static constexpr int kChannels = WINDLASS_CHANNELS;
+
+struct ChannelDef {
+  const char* name;         // logs, τίτλος στο UI, ?channel= στο /api/anchor/sessions
+  const char* sk_prefix;    // με την τελεία στο τέλος
+  const char* config_path;
+  int         relay_up_pin;     // default pins, αλλάζουν από το UI
+  int         relay_down_pin;
+  int         chain_sensor_pin;
+};
+
+static const ChannelDef kChannelDefs[] = {
+  {"bow",   SK_ANCHOR_PREFIX,            "/sensors/akat/anchor",      26, 27, 25},
+  {"stern", "sensors.akat.sternAnchor.", "/sensors/akat/sternAnchor", 32, 33, 14},
+};
+
+static_assert(kChannels >= 1 && kChannels <= (int)(sizeof(kChannelDefs) / sizeof(kChannelDefs[0])),
+              "WINDLASS_CHANNELS: add an entry to kChannelDefs");
+static_assert(kChannels <= CounterJournal::kMaxChannels, "WINDLASS_CHANNELS: journal limit");
+
+// ---------- Safe boot ----------
+// Τα ρελέ σβήνουν πριν από οτιδήποτε άλλο στο setup(), πριν φορτωθεί το
+// config από το SPIFFS. Pins και πολικότητα έρχονται από ένα αντίγραφο στο
+// NVS (γράφεται όταν αλλάξουν από το UI), αλλιώς τα defaults του channel.
+// Το επίπεδο "off" γράφεται πριν το pinMode(OUTPUT), οπότε ούτε τότε ούτε
+// στο setupPins() αργότερα περνάει παλμός από τα ρελέ.
+struct RelayBootPins {
+  int8_t  up;
+  int8_t  down;
+  uint8_t active_high;
+};
+
+static RelayBootPins g_relay_boot[kChannels];
+BootTimeline g_boot;  // ορόσημα της εκκίνησης, μία φορά ανά boot
+
+static void relaysSafe_() {
+  for (int i = 0; i < kChannels; i++) {
+    g_relay_boot[i].up = (int8_t)kChannelDefs[i].relay_up_pin;
+    g_relay_boot[i].down = (int8_t)kChannelDefs[i].relay_down_pin;
+    g_relay_boot[i].active_high = 1;
+  }
+  Preferences prefs;
+  if (prefs.begin("boot", true)) {
+    if (prefs.getBytesLength("relays") == sizeof(g_relay_boot)) {
+      prefs.getBytes("relays", g_relay_boot, sizeof(g_relay_boot));
     }
-    last_sensor_state = digitalRead(chain_sensor_pin);
-    sensor_stable_since = millis();
-    sensor_stable_state = last_sensor_state;
-    
-    ESP_LOGI(TAG, "Chain counter initialized: pin=%d, pullup=%d, cal=%.2fm/pulse", 
-             chain_sensor_pin, chain_sensor_pullup, chain_calibration);
+    prefs.end();
   }
-  
-  inline void relaysOff_() {
-    digitalWrite(relay_up_pin,   relays_active_high ? LOW : HIGH);
-    digitalWrite(relay_down_pin, relays_active_high ? LOW : HIGH);
-    relays_on_ = false;
+  for (const RelayBootPins& r : g_relay_boot) {
+    const uint8_t off = r.active_high ? LOW : HIGH;
+    digitalWrite(r.up, off);
+    digitalWrite(r.down, off);
+    pinMode(r.up, OUTPUT);
+    pinMode(r.down, OUTPUT);
   }
-  
-  inline void relayUpOn_() {
-    digitalWrite(relay_down_pin, relays_active_high ? LOW : HIGH);
-    digitalWrite(relay_up_pin,   relays_active_high ? HIGH : LOW);
-    relays_on_ = true;
+}
+
+// Loop task, όταν εφαρμόζονται ρυθμίσεις: γράφει στο NVS μόνο αλλαγές
+static void rememberRelays_(int channel, const WindlassConfig& c) {
+  RelayBootPins r = {(int8_t)c.relay_up_pin, (int8_t)c.relay_down_pin,
+                     (uint8_t)(c.relays_active_high ? 1 : 0)};
+  if (memcmp(&r, &g_relay_boot[channel], sizeof(r)) == 0) return;
+  g_relay_boot[channel] = r;
+  Preferences prefs;
+  if (!prefs.begin("boot")) return;
+  prefs.putBytes("relays", g_relay_boot, sizeof(g_relay_boot));
+  prefs.end();
+}
+
+// Το UDP passphrase μένει μόνο στο NVS: το config (SPIFFS) το επιστρέφει
+// όποιος κάνει GET, άρα εκεί δεν γράφεται ποτέ.
+static void loadUdpKey_(char (&key)[33]) {
+  key[0] = '\0';
+  Preferences prefs;
+  if (!prefs.begin("udp", true)) return;
+  if (prefs.isKey("key")) prefs.getString("key", key, sizeof(key));
+  prefs.end();
+}
+
+static void storeUdpKey_(const char* key) {
+  Preferences prefs;
+  if (!prefs.begin("udp")) return;
+  if (key[0]) prefs.putString("key", key);
+  else prefs.remove("key");
+  prefs.end();
+}
+
+// Fast reconnect: κανάλι και BSSID του τελευταίου AP. Με αυτά το πρώτο
+// connect ξεκινάει πριν το SensESP φορτώσει το config του και δεν σκανάρει
+// όλα τα κανάλια. Ισχύει μόνο για το SSID που έχει ήδη ο WiFi driver.
+struct WifiBootCache {
+  char    ssid[33];
+  uint8_t bssid[6];
+  uint8_t channel;
+};
+
+static void wifiFastConnect_() {
+  WifiBootCache c;
+  Preferences prefs;
+  if (!prefs.begin("boot", true)) return;
+  const bool ok = prefs.getBytesLength("wifi") == sizeof(c) &&
+                  prefs.getBytes("wifi", &c, sizeof(c)) == sizeof(c);
+  prefs.end();
+  if (!ok || !c.channel) return;
+  WiFi.mode(WIFI_STA);
+  wifi_config_t conf;
+  if (esp_wifi_get_config(WIFI_IF_STA, &conf) != ESP_OK) return;
+  char ssid[33], pass[65];
+  memcpy(ssid, conf.sta.ssid, 32);
+  ssid[32] = 0;
+  memcpy(pass, conf.sta.password, 64);
+  pass[64] = 0;
+  if (!ssid[0] || strcmp(ssid, c.ssid) != 0) return;
+  ESP_LOGI(TAG, "WiFi: fast connect to %s on channel %u", ssid, (unsigned)c.channel);
+  WiFi.begin(ssid, pass, c.channel, c.bssid);
+}
+
+// WiFi event task, σε κάθε GOT_IP: ορόσημο και cache (μόνο αν άλλαξε ο AP)
+static void wifiGotIp_() {
+  g_boot.mark(kBootWifiUp, millis());
+  WifiBootCache c = {};
+  snprintf(c.ssid, sizeof(c.ssid), "%s", WiFi.SSID().c_str());
+  const uint8_t* bssid = WiFi.BSSID();
+  if (bssid) memcpy(c.bssid, bssid, sizeof(c.bssid));
+  c.channel = (uint8_t)WiFi.channel();
+  Preferences prefs;
+  if (!prefs.begin("boot")) return;
+  WifiBootCache old;
+  if (prefs.getBytesLength("wifi") != sizeof(old) || prefs.getBytes("wifi", &old, sizeof(old)) != sizeof(old) ||
+      memcmp(&old, &c, sizeof(c)) != 0) {
+    prefs.putBytes("wifi", &c, sizeof(c));
   }
-  
-  inline void relayDownOn_() {
-    digitalWrite(relay_up_pin,   relays_active_high ? LOW : HIGH);
-    digitalWrite(relay_down_pin, relays_active_high ? HIGH : LOW);
-    relays_on_ = true;
-  }
-
-  // ---- Chain Counter Logic ----
-  void updateChainCounter() {
-    // Διάβασε την κατάσταση του αισθητήρα
-    bool current_state = digitalRead(chain_sensor_pin);
-    unsigned long now_ms = millis();
-    
-    // Βελτιωμένο debouncing: ο αισθητήρας πρέπει να είναι σταθερός για 150ms
-    if (current_state != last_sensor_state) {
-      // Η κατάσταση άλλαξε - ξεκίνα μέτρηση σταθερότητας
-      last_sensor_state = current_state;
-      sensor_stable_since = now_ms;
-      return; // Περίμενε να σταθεροποιηθεί
-    }
-    
-    // Έλεγξε αν η κατάσταση είναι σταθερή για αρκετό χρόνο
-    if (now_ms - sensor_stable_since < pulse_debounce_ms) {
-      return; // Ακόμα περιμένουμε σταθεροποίηση
-    }
-    
-    // Η κατάσταση είναι σταθερή - έλεγξε για μετάβαση
-    if (current_state != sensor_stable_state) {
-      // Η σταθερή κατάσταση άλλαξε (μετά από debounce)
-      bool old_stable = sensor_stable_state;
-      sensor_stable_state = current_state;
-      
-      // Μέτρησε μόνο στην ανοδική ακμή (LOW→HIGH)
-      if (old_stable == LOW && sensor_stable_state == HIGH) {
-        // Πρόσθετος έλεγχος: αγνόησε παλμούς πολύ κοντά χρονικά
-        if (now_ms - last_pulse_ms < pulse_debounce_ms * 2) {
-          ESP_LOGW(TAG, "Chain pulse ignored (too soon: %lums)", now_ms - last_pulse_ms);
-          return;
-        }
-        
-        last_pulse_ms = now_ms;
-        
-        // Μέτρησε ανάλογα με την κατεύθυνση
-        if (state == RUNNING_DOWN) {
-          // Κατέβασμα αγκύρας → αύξηση μέτρων
-          chain_out_meters += chain_calibration;
-          chain_pulse_count++;
-          ESP_LOGI(TAG, "Chain OUT: %.1fm (pulse #%d)", chain_out_meters, chain_pulse_count);
-        } else if (state == RUNNING_UP) {
-          // Ανέβασμα αγκύρας → μείωση μέτρων
-          chain_out_meters -= chain_calibration;
-          if (chain_out_meters < 0.0f) chain_out_meters = 0.0f;
-          chain_pulse_count--;
-          if (chain_pulse_count < 0) chain_pulse_count = 0;
-          ESP_LOGI(TAG, "Chain IN: %.1fm (pulse #%d)", chain_out_meters, chain_pulse_count);
+  prefs.end();
+}
+
+// ---------- Chain counter journal (partition "chainlog") ----------
+class PartitionJournalFlash : public JournalFlash {
+ public:
+  static constexpr esp_partition_subtype_t kSubtype = (esp_partition_subtype_t)0x40;
+
+  bool begin() {
+    part_ = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, kSubtype, "chainlog");
+    return part_ != nullptr;
+  }
+  bool read(uint32_t offset, void* dst, size_t len) override {
+    return esp_partition_read(part_, offset, dst, len) == ESP_OK;
+  }
+  bool write(uint32_t offset, const void* src, size_t len) override {
+    return esp_partition_write(part_, offset, src, len) == ESP_OK;
+  }
+  bool erase_sector(uint32_t offset) override {
+    return esp_partition_erase_range(part_, offset, kSectorSize) == ESP_OK;
+  }
+  uint32_t size() const override { return part_ ? part_->size : 0; }
+
+ private:
+  const esp_partition_t* part_ = nullptr;
+};
+
+// Οι εγγραφές στο flash γίνονται σε δικό τους task ώστε ένα sector erase
+// (~40ms) να μη μπλοκάρει ποτέ το tick(). Το submit() κρατάει μόνο την πιο
+// πρόσφατη κατάσταση ανά channel - σε freefall οι ενδιάμεσες συγχωνεύονται.
+class JournalWriter {
+ public:
+  // Recovers the latest records before the task starts. True if any exists
+  // (per channel: latest()).
+  bool begin() {
+    if (!flash_.begin()) {
+      ESP_LOGW(TAG, "Journal: no 'chainlog' partition, counter persistence via config only");
+      return false;
+    }
+    const unsigned long t0 = micros();
+    CounterRecord newest;
+    const bool found = journal_.recover(&flash_, newest);
+    ESP_LOGI(TAG, "Journal: recovered=%d seq=%u in %luus (sector %u slot %u, torn=%u)", found,
+             found ? (unsigned)newest.seq : 0u, micros() - t0, (unsigned)journal_.head_sector(),
+             (unsigned)journal_.head_slot(), (unsigned)journal_.stats().torn_records);
+    xTaskCreatePinnedToCore(&JournalWriter::task_, "chainlog", 3072, this, 2, &task_handle_,
+                            tskNO_AFFINITY);
+    return found;
+  }
+
+  // Μόνο πριν από το πρώτο submit() (setup)
+  bool latest(int channel, CounterRecord& out) const { return journal_.latest(channel, out); }
+
+  void submit(uint8_t channel, int32_t pulses, float meters, uint8_t state) {
+    if (!task_handle_ || channel >= CounterJournal::kMaxChannels) return;
+    portENTER_CRITICAL(&mux_);
+    Pending& p = pending_[channel];
+    p.pulses = pulses;
+    p.meters = meters;
+    p.state = state;
+    p.has = true;
+    portEXIT_CRITICAL(&mux_);
+    xTaskNotifyGive(task_handle_);
+  }
+
+  const CounterJournal::Stats& stats() const { return journal_.stats(); }
+
+ private:
+  struct Pending {
+    bool    has;
+    int32_t pulses;
+    float   meters;
+    uint8_t state;
+  };
+
+  static void task_(void* arg) {
+    auto* self = static_cast<JournalWriter*>(arg);
+    for (;;) {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      for (bool any = true; any;) {
+        any = false;
+        for (uint8_t c = 0; c < CounterJournal::kMaxChannels; c++) {
+          portENTER_CRITICAL(&self->mux_);
+          const Pending p = self->pending_[c];
+          self->pending_[c].has = false;
+          portEXIT_CRITICAL(&self->mux_);
+          if (!p.has) continue;
+          any = true;
+          if (!self->journal_.append(p.pulses, p.meters, p.state, c)) {
+            ESP_LOGW(TAG, "Journal: append failed (channel %u)", (unsigned)c);
+          }
         }
-        
-        // Στείλε ενημέρωση στο Signal K
-        sendChainUpdate_();
       }
     }
   }
-  
-  void resetChainCounter() {
-    chain_out_meters = 0.0f;
-    chain_pulse_count = 0;
-    ESP_LOGI(TAG, "Chain counter reset to 0");
-    sendChainUpdate_();
+
+  PartitionJournalFlash flash_;
+  CounterJournal journal_;
+  TaskHandle_t  task_handle_ = nullptr;
+  portMUX_TYPE  mux_ = portMUX_INITIALIZER_UNLOCKED;
+  Pending       pending_[CounterJournal::kMaxChannels] = {};
+};
+
+JournalWriter g_journal;
+
+// Οι μετρητές πριν από ένα restart του firmware (βλ. saveCountersToRtc_)
+RTC_NOINIT_ATTR CounterRtcRecord g_counter_rtc;
+uint8_t g_counters_restored = CounterRtcRecord::kNone;  // από ποιο restart, αν ήρθαν από τη RTC
+
+// ---------- Anchoring session log (SPIFFS, /slog/<id>.bin) ----------
+// Ένα log ανά channel: το channel 0 στα /slog/<id>.bin, το N στα /slog/N-<id>.bin.
+class SpiffsSessionStore : public SessionStore {
+ public:
+  void begin(uint8_t channel) { channel_ = channel; }
+
+  bool range(uint32_t& first, uint32_t& last) override {
+    File dir = SPIFFS.open("/slog");
+    if (!dir) return false;
+    bool any = false;
+    for (File f = dir.openNextFile(); f; f = dir.openNextFile()) {
+      uint32_t id;
+      if (!parse_(f.name(), id)) continue;
+      if (!any || (int32_t)(id - first) < 0) first = id;
+      if (!any || (int32_t)(id - last) > 0) last = id;
+      any = true;
+    }
+    return any;
   }
-  
-  void sendChainUpdate_() {
-    auto app = ::sensesp::SensESPApp::get();
-    if (!app) return;
-    auto ws = app->get_ws_client();
-    if (!ws) return;
-    extern SKWSConnectionState g_ws_state;
-    if (g_ws_state != SKWSConnectionState::kSKWSConnected) return;
-    
-    JsonDocument doc;
-    JsonObject root = doc.to<JsonObject>();
-    root["context"] = "vessels.self";
-    JsonArray updates = root["updates"].to<JsonArray>();
-    JsonObject upd = updates.add<JsonObject>();
-    JsonObject src = upd["source"].to<JsonObject>();
-    src["label"] = "signalk-anchoralarm-akat";
-    JsonArray values = upd["values"].to<JsonArray>();
-    
-    // Μέτρα αλυσίδας
-    JsonObject v1 = values.add<JsonObject>();
-    v1["path"] = "sensors.akat.anchor.chainOut";
-    v1["value"] = chain_out_meters;
-    
-    // Αριθμός παλμών
-    JsonObject v2 = values.add<JsonObject>();
-    v2["path"] = "sensors.akat.anchor.chainPulses";
-    v2["value"] = chain_pulse_count;
-    
-    String payload;
-    serializeJson(doc, payload);
-    ws->sendTXT(payload);
-  }
-
-  // ---- Publish helpers ----
-  String stateToString_() const {
-    switch (state) {
-      case IDLE: return "idle";
-      case RUNNING_UP: return "running_up";
-      case RUNNING_DOWN: return "running_down";
-      case FAULT: return "fault";
-    }
-    return "idle";
+  bool append(uint32_t id, const void* src, size_t len) override {
+    char path[kPathBytes];
+    File f = SPIFFS.open(path_(id, path), FILE_APPEND);
+    if (!f) return false;
+    const bool ok = f.write(static_cast<const uint8_t*>(src), len) == len;
+    f.close();
+    return ok;
   }
-
-  // ---- Signal K delta helpers ----
-  void sendSkDeltaBool_(const char* path, bool value) {
-    auto app = ::sensesp::SensESPApp::get();
-    if (!app) return;
-    auto ws = app->get_ws_client();
-    if (!ws) return;
-    extern SKWSConnectionState g_ws_state;
-    if (g_ws_state != SKWSConnectionState::kSKWSConnected) return;
-    
-    JsonDocument doc;
-    JsonObject root = doc.to<JsonObject>();
-    root["context"] = "vessels.self";
-    JsonArray updates = root["updates"].to<JsonArray>();
-    JsonObject upd = updates.add<JsonObject>();
-    JsonArray values = upd["values"].to<JsonArray>();
-    JsonObject v = values.add<JsonObject>();
-    v["path"] = path;
-    v["value"] = value;
-    String payload;
-    serializeJson(doc, payload);
-    ws->sendTXT(payload);
-  }
-
-  void sendSkDeltaString_(const char* path, const String& value) {
-    auto app = ::sensesp::SensESPApp::get();
-    if (!app) return;
-    auto ws = app->get_ws_client();
-    if (!ws) return;
-    extern SKWSConnectionState g_ws_state;
-    if (g_ws_state != SKWSConnectionState::kSKWSConnected) return;
-    
-    JsonDocument doc;
-    JsonObject root = doc.to<JsonObject>();
-    root["context"] = "vessels.self";
-    JsonArray updates = root["updates"].to<JsonArray>();
-    JsonObject upd = updates.add<JsonObject>();
-    JsonArray values = upd["values"].to<JsonArray>();
-    JsonObject v = values.add<JsonObject>();
-    v["path"] = path;
-    v["value"] = value;
-    String payload;
-    serializeJson(doc, payload);
-    ws->sendTXT(payload);
+  int32_t read(uint32_t id, uint32_t offset, void* dst, size_t len) override {
+    char path[kPathBytes];
+    File f = SPIFFS.open(path_(id, path), FILE_READ);
+    if (!f) return -1;
+    const int32_t n = f.seek(offset) ? (int32_t)f.read(static_cast<uint8_t*>(dst), len) : 0;
+    f.close();
+    return n;
+  }
+  bool remove(uint32_t id) override {
+    char path[kPathBytes];
+    return SPIFFS.remove(path_(id, path));
   }
 
-  void sendHeartbeat(bool include_enabled = false) {
-    auto app = ::sensesp::SensESPApp::get();
-    if (!app) return;
-    auto ws = app->get_ws_client();
-    if (!ws) return;
-    extern SKWSConnectionState g_ws_state;
-    if (g_ws_state != SKWSConnectionState::kSKWSConnected) return;
-    
-    JsonDocument doc;
-    JsonObject root = doc.to<JsonObject>();
-    root["context"] = "vessels.self";
-    JsonArray updates = root["updates"].to<JsonArray>();
-    JsonObject upd = updates.add<JsonObject>();
-    JsonObject src = upd["source"].to<JsonObject>();
-    src["label"] = "signalk-anchoralarm-akat";
-    JsonArray values = upd["values"].to<JsonArray>();
-    
-    if (include_enabled) {
-      JsonObject v1 = values.add<JsonObject>();
-      v1["path"] = "sensors.akat.anchor.enabled";
-      v1["value"] = enabled;
-    }
-    
-    JsonObject v2 = values.add<JsonObject>();
-    v2["path"] = "sensors.akat.anchor.lastUpdate";
-    v2["value"] = isoTimestamp();
-    
-    // Συμπεριέλαβε την μέτρηση αλυσίδας στο heartbeat
-    JsonObject v3 = values.add<JsonObject>();
-    v3["path"] = "sensors.akat.anchor.chainOut";
-    v3["value"] = chain_out_meters;
-    
-    String payload;
-    serializeJson(doc, payload);
-    ws->sendTXT(payload);
+ private:
+  static constexpr size_t kPathBytes = 24;
+
+  // Στο buffer του caller: το writer task (append/remove) και ο httpd
+  // (read, export) τρέχουν ταυτόχρονα, σε όλα τα channels
+  const char* path_(uint32_t id, char (&buf)[kPathBytes]) const {
+    if (channel_) snprintf(buf, sizeof(buf), "/slog/%u-%08x.bin", (unsigned)channel_, (unsigned)id);
+    else snprintf(buf, sizeof(buf), "/slog/%08x.bin", (unsigned)id);
+    return buf;
+  }
+  bool parse_(const char* name, uint32_t& id) const {
+    const char* base = strrchr(name, '/');
+    base = base ? base + 1 : name;
+    if (channel_) {
+      char prefix[6];
+      const int n = snprintf(prefix, sizeof(prefix), "%u-", (unsigned)channel_);
+      if (strncmp(base, prefix, n) != 0) return false;
+      base += n;
+    }
+    char* end = nullptr;
+    id = (uint32_t)strtoul(base, &end, 16);
+    return end == base + 8 && strcmp(end, ".bin") == 0;
   }
 
-  void publishState_(const char* last_cmd = nullptr) {
-    // State publishing happens via periodic heartbeat
+  uint8_t channel_ = 0;
+};
+
+// Το motor task μόνο βάζει events στην ουρά. Κωδικοποίηση και εγγραφές στο
+// SPIFFS γίνονται σε δικό τους task χαμηλής προτεραιότητας, με ένα append
+// ανά γέμισμα του buffer, σε κάθε stop ή μετά από kFlushIdleMs ησυχίας.
+class SessionRecorder {
+ public:
+  static constexpr uint32_t kFlushIdleMs = 5000;
+  // Τα logs μοιράζονται το SPIFFS (416 KiB από το layout με δύο app slots)
+  static constexpr uint32_t kSegmentsPerChannel = SessionLogWriter::kMaxSegments / kChannels;
+
+  void begin() {
+    for (int c = 0; c < kChannels; c++) {
+      stores_[c].begin((uint8_t)c);
+      logs_[c].begin(&stores_[c], kSegmentsPerChannel);
+      ESP_LOGI(TAG, "Session log %s: segments %u..%u", kChannelDefs[c].name,
+               (unsigned)logs_[c].first_segment(), (unsigned)logs_[c].current_segment());
+    }
+    xTaskCreatePinnedToCore(&SessionRecorder::task_, "sessionlog", 3072, this, 1, &task_handle_,
+                            tskNO_AFFINITY);
   }
 
-  // ---- Core operations ----
-  void stopNow_(const char* reason = "stop") {
-    relaysOff_();
-    state = IDLE;
-    op_end_ms = 0;
-    op_start_ms = 0;
-    neutral_waiting = false;
+  // Motor task (single producer)
+  void submit(const SessionEvent& ev) {
+    if (!task_handle_) return;
+    events_.push(ev);
+    if (ev.type != SessionEvent::kPulse) xTaskNotifyGive(task_handle_);
   }
 
-  void startRun_(RunState dir, float seconds) {
-    const unsigned long now_ms = millis();
-    op_start_ms = now_ms;
-    op_end_ms = now_ms + (unsigned long)(seconds * 1000.0f);
-    if (dir == RUNNING_UP) {
-      relayUpOn_();
-      state = RUNNING_UP;
-    } else {
-      relayDownOn_();
-      state = RUNNING_DOWN;
+  SessionStore& store(int channel) { return stores_[channel]; }
+  uint32_t dropped() const { return events_.overflows(); }
+  const SessionLogWriter::Stats& stats(int channel) const { return logs_[channel].stats(); }
+
+ private:
+  static void task_(void* arg) {
+    auto* self = static_cast<SessionRecorder*>(arg);
+    unsigned long last_event_ms = 0;
+    for (;;) {
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+      SessionEvent ev;
+      bool stopped = false;
+      while (self->events_.pop(ev)) {
+        const time_t now = time(nullptr);
+        SessionLogWriter& log = self->logs_[ev.channel < kChannels ? ev.channel : 0];
+        log.append(ev, now > 1600000000 ? (uint32_t)now : 0);
+        stopped |= ev.type == SessionEvent::kStop;
+        last_event_ms = millis();
+      }
+      for (int c = 0; c < kChannels; c++) {
+        SessionLogWriter& log = self->logs_[c];
+        if (log.buffered() && (stopped || millis() - last_event_ms >= kFlushIdleMs)) log.flush();
+      }
     }
   }
 
-  void runDirection_(RunState dir, float seconds) {
-    if (!enabled) return;
+  SpiffsSessionStore             stores_[kChannels];
+  SessionLogWriter               logs_[kChannels];
+  SpscRing<SessionEvent, 128>    events_;
+  TaskHandle_t                   task_handle_ = nullptr;
+};
+
+SessionRecorder g_sessions;
+
+// ---------- Motor task ----------
+// Relays, timers και μετρητές όλων των channels τρέχουν σε ένα task στον άλλο
+// πυρήνα από το loop task (SensESP, WebSocket, web UI), με προτεραιότητα
+// πάνω από το lwIP. Ξυπνάει με κάθε εντολή, κάθε edge ενός αισθητήρα και
+// κάθε kMotorPeriodMs όσο κάποιο channel κινείται. Σε ηρεμία μπλοκάρει έως
+// kMotorIdleMs.
+static constexpr UBaseType_t kMotorTaskPriority = 20;
+static constexpr uint32_t    kMotorPeriodMs = 2;
+static constexpr uint32_t    kMotorIdleMs = 1000;  // snapshot refresh χωρίς κίνηση
+static TaskHandle_t g_motor_task = nullptr;         // nullptr: οι εντολές εφαρμόζονται inline
+
+// Ρυθμίσεις όπως τις βλέπει το UI: του πυρήνα + του telemetry (το telemetry
+// είναι κοινό, ισχύουν του channel 0).
+struct AnchorSettings {
+  WindlassConfig core;
+  int telemetry_window_ms;     // Coalescing παράθυρο για deltas
+  int telemetry_keepalive_ms;  // Μέγιστη "ηλικία" τιμής στον server
+  int  udp_port;               // 0 = χωρίς UDP transport (ισχύει μετά από restart)
+  char udp_key[33];            // passphrase, κενό = μόνο status
+  bool  watch_enabled;         // anchor watch (βλ. anchor_watch.h)
+  float watch_margin_m;        // ακτίνα = αλυσίδα + margin
+  int   watch_alarm_pin;       // HIGH όσο σέρνει, -1 = κανένα
+  float keel_draft_m;          // belowKeel + βύθισμα = βάθος από την επιφάνεια
+  float bow_height_m;          // ράουλο πάνω από το νερό (ανά windlass)
+  float target_scope;          // στόχος για το scopeRecommendedChain
+};
+
+// ---------- Telemetry ----------
+// Ένας publisher για όλα τα channels: οι τιμές τους φεύγουν στο ίδιο frame.
+static constexpr size_t kTelemetryFrameBytes = 2048;
+static constexpr size_t kSharedTelemetrySlots = 56;   // telemetry, perf, heap, boot, watch
+static constexpr size_t kChannelTelemetrySlots = 13;
+typedef TelemetryPublisher<kSharedTelemetrySlots + kChannelTelemetrySlots * kChannels,
+                           kTelemetryFrameBytes> Publisher;
+Publisher g_telemetry;
+
+// Εντολές από το δίκτυο, όλων των channels. Writer: loop task.
+struct CommandStats {
+  uint32_t accepted[kCmdLatCount];  // πήραν id και πήγαν στο mailbox
+  uint32_t acked;
+  uint32_t ignored;                 // listener εκτός σύνδεσης ή μέσα στο settling
+  uint32_t unknown;                 // state string που δεν αναγνωρίστηκε
+};
+CommandStats g_cmd_stats = {};       // για soak tests (GET /api/anchor/stats)
+
+// Μετά από κάθε connect οι listeners αγνοούν τόσο τις τιμές που ξαναστέλνει
+// ο server από την cache του (τα PUT γίνονται δεκτά αμέσως)
+static constexpr uint32_t kConnectionSettlingMs = 2000;
+
+// Keepalive τιμών που αλλάζουν σπάνια ή προκύπτουν από άλλες (scope,
+// ρεύμα, watch): αρκεί για να μη γίνουν stale, χωρίς 2s κίνηση στο WS
+static constexpr uint32_t kSlowKeepaliveMs = 30000;
+uint32_t     g_next_cmd_id = 1;      // id των εντολών από το δίκτυο (0 = χωρίς ack)
+
+// ---------- Windlass channel ----------
+// Το WindlassCore το αγγίζει μόνο το motor task (μέσω του driver_). Η υπόλοιπη
+// κλάση είναι η πλευρά του δικτύου για ένα windlass: στέλνει εντολές στο
+// link_ και διαβάζει το snapshot. Πριν ξεκινήσει το task, οι εντολές
+// εφαρμόζονται inline.
+class WindlassChannel : public FileSystemSaveable, public WindlassCore {
+ public:
+  explicit WindlassChannel(uint8_t index)
+      : FileSystemSaveable(kChannelDefs[index].config_path),
+        index_(index),
+        def_(kChannelDefs[index]) {
+    relay_up_pin = def_.relay_up_pin;
+    relay_down_pin = def_.relay_down_pin;
+    chain_sensor_pin = def_.chain_sensor_pin;
+    setupTelemetry_();
+    AnchorSettings st;
+    st.core = config();
+    st.telemetry_window_ms = 250;
+    st.telemetry_keepalive_ms = 2000;
+    st.udp_port = 0;
+    if (index_ == 0) loadUdpKey_(st.udp_key);
+    else st.udp_key[0] = '\0';
+    st.watch_enabled = true;
+    st.watch_margin_m = 10.0f;
+    st.watch_alarm_pin = -1;
+    st.keel_draft_m = 0.0f;
+    st.bow_height_m = 1.0f;
+    st.target_scope = 5.0f;
+    applySettings_(st);
+  }
+
+  const uint8_t     index_;
+  const ChannelDef& def_;
 
-    if (processing_command_) {
-      ESP_LOGD(TAG, "Ignoring command - already processing");
-      return;
-    }
-    processing_command_ = true;
+  // Motor side ↔ network side
+  MotorLink     link_;
+  MotorDriver   driver_{*this, link_};
+  MotorSnapshot snap_ = {};  // τελευταίο snapshot, διαβάζεται στο tick()
+  ScopeCalc     scope_;      // βάθος από τον AnchorController, αλυσίδα από το snap_
+  const char*   last_command_ = nullptr;  // ό,τι έφυγε τελευταίο στο lastCommand
+  uint32_t      saved_seq_ = 0;
 
-    const unsigned long now_ms = millis();
-    String current_cmd = (dir == RUNNING_UP) ? "up" : (dir == RUNNING_DOWN) ? "down" : "idle";
-    if (current_cmd == last_command_state_ && 
-        (now_ms - last_command_ms_ < command_debounce_ms_)) {
-      processing_command_ = false;
+  // Ρυθμίσεις: settings_ = ενεργές (writer: loop task), ui_settings_ = ό,τι
+  // έφερε το from_json (writer: όποιο task καλεί το from_json)
+  Seqlock<AnchorSettings> settings_;
+  Seqlock<AnchorSettings> ui_settings_;
+  uint32_t                ui_seen_ = 0;
+
+  // SK Listeners (fallback) και PUT handlers για τα ίδια paths
+  StringSKListener* sk_state_listener = nullptr;
+  StringSKPutRequestListener* sk_state_put = nullptr;
+
+  // Telemetry του channel στον κοινό publisher, paths με το prefix του
+  SkPathArena<768> paths_;
+  SkPath ack_path_;
+  struct {
+    int8_t enabled, last_update, chain_out, chain_pulses, last_command;
+    int8_t chain_target, target_eta, chain_speed;
+    int8_t motor_current, motor_current_peak;
+    int8_t scope, scope_chain, scope_remaining;
+  } tm_;
+
+  // ---- Motor task side (hooks του WindlassCore) ----
+  // Η μέτρηση φεύγει με το snapshot, εδώ μόνο το journal
+  void onChainChanged_() override {
+    g_journal.submit(index_, (int32_t)chain_pulse_count, chain_out_meters, (uint8_t)state);
+  }
+
+  void onRunStateChanged_(const char* what) override { driver_.event(what); }
+
+  void onSessionEvent_(const SessionEvent& ev) override {
+    SessionEvent e = ev;
+    e.channel = index_;
+    g_sessions.submit(e);
+  }
+
+  // Το coast που έμαθε επιβιώνει από reboot (το save() γίνεται στο loop task)
+  void onCoastLearned_() override {
+    ESP_LOGI(TAG, "%s: coast learned: down %.2fm, up %.2fm", def_.name, coast_.coast_m(0),
+             coast_.coast_m(1));
+    driver_.requestSave();
+  }
+
+  // ---- Network side ----
+  // Μόνο από το loop task (single producer του mailbox)
+  void motorPost_(MotorCommand::Type type, uint8_t arg = 0, float value = 0.0f,
+                  const char* reason = nullptr,
+                  MotorCommand::Source source = MotorCommand::kSrcInternal) {
+    AllocScope scope(g_heap_stats, kAllocCommands);
+    g_loop_activity_ms = millis();
+    const uint32_t id = source == MotorCommand::kSrcInternal ? 0 : g_next_cmd_id++;
+    if (id) g_cmd_stats.accepted[source == MotorCommand::kSrcPut ? kCmdLatPut : kCmdLatListener]++;
+    const MotorCommand c = MotorLink::make(type, arg, value, reason, source, id);
+    if (!g_motor_task) {
+      driver_.apply(c);
+      driver_.publish();
       return;
     }
-    last_command_ms_ = now_ms;
-    last_command_state_ = current_cmd;
-
-    float dur = seconds;
-    if (dur <= 0.0f) dur = default_chain_seconds;
-
-    // Change direction → neutral pause
-    if ((dir == RUNNING_UP && state == RUNNING_DOWN) ||
-        (dir == RUNNING_DOWN && state == RUNNING_UP)) {
-      relaysOff_();
-      neutral_waiting = true;
-      neutral_until_ms = now_ms + (unsigned long)neutral_ms;
-      queued_dir_ = dir;
-      queued_dur_s_ = dur;
-      processing_command_ = false;
-      return;
+    if (!link_.post(c)) {
+      ESP_LOGW(TAG, "%s: motor mailbox full - command dropped", def_.name);
     }
+    xTaskNotifyGive(g_motor_task);
+  }
 
-    // Same direction → extend time
-    if ((dir == RUNNING_UP && state == RUNNING_UP) ||
-        (dir == RUNNING_DOWN && state == RUNNING_DOWN)) {
-      unsigned long remaining = (op_end_ms > now_ms) ? (op_end_ms - now_ms) : 0;
-      unsigned long add_ms = (unsigned long)(dur * 1000.0f);
-      unsigned long new_total = remaining + add_ms;
-      
-      op_end_ms = now_ms + new_total;
-      
-      ESP_LOGI(TAG, "Extended runtime: new end in %.1fs", new_total / 1000.0f);
-      
-      processing_command_ = false;
-      return;
+  // Κάνει ενεργές νέες ρυθμίσεις (loop task ή setup)
+  void applySettings_(const AnchorSettings& st,
+                      MotorCommand::Source source = MotorCommand::kSrcInternal) {
+    settings_.write(st);
+    link_.config.write(st.core);
+    scope_.configure(st.bow_height_m, st.target_scope);
+    if (index_ == 0) {
+      g_telemetry.configure(st.telemetry_window_ms < 0 ? 0 : st.telemetry_window_ms,
+                            st.telemetry_keepalive_ms < 0 ? 0 : st.telemetry_keepalive_ms);
     }
+    motorPost_(MotorCommand::kApplyConfig, 0, 0.0f, nullptr, source);
+  }
 
-    // Queued due to neutral wait
-    if (neutral_waiting && now_ms < neutral_until_ms) {
-      queued_dir_ = dir;
-      queued_dur_s_ = dur;
-      processing_command_ = false;
-      return;
+  // Τρέχουσες ρυθμίσεις με το coast που έχει μάθει το motor task. Το web
+  // server task (prio 5) μπορεί να διακόψει το loop task μέσα στο
+  // settings_.write(): read_yielding() του αφήνει ένα tick να τελειώσει.
+  // false αν οι ρυθμίσεις δεν διαβάστηκαν ούτε σε ~100ms.
+  bool currentSettings_(AnchorSettings& st) const {
+    if (!settings_.read_yielding(st)) {
+      ESP_LOGW(TAG, "%s: settings busy - request skipped", def_.name);
+      return false;
     }
+    MotorSnapshot s;
+    link_.snapshot.read(s);
+    st.core.coast_down_m = s.coast_down_m;
+    st.core.coast_up_m = s.coast_up_m;
+    return true;
+  }
 
-    startRun_(dir, dur);
-    processing_command_ = false;
+  bool running_() const { return snap_.state == RUNNING_UP || snap_.state == RUNNING_DOWN; }
+
+  // Το keepalive της ρύθμισης (2s) μόνο για lastUpdate και chainOut. Οι
+  // υπόλοιπες τιμές αλλάζουν αργά ή βγαίνουν από άλλες, οπότε
+  // kSlowKeepaliveMs. Το lastCommand είναι γεγονός: μόνο όταν αλλάζει.
+  void setupTelemetry_() {
+    const char* p = def_.sk_prefix;
+    tm_.enabled      = g_telemetry.add(paths_.make(p, "enabled"), Publisher::kBool,
+                                       Publisher::kOnChange, kSlowKeepaliveMs);
+    tm_.last_update  = g_telemetry.add(paths_.make(p, "lastUpdate"), Publisher::kTimestamp,
+                                       Publisher::kKeepaliveOnly);
+    tm_.chain_out    = g_telemetry.add(paths_.make(p, "chainOut"), Publisher::kFloat);
+    tm_.chain_pulses = g_telemetry.add(paths_.make(p, "chainPulses"), Publisher::kInt,
+                                       Publisher::kOnChange, kSlowKeepaliveMs);
+    tm_.last_command = g_telemetry.add(paths_.make(p, "lastCommand"), Publisher::kString,
+                                       Publisher::kOnChange, Publisher::kNoKeepalive);
+    tm_.chain_target = addSlowFloat_(p, "chainTarget");
+    tm_.target_eta   = addSlowFloat_(p, "chainTargetEta");
+    tm_.chain_speed  = addSlowFloat_(p, "chainSpeed");
+    tm_.motor_current      = addSlowFloat_(p, "motorCurrent");
+    tm_.motor_current_peak = addSlowFloat_(p, "motorCurrentPeak");
+    tm_.scope           = addSlowFloat_(p, "scope");
+    tm_.scope_chain     = addSlowFloat_(p, "scopeRecommendedChain");
+    tm_.scope_remaining = addSlowFloat_(p, "scopeRemainingChain");
+    ack_path_ = paths_.make(p, "commandAck");
   }
 
-  void tick() {
-    const unsigned long now_ms = millis();
+  int8_t addSlowFloat_(const char* prefix, const char* key) {
+    return g_telemetry.add(paths_.make(prefix, key), Publisher::kFloat, Publisher::kOnChange,
+                           kSlowKeepaliveMs);
+  }
 
-    // SAFETY: Check connection state and stop if disconnected
-    extern SKWSConnectionState g_ws_state;
-    if (g_ws_state != SKWSConnectionState::kSKWSConnected) {
-      if (state == RUNNING_UP || state == RUNNING_DOWN) {
-        ESP_LOGW(TAG, "SAFETY: Motor running while disconnected - stopping");
-        stopNow_("safety:not_connected");
-        return;
-      }
+  // Οι τιμές του channel πριν από το poll του κοινού publisher
+  void updateTelemetry_() {
+    AnchorSettings st;
+    settings_.read(st);
+    g_telemetry.set_bool(tm_.enabled, st.core.enabled);
+    g_telemetry.set_float(tm_.chain_out, snap_.chain_out_meters);
+    g_telemetry.set_int(tm_.chain_pulses, snap_.chain_pulse_count);
+    // ETA σε ακέραια δευτερόλεπτα, ταχύτητα σε 0.1 m/s: αλλάζουν σπάνια
+    g_telemetry.set_float(tm_.chain_target, snap_.chain_target_m, true);
+    g_telemetry.set_float(tm_.target_eta, roundf(snap_.target_eta_s));
+    g_telemetry.set_float(tm_.chain_speed, roundf(snap_.chain_speed * 10.0f) / 10.0f);
+    // Ρεύμα σε ακέραια A: ο θόρυβος του ADC δεν βγάζει deltas
+    if (st.core.current_sensor_pin >= 0) {
+      g_telemetry.set_float(tm_.motor_current, roundf(snap_.current_ma / 1000.0f));
+      g_telemetry.set_float(tm_.motor_current_peak, roundf(snap_.current_peak_ma / 1000.0f));
     }
+    // Scope σε 0.1, μέτρα σε 0.1: αλλάζουν με κάθε παλμό, όχι με τον θόρυβο
+    // του sounder. NAN (null) χωρίς βάθος.
+    g_telemetry.set_float(tm_.scope, roundf(scope_.scope() * 10.0f) / 10.0f);
+    g_telemetry.set_float(tm_.scope_chain, roundf(scope_.recommended_m() * 10.0f) / 10.0f);
+    g_telemetry.set_float(tm_.scope_remaining, roundf(scope_.remaining_m() * 10.0f) / 10.0f);
+  }
 
-    // Update chain counter (ανεξάρτητα από την κατάσταση σύνδεσης)
-    updateChainCounter();
+  void sendHeartbeat() {
+    g_telemetry.force(tm_.last_update, true);
+    g_telemetry.force(tm_.chain_out, true);
+  }
 
-    // Process neutral wait queue
-    if (neutral_waiting && now_ms >= neutral_until_ms) {
-      neutral_waiting = false;
-      if (queued_dir_ != IDLE) {
-        auto qdir = queued_dir_;
-        float qdur = queued_dur_s_;
-        queued_dir_ = IDLE; 
-        queued_dur_s_ = 0.0f;
-        startRun_(qdir, qdur);
-        return;
-      }
-    }
+  void publishState_(const char* last_cmd = nullptr) {
+    if (!last_cmd) return;
+    last_command_ = last_cmd;
+    g_telemetry.set_string(tm_.last_command, last_cmd, true);
+  }
 
-    // Check for operation timeout
-    if ((state == RUNNING_UP || state == RUNNING_DOWN) && now_ms >= op_end_ms) {
-      stopNow_(state == RUNNING_UP ? "up:done" : "down:done");
-    }
+  // Network side του channel: ρυθμίσεις, snapshot, events, save. Τα acks τα
+  // αδειάζει ο AnchorController.
+  void tick(unsigned long now_ms, bool link_up) {
+    // SAFETY: το motor task σταματάει αν πέσει η σύνδεση ή κολλήσει το loop
+    link_.link_up.store(link_up);
+    link_.loop_alive_ms.store((uint32_t)now_ms);
 
-    // Send heartbeat if connected
-    if (g_ws_state == SKWSConnectionState::kSKWSConnected) {
-      if (now_ms - last_sk_update_ms_ >= 2000) {
-        sendHeartbeat(false);
-        
-        if (state == RUNNING_UP) {
-          sendSkDeltaString_("sensors.akat.anchor.lastCommand", String("up:run"));
-        } else if (state == RUNNING_DOWN) {
-          sendSkDeltaString_("sensors.akat.anchor.lastCommand", String("down:run"));
-        }
-        
-        last_sk_update_ms_ = now_ms;
-      }
+    // Νέες ρυθμίσεις από το web UI
+    if (ui_settings_.version() != ui_seen_) {
+      AnchorSettings st;
+      ui_seen_ = ui_settings_.version();
+      ui_settings_.read(st);
+      applySettings_(st);
+      rememberRelays_(index_, st.core);
     }
 
-    // Blink LED when relays are active
-    if (relays_on_) {
-      if (now_ms - last_led_toggle_ms_ >= 1000) {
-        led_state_ = !led_state_;
-        digitalWrite(LED_BUILTIN, led_state_ ? HIGH : LOW);
-        last_led_toggle_ms_ = now_ms;
-      }
-    } else {
-      if (led_state_) {
-        led_state_ = false;
-        digitalWrite(LED_BUILTIN, LOW);
-      }
+    // Counter, neutral queue, run timeout (inline αν δεν υπάρχει task)
+    if (!g_motor_task) driver_.step((uint32_t)now_ms);
+
+    link_.snapshot.read(snap_);
+    scope_.update(snap_.chain_out_meters);
+    const char* what;
+    while (link_.events.pop(what)) publishState_(what);
+    if (snap_.save_seq != saved_seq_) {
+      saved_seq_ = snap_.save_seq;
+      save();
     }
   }
 
   // ---------- Serialization for UI config ----------
+  // Καλούνται και από το task του web server: μόνο seqlock reads/writes, και
+  // το settings_ (writer: loop task) μόνο με read_yielding()
   bool to_json(JsonObject& root) override {
-    root["relay_up_pin"] = relay_up_pin;
-    root["relay_down_pin"] = relay_down_pin;
-    root["relays_active_high"] = relays_active_high;
-    root["enabled"] = enabled;
-    root["default_chain_seconds"] = default_chain_seconds;
-    root["neutral_ms"] = neutral_ms;
-    root["chain_sensor_pin"] = chain_sensor_pin;
-    root["chain_sensor_pullup"] = chain_sensor_pullup;
-    root["chain_calibration"] = chain_calibration;
-    root["chain_out_meters"] = chain_out_meters;  // Αποθήκευση της τρέχουσας μέτρησης
+    AnchorSettings st;
+    if (!currentSettings_(st)) return false;
+    MotorSnapshot snap;
+    link_.snapshot.read(snap);
+    root["relay_up_pin"] = st.core.relay_up_pin;
+    root["relay_down_pin"] = st.core.relay_down_pin;
+    root["relays_active_high"] = st.core.relays_active_high;
+    root["enabled"] = st.core.enabled;
+    root["default_chain_seconds"] = st.core.default_chain_seconds;
+    root["neutral_ms"] = st.core.neutral_ms;
+    if (index_ == 0) {
+      root["telemetry_window_ms"] = st.telemetry_window_ms;
+      root["telemetry_keepalive_ms"] = st.telemetry_keepalive_ms;
+      root["udp_port"] = st.udp_port;
+      root["udp_key"] = "";  // ποτέ το ίδιο το κλειδί
+      root["udp_key_set"] = st.udp_key[0] != '\0';
+      root["watch_enabled"] = st.watch_enabled;
+      root["watch_margin_m"] = st.watch_margin_m;
+      root["watch_alarm_pin"] = st.watch_alarm_pin;
+      root["keel_draft_m"] = st.keel_draft_m;
+    }
+    root["bow_height_m"] = st.bow_height_m;
+    root["target_scope"] = st.target_scope;
+    root["chain_sensor_pin"] = st.core.chain_sensor_pin;
+    root["chain_sensor_pullup"] = st.core.chain_sensor_pullup;
+    root["chain_calibration"] = st.core.chain_calibration;
+    root["chain_filter_adaptive"] = st.core.chain_filter_adaptive;
+    root["chain_coast_down_m"] = st.core.coast_down_m;
+    root["chain_coast_up_m"] = st.core.coast_up_m;
+    root["current_sensor_pin"] = st.core.current_sensor_pin;
+    root["current_zero"] = st.core.current_zero;
+    root["current_ma_per_count"] = st.core.current_ma_per_count;
+    root["stall_current_a"] = st.core.stall_current_a;
+    root["overload_current_a"] = st.core.overload_current_a;
+    root["chain_out_meters"] = snap.chain_out_meters;  // Αποθήκευση της τρέχουσας μέτρησης
     return true;
   }
 
   bool from_json(const JsonObject& c) override {
-    if (c["relay_up_pin"].is<int>()) relay_up_pin = c["relay_up_pin"].as<int>();
-    if (c["relay_down_pin"].is<int>()) relay_down_pin = c["relay_down_pin"].as<int>();
-    if (c["relays_active_high"].is<bool>()) relays_active_high = c["relays_active_high"].as<bool>();
-    if (c["enabled"].is<bool>()) enabled = c["enabled"].as<bool>();
-    if (c["default_chain_seconds"].is<float>()) default_chain_seconds = c["default_chain_seconds"].as<float>();
-    if (c["neutral_ms"].is<int>()) neutral_ms = c["neutral_ms"].as<int>();
-    if (c["chain_sensor_pin"].is<int>()) chain_sensor_pin = c["chain_sensor_pin"].as<int>();
-    if (c["chain_sensor_pullup"].is<bool>()) chain_sensor_pullup = c["chain_sensor_pullup"].as<bool>();
-    if (c["chain_calibration"].is<float>()) chain_calibration = c["chain_calibration"].as<float>();
+    AnchorSettings st;
+    if (!currentSettings_(st)) return false;
+    WindlassConfig& k = st.core;
+    if (c["relay_up_pin"].is<int>()) k.relay_up_pin = c["relay_up_pin"].as<int>();
+    if (c["relay_down_pin"].is<int>()) k.relay_down_pin = c["relay_down_pin"].as<int>();
+    if (c["relays_active_high"].is<bool>()) k.relays_active_high = c["relays_active_high"].as<bool>();
+    if (c["enabled"].is<bool>()) k.enabled = c["enabled"].as<bool>();
+    if (c["default_chain_seconds"].is<float>()) k.default_chain_seconds = c["default_chain_seconds"].as<float>();
+    if (c["neutral_ms"].is<int>()) k.neutral_ms = c["neutral_ms"].as<int>();
+    if (c["telemetry_window_ms"].is<int>()) st.telemetry_window_ms = c["telemetry_window_ms"].as<int>();
+    if (c["telemetry_keepalive_ms"].is<int>()) st.telemetry_keepalive_ms = c["telemetry_keepalive_ms"].as<int>();
+    if (c["udp_port"].is<int>()) st.udp_port = c["udp_port"].as<int>();
+    // Κενό = κράτα το αποθηκευμένο, "-" = σβήσ' το. Ένα παλιό config με το
+    // κλειδί μέσα μεταφέρεται έτσι στο NVS στο πρώτο load.
+    const char* key = c["udp_key"].is<const char*>() ? c["udp_key"].as<const char*>() : nullptr;
+    if (index_ == 0 && key && key[0]) {
+      if (strcmp(key, "-") == 0) {
+        st.udp_key[0] = '\0';
+      } else {
+        strncpy(st.udp_key, key, sizeof(st.udp_key) - 1);
+        st.udp_key[sizeof(st.udp_key) - 1] = '\0';
+      }
+      storeUdpKey_(st.udp_key);
+    }
+    if (c["watch_enabled"].is<bool>()) st.watch_enabled = c["watch_enabled"].as<bool>();
+    if (c["watch_margin_m"].is<float>()) st.watch_margin_m = c["watch_margin_m"].as<float>();
+    if (c["watch_alarm_pin"].is<int>()) st.watch_alarm_pin = c["watch_alarm_pin"].as<int>();
+    if (c["keel_draft_m"].is<float>()) st.keel_draft_m = c["keel_draft_m"].as<float>();
+    if (c["bow_height_m"].is<float>()) st.bow_height_m = c["bow_height_m"].as<float>();
+    if (c["target_scope"].is<float>()) st.target_scope = c["target_scope"].as<float>();
+    if (c["chain_sensor_pin"].is<int>()) k.chain_sensor_pin = c["chain_sensor_pin"].as<int>();
+    if (c["chain_sensor_pullup"].is<bool>()) k.chain_sensor_pullup = c["chain_sensor_pullup"].as<bool>();
+    if (c["chain_calibration"].is<float>()) k.chain_calibration = c["chain_calibration"].as<float>();
+    if (c["chain_filter_adaptive"].is<bool>()) k.chain_filter_adaptive = c["chain_filter_adaptive"].as<bool>();
+    if (c["chain_coast_down_m"].is<float>()) k.coast_down_m = c["chain_coast_down_m"].as<float>();
+    if (c["chain_coast_up_m"].is<float>()) k.coast_up_m = c["chain_coast_up_m"].as<float>();
+    if (c["current_sensor_pin"].is<int>()) k.current_sensor_pin = c["current_sensor_pin"].as<int>();
+    if (c["current_zero"].is<int>()) k.current_zero = c["current_zero"].as<int>();
+    if (c["current_ma_per_count"].is<float>()) k.current_ma_per_count = c["current_ma_per_count"].as<float>();
+    if (c["stall_current_a"].is<float>()) k.stall_current_a = c["stall_current_a"].as<float>();
+    if (c["overload_current_a"].is<float>()) k.overload_current_a = c["overload_current_a"].as<float>();
+
+    if (g_motor_task) {
+      // Από το web UI: το loop task το περνάει στο motor task. Η μέτρηση
+      // αλλάζει μόνο μέσω chainOutSet, όχι από μια παλιά φόρμα.
+      ui_settings_.write(st);
+      return true;
+    }
+    // Boot (load): ακόμα δεν τρέχει task, όλα inline
     if (c["chain_out_meters"].is<float>()) chain_out_meters = c["chain_out_meters"].as<float>();
-    setupPins();
+    applySettings_(st);
+    rememberRelays_(index_, st.core);  // pins από config πριν υπήρχε το αντίγραφο στο NVS
     return true;
   }
 
+  // Τα πεδία του telemetry (κοινός publisher) μόνο στο channel 0
   String get_config_schema() const {
-    return FPSTR(R"###({
+    String schema = FPSTR(R"###({
       "type":"object",
       "properties":{
         "relay_up_pin":{"title":"Relay UP GPIO","type":"integer"},
@@ -491,131 +944,2039 @@ class AnchorController : public FileSystemSaveable {
         "relays_active_high":{"title":"Relays Active HIGH","type":"boolean"},
         "enabled":{"title":"Enabled","type":"boolean"},
         "default_chain_seconds":{"title":"Default Seconds","type":"number","minimum":0},
-        "neutral_ms":{"title":"Neutral Delay (ms)","type":"integer","minimum":0},
+        "neutral_ms":{"title":"Neutral Delay (ms)","type":"integer","minimum":0},)###");
+    if (index_ == 0) {
+      schema += FPSTR(R"###(
+        "telemetry_window_ms":{"title":"Telemetry Coalescing Window (ms)","type":"integer","minimum":0},
+        "telemetry_keepalive_ms":{"title":"Telemetry Keepalive (ms)","type":"integer","minimum":0},
+        "udp_port":{"title":"UDP Port (0 = off, restart to apply)","type":"integer","minimum":0,"maximum":65535},
+        "udp_key":{"title":"New UDP Passphrase (empty = keep, - = remove)","type":"string","maxLength":32},
+        "udp_key_set":{"title":"UDP Passphrase Stored (commands allowed)","type":"boolean","readOnly":true},
+        "watch_enabled":{"title":"Anchor Watch","type":"boolean"},
+        "watch_margin_m":{"title":"Anchor Watch Margin (m, boat length + GPS offset)","type":"number","minimum":0},
+        "watch_alarm_pin":{"title":"Anchor Alarm GPIO (-1 = none)","type":"integer"},
+        "keel_draft_m":{"title":"Keel Draft (m, added to belowKeel depth)","type":"number","minimum":0},)###");
+    }
+    schema += FPSTR(R"###(
+        "bow_height_m":{"title":"Bow Roller Height (m above water)","type":"number","minimum":0},
+        "target_scope":{"title":"Target Scope Ratio","type":"number","minimum":1},)###");
+    schema += FPSTR(R"###(
         "chain_sensor_pin":{"title":"Chain Sensor GPIO","type":"integer"},
         "chain_sensor_pullup":{"title":"Enable Internal Pull-up","type":"boolean"},
-        "chain_calibration":{"title":"Meters per Pulse","type":"number","minimum":0.1}
+        "chain_calibration":{"title":"Meters per Pulse","type":"number","minimum":0.1},
+        "chain_filter_adaptive":{"title":"Adaptive Pulse Filter (fast chain runs)","type":"boolean"},
+        "chain_coast_down_m":{"title":"Learned Coast DOWN (m)","type":"number","minimum":0},
+        "chain_coast_up_m":{"title":"Learned Coast UP (m)","type":"number","minimum":0},
+        "current_sensor_pin":{"title":"Motor Current ADC GPIO (-1 = none, ADC1 only)","type":"integer"},
+        "current_zero":{"title":"Current Sensor Zero (ADC counts)","type":"integer","minimum":0,"maximum":4095},
+        "current_ma_per_count":{"title":"Current Sensor mA per Count","type":"number"},
+        "stall_current_a":{"title":"Stall Cutoff (A RMS, 0 = off)","type":"number","minimum":0},
+        "overload_current_a":{"title":"Overload Cutoff (A peak, 0 = off)","type":"number","minimum":0}
       }
     })###");
+    return schema;
   }
 
   // ---------- Signal K integration ----------
+  // Κοινοί handlers για listeners και PUTs. Και τα δύο τα εκπέμπει το
+  // SensESP στο loop task, άρα το motorPost_() μένει single producer.
+  void onStateCommand_(const String& cmd_state, MotorCommand::Source src) {
+    AllocScope scope(g_heap_stats, kAllocCommands);
+    // Χωρίς String compares: parse σε enum, ο πίνακας μεταβάσεων στο motor task
+    const Command cmd = parseCommand(cmd_state.c_str());
+    if (cmd == kCmdUnknown) {
+      g_cmd_stats.unknown++;
+      return;
+    }
+    motorPost_(MotorCommand::kFsm, (uint8_t)cmd, 0.0f, nullptr, src);
+  }
+
+  // Οι listeners δέχονται τιμές μόνο με σύνδεση (deltas που ξαναπαίζονται
+  // στο reconnect δεν είναι εντολές)
+  bool listenerConnected_() {
+    extern SKWSConnectionState g_ws_state;
+    if (g_ws_state == SKWSConnectionState::kSKWSConnected) return true;
+    g_cmd_stats.ignored++;
+    return false;
+  }
+
+  void onDefaultChainSeconds_(float secs, MotorCommand::Source src) {
+    AllocScope scope(g_heap_stats, kAllocCommands);
+    AnchorSettings st;
+    if (!currentSettings_(st)) return;
+    st.core.default_chain_seconds = secs < 0 ? 0.0f : secs;
+    applySettings_(st, src);
+  }
+
+  // Το motor task ενημερώνει μέτρα/παλμούς, το save() και η επιβεβαίωση
+  // προς το Signal K ακολουθούν μέσω του snapshot
+  void onChainOutSet_(float meters, MotorCommand::Source src) {
+    motorPost_(MotorCommand::kSetChainOut, 1, meters, nullptr, src);
+  }
+
+  void onChainTargetSet_(float meters, MotorCommand::Source src) {
+    motorPost_(MotorCommand::kSetTarget, 0, meters, nullptr, src);
+  }
+
+  void onResetChainCounter_(bool reset, MotorCommand::Source src) {
+    if (reset) motorPost_(MotorCommand::kResetCounter, 0, 0.0f, nullptr, src);
+  }
+
   void attachSignalK() {
+    attachListeners_();
+    attachPutHandlers_();
+  }
+
+  // Fallback: subscriptions με minPeriod, για clients που γράφουν deltas
+  void attachListeners_() {
+    const String prefix = def_.sk_prefix;
+
     // State listener
-    sk_state_listener = new StringSKListener("sensors.akat.anchor.state", 300);
+    sk_state_listener = new StringSKListener(prefix + "state", 300);
     sk_state_listener->connect_to(new LambdaConsumer<String>([this](const String& cmd_state) {
       extern SKWSConnectionState g_ws_state;
       extern unsigned long g_connection_time;
-      
+
       if (g_ws_state != SKWSConnectionState::kSKWSConnected) {
         ESP_LOGD(TAG, "Ignoring listener update - not connected");
+        g_cmd_stats.ignored++;
         return;
       }
 
-      if (g_connection_time > 0 && (millis() - g_connection_time < 2000)) {
+      if (g_connection_time > 0 && (millis() - g_connection_time < kConnectionSettlingMs)) {
         ESP_LOGD(TAG, "Ignoring listener update - connection settling period");
+        g_cmd_stats.ignored++;
         return;
       }
 
-      if (cmd_state == "running_up") {
-        if (state != RUNNING_UP) {
-          runDirection_(RUNNING_UP, 3600.0f);
-        }
-      } else if (cmd_state == "running_down") {
-        if (state != RUNNING_DOWN) {
-          runDirection_(RUNNING_DOWN, 3600.0f);
-        }
-      } else if (cmd_state == "freefall") {
-        runDirection_(RUNNING_DOWN, 0.0f);
-      } else if (cmd_state == "idle") {
-        if (state != IDLE) {
-          stopNow_("idle:remote");
-        }
-      } else if (cmd_state == "reset_counter") {
-        // Εντολή για reset του μετρητή αλυσίδας
-        resetChainCounter();
-      }
+      onStateCommand_(cmd_state, MotorCommand::kSrcListener);
     }));
 
     // Default chain seconds listener
-    auto default_chain_listener = new FloatSKListener("sensors.akat.anchor.defaultChainSeconds", 500);
+    auto default_chain_listener = new FloatSKListener(prefix + "defaultChainSeconds", 500);
     default_chain_listener->connect_to(new LambdaConsumer<float>([this](float secs) {
-      extern SKWSConnectionState g_ws_state;
-      if (g_ws_state != SKWSConnectionState::kSKWSConnected) return;
-      float v = secs < 0 ? 0.0f : secs;
-      default_chain_seconds = v;
+      if (!listenerConnected_()) return;
+      onDefaultChainSeconds_(secs, MotorCommand::kSrcListener);
     }));
-    
+
     // Chain counter SET listener - ακούει για νέα τιμή μέτρων
-    auto chain_set_listener = new FloatSKListener("sensors.akat.anchor.chainOutSet", 500);
+    auto chain_set_listener = new FloatSKListener(prefix + "chainOutSet", 500);
     chain_set_listener->connect_to(new LambdaConsumer<float>([this](float meters) {
-      extern SKWSConnectionState g_ws_state;
-      if (g_ws_state != SKWSConnectionState::kSKWSConnected) return;
-      
-      // Ενημέρωσε τον μετρητή με τη νέα τιμή
-      chain_out_meters = meters;
-      if (chain_out_meters < 0.0f) chain_out_meters = 0.0f;
-      
-      // Υπολόγισε τους παλμούς από τα μέτρα
-      chain_pulse_count = (int)(chain_out_meters / chain_calibration);
-      
-      ESP_LOGI(TAG, "Chain counter SET to %.1fm (%d pulses) via SignalK", 
-               chain_out_meters, chain_pulse_count);
-      
-      // Αποθήκευσε την νέα τιμή
-      save();
-      
-      // Στείλε επιβεβαίωση πίσω στο Signal K
-      sendChainUpdate_();
+      if (!listenerConnected_()) return;
+      onChainOutSet_(meters, MotorCommand::kSrcListener);
+    }));
+
+    // Target length listener - αυτόματο stop σε αυτά τα μέτρα (<0 = καθαρισμός)
+    auto chain_target_listener = new FloatSKListener(prefix + "chainTargetSet", 500);
+    chain_target_listener->connect_to(new LambdaConsumer<float>([this](float meters) {
+      if (!listenerConnected_()) return;
+      onChainTargetSet_(meters, MotorCommand::kSrcListener);
     }));
-    
+
     // Chain counter RESET listener (boolean) - για reset στο 0
-    auto chain_reset_listener = new BoolSKListener("sensors.akat.anchor.resetChainCounter", 500);
+    auto chain_reset_listener = new BoolSKListener(prefix + "resetChainCounter", 500);
     chain_reset_listener->connect_to(new LambdaConsumer<bool>([this](bool reset) {
-      extern SKWSConnectionState g_ws_state;
-      if (g_ws_state != SKWSConnectionState::kSKWSConnected) return;
-      if (reset) {
-        resetChainCounter();
-      }
+      if (!listenerConnected_()) return;
+      onResetChainCounter_(reset, MotorCommand::kSrcListener);
+    }));
+  }
+
+  // PUT handlers: η εντολή φεύγει για το motor task μόλις γίνει parse το
+  // frame, χωρίς το minPeriod της subscription. Ένα PUT είναι ρητό αίτημα
+  // και δεν ξαναπαίζεται μετά από reconnect, οπότε δεν χρειάζεται settling.
+  // Το PUT response το στέλνει το SKWSClient του SensESP πριν τρέξει ο
+  // handler: πάντα COMPLETED, χωρίς id ή αποτέλεσμα της εντολής. Το
+  // αποτέλεσμα (result, state) φτάνει μόνο με το commandAck delta και η
+  // νέα κατάσταση ως urgent lastCommand delta (βλ. publishState_).
+  void attachPutHandlers_() {
+    const String prefix = def_.sk_prefix;
+
+    sk_state_put = new StringSKPutRequestListener(prefix + "state");
+    sk_state_put->connect_to(new LambdaConsumer<String>([this](const String& cmd_state) {
+      onStateCommand_(cmd_state, MotorCommand::kSrcPut);
+    }));
+
+    auto default_chain_put = new FloatSKPutRequestListener(prefix + "defaultChainSeconds");
+    default_chain_put->connect_to(new LambdaConsumer<float>([this](float secs) {
+      onDefaultChainSeconds_(secs, MotorCommand::kSrcPut);
+    }));
+
+    auto chain_set_put = new FloatSKPutRequestListener(prefix + "chainOutSet");
+    chain_set_put->connect_to(new LambdaConsumer<float>([this](float meters) {
+      onChainOutSet_(meters, MotorCommand::kSrcPut);
+    }));
+
+    auto chain_target_put = new FloatSKPutRequestListener(prefix + "chainTargetSet");
+    chain_target_put->connect_to(new LambdaConsumer<float>([this](float meters) {
+      onChainTargetSet_(meters, MotorCommand::kSrcPut);
+    }));
+
+    auto chain_reset_put = new BoolSKPutRequestListener(prefix + "resetChainCounter");
+    chain_reset_put->connect_to(new LambdaConsumer<bool>([this](bool reset) {
+      onResetChainCounter_(reset, MotorCommand::kSrcPut);
     }));
   }
 };
 
 // ConfigSchema overload for ConfigItem
 namespace sensesp {
-inline const String ConfigSchema(const AnchorController& obj) {
+inline const String ConfigSchema(const WindlassChannel& obj) {
   return obj.get_config_schema();
 }
 }
 
-// --------- Globals ----------
-std::shared_ptr<AnchorController> anchor;
-SKWSConnectionState g_ws_state = SKWSConnectionState::kSKWSDisconnected;
-unsigned long g_connection_time = 0;
+// ---------- AnchorController ----------
+// Το κοινό κομμάτι όλων των channels: το motor task, το tick του loop, ο
+// publisher (perf, heap, telemetry μετρητές), τα acks και το LED.
+class AnchorController {
+ public:
+  AnchorController() {
+    tx_payload_.reserve(kTelemetryFrameBytes);
+    for (int i = 0; i < kChannels; i++) channels_[i] = std::make_shared<WindlassChannel>(i);
+    setupTelemetry_();
+  }
 
-void setup() {
-  SetupLogging();
+  std::shared_ptr<WindlassChannel> channels_[kChannels];
+  TaskHandle_t loop_task_ = nullptr;
 
-  SensESPAppBuilder builder;
-  builder.set_hostname("sensesp-anchor");
-  builder.set_wifi_access_point("SensESP-anchor", "948171");
-  ::sensesp::sensesp_app = builder.get_app();
+  // Periodic tasks & LED state
+  WheelTimer perf_timer_{&AnchorController::perfRoll_, this};
+  WheelTimer led_timer_{&AnchorController::ledBlink_, this};
+  bool       led_active_ = false;
+  bool       led_state_ = false;
 
-  configTime(0, 0, "pool.ntp.org");
+  // Telemetry: οι producers σημαδεύουν τιμές, ένα coalesced frame ανά window
+  String    tx_payload_;  // reserved μία φορά, ξαναχρησιμοποιείται
+  struct {
+    int8_t tx_frames, tx_bytes;
+    int8_t loop_wakeups, motor_wakeups;
+    int8_t heap_free, heap_min_free, heap_largest;
+    int8_t heap_prev_min_free, heap_prev_largest, reset_reason;
+    int8_t ws_reconnects, ws_last_outage;
+    int8_t watch_state, watch_max_radius, watch_current_radius;
+    int8_t watch_swing_radius, watch_swing_offset;
+  } tm_;
+  int8_t heap_alloc_ids_[kAllocSubsystemCount];
+  int8_t boot_ids_[kBootMilestoneCount];
+  int8_t cmd_latency_ids_[kCmdLatCount][4];
+  SkDeltaEncoder<384> ack_enc_;  // ένα ack = ένα frame, εκτός coalescing
 
-  anchor = std::make_shared<AnchorController>();
-  anchor->load();
+  // Loop latency: ένα window ανά kPerfWindowMs, p50/p99/max σε us
+  unsigned long last_perf_roll_ms_ = 0;
+  int8_t perf_ids_[kPerfStageCount][3];
+  // Wakeups/s του τελευταίου window (loop task και motor task)
+  uint32_t perf_loop_wakeups_ = 0;
+  uint32_t perf_motor_wakeups_ = 0;
+  float    loop_wakeups_per_s_ = 0.0f;
+  float    motor_wakeups_per_s_ = 0.0f;
 
-  ConfigItem(anchor)
-    ->set_title("Anchor Controller")
-    ->set_description("Relay control & timings for anchor windlass with chain counter")
-    ->set_sort_order(100)
-    ->set_config_schema(anchor->get_config_schema());
+  // Anchor watch: fixes από τον listener του navigation.position, αλυσίδα
+  // από το snapshot του channel 0 (το πρώτο windlass είναι της πλώρης),
+  // όλα στο loop task. Η θέση της άγκυρας επιβιώνει από reboot (NVS).
+  static constexpr uint32_t kPositionPeriodMs = 1000;        // minPeriod της subscription
+  static constexpr uint32_t kWatchObjectKeepaliveMs = 60000;
+  struct AnchorNvs {
+    double lat;
+    double lon;
+  };
+  AnchorWatch watch_;
+  uint32_t    watch_settings_seen_ = 0;
+  int         watch_alarm_pin_ = -1;
+  bool        watch_frame_pending_ = false;
+  uint32_t    watch_frame_ms_ = 0;
+  uint32_t    watch_max_fix_us_ = 0;
+  SkDeltaEncoder<384> watch_enc_;  // position + notification, εκτός coalescing
 
-  anchor->setupPins();
-  anchor->attachSignalK();
+  // Βάθος για το scope όλων των channels και την ακτίνα του anchor watch
+  static constexpr uint32_t kDepthPeriodMs = 1000;
+  DepthFilter depth_;
+  float       keel_draft_m_ = 0.0f;
 
-  pinMode(LED_BUILTIN, OUTPUT);
+  // ---- Motor task ----
+  static void motorTask_(void* arg) {
+    auto* self = static_cast<AnchorController*>(arg);
+    // Το GPIO interrupt δένεται στον πυρήνα που κάνει το attach: μόνο ο
+    // αισθητήρας, τα ρελέ τα έστησε ήδη το setup() (safe boot)
+    for (auto& ch : self->channels_) ch->setupChainSensor();
+    for (;;) {
+      const uint32_t now_ms = millis();
+      uint32_t wait = kMotorIdleMs;
+      for (auto& ch : self->channels_) {
+        const uint32_t due = ch->msUntilDue(now_ms, kMotorPeriodMs);
+        if (due < wait) wait = due;
+      }
+      if (wait) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+      const uint32_t t = millis();
+      for (auto& ch : self->channels_) ch->driver_.step(t);
+      self->updateCurrentSampler_();
+    }
+  }
+
+  // ---- Motor current sampler ----
+  // Ένα esp_timer στα kSampleHz διαβάζει το ADC κάθε channel με αισθητήρα
+  // και γράφει στην ουρά του. Τρέχει μόνο όσο κάποιο ρελέ είναι κλειστό.
+  // Το φιλτράρισμα και το cutoff γίνονται στο motor task (tickCore_).
+  esp_timer_handle_t current_timer_ = nullptr;
+  bool               sampling_ = false;
+
+  static void sampleCurrent_(void* arg) {
+    auto* self = static_cast<AnchorController*>(arg);
+    for (auto& ch : self->channels_) {
+      const int pin = ch->current_adc_pin_.load(std::memory_order_relaxed);
+      if (pin >= 0) ch->pushCurrentSample_((uint16_t)analogRead((uint8_t)pin));
+    }
+  }
+
+  // Motor task (ή loop task χωρίς motor task): ο core έχει την κατάσταση
+  void updateCurrentSampler_() {
+    bool want = false;
+    for (auto& ch : channels_) want |= ch->relays_on_ && ch->current_sensor_pin >= 0;
+    if (want == sampling_) return;
+    if (!current_timer_) {
+      esp_timer_create_args_t args = {};
+      args.callback = &AnchorController::sampleCurrent_;
+      args.arg = this;
+      args.dispatch_method = ESP_TIMER_TASK;
+      args.name = "current";
+      if (esp_timer_create(&args, &current_timer_) != ESP_OK) {
+        ESP_LOGE(TAG, "Current sampler timer not created - no stall/overload cutoff");
+        current_timer_ = nullptr;
+        return;
+      }
+    }
+    sampling_ = want;
+    if (want) {
+      esp_timer_start_periodic(current_timer_, 1000000ULL / CurrentMonitor::kSampleHz);
+    } else {
+      esp_timer_stop(current_timer_);
+    }
+  }
+
+  // Κάθε edge κάθε αισθητήρα ξυπνάει το motor task (από το ISR)
+  static void IRAM_ATTR notifyMotorFromIsr_(void*) {
+    if (!g_motor_task) return;
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(g_motor_task, &woken);
+    if (woken) portYIELD_FROM_ISR();
+  }
+
+  // Το motor task ξυπνάει το loop όταν υπάρχει κάτι να σταλεί
+  static void wakeLoop_(void* arg) {
+    auto* self = static_cast<AnchorController*>(arg);
+    if (self->loop_task_) xTaskNotifyGive(self->loop_task_);
+  }
+
+  void startMotorTask() {
+    const BaseType_t core = xPortGetCoreID() == 0 ? 1 : 0;
+    loop_task_ = xTaskGetCurrentTaskHandle();
+    for (auto& ch : channels_) {
+      ch->link_.loop_alive_ms.store(millis());
+      ch->link_.wake_ctx = this;
+      ch->link_.wake_network = &AnchorController::wakeLoop_;
+      ch->edge_notify_ctx_ = nullptr;
+      ch->edge_notify_ = &AnchorController::notifyMotorFromIsr_;
+    }
+    if (xTaskCreatePinnedToCore(&AnchorController::motorTask_, "windlass", 4096, this,
+                                kMotorTaskPriority, &g_motor_task, core) != pdPASS) {
+      g_motor_task = nullptr;
+      ESP_LOGE(TAG, "Motor task not started - running the core from loop()");
+      return;
+    }
+    ESP_LOGI(TAG, "Motor task on core %d, priority %u, %d channel(s)", (int)core,
+             (unsigned)kMotorTaskPriority, kChannels);
+  }
+
+  // ---- Network side ----
+  // Ασφάλεια: stop σε όλα τα channels (η εντολή πρώτα, ώστε να φτάσει πριν
+  // το motor task δει το link_up)
+  void stopAll_(const char* reason) {
+    for (auto& ch : channels_) {
+      if (ch->running_()) ESP_LOGW(TAG, "SAFETY: stopping %s windlass (%s)", ch->def_.name, reason);
+      ch->motorPost_(MotorCommand::kStop, 0, 0.0f, reason);
+      ch->link_.link_up.store(false);
+    }
+  }
+
+  // Από οποιοδήποτε task (π.χ. το OTA handler του http server): διαβάζει
+  // το snapshot του motor task, όχι το snap_ του loop
+  bool anyRunning_() const {
+    for (auto& ch : channels_) {
+      MotorSnapshot s;
+      ch->link_.snapshot.read(s);
+      if (s.state == WindlassFsm::RUNNING_UP || s.state == WindlassFsm::RUNNING_DOWN) return true;
+    }
+    return false;
+  }
+
+  // ---- Signal K delta helpers ----
+  SKWSClient* wsReady_() {
+    auto app = ::sensesp::SensESPApp::get();
+    if (!app) return nullptr;
+    auto ws = app->get_ws_client();
+    if (!ws) return nullptr;
+    extern SKWSConnectionState g_ws_state;
+    if (g_ws_state != SKWSConnectionState::kSKWSConnected) return nullptr;
+    return ws.get();
+  }
+
+  void setupTelemetry_() {
+    tm_.tx_frames    = g_telemetry.add(SK_ANCHOR_PATH("telemetry.frames"), Publisher::kInt,
+                                       Publisher::kKeepaliveOnly, 60000);
+    tm_.tx_bytes     = g_telemetry.add(SK_ANCHOR_PATH("telemetry.bytes"), Publisher::kInt,
+                                       Publisher::kKeepaliveOnly, 60000);
+#define X(id, name)                                                                     \
+    perf_ids_[id][0] = g_telemetry.add(SK_ANCHOR_PATH("perf." name ".p50"), Publisher::kInt, \
+                                       Publisher::kManual);                                \
+    perf_ids_[id][1] = g_telemetry.add(SK_ANCHOR_PATH("perf." name ".p99"), Publisher::kInt, \
+                                       Publisher::kManual);                                \
+    perf_ids_[id][2] = g_telemetry.add(SK_ANCHOR_PATH("perf." name ".max"), Publisher::kInt, \
+                                       Publisher::kManual);
+    LOOP_PERF_STAGES(X)
+#undef X
+    tm_.loop_wakeups  = g_telemetry.add(SK_ANCHOR_PATH("perf.loopWakeups"), Publisher::kInt,
+                                        Publisher::kManual);
+    tm_.motor_wakeups = g_telemetry.add(SK_ANCHOR_PATH("perf.motorWakeups"), Publisher::kInt,
+                                        Publisher::kManual);
+    tm_.heap_free     = g_telemetry.add(SK_ANCHOR_PATH("heap.free"), Publisher::kInt,
+                                        Publisher::kManual);
+    tm_.heap_min_free = g_telemetry.add(SK_ANCHOR_PATH("heap.minFree"), Publisher::kInt,
+                                        Publisher::kManual);
+    tm_.heap_largest  = g_telemetry.add(SK_ANCHOR_PATH("heap.largestBlock"), Publisher::kInt,
+                                        Publisher::kManual);
+    tm_.heap_prev_min_free = g_telemetry.add(SK_ANCHOR_PATH("heap.previousBoot.minFree"),
+                                             Publisher::kInt, Publisher::kManual);
+    tm_.heap_prev_largest  = g_telemetry.add(SK_ANCHOR_PATH("heap.previousBoot.largestBlock"),
+                                             Publisher::kInt, Publisher::kManual);
+    tm_.reset_reason       = g_telemetry.add(SK_ANCHOR_PATH("heap.previousBoot.resetReason"),
+                                             Publisher::kString, Publisher::kManual);
+#define X(id, name)                                                                       \
+    heap_alloc_ids_[id] = g_telemetry.add(SK_ANCHOR_PATH("heap.allocs." name), Publisher::kInt, \
+                                          Publisher::kManual);
+    ALLOC_SUBSYSTEMS(X)
+#undef X
+#define X(id, name)                                                                           \
+    cmd_latency_ids_[id][0] = g_telemetry.add(SK_ANCHOR_PATH("perf.cmdLatency." name ".p50"),    \
+                                              Publisher::kInt, Publisher::kManual);              \
+    cmd_latency_ids_[id][1] = g_telemetry.add(SK_ANCHOR_PATH("perf.cmdLatency." name ".p95"),    \
+                                              Publisher::kInt, Publisher::kManual);              \
+    cmd_latency_ids_[id][2] = g_telemetry.add(SK_ANCHOR_PATH("perf.cmdLatency." name ".p99"),    \
+                                              Publisher::kInt, Publisher::kManual);              \
+    cmd_latency_ids_[id][3] = g_telemetry.add(SK_ANCHOR_PATH("perf.cmdLatency." name ".max"),    \
+                                              Publisher::kInt, Publisher::kManual);
+    CMD_LATENCY_SOURCES(X)
+#undef X
+    tm_.ws_reconnects  = g_telemetry.add(SK_ANCHOR_PATH("connection.reconnects"), Publisher::kInt,
+                                         Publisher::kManual);
+    tm_.ws_last_outage = g_telemetry.add(SK_ANCHOR_PATH("connection.lastOutageMs"),
+                                         Publisher::kInt, Publisher::kManual);
+    tm_.watch_state          = g_telemetry.add(SK_ANCHOR_PATH("watch.state"), Publisher::kString,
+                                               Publisher::kOnChange, kSlowKeepaliveMs);
+    tm_.watch_max_radius     = g_telemetry.add(SK_PATH_KEY("navigation.anchor.maxRadius"),
+                                               Publisher::kFloat, Publisher::kOnChange,
+                                               kSlowKeepaliveMs);
+    tm_.watch_current_radius = g_telemetry.add(SK_PATH_KEY("navigation.anchor.currentRadius"),
+                                               Publisher::kFloat, Publisher::kOnChange,
+                                               kSlowKeepaliveMs);
+    tm_.watch_swing_radius   = g_telemetry.add(SK_ANCHOR_PATH("watch.swingRadius"),
+                                               Publisher::kFloat, Publisher::kOnChange,
+                                               kSlowKeepaliveMs);
+    tm_.watch_swing_offset   = g_telemetry.add(SK_ANCHOR_PATH("watch.swingOffset"),
+                                               Publisher::kFloat, Publisher::kOnChange,
+                                               kSlowKeepaliveMs);
+#define X(id, name)                                                                      \
+    boot_ids_[id] = g_telemetry.add(SK_ANCHOR_PATH("boot." name "Ms"), Publisher::kInt, \
+                                    Publisher::kManual);
+    BOOT_MILESTONES(X)
+#undef X
+  }
+
+  // Κάθε kPerfWindowMs από το g_timers
+  static void perfRoll_(void* arg) {
+    auto* self = static_cast<AnchorController*>(arg);
+    self->publishPerf_();
+    g_timers.schedule(self->perf_timer_, kPerfWindowMs);
+  }
+
+  // Κλείνει το window του profiler και στέλνει τα percentiles του
+  void publishPerf_() {
+    const unsigned long now_ms = millis();
+    const float secs = (now_ms - last_perf_roll_ms_) / 1000.0f;
+    // Κάθε wakeup του motor task κάνει ένα βήμα σε κάθε channel
+    const uint32_t motor_steps = channels_[0]->snap_.seq;
+    last_perf_roll_ms_ = now_ms;
+    if (secs > 0.0f) {
+      loop_wakeups_per_s_ = (g_loop_wakeups - perf_loop_wakeups_) / secs;
+      motor_wakeups_per_s_ = (motor_steps - perf_motor_wakeups_) / secs;
+    }
+    perf_loop_wakeups_ = g_loop_wakeups;
+    perf_motor_wakeups_ = motor_steps;
+    g_telemetry.set_int(tm_.loop_wakeups, (int32_t)lroundf(loop_wakeups_per_s_));
+    g_telemetry.set_int(tm_.motor_wakeups, (int32_t)lroundf(motor_wakeups_per_s_));
+    g_telemetry.force(tm_.loop_wakeups);
+    g_telemetry.force(tm_.motor_wakeups);
+    g_loop_perf.roll();
+    for (int i = 0; i < kPerfStageCount; i++) {
+      auto sum = g_loop_perf.summary(i);
+      g_telemetry.set_int(perf_ids_[i][0], (int32_t)sum.p50_us);
+      g_telemetry.set_int(perf_ids_[i][1], (int32_t)sum.p99_us);
+      g_telemetry.set_int(perf_ids_[i][2], (int32_t)sum.max_us);
+      for (int k = 0; k < 3; k++) g_telemetry.force(perf_ids_[i][k]);
+    }
+    g_cmd_latency.roll();
+    for (int i = 0; i < kCmdLatCount; i++) {
+      auto sum = g_cmd_latency.summary(i);
+      if (!sum.count) continue;  // καμία εντολή από αυτή την πηγή στο window
+      g_telemetry.set_int(cmd_latency_ids_[i][0], (int32_t)sum.p50_us);
+      g_telemetry.set_int(cmd_latency_ids_[i][1], (int32_t)sum.p95_us);
+      g_telemetry.set_int(cmd_latency_ids_[i][2], (int32_t)sum.p99_us);
+      g_telemetry.set_int(cmd_latency_ids_[i][3], (int32_t)sum.max_us);
+      for (int k = 0; k < 4; k++) g_telemetry.force(cmd_latency_ids_[i][k]);
+    }
+  }
+
+  // Κάθε kHeapSampleMs (βλ. heapSample_): αργό path, μαζί με το RTC στιγμιότυπο
+  void publishHeap_(const HeapRtcRecord& now) {
+    g_telemetry.set_int(tm_.heap_free, (int32_t)now.free_bytes);
+    g_telemetry.set_int(tm_.heap_min_free, (int32_t)now.min_free_bytes);
+    g_telemetry.set_int(tm_.heap_largest, (int32_t)now.largest_block);
+    g_telemetry.force(tm_.heap_free);
+    g_telemetry.force(tm_.heap_min_free);
+    g_telemetry.force(tm_.heap_largest);
+    for (int i = 0; i < kAllocSubsystemCount; i++) {
+      g_telemetry.set_int(heap_alloc_ids_[i], (int32_t)now.allocs[i]);
+      g_telemetry.force(heap_alloc_ids_[i]);
+    }
+  }
+
+  // Μία φορά: τι έδειχνε το heap πριν από το τελευταίο reset
+  void publishPreviousBoot_(const char* reset_reason, const HeapRtcRecord* prev) {
+    g_telemetry.set_string(tm_.reset_reason, reset_reason);
+    g_telemetry.force(tm_.reset_reason);
+    if (!prev) return;
+    g_telemetry.set_int(tm_.heap_prev_min_free, (int32_t)prev->min_free_bytes);
+    g_telemetry.set_int(tm_.heap_prev_largest, (int32_t)prev->largest_block);
+    g_telemetry.force(tm_.heap_prev_min_free);
+    g_telemetry.force(tm_.heap_prev_largest);
+  }
+
+  // Σε κάθε connect: πόσες επανασυνδέσεις και πόσο κράτησε η τελευταία διακοπή
+  void publishConnection_(const ReconnectBackoff::Stats& st) {
+    g_telemetry.set_int(tm_.ws_reconnects, (int32_t)st.reconnects);
+    g_telemetry.set_int(tm_.ws_last_outage, (int32_t)st.last_outage_ms);
+    g_telemetry.force(tm_.ws_reconnects);
+    g_telemetry.force(tm_.ws_last_outage);
+  }
+
+  // Μία φορά, στο readyForCommands: πόσο πήρε κάθε ορόσημο της εκκίνησης
+  void publishBoot_() {
+    for (int i = 0; i < kBootMilestoneCount; i++) {
+      g_telemetry.set_int(boot_ids_[i], (int32_t)g_boot.at(i));
+      g_telemetry.force(boot_ids_[i]);
+    }
+  }
+
+  // ---- Anchor watch ----
+  // Listener του navigation.position (loop task)
+  void onFix_(const Position& p) {
+    const uint32_t t0 = micros();
+    watch_.on_fix(p.latitude, p.longitude, millis());
+    const uint32_t us = micros() - t0;
+    if (us > watch_max_fix_us_) watch_max_fix_us_ = us;
+  }
+
+  // Listeners του βάθους (loop task)
+  void onDepth_(DepthFilter::Source src, float depth_m) {
+    if (src == DepthFilter::kKeel) depth_m += keel_draft_m_;
+    depth_.add(src, depth_m, millis());
+  }
+
+  // Μία φορά στο setup(), μετά τα configs: η άγκυρα πριν από το reboot
+  void restoreWatch_() {
+    AnchorNvs a;
+    Preferences prefs;
+    if (!prefs.begin("watch", true)) return;
+    const bool ok = prefs.getBytesLength("anchor") == sizeof(a) &&
+                    prefs.getBytes("anchor", &a, sizeof(a)) == sizeof(a);
+    prefs.end();
+    if (!ok) return;
+    watch_.restore_anchor(a.lat, a.lon);
+    watch_.take_events();  // ήδη στο NVS
+    watch_frame_pending_ = true;
+    ESP_LOGI(TAG, "Anchor watch: anchor restored at %.6f,%.6f", a.lat, a.lon);
+  }
+
+  // Loop task, όταν η άγκυρα πέφτει ή σηκώνεται (σπάνιο)
+  void rememberAnchor_() {
+    Preferences prefs;
+    if (!prefs.begin("watch")) return;
+    if (watch_.has_anchor()) {
+      const AnchorNvs a = {watch_.anchor_lat(), watch_.anchor_lon()};
+      prefs.putBytes("anchor", &a, sizeof(a));
+    } else {
+      prefs.remove("anchor");
+    }
+    prefs.end();
+  }
+
+  // Κάθε tick: αλυσίδα του channel 0, ρυθμίσεις, alarm pin, logs
+  void updateWatch_(unsigned long now_ms) {
+    WindlassChannel& bow = *channels_[0];
+    if (bow.settings_.version() != watch_settings_seen_) {
+      AnchorSettings st;
+      watch_settings_seen_ = bow.settings_.version();
+      bow.settings_.read(st);
+      watch_.configure(st.watch_enabled, st.watch_margin_m);
+      keel_draft_m_ = st.keel_draft_m < 0.0f ? 0.0f : st.keel_draft_m;
+      if (st.watch_alarm_pin != watch_alarm_pin_) {
+        if (watch_alarm_pin_ >= 0) digitalWrite(watch_alarm_pin_, LOW);
+        watch_alarm_pin_ = st.watch_alarm_pin;
+        if (watch_alarm_pin_ >= 0) {
+          digitalWrite(watch_alarm_pin_, watch_.state() == AnchorWatch::kDrag ? HIGH : LOW);
+          pinMode(watch_alarm_pin_, OUTPUT);
+        }
+      }
+    }
+    watch_.set_vertical_m(bow.scope_.vertical_m());
+    watch_.update(bow.snap_.chain_out_meters, bow.running_(), (uint32_t)now_ms);
+    const uint8_t ev = watch_.take_events();
+    if (ev & AnchorWatch::kEvAnchor) {
+      if (watch_.has_anchor()) {
+        ESP_LOGI(TAG, "Anchor watch: anchor %s at %.6f,%.6f",
+                 AnchorWatch::sourceName(watch_.source()), watch_.anchor_lat(), watch_.anchor_lon());
+      } else {
+        ESP_LOGI(TAG, "Anchor watch: anchor up");
+      }
+      rememberAnchor_();
+      watch_frame_pending_ = true;
+    }
+    if (ev & AnchorWatch::kEvState) {
+      const AnchorWatch::State s = watch_.state();
+      if (s == AnchorWatch::kDrag) {
+        ESP_LOGW(TAG, "ANCHOR DRAG: %.0fm from the anchor, radius %.0fm", watch_.distance_m(),
+                 watch_.alarm_radius_m());
+      } else {
+        ESP_LOGI(TAG, "Anchor watch: %s", AnchorWatch::stateName(s));
+      }
+      if (watch_alarm_pin_ >= 0) digitalWrite(watch_alarm_pin_, s == AnchorWatch::kDrag ? HIGH : LOW);
+      watch_frame_pending_ = true;
+    }
+  }
+
+  // Ακτίνες σε ακέραια μέτρα: ο θόρυβος του GPS δεν βγάζει deltas
+  void updateWatchTelemetry_() {
+    const AnchorWatch::State s = watch_.state();
+    const bool on = s != AnchorWatch::kOff;
+    g_telemetry.set_string(tm_.watch_state, AnchorWatch::stateName(s), s == AnchorWatch::kDrag);
+    g_telemetry.set_float(tm_.watch_max_radius, on ? roundf(watch_.alarm_radius_m()) : NAN);
+    g_telemetry.set_float(tm_.watch_current_radius, on ? roundf(watch_.distance_m()) : NAN);
+    g_telemetry.set_float(tm_.watch_swing_radius, on ? roundf(watch_.swing_radius_m()) : NAN);
+    g_telemetry.set_float(tm_.watch_swing_offset, on ? roundf(watch_.swing_offset_m()) : NAN);
+  }
+
+  // navigation.anchor.position και notifications.navigation.anchor είναι
+  // αντικείμενα: δικό τους frame όταν αλλάζουν και κάθε kWatchObjectKeepaliveMs
+  void publishWatchObjects_(SKWSClient* ws, uint32_t now_ms) {
+    const bool keepalive = watch_.has_anchor() && now_ms - watch_frame_ms_ >= kWatchObjectKeepaliveMs;
+    if (!watch_frame_pending_ && !keepalive) return;
+    watch_frame_pending_ = false;
+    watch_frame_ms_ = now_ms;
+    const AnchorWatch::State s = watch_.state();
+    const bool anchored = watch_.has_anchor();
+    const char* level = "normal";
+    const char* method = "[]";
+    char message[80];
+    if (s == AnchorWatch::kDrag) {
+      level = "emergency";
+      method = "[\"visual\",\"sound\"]";
+      snprintf(message, sizeof(message), "Anchor dragging: %.0fm from the anchor, radius %.0fm",
+               watch_.distance_m(), watch_.alarm_radius_m());
+    } else if (s == AnchorWatch::kNoFix) {
+      level = "warn";
+      method = "[\"visual\"]";
+      snprintf(message, sizeof(message), "Anchor watch: no position fix");
+    } else {
+      snprintf(message, sizeof(message), "Anchor watch: %s", AnchorWatch::stateName(s));
+    }
+    watch_enc_.begin();
+    watch_enc_.begin_object(SK_PATH_KEY("navigation.anchor.position"));
+    watch_enc_.member_fixed("latitude", anchored ? watch_.anchor_lat() : NAN, 7);
+    watch_enc_.member_fixed("longitude", anchored ? watch_.anchor_lon() : NAN, 7);
+    watch_enc_.end_object();
+    watch_enc_.begin_object(SK_PATH_KEY("notifications.navigation.anchor"));
+    watch_enc_.member("state", level);
+    watch_enc_.member_raw("method", method);
+    watch_enc_.member("message", message);
+    watch_enc_.end_object();
+    const char* frame = watch_enc_.finish();
+    if (!frame) return;
+    tx_payload_ = frame;
+    ws->sendTXT(tx_payload_);
+  }
+
+  // Καλείται από το tick(): ένα frame με τις τιμές όλων των channels
+  void publishTelemetry_(unsigned long now_ms) {
+    SKWSClient* ws = wsReady_();
+    if (!ws) return;
+    AllocScope scope(g_heap_stats, kAllocTelemetry);
+    for (auto& ch : channels_) ch->updateTelemetry_();
+    updateWatchTelemetry_();
+    g_telemetry.set_int(tm_.tx_frames, (int32_t)g_telemetry.frames_sent());
+    g_telemetry.set_int(tm_.tx_bytes, (int32_t)g_telemetry.bytes_sent());
+    g_telemetry.poll((uint32_t)now_ms, time(nullptr), [this, ws](const char* frame, size_t) {
+      // Η χωρητικότητα φτάνει για κάθε frame, άρα το assign δεν ξαναδεσμεύει
+      tx_payload_ = frame;
+      ws->sendTXT(tx_payload_);
+    });
+    publishWatchObjects_(ws, (uint32_t)now_ms);
+  }
+
+  // Ζητάει άμεσο heartbeat. Με include_enabled ξαναστέλνονται όλες οι τιμές
+  // (π.χ. αμέσως μετά από reconnect).
+  void sendHeartbeat(bool include_enabled = false) {
+    if (include_enabled) {
+      g_telemetry.invalidate();
+      watch_frame_pending_ = true;
+      return;
+    }
+    for (auto& ch : channels_) ch->sendHeartbeat();
+  }
+
+  // Wall clock ενός micros() timestamp. false αν η ώρα δεν έχει οριστεί.
+  static bool wallTime_(uint32_t t_us, time_t& secs, uint32_t& ms) {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    if (tv.tv_sec < 1600000000) return false;
+    const int64_t at_ms = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000 -
+                          (int64_t)((uint32_t)(micros() - t_us) / 1000);
+    secs = (time_t)(at_ms / 1000);
+    ms = (uint32_t)(at_ms % 1000);
+    return true;
+  }
+
+  static const char* ackCommandName_(const CommandAck& a) {
+    switch (a.type) {
+      case MotorCommand::kFsm:          return WindlassFsm::commandName((WindlassFsm::Command)a.arg);
+      case MotorCommand::kStop:         return "stop";
+      case MotorCommand::kSetTarget:    return "chainTargetSet";
+      case MotorCommand::kSetChainOut:  return "chainOutSet";
+      case MotorCommand::kResetCounter: return "resetChainCounter";
+      case MotorCommand::kApplyConfig:  return "defaultChainSeconds";
+    }
+    return "";
+  }
+
+  // Latency στα histograms και ack delta αμέσως, έξω από το coalescing
+  // window, στο commandAck του channel:
+  // {"id","command","source","result","state","receivedAt","actuatedAt","latencyUs"}
+  void onCommandAck_(const WindlassChannel& ch, const CommandAck& a) {
+    const int src = a.source == MotorCommand::kSrcPut ? kCmdLatPut : kCmdLatListener;
+    const uint32_t latency_us = a.actuated_us - a.received_us;
+    g_cmd_stats.acked++;
+    if (a.actuated) {
+      g_cmd_latency.record(src, latency_us * kCmdLatencyUnitsPerUs);
+      g_cmd_latency_boot[src].record(latency_us * kCmdLatencyUnitsPerUs);
+    }
+    ESP_LOGD(TAG, "Command #%u %s %s (%s): %s%uus", (unsigned)a.id, ch.def_.name,
+             ackCommandName_(a), kCmdLatencyNames[src],
+             a.actuated ? "relays after " : "no relay change, ",
+             a.actuated ? (unsigned)latency_us : 0u);
+
+    SKWSClient* ws = wsReady_();
+    if (!ws) return;
+    AllocScope scope(g_heap_stats, kAllocTelemetry);
+    char received[SkTimestampCache::kMsLen + 1];
+    char actuated[SkTimestampCache::kMsLen + 1];
+    time_t secs;
+    uint32_t ms;
+    const bool wall = wallTime_(a.received_us, secs, ms);
+    if (wall) SkTimestampCache::render_ms(received, secs, ms);
+    const bool act_wall = a.actuated && wallTime_(a.actuated_us, secs, ms);
+    if (act_wall) SkTimestampCache::render_ms(actuated, secs, ms);
+    ack_enc_.begin();
+    ack_enc_.begin_object(ch.ack_path_);
+    ack_enc_.member("id", a.id);
+    ack_enc_.member("command", ackCommandName_(a));
+    ack_enc_.member("source", kCmdLatencyNames[src]);
+    ack_enc_.member("result", WindlassCore::outcomeName(a.outcome));
+    ack_enc_.member("state", WindlassFsm::stateName(a.state));
+    ack_enc_.member("receivedAt", wall ? received : nullptr);
+    ack_enc_.member("actuatedAt", act_wall ? actuated : nullptr);
+    if (a.actuated) ack_enc_.member("latencyUs", latency_us);
+    else ack_enc_.member("latencyUs", (const char*)nullptr);
+    ack_enc_.end_object();
+    const char* frame = ack_enc_.finish();
+    if (!frame) return;
+    tx_payload_ = frame;
+    ws->sendTXT(tx_payload_);
+  }
+
+  // Πόσο μπορεί να κοιμηθεί το loop task χωρίς να αργήσει ο anchor:
+  // το επόμενο telemetry frame, ή οι πυρήνες όταν τρέχουν inline.
+  uint32_t loopMsUntilDue(unsigned long now_ms) {
+    uint32_t wait = wsReady_() ? g_telemetry.ms_until_due((uint32_t)now_ms) : UINT32_MAX;
+    if (!g_motor_task) {
+      for (auto& ch : channels_) {
+        const uint32_t core = ch->msUntilDue(now_ms, kMotorPeriodMs);
+        if (core < wait) wait = core;
+      }
+    }
+    return wait;
+  }
+
+  void startTimers() { g_timers.schedule(perf_timer_, kPerfWindowMs); }
+
+  // Blink LED when relays are active: ένα toggle ανά δευτερόλεπτο
+  static void ledBlink_(void* arg) {
+    auto* self = static_cast<AnchorController*>(arg);
+    self->led_state_ = !self->led_state_;
+    digitalWrite(LED_BUILTIN, self->led_state_ ? HIGH : LOW);
+    g_timers.schedule(self->led_timer_, 1000);
+  }
+
+  // Network side του loop: το motor task κάνει relays/timers/μετρητές
+  void tick() {
+    const unsigned long now_ms = millis();
+    extern SKWSConnectionState g_ws_state;
+    const bool link_up = g_ws_state == SKWSConnectionState::kSKWSConnected;
+
+    bool relays_on = false;
+    const float depth_m = depth_.depth_m((uint32_t)now_ms);
+    for (auto& ch : channels_) {
+      ch->scope_.set_depth(depth_m);
+      ch->tick(now_ms, link_up);
+      CommandAck ack;
+      while (ch->link_.acks.pop(ack)) onCommandAck_(*ch, ack);
+      relays_on |= ch->snap_.relays_on;
+    }
+    if (!g_motor_task) updateCurrentSampler_();
+    updateWatch_(now_ms);
+
+    // Coalesced telemetry (αλλαγές + keepalive heartbeat)
+    publishTelemetry_(now_ms);
+
+    // Blink LED when relays are active (οποιουδήποτε channel)
+    if (relays_on != led_active_) {
+      led_active_ = relays_on;
+      if (led_active_) {
+        g_timers.schedule(led_timer_, 0);
+      } else {
+        g_timers.cancel(led_timer_);
+        led_state_ = false;
+        digitalWrite(LED_BUILTIN, LOW);
+      }
+    }
+  }
+
+  void attachSignalK() {
+    for (auto& ch : channels_) ch->attachSignalK();
+    // Θέση για το anchor watch: δεδομένα, όχι εντολή, άρα χωρίς settling
+    auto position = new SKValueListener<Position>("navigation.position", kPositionPeriodMs);
+    position->connect_to(new LambdaConsumer<Position>([this](const Position& p) { onFix_(p); }));
+    // Βάθος για το scope: belowSurface, αλλιώς belowKeel + βύθισμα
+    auto surface = new FloatSKListener("environment.depth.belowSurface", kDepthPeriodMs);
+    surface->connect_to(new LambdaConsumer<float>(
+        [this](float d) { onDepth_(DepthFilter::kSurface, d); }));
+    auto keel = new FloatSKListener("environment.depth.belowKeel", kDepthPeriodMs);
+    keel->connect_to(new LambdaConsumer<float>([this](float d) { onDepth_(DepthFilter::kKeel, d); }));
+  }
+};
+
+// --------- Globals ----------
+std::shared_ptr<AnchorController> anchor;
+SKWSConnectionState g_ws_state = SKWSConnectionState::kSKWSDisconnected;
+unsigned long g_connection_time = 0;
+
+// ---------- Loop timers ----------
+static constexpr uint32_t kInitialHeartbeatMs = 500;  // μετά το connect
+static constexpr uint32_t kWifiLogMs = 60000;
+static constexpr uint32_t kWsReconnectBaseMs = 500;       // πρώτη προσπάθεια σε 250-500ms
+static constexpr uint32_t kWsReconnectMaxMs = 60000;
+static constexpr uint32_t kWsRestartAfterMs = 8 * 60000;  // συνεχής διακοπή τόσο = restart
+
+static ReconnectBackoff g_ws_backoff(kWsReconnectBaseMs, kWsReconnectMaxMs);
+
+// Για soak tests: πόσες φορές ήρθε/έπεσε η σύνδεση (οι προσπάθειες στο g_ws_backoff)
+static uint32_t g_ws_connects = 0;
+static uint32_t g_ws_disconnects = 0;
+
+// Οι μετρητές του loop task για το /api/anchor/stats. Ο handler τρέχει στο
+// httpd task και διαβάζει μόνο αυτό το αντίγραφο, που γράφεται στο τέλος
+// κάθε περάσματος του loop.
+struct LoopStats {
+  uint32_t at_ms;                  // millis() του write
+  int      ws_state;
+  uint32_t ws_connects;
+  uint32_t ws_disconnects;
+  ReconnectBackoff::Stats backoff;
+  uint8_t  backoff_attempt;
+  bool     ws_down;
+  uint32_t outage_ms;              // μέχρι το at_ms
+  uint32_t next_delay_ms;
+  CommandStats commands;
+  uint32_t last_cmd_id;
+  uint32_t tx_frames;
+  uint32_t tx_bytes;
+  uint32_t tx_overflows;
+  bool     has_anchor;             // τα παρακάτω μόνο με anchor
+  AnchorWatch::State  watch_state;
+  AnchorWatch::Source watch_source;
+  uint32_t watch_fixes;
+  uint32_t watch_rejected;
+  uint32_t watch_max_fix_us;
+  DepthFilter::Source depth_source;
+  float    depth_m;
+  uint32_t depth_samples;
+  uint32_t depth_rejected;
+};
+static Seqlock<LoopStats> g_loop_stats;
+
+static void publishLoopStats_(uint32_t now_ms) {
+  LoopStats s;
+  memset(&s, 0, sizeof(s));
+  s.at_ms = now_ms;
+  s.ws_state = (int)g_ws_state;
+  s.ws_connects = g_ws_connects;
+  s.ws_disconnects = g_ws_disconnects;
+  s.backoff = g_ws_backoff.stats();
+  s.backoff_attempt = g_ws_backoff.attempt();
+  s.ws_down = g_ws_backoff.down();
+  s.outage_ms = g_ws_backoff.outage_ms(now_ms);
+  s.next_delay_ms = s.ws_down ? g_ws_backoff.last_delay_ms() : 0;
+  s.commands = g_cmd_stats;
+  s.last_cmd_id = g_next_cmd_id - 1;
+  s.tx_frames = g_telemetry.frames_sent();
+  s.tx_bytes = g_telemetry.bytes_sent();
+  s.tx_overflows = g_telemetry.overflows();
+  if (anchor) {
+    const AnchorWatch& w = anchor->watch_;
+    const DepthFilter& d = anchor->depth_;
+    s.has_anchor = true;
+    s.watch_state = w.state();
+    s.watch_source = w.source();
+    s.watch_fixes = w.fixes();
+    s.watch_rejected = w.rejected();
+    s.watch_max_fix_us = anchor->watch_max_fix_us_;
+    s.depth_source = d.source();
+    s.depth_m = d.depth_m(now_ms);
+    s.depth_samples = d.samples();
+    s.depth_rejected = d.rejected();
+  }
+  g_loop_stats.write(s);
+}
+
+// Ξαναστέλνει όλες τις τιμές λίγο μετά το connect
+static void initialHeartbeat_(void*) {
+  if (!anchor || g_ws_state != SKWSConnectionState::kSKWSConnected) return;
+  ESP_LOGI(TAG, "Sending initial enabled=true to SignalK");
+  anchor->sendHeartbeat(true);
+}
+
+// Πρώτο connect + settling: από εδώ γίνονται δεκτές και οι εντολές των
+// listeners. Κλείνει το boot timeline και το στέλνει μία φορά.
+static void readyForCommands_(void*) {
+  if (g_ws_state != SKWSConnectionState::kSKWSConnected) return;
+  if (!g_boot.mark(kBootReady, millis())) return;
+  ESP_LOGI(TAG, "Boot: relaysSafe=%ums configLoaded=%ums wifiUp=%ums wsConnected=%ums ready=%ums",
+           (unsigned)g_boot.at(kBootRelaysSafe), (unsigned)g_boot.at(kBootConfigLoaded),
+           (unsigned)g_boot.at(kBootWifiUp), (unsigned)g_boot.at(kBootWsConnected),
+           (unsigned)g_boot.at(kBootReady));
+  if (anchor) anchor->publishBoot_();
+}
+
+static void wifiLog_(void*);
+static void wsWatchdog_(void*);
+
+static const char* resetReasonName_(esp_reset_reason_t r) {
+  switch (r) {
+    case ESP_RST_POWERON:   return "poweron";
+    case ESP_RST_EXT:       return "external";
+    case ESP_RST_SW:        return "software";
+    case ESP_RST_PANIC:     return "panic";
+    case ESP_RST_INT_WDT:   return "int_wdt";
+    case ESP_RST_TASK_WDT:  return "task_wdt";
+    case ESP_RST_WDT:       return "wdt";
+    case ESP_RST_DEEPSLEEP: return "deepsleep";
+    case ESP_RST_BROWNOUT:  return "brownout";
+    default:                return "unknown";
+  }
+}
+
+// Heap τώρα + μετρητές δεσμεύσεων → RTC στιγμιότυπο και telemetry
+static void heapSample_(void*);
+WheelTimer g_heap_timer(&heapSample_, nullptr);
+
+static void heapSample_(void*) {
+  g_timers.schedule(g_heap_timer, kHeapSampleMs);
+  HeapRtcRecord r = g_heap_rtc;
+  r.uptime_s = millis() / 1000;
+  r.free_bytes = ESP.getFreeHeap();
+  r.min_free_bytes = ESP.getMinFreeHeap();
+  r.largest_block = ESP.getMaxAllocHeap();
+  for (int i = 0; i < kAllocSubsystemCount; i++) r.allocs[i] = g_heap_stats.allocs(i);
+  r.frees = g_heap_stats.frees();
+  r.failed = g_heap_stats.failed();
+  r.seal();
+  g_heap_rtc = r;
+  if (anchor) anchor->publishHeap_(r);
+}
+
+// Στην αρχή του setup(): κρατάει το στιγμιότυπο του προηγούμενου boot
+static void heapBoot_() {
+  g_alloc_task = xTaskGetCurrentTaskHandle();
+  g_reset_reason = esp_reset_reason();
+  uint32_t boots = 1;
+  if (g_reset_reason != ESP_RST_POWERON && g_heap_rtc.valid()) {
+    g_heap_prev = g_heap_rtc;
+    g_heap_prev_valid = true;
+    boots = g_heap_prev.boots + 1;
+  }
+  memset(&g_heap_rtc, 0, sizeof(g_heap_rtc));
+  g_heap_rtc.boots = boots;
+  g_heap_rtc.seal();
+}
+
+// Πριν από κάθε restart που κάνει το firmware: μετρητές και run state στη
+// RTC μνήμη, χωρίς εγγραφή σε flash. Στο setup() πριν υπάρξει ο anchor δεν
+// γράφει τίποτα, ώστε να μη χαθεί ένα record που δεν έχει διαβαστεί ακόμα.
+static void saveCountersToRtc_(CounterRtcRecord::Reason reason) {
+  if (!anchor) return;
+  CounterRtcRecord r;
+  memset(&r, 0, sizeof(r));
+  r.channels = kChannels;
+  r.reason = reason;
+  r.uptime_ms = millis();
+  for (auto& ch : anchor->channels_) {
+    MotorSnapshot s;
+    ch->link_.snapshot.read(s);
+    r.ch[ch->index_].pulses = s.chain_pulse_count;
+    r.ch[ch->index_].meters = s.chain_out_meters;
+    r.ch[ch->index_].state = (uint8_t)s.state;
+  }
+  r.seal();
+  g_counter_rtc = r;
+}
+
+static void restartKeepingCounters_(CounterRtcRecord::Reason reason) {
+  delay(100);  // να φύγουν τα logs
+  saveCountersToRtc_(reason);
+  ESP.restart();
+}
+
+WheelTimer g_initial_heartbeat_timer(&initialHeartbeat_, nullptr);
+WheelTimer g_ready_timer(&readyForCommands_, nullptr);
+WheelTimer g_wifi_log_timer(&wifiLog_, nullptr);
+WheelTimer g_ws_watchdog_timer(&wsWatchdog_, nullptr);
+
+static void wifiLog_(void*) {
+  g_timers.schedule(g_wifi_log_timer, kWifiLogMs);
+  if (WiFi.isConnected()) {
+    ESP_LOGI(TAG, "WiFi ok: IP=%s RSSI=%d", WiFi.localIP().toString().c_str(), WiFi.RSSI());
+  } else {
+    ESP_LOGW(TAG, "WiFi disconnected");
+  }
+  if (anchor) {
+    ESP_LOGI(TAG, "Telemetry: frames=%u bytes=%u values=%u marks=%u skipped=%u",
+             (unsigned)g_telemetry.frames_sent(), (unsigned)g_telemetry.bytes_sent(),
+             (unsigned)g_telemetry.values_sent(), (unsigned)g_telemetry.marks(),
+             (unsigned)g_telemetry.skipped_unchanged());
+    for (auto& ch : anchor->channels_) {
+      ESP_LOGI(TAG, "Motor %s: steps=%u last=%uus max=%uus mailbox_drops=%u", ch->def_.name,
+               (unsigned)ch->snap_.seq, (unsigned)ch->snap_.last_step_us,
+               (unsigned)ch->snap_.max_step_us, (unsigned)ch->link_.commands.overflows());
+      const SessionLogWriter::Stats& sl = g_sessions.stats(ch->index_);
+      ESP_LOGI(TAG, "Session log %s: events=%u bytes=%u segments=%u evicted=%u errors=%u",
+               ch->def_.name, (unsigned)sl.events, (unsigned)sl.bytes,
+               (unsigned)sl.segments_opened, (unsigned)sl.segments_evicted,
+               (unsigned)sl.write_errors);
+    }
+    ESP_LOGI(TAG, "Session log: drops=%u", (unsigned)g_sessions.dropped());
+    ESP_LOGI(TAG, "Heap: free=%u min=%u largest=%u allocs=%u/%u/%u/%u/%u frees=%u failed=%u",
+             (unsigned)ESP.getFreeHeap(), (unsigned)ESP.getMinFreeHeap(),
+             (unsigned)ESP.getMaxAllocHeap(), (unsigned)g_heap_stats.allocs(kAllocOther),
+             (unsigned)g_heap_stats.allocs(kAllocEventLoop), (unsigned)g_heap_stats.allocs(kAllocCommands),
+             (unsigned)g_heap_stats.allocs(kAllocTelemetry), (unsigned)g_heap_stats.allocs(kAllocTimers),
+             (unsigned)g_heap_stats.frees(), (unsigned)g_heap_stats.failed());
+    ESP_LOGI(TAG, "Wakeups/s: loop=%.1f motor=%.1f timers=%u pending",
+             anchor->loop_wakeups_per_s_, anchor->motor_wakeups_per_s_,
+             (unsigned)g_timers.pending());
+  }
+}
+
+// Οπλίζεται όσο δεν υπάρχει σύνδεση (βλ. το consumer στο setup), με
+// καθυστερήσεις από το g_ws_backoff
+static void wsWatchdog_(void*) {
+  auto app = ::sensesp::SensESPApp::get();
+  if (!app || g_ws_state == SKWSConnectionState::kSKWSConnected) return;
+  const uint32_t now_ms = millis();
+  if (g_ws_backoff.outage_ms(now_ms) >= kWsRestartAfterMs) {
+    ESP_LOGE(TAG, "WS watchdog: no connection for %us after %u attempts, restarting ESP32",
+             (unsigned)(g_ws_backoff.outage_ms(now_ms) / 1000),
+             (unsigned)g_ws_backoff.attempt());
+    restartKeepingCounters_(CounterRtcRecord::kWsWatchdog);
+  }
+  auto ws = app->get_ws_client();
+  if (!ws) return;
+  // Χωρίς WiFi ή με μια σύνδεση σε εξέλιξη δεν μετράει προσπάθεια: ξανά
+  // σύντομα, ώστε η πρώτη να γίνει μόλις έρθει το WiFi
+  if (!WiFi.isConnected() || g_ws_state != SKWSConnectionState::kSKWSDisconnected) {
+    g_timers.schedule(g_ws_watchdog_timer, kWsReconnectBaseMs);
+    return;
+  }
+  const uint32_t next_ms = g_ws_backoff.on_attempt();
+  ESP_LOGW(TAG, "WS watchdog: reconnect attempt %u, next in %ums", (unsigned)g_ws_backoff.attempt(),
+           (unsigned)next_ms);
+  ws->connect();
+  g_timers.schedule(g_ws_watchdog_timer, next_ms);
+}
+
+// ---------- UDP transport ----------
+// Το UdpLink (include/udp_link.h) σε δικό του task στον πυρήνα του δικτύου:
+// μπλοκάρει στο socket και γράφει τις εντολές κατευθείαν στα udp_commands
+// των channels, χωρίς να περιμένει το loop task ή το WebSocket.
+static constexpr UBaseType_t kUdpTaskPriority = 5;  // πάνω από το loop, κάτω από lwIP
+
+class UdpTransport {
+ public:
+  bool begin(int port, const char* passphrase) {
+    sock_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock_ < 0) return false;
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(sock_, (sockaddr*)&addr, sizeof(addr)) < 0) {
+      close(sock_);
+      sock_ = -1;
+      return false;
+    }
+    uint8_t key[16];
+    udp_wire::derive_key(passphrase, key);
+    MotorLink* links[kChannels];
+    for (int i = 0; i < kChannels; i++) links[i] = &anchor->channels_[i]->link_;
+    link_.begin(key, passphrase[0] != '\0', links, kChannels, &UdpTransport::send_,
+                &UdpTransport::notifyMotor_, &esp_random, this);
+    port_ = port;
+    const BaseType_t core = xPortGetCoreID();
+    if (xTaskCreatePinnedToCore(&UdpTransport::task_, "udp", 4096, this, kUdpTaskPriority,
+                                &task_handle_, core) != pdPASS) {
+      close(sock_);
+      sock_ = -1;
+      return false;
+    }
+    return true;
+  }
+
+  bool running() const { return task_handle_ != nullptr; }
+  int port() const { return port_; }
+  const UdpLink& link() const { return link_; }
+
+ private:
+  static void task_(void* arg) {
+    auto* self = static_cast<UdpTransport*>(arg);
+    uint8_t buf[256];
+    for (;;) {
+      const uint32_t wait = self->link_.ms_until_due(millis());
+      fd_set rd;
+      FD_ZERO(&rd);
+      FD_SET(self->sock_, &rd);
+      timeval tv;
+      tv.tv_sec = wait / 1000;
+      tv.tv_usec = (wait % 1000) * 1000;
+      if (select(self->sock_ + 1, &rd, nullptr, nullptr, &tv) > 0) {
+        sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        const int n = recvfrom(self->sock_, buf, sizeof(buf), 0, (sockaddr*)&from, &from_len);
+        if (n > 0) {
+          self->link_.on_datagram(from.sin_addr.s_addr, ntohs(from.sin_port), buf, (size_t)n,
+                                  millis());
+        }
+      }
+      self->link_.poll(millis(), g_ws_state == SKWSConnectionState::kSKWSConnected);
+    }
+  }
+
+  static void send_(void* ctx, uint32_t addr, uint16_t port, const uint8_t* p, size_t n) {
+    auto* self = static_cast<UdpTransport*>(ctx);
+    sockaddr_in to = {};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(port);
+    to.sin_addr.s_addr = addr;
+    sendto(self->sock_, p, n, 0, (sockaddr*)&to, sizeof(to));
+  }
+
+  static void notifyMotor_(void*) {
+    if (g_motor_task) xTaskNotifyGive(g_motor_task);
+  }
+
+  UdpLink      link_;
+  int          sock_ = -1;
+  int          port_ = 0;
+  TaskHandle_t task_handle_ = nullptr;
+};
+
+UdpTransport g_udp;
+
+// ---------- Live status (Server-Sent Events) ----------
+// GET /live: μια μικρή σελίδα για το tablet στην πλώρη, χωρίς Signal K
+// server. GET /api/anchor/live: text/event-stream, ένα event σε κάθε αλλαγή
+// (state, αλυσίδα, παλμοί/s, τελευταία εντολή ή αιτία stop, scope, watch).
+//
+// Ο esp_http_server έχει ένα task: ένας handler που κρατάει τη σύνδεση θα
+// τον μπλόκαρε. Ο handler στέλνει μόνο τα headers και κρατάει το socket.
+// Τα events τα γράφει μια δουλειά στην ουρά του server (httpd_queue_work)
+// χωρίς αναμονή (MSG_DONTWAIT): όποιος client δεν προλαβαίνει κλείνει. Το
+// loop task απλώς φτιάχνει το event σε έναν buffer κάθε kPollMs και το
+// συγκρίνει με το προηγούμενο - ποτέ δεν περιμένει socket.
+//
+// Buffers: next_ (loop task), out_ (loop task όσο !in_flight_, μετά httpd).
+// Τα slots των clients τα αλλάζει μόνο το httpd task.
+class LiveStream {
+ public:
+  static constexpr int      kMaxClients = 3;      // τα υπόλοιπα sockets μένουν στο web UI
+  static constexpr uint32_t kPollMs = 200;         // ≤ 5 events/s
+  static constexpr uint32_t kKeepaliveMs = 15000;  // ίδιο event, για proxies / νεκρά sockets
+  static constexpr size_t   kEventBytes = 96 + 192 * kChannels;
+
+  void start() { g_timers.schedule(timer_, kPollMs); }
+
+  // httpd task: headers, και το socket μένει ανοιχτό για τα events
+  esp_err_t open(httpd_req_t* req) {
+    Client* c = nullptr;
+    for (Client& x : clients_) {
+      if (x.fd < 0) {
+        c = &x;
+        break;
+      }
+    }
+    if (!c) {
+      rejected_++;
+      static const char kBusy[] = "too many live clients";
+      httpd_resp_set_status(req, "503 Service Unavailable");
+      httpd_resp_set_hdr(req, "Retry-After", "10");
+      return httpd_resp_send(req, kBusy, sizeof(kBusy) - 1);
+    }
+    static const char kHead[] =
+        "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\n"
+        "Connection: keep-alive\r\n\r\nretry: 3000\n\n";
+    if (httpd_send(req, kHead, sizeof(kHead) - 1) != (int)sizeof(kHead) - 1) return ESP_FAIL;
+    hd_ = req->handle;
+    c->fd = httpd_req_to_sockfd(req);
+    c->closing = false;
+    c->owner = this;
+    // Το free_ctx καλείται όταν ο server κλείσει το session (client έφυγε,
+    // LRU purge ή trigger_close): μόνο τότε ελευθερώνεται το slot
+    req->sess_ctx = c;
+    req->free_ctx = &LiveStream::closed_;
+    opened_++;
+    count_.fetch_add(1);
+    resend_.store(true);
+    return ESP_OK;
+  }
+
+  uint8_t  clients() const { return count_.load(); }
+  uint32_t opened() const { return opened_; }
+  uint32_t rejected() const { return rejected_; }
+  uint32_t dropped() const { return dropped_; }
+  uint32_t events() const { return events_; }
+  uint32_t bytes() const { return bytes_; }
+
+ private:
+  struct Client {
+    int         fd = -1;
+    bool        closing = false;
+    LiveStream* owner = nullptr;
+  };
+
+  // httpd task
+  static void closed_(void* ctx) {
+    Client* c = static_cast<Client*>(ctx);
+    c->fd = -1;
+    c->closing = false;
+    c->owner->count_.fetch_sub(1);
+  }
+
+  // httpd task: το ίδιο event σε όλους
+  static void send_(void* arg) {
+    LiveStream* self = static_cast<LiveStream*>(arg);
+    for (Client& c : self->clients_) {
+      if (c.fd < 0 || c.closing) continue;
+      const int n = httpd_socket_send(self->hd_, c.fd, self->out_, self->out_len_, MSG_DONTWAIT);
+      if (n != (int)self->out_len_) {
+        // Μισό event θα χαλούσε το stream: κλείνει, το EventSource ξανασυνδέεται
+        self->dropped_++;
+        c.closing = true;
+        httpd_sess_trigger_close(self->hd_, c.fd);
+      }
+    }
+    self->in_flight_.store(false);
+  }
+
+  static void poll_(void* arg) {
+    LiveStream* self = static_cast<LiveStream*>(arg);
+    self->poll(millis());
+    g_timers.schedule(self->timer_, kPollMs);
+  }
+
+  // Loop task
+  void poll(uint32_t now_ms) {
+    if (count_.load() == 0 || !anchor || in_flight_.load()) return;
+    const size_t n = format_(next_, sizeof(next_));
+    if (!n) return;
+    const bool changed = n != out_len_ || memcmp(next_, out_, n) != 0;
+    if (!changed && !resend_.load() && now_ms - sent_ms_ < kKeepaliveMs) return;
+    resend_.store(false);
+    memcpy(out_, next_, n);
+    out_len_ = n;
+    sent_ms_ = now_ms;
+    in_flight_.store(true);
+    if (httpd_queue_work(hd_, &LiveStream::send_, this) != ESP_OK) {
+      in_flight_.store(false);
+      return;
+    }
+    events_++;
+    bytes_ += n;
+  }
+
+  // "null" για NAN, αλλιώς ένα δεκαδικό
+  static const char* fixed1_(char* out, size_t len, float v) {
+    if (isnan(v) || isinf(v)) return "null";
+    snprintf(out, len, "%.1f", v);
+    return out;
+  }
+
+  size_t format_(char* out, size_t len) {
+    extern SKWSConnectionState g_ws_state;
+    int n = snprintf(out, len, "data: {\"sk\":%s,\"ch\":[",
+                     g_ws_state == SKWSConnectionState::kSKWSConnected ? "true" : "false");
+    for (auto& ch : anchor->channels_) {
+      if (n >= (int)len) return 0;
+      // Τρέχει από το timer wheel του loop task (του writer), αλλά με όριο:
+      // ένα event λιγότερο αντί για κόλλημα αν μετακινηθεί σε άλλο task
+      AnchorSettings st;
+      if (!ch->settings_.read_yielding(st)) return 0;
+      const MotorSnapshot& s = ch->snap_;
+      const float rate = st.core.chain_calibration > 0.0f ? s.chain_speed / st.core.chain_calibration : 0.0f;
+      char scope[16];
+      n += snprintf(out + n, len - n,
+                    "%s{\"name\":\"%s\",\"state\":\"%s\",\"chainOut\":%.1f,\"pulseRate\":%.1f,"
+                    "\"last\":\"%s\",\"scope\":%s}",
+                    ch->index_ ? "," : "", ch->def_.name, WindlassFsm::stateName(s.state),
+                    s.chain_out_meters, rate, ch->last_command_ ? ch->last_command_ : "",
+                    fixed1_(scope, sizeof(scope), ch->scope_.scope()));
+    }
+    if (n >= (int)len) return 0;
+    n += snprintf(out + n, len - n, "],\"watch\":\"%s\"}\n\n",
+                  AnchorWatch::stateName(anchor->watch_.state()));
+    return n < (int)len ? (size_t)n : 0;
+  }
+
+  Client             clients_[kMaxClients];
+  httpd_handle_t     hd_ = nullptr;
+  std::atomic<uint8_t> count_{0};
+  std::atomic<bool>  in_flight_{false};
+  std::atomic<bool>  resend_{false};   // νέος client: στείλε ό,τι υπάρχει
+  char               next_[kEventBytes];
+  char               out_[kEventBytes];
+  size_t             out_len_ = 0;
+  uint32_t           sent_ms_ = 0;
+  uint32_t           opened_ = 0, rejected_ = 0, dropped_ = 0;
+  uint32_t           events_ = 0, bytes_ = 0;
+  WheelTimer         timer_{&LiveStream::poll_, this};
+};
+
+LiveStream g_live;
+
+// Η σελίδα του /live: σταθερή, μένει στο flash (const). Κάθε event ξαναγράφει μόνο τα
+// κείμενα, η σελίδα δεν ξαναφορτώνεται.
+static const char kLivePage[] = R"###(<!doctype html>
+<meta name=viewport content="width=device-width,initial-scale=1"><title>Anchor</title>
+<style>body{font:18px sans-serif;margin:1em;background:#111;color:#eee}
+b{display:block;font-size:3.5em}h3{margin:.8em 0 0}.x{color:#f55}</style>
+<div id=c></div><p id=w></p><p id=s>connecting...</p>
+<script>
+var $=function(i){return document.getElementById(i)},e=new EventSource('/api/anchor/live');
+e.onopen=function(){$('s').textContent='live'};
+e.onerror=function(){$('s').textContent='reconnecting...'};
+e.onmessage=function(m){var d=JSON.parse(m.data),h='';
+d.ch.forEach(function(x){h+='<h3>'+x.name+': '+x.state.replace('_',' ')+'</h3><b>'+
+x.chainOut.toFixed(1)+' m</b>'+x.pulseRate.toFixed(1)+' pulses/s &middot; scope '+
+(x.scope==null?'-':x.scope.toFixed(1))+' &middot; '+(x.last||'-')});
+$('c').innerHTML=h;$('w').textContent='anchor watch: '+d.watch;
+$('w').className=d.watch=='drag'?'x':'';$('s').textContent=d.sk?'live':'live (Signal K offline)'};
+</script>
+)###";
+
+// GET /live και GET /api/anchor/live (βλ. LiveStream)
+static void registerLiveEndpoints() {
+  auto app = ::sensesp::SensESPApp::get();
+  if (!app) return;
+  auto server = app->get_http_server();
+  if (!server) return;
+  auto page = std::make_shared<HTTPRequestHandler>(
+      1 << HTTP_GET, "/live", [](httpd_req_t* req) {
+        httpd_resp_set_type(req, "text/html");
+        return httpd_resp_send(req, kLivePage, sizeof(kLivePage) - 1);
+      });
+  server->add_handler(page);
+  auto stream = std::make_shared<HTTPRequestHandler>(
+      1 << HTTP_GET, "/api/anchor/live", [](httpd_req_t* req) { return g_live.open(req); });
+  server->add_handler(stream);
+  g_live.start();
+}
+
+// GET /api/anchor/perf - τα percentiles του τελευταίου window σε JSON
+static void registerPerfEndpoint() {
+  auto app = ::sensesp::SensESPApp::get();
+  if (!app) return;
+  auto server = app->get_http_server();
+  if (!server) return;
+  auto handler = std::make_shared<HTTPRequestHandler>(
+      1 << HTTP_GET, "/api/anchor/perf", [](httpd_req_t* req) {
+        static char body[1024];
+        int n = snprintf(body, sizeof(body), "{\"windowMs\":%lu,\"windows\":%u,\"stages\":{",
+                         kPerfWindowMs, (unsigned)g_loop_perf.windows());
+        for (int i = 0; i < kPerfStageCount && n < (int)sizeof(body); i++) {
+          auto sum = g_loop_perf.summary(i);
+          n += snprintf(body + n, sizeof(body) - n,
+                        "%s\"%s\":{\"count\":%u,\"p50us\":%u,\"p99us\":%u,\"maxus\":%u}",
+                        i ? "," : "", kPerfStageNames[i], (unsigned)sum.count,
+                        (unsigned)sum.p50_us, (unsigned)sum.p99_us, (unsigned)sum.max_us);
+        }
+        if (n < (int)sizeof(body) && anchor) {
+          n += snprintf(body + n, sizeof(body) - n,
+                        "},\"wakeupsPerS\":{\"loop\":%.1f,\"motor\":%.1f", anchor->loop_wakeups_per_s_,
+                        anchor->motor_wakeups_per_s_);
+          if (n < (int)sizeof(body)) n += snprintf(body + n, sizeof(body) - n, "},\"commandLatencyUs\":{");
+          for (int i = 0; i < kCmdLatCount && n < (int)sizeof(body); i++) {
+            auto sum = g_cmd_latency.summary(i);
+            auto boot = g_cmd_latency.summarize(g_cmd_latency_boot[i]);
+            n += snprintf(body + n, sizeof(body) - n,
+                          "%s\"%s\":{\"count\":%u,\"p50us\":%u,\"p95us\":%u,\"p99us\":%u,"
+                          "\"maxus\":%u,\"sinceBoot\":{\"count\":%u,\"p50us\":%u,\"p95us\":%u,"
+                          "\"maxus\":%u}}",
+                          i ? "," : "", kCmdLatencyNames[i], (unsigned)sum.count,
+                          (unsigned)sum.p50_us, (unsigned)sum.p95_us, (unsigned)sum.p99_us,
+                          (unsigned)sum.max_us, (unsigned)boot.count, (unsigned)boot.p50_us,
+                          (unsigned)boot.p95_us, (unsigned)boot.max_us);
+          }
+          if (g_udp.running() && n < (int)sizeof(body)) {
+            auto udp = g_cmd_latency.summarize(g_udp.link().latency());
+            n += snprintf(body + n, sizeof(body) - n,
+                          ",\"udp\":{\"sinceBoot\":{\"count\":%u,\"p50us\":%u,\"p95us\":%u,"
+                          "\"maxus\":%u}}",
+                          (unsigned)udp.count, (unsigned)udp.p50_us, (unsigned)udp.p95_us,
+                          (unsigned)udp.max_us);
+          }
+        }
+        if (n < (int)sizeof(body)) n += snprintf(body + n, sizeof(body) - n, "}}");
+        if (n >= (int)sizeof(body)) n = sizeof(body) - 1;
+        httpd_resp_set_type(req, "application/json");
+        return httpd_resp_send(req, body, n);
+      });
+  server->add_handler(handler);
+}
+
+// GET /api/anchor/stats - μετρητές για soak tests με έναν εξωτερικό Signal K
+// server: εντολές ανά πηγή (σύγκριση με τα commandAck ids), frames (σύγκριση
+// με όσα έφτασαν), συνδέσεις και heap (διαρροές σε runs πολλών ωρών). Τα
+// δεδομένα του loop task έρχονται από το g_loop_stats, όχι απευθείας.
+static void registerStatsEndpoint() {
+  auto app = ::sensesp::SensESPApp::get();
+  if (!app) return;
+  auto server = app->get_http_server();
+  if (!server) return;
+  auto handler = std::make_shared<HTTPRequestHandler>(
+      1 << HTTP_GET, "/api/anchor/stats", [](httpd_req_t* req) {
+        static char body[2048];
+        LoopStats ls;
+        if (!g_loop_stats.read_yielding(ls)) {
+          static const char kBusy[] = "stats busy";
+          httpd_resp_set_status(req, "503 Service Unavailable");
+          httpd_resp_set_hdr(req, "Retry-After", "1");
+          return httpd_resp_send(req, kBusy, sizeof(kBusy) - 1);
+        }
+        const uint32_t now_ms = millis();
+        const uint32_t outage_ms = ls.ws_down ? ls.outage_ms + (now_ms - ls.at_ms) : 0;
+        int n = snprintf(body, sizeof(body),
+                         "{\"uptimeMs\":%lu,\"heap\":{\"free\":%u,\"minFree\":%u,\"largest\":%u},"
+                         "\"ws\":{\"state\":%d,\"connects\":%u,\"disconnects\":%u,"
+                         "\"watchdogReconnects\":%u,\"reconnectAttempts\":%u,\"reconnects\":%u,"
+                         "\"outageMs\":%u,\"lastOutageMs\":%u,\"longestOutageMs\":%u,"
+                         "\"nextDelayMs\":%u}",
+                         (unsigned long)now_ms, (unsigned)ESP.getFreeHeap(),
+                         (unsigned)ESP.getMinFreeHeap(), (unsigned)ESP.getMaxAllocHeap(),
+                         ls.ws_state, (unsigned)ls.ws_connects, (unsigned)ls.ws_disconnects,
+                         (unsigned)ls.backoff.attempts, (unsigned)ls.backoff_attempt,
+                         (unsigned)ls.backoff.reconnects, (unsigned)outage_ms,
+                         (unsigned)ls.backoff.last_outage_ms,
+                         (unsigned)ls.backoff.longest_outage_ms, (unsigned)ls.next_delay_ms);
+        if (n < (int)sizeof(body) && anchor) {
+          const CommandStats& cs = ls.commands;
+          uint32_t mailbox_drops = 0, ack_drops = 0, session_events = 0;
+          uint32_t stall_trips = 0, overload_trips = 0, sample_drops = 0;
+          for (auto& ch : anchor->channels_) {
+            mailbox_drops += ch->link_.commands.overflows();
+            ack_drops += ch->link_.acks.overflows();
+            session_events += g_sessions.stats(ch->index_).events;
+            MotorSnapshot s;
+            ch->link_.snapshot.read(s);
+            stall_trips += s.stall_trips;
+            overload_trips += s.overload_trips;
+            sample_drops += ch->current_samples_.overflows();
+          }
+          n += snprintf(body + n, sizeof(body) - n,
+                        ",\"commands\":{\"listener\":%u,\"put\":%u,\"acked\":%u,\"ignored\":%u,"
+                        "\"unknown\":%u,\"lastId\":%u,\"mailboxDrops\":%u,\"ackDrops\":%u},"
+                        "\"telemetry\":{\"frames\":%u,\"bytes\":%u,\"overflows\":%u},"
+                        "\"sessionLog\":{\"events\":%u,\"drops\":%u},"
+                        "\"current\":{\"stallTrips\":%u,\"overloadTrips\":%u,\"sampleDrops\":%u}",
+                        (unsigned)cs.accepted[kCmdLatListener], (unsigned)cs.accepted[kCmdLatPut],
+                        (unsigned)cs.acked, (unsigned)cs.ignored, (unsigned)cs.unknown,
+                        (unsigned)ls.last_cmd_id, (unsigned)mailbox_drops,
+                        (unsigned)ack_drops, (unsigned)ls.tx_frames,
+                        (unsigned)ls.tx_bytes, (unsigned)ls.tx_overflows,
+                        (unsigned)session_events, (unsigned)g_sessions.dropped(),
+                        (unsigned)stall_trips, (unsigned)overload_trips, (unsigned)sample_drops);
+        }
+        if (n < (int)sizeof(body) && ls.has_anchor) {
+          n += snprintf(body + n, sizeof(body) - n,
+                        ",\"anchorWatch\":{\"state\":\"%s\",\"anchor\":\"%s\",\"fixes\":%u,"
+                        "\"rejected\":%u,\"maxFixUs\":%u}",
+                        AnchorWatch::stateName(ls.watch_state),
+                        AnchorWatch::sourceName(ls.watch_source), (unsigned)ls.watch_fixes,
+                        (unsigned)ls.watch_rejected, (unsigned)ls.watch_max_fix_us);
+          char depth[16] = "null";
+          if (!isnan(ls.depth_m)) snprintf(depth, sizeof(depth), "%.1f", ls.depth_m);
+          if (n < (int)sizeof(body)) {
+            n += snprintf(body + n, sizeof(body) - n,
+                          ",\"depth\":{\"source\":\"%s\",\"m\":%s,\"samples\":%u,\"rejected\":%u}",
+                          DepthFilter::sourceName(ls.depth_source), depth,
+                          (unsigned)ls.depth_samples, (unsigned)ls.depth_rejected);
+          }
+        }
+        if (n < (int)sizeof(body) && g_udp.running()) {
+          const UdpLink::Stats& us = g_udp.link().stats();
+          n += snprintf(body + n, sizeof(body) - n,
+                        ",\"udp\":{\"port\":%d,\"peers\":%d,\"rx\":%u,\"bad\":%u,\"replayed\":%u,"
+                        "\"commands\":%u,\"duplicates\":%u,\"rejected\":%u,\"busy\":%u,"
+                        "\"notRun\":%u,\"acks\":%u,\"status\":%u}",
+                        g_udp.port(), g_udp.link().peers(), (unsigned)us.rx, (unsigned)us.bad,
+                        (unsigned)us.replayed, (unsigned)us.commands, (unsigned)us.duplicates,
+                        (unsigned)us.rejected, (unsigned)us.busy, (unsigned)us.not_run,
+                        (unsigned)us.acks, (unsigned)us.status);
+        }
+        if (n < (int)sizeof(body)) {
+          n += snprintf(body + n, sizeof(body) - n,
+                        ",\"live\":{\"clients\":%u,\"opened\":%u,\"rejected\":%u,\"dropped\":%u,"
+                        "\"events\":%u,\"bytes\":%u}",
+                        (unsigned)g_live.clients(), (unsigned)g_live.opened(),
+                        (unsigned)g_live.rejected(), (unsigned)g_live.dropped(),
+                        (unsigned)g_live.events(), (unsigned)g_live.bytes());
+        }
+        if (n < (int)sizeof(body)) n += snprintf(body + n, sizeof(body) - n, ",\"allocs\":{");
+        for (int i = 0; i < kAllocSubsystemCount && n < (int)sizeof(body); i++) {
+          n += snprintf(body + n, sizeof(body) - n, "%s\"%s\":{\"count\":%u,\"bytes\":%u}",
+                        i ? "," : "", HeapStats::name(i), (unsigned)g_heap_stats.allocs(i),
+                        (unsigned)g_heap_stats.bytes(i));
+        }
+        if (n < (int)sizeof(body)) {
+          n += snprintf(body + n, sizeof(body) - n, ",\"frees\":%u,\"failed\":%u},\"bootMs\":{",
+                        (unsigned)g_heap_stats.frees(), (unsigned)g_heap_stats.failed());
+        }
+        for (int i = 0; i < kBootMilestoneCount && n < (int)sizeof(body); i++) {
+          n += snprintf(body + n, sizeof(body) - n, g_boot.reached(i) ? "%s\"%s\":%u" : "%s\"%s\":null",
+                        i ? "," : "", BootTimeline::name(i), (unsigned)g_boot.at(i));
+        }
+        if (n < (int)sizeof(body)) {
+          n += snprintf(body + n, sizeof(body) - n, "},\"previousBoot\":{\"resetReason\":\"%s\"",
+                        resetReasonName_(g_reset_reason));
+        }
+        if (n < (int)sizeof(body) && g_counters_restored != CounterRtcRecord::kNone) {
+          n += snprintf(body + n, sizeof(body) - n, ",\"countersFromRtc\":\"%s\"",
+                        CounterRtcRecord::reasonName(g_counters_restored));
+        }
+        if (n < (int)sizeof(body) && g_heap_prev_valid) {
+          n += snprintf(body + n, sizeof(body) - n,
+                        ",\"boots\":%u,\"uptimeS\":%u,\"free\":%u,\"minFree\":%u,\"largest\":%u,"
+                        "\"failed\":%u",
+                        (unsigned)g_heap_prev.boots, (unsigned)g_heap_prev.uptime_s,
+                        (unsigned)g_heap_prev.free_bytes, (unsigned)g_heap_prev.min_free_bytes,
+                        (unsigned)g_heap_prev.largest_block, (unsigned)g_heap_prev.failed);
+        }
+        if (n < (int)sizeof(body)) n += snprintf(body + n, sizeof(body) - n, "}}");
+        if (n >= (int)sizeof(body)) n = sizeof(body) - 1;
+        httpd_resp_set_type(req, "application/json");
+        return httpd_resp_send(req, body, n);
+      });
+  server->add_handler(handler);
+}
+
+// GET /api/anchor/sessions[?channel=N] - όλο το session log ενός channel
+// (παλαιότερο segment πρώτο) σε chunks, χωρίς να φορτωθεί στη RAM.
+// Αποκωδικοποίηση: tools/session_replay.
+static void registerSessionEndpoint() {
+  auto app = ::sensesp::SensESPApp::get();
+  if (!app) return;
+  auto server = app->get_http_server();
+  if (!server) return;
+  auto handler = std::make_shared<HTTPRequestHandler>(
+      1 << HTTP_GET, "/api/anchor/sessions", [](httpd_req_t* req) {
+        static uint8_t chunk[1024];  // ο http server εξυπηρετεί ένα request τη φορά
+        static char disposition[64];
+        char query[32], value[4];
+        int channel = 0;
+        if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+            httpd_query_key_value(query, "channel", value, sizeof(value)) == ESP_OK) {
+          channel = atoi(value);
+        }
+        if (channel < 0 || channel >= kChannels) {
+          httpd_resp_send_err(req, HTTPD_404_NOT_FOUND, "no such channel");
+          return ESP_FAIL;
+        }
+        SessionStore& store = g_sessions.store(channel);
+        httpd_resp_set_type(req, "application/octet-stream");
+        if (channel) {
+          snprintf(disposition, sizeof(disposition), "attachment; filename=\"anchor-sessions-%s.asl\"",
+                   kChannelDefs[channel].name);
+        } else {
+          snprintf(disposition, sizeof(disposition), "attachment; filename=\"anchor-sessions.asl\"");
+        }
+        httpd_resp_set_hdr(req, "Content-Disposition", disposition);
+        uint32_t first, last;
+        if (store.range(first, last)) {
+          for (uint32_t id = first; (int32_t)(last - id) >= 0; id++) {
+            uint32_t offset = 0;
+            int32_t n;
+            // Ένα segment που σβήστηκε στο μεταξύ απλώς λείπει από το export
+            while ((n = store.read(id, offset, chunk, sizeof(chunk))) > 0) {
+              if (httpd_resp_send_chunk(req, (const char*)chunk, n) != ESP_OK) return ESP_FAIL;
+              offset += (uint32_t)n;
+            }
+          }
+        }
+        return httpd_resp_send_chunk(req, nullptr, 0);
+      });
+  server->add_handler(handler);
+}
+
+// ---------- OTA updates (app0/app1, βλ. partitions_sensesp.csv) ----------
+// POST /api/anchor/ota δέχεται είτε ολόκληρο image (.bin, 0xE9) είτε delta
+// patch (tools/ota_diff, "AOP1") πάνω στο image που τρέχει. Το patch
+// εφαρμόζεται όπως φτάνει, κατευθείαν στο ανενεργό slot.
+//
+// Μετά το update το νέο image είναι "σε δοκιμή": επιβεβαιώνεται μόλις μείνει
+// συνδεδεμένο στον Signal K kOtaHealthyMs. Αλλιώς γυρνάμε στο προηγούμενο
+// slot - μετά από kOtaMaxTrialBoots boots (crash loop) ή στο kOtaTrialMs
+// (όταν κανένας windlass δεν κινείται). Η δοκιμή κρατιέται στο NVS, ώστε να
+// δουλεύει και χωρίς CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE. Με αυτό, το
+// ESP_OTA_IMG_PENDING_VERIFY μετράει κι αυτό ως δοκιμή.
+static constexpr uint32_t kOtaTickMs = 1000;
+static constexpr uint32_t kOtaHealthyMs = 60000;   // συνεχής σύνδεση SK
+static constexpr uint32_t kOtaTrialMs = 600000;    // από το boot
+static constexpr uint8_t  kOtaMaxTrialBoots = 3;
+static constexpr int      kOtaRecvTimeouts = 5;    // διαδοχικά timeouts του socket
+
+// Κρατάει το Arduino core από το να επιβεβαιώσει μόνο του το νέο image
+extern "C" bool verifyRollbackLater() { return true; }
+
+class PartitionOtaSource : public OtaSource {
+ public:
+  explicit PartitionOtaSource(const esp_partition_t* part) : part_(part) {}
+  bool read(uint32_t offset, void* dst, size_t len) override {
+    return esp_partition_read(part_, offset, dst, len) == ESP_OK;
+  }
+
+ private:
+  const esp_partition_t* part_;
+};
+
+class SlotOtaSink : public OtaSink {
+ public:
+  // size: το μέγεθος του νέου image, ώστε να σβηστεί μόνο όσο χρειάζεται
+  bool begin(const esp_partition_t* part, size_t size) {
+    open_ = esp_ota_begin(part, size, &handle_) == ESP_OK;
+    return open_;
+  }
+  bool write(const void* src, size_t len) override {
+    return esp_ota_write(handle_, src, len) == ESP_OK;
+  }
+  // Ελέγχει και το image (checksum/hash) πριν γίνει bootable
+  bool end() {
+    open_ = false;
+    return esp_ota_end(handle_) == ESP_OK;
+  }
+  void abort() {
+    if (open_) esp_ota_abort(handle_);
+    open_ = false;
+  }
+
+ private:
+  esp_ota_handle_t handle_ = 0;
+  bool open_ = false;
+};
+
+class OtaUpdater {
+ public:
+  WheelTimer timer_{&OtaUpdater::tick_, this};
+
+  // Στο setup(): μετράει τα boots της δοκιμής ή καταγράφει ένα rollback
+  void boot() {
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    esp_ota_img_states_t state;
+    native_pending_ = esp_ota_get_state_partition(running, &state) == ESP_OK &&
+                      state == ESP_OTA_IMG_PENDING_VERIFY;
+    Preferences prefs;
+    prefs.begin("ota");
+    prefs.getString("last", last_, sizeof(last_));
+    if (prefs.getUChar("trial", 0)) {
+      char target[17] = "";
+      prefs.getString("target", target, sizeof(target));
+      prefs.getString("prev", prev_, sizeof(prev_));
+      if (strcmp(target, running->label) != 0) {
+        // Ο bootloader (ή εμείς) γύρισε ήδη στο προηγούμενο slot
+        ESP_LOGW(TAG, "OTA: %s did not confirm, running %s again", target, running->label);
+        snprintf(last_, sizeof(last_), "rolled_back:boot");
+        prefs.putString("last", last_);
+        prefs.putUChar("trial", 0);
+      } else {
+        trial_boots_ = prefs.getUChar("tries", 0) + 1;
+        prefs.putUChar("tries", trial_boots_);
+        trial_ = true;
+      }
+    } else if (native_pending_) {
+      trial_boots_ = 1;
+      trial_ = true;
+    }
+    prefs.end();
+    if (!trial_) return;
+    ESP_LOGW(TAG, "OTA: %s on trial (boot %u of %u)", running->label, (unsigned)trial_boots_,
+             (unsigned)kOtaMaxTrialBoots);
+    if (trial_boots_ > kOtaMaxTrialBoots) rollback_("boot_loop");
+  }
+
+  void startTimer() { g_timers.schedule(timer_, kOtaTickMs); }
+
+  // POST /api/anchor/ota (http server task)
+  esp_err_t upload(httpd_req_t* req) {
+    if (busy_.exchange(true)) return reply_(req, "409 Conflict", "busy", 0);
+    const esp_err_t r = upload_(req);
+    busy_.store(false);
+    return r;
+  }
+
+  // GET /api/anchor/ota
+  esp_err_t status(httpd_req_t* req) {
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    const esp_partition_t* boot = esp_ota_get_boot_partition();
+    static char body[384];
+    const int n = snprintf(body, sizeof(body),
+                           "{\"running\":\"%s\",\"boot\":\"%s\",\"trial\":%s,\"trialBoots\":%u,"
+                           "\"nativeRollback\":%s,\"rebootPending\":%s,\"busy\":%s,\"last\":\"%s\","
+                           "\"lastUpdate\":{\"mode\":\"%s\",\"result\":\"%s\",\"received\":%u,"
+                           "\"written\":%u,\"ms\":%u}}",
+                           running ? running->label : "", boot ? boot->label : "",
+                           trial_ ? "true" : "false", (unsigned)trial_boots_,
+                           native_pending_ ? "true" : "false",
+                           reboot_requested_.load() ? "true" : "false",
+                           busy_.load() ? "true" : "false", last_, upd_.mode, upd_.result,
+                           (unsigned)upd_.received, (unsigned)upd_.written, (unsigned)upd_.ms);
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, body, n < (int)sizeof(body) ? n : (int)sizeof(body) - 1);
+  }
+
+ private:
+  // Το αποτέλεσμα του τελευταίου update, για το GET
+  struct Update {
+    const char* mode = "none";
+    const char* result = "none";
+    uint32_t received = 0;
+    uint32_t written = 0;
+    uint32_t ms = 0;
+  };
+
+  // Ένα chunk από το socket. 0 = τέλος ή σφάλμα.
+  int recv_(httpd_req_t* req, size_t remaining) {
+    const size_t want = remaining < sizeof(buf_) ? remaining : sizeof(buf_);
+    for (int timeouts = 0; timeouts < kOtaRecvTimeouts; timeouts++) {
+      const int n = httpd_req_recv(req, (char*)buf_, want);
+      if (n != HTTPD_SOCK_ERR_TIMEOUT) return n > 0 ? n : 0;
+    }
+    return 0;
+  }
+
+  esp_err_t upload_(httpd_req_t* req) {
+    if (anchor && anchor->anyRunning_()) return reply_(req, "409 Conflict", "windlass_running", 0);
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    const esp_partition_t* next = esp_ota_get_next_update_partition(nullptr);
+    if (!running || !next) return reply_(req, "500 Internal Server Error", "no_ota_slot", 0);
+
+    const uint32_t t0 = millis();
+    upd_ = Update();
+    size_t remaining = req->content_len;
+    // Αρκετά bytes για να φανεί τι είναι (το header του patch)
+    size_t have = 0;
+    while (have < ota_patch::kHeaderBytes && remaining) {
+      const int n = httpd_req_recv(req, (char*)head_ + have, ota_patch::kHeaderBytes - have);
+      if (n == HTTPD_SOCK_ERR_TIMEOUT) continue;
+      if (n <= 0) return reply_(req, "400 Bad Request", "short_upload", t0);
+      have += n;
+      remaining -= n;
+    }
+    const bool patch = have >= 4 && memcmp(head_, ota_patch::kMagic, 4) == 0;
+    if (!patch && (have == 0 || head_[0] != 0xE9)) {
+      return reply_(req, "400 Bad Request", "not_an_image", t0);
+    }
+    upd_.mode = patch ? "patch" : "image";
+    const uint32_t size = patch ? ota_patch::get_u32(head_ + 12) : req->content_len;
+    if (size > next->size) return reply_(req, "400 Bad Request", "too_large", t0);
+
+    ESP_LOGI(TAG, "OTA: %s of %u bytes → %s (%u bytes image)", upd_.mode,
+             (unsigned)req->content_len, next->label, (unsigned)size);
+    if (!sink_.begin(next, size)) return reply_(req, "500 Internal Server Error", "ota_begin", t0);
+
+    PartitionOtaSource source(running);
+    DeltaPatcher::Status st = DeltaPatcher::kRunning;
+    bool ok = true;
+    if (patch) {
+      patcher_.begin(&source, running->size, &sink_);
+      st = patcher_.feed(head_, have);
+    } else {
+      ok = sink_.write(head_, have);
+    }
+    upd_.received = have;
+    while (ok && remaining && st == DeltaPatcher::kRunning) {
+      const int n = recv_(req, remaining);
+      if (n <= 0) break;
+      remaining -= n;
+      upd_.received += n;
+      if (patch) st = patcher_.feed(buf_, n);
+      else ok = sink_.write(buf_, n);
+    }
+    upd_.written = patch ? patcher_.written() : upd_.received;
+
+    const char* result = nullptr;
+    if (!ok) result = "write_failed";
+    else if (remaining) result = "short_upload";
+    else if (patch && st != DeltaPatcher::kDone) {
+      result = st == DeltaPatcher::kRunning ? "short_patch" : DeltaPatcher::statusName(st);
+    }
+    if (result) {
+      sink_.abort();
+      return reply_(req, "400 Bad Request", result, t0);
+    }
+    if (!sink_.end()) return reply_(req, "400 Bad Request", "image_invalid", t0);
+    if (esp_ota_set_boot_partition(next) != ESP_OK) {
+      return reply_(req, "500 Internal Server Error", "set_boot", t0);
+    }
+
+    // Το νέο slot μπαίνει σε δοκιμή από το πρώτο του boot
+    Preferences prefs;
+    prefs.begin("ota");
+    prefs.putUChar("trial", 1);
+    prefs.putUChar("tries", 0);
+    prefs.putString("prev", running->label);
+    prefs.putString("target", next->label);
+    prefs.end();
+    reboot_requested_.store(true);
+    return reply_(req, "200 OK", "ok", t0);
+  }
+
+  esp_err_t reply_(httpd_req_t* req, const char* http_status, const char* result, uint32_t t0) {
+    if (t0) {
+      upd_.result = result;
+      upd_.ms = millis() - t0;
+    }
+    if (strcmp(result, "ok") != 0) ESP_LOGW(TAG, "OTA: %s", result);
+    char body[192];
+    const uint32_t ms = t0 ? upd_.ms : 0;
+    const int n = snprintf(body, sizeof(body),
+                           "{\"result\":\"%s\",\"mode\":\"%s\",\"received\":%u,\"written\":%u,"
+                           "\"ms\":%u,\"kBps\":%.1f,\"reboot\":%s}",
+                           result, t0 ? upd_.mode : "none", t0 ? (unsigned)upd_.received : 0u,
+                           t0 ? (unsigned)upd_.written : 0u, (unsigned)ms,
+                           ms ? upd_.received / (float)ms : 0.0f,
+                           reboot_requested_.load() ? "true" : "false");
+    httpd_resp_set_status(req, http_status);
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, body, n < (int)sizeof(body) ? n : (int)sizeof(body) - 1);
+  }
+
+  // Κάθε kOtaTickMs από το g_timers: reboot μετά από update, επιβεβαίωση ή
+  // rollback της δοκιμής. Τίποτα όσο κινείται κάποιος windlass.
+  static void tick_(void* arg) {
+    auto* self = static_cast<OtaUpdater*>(arg);
+    g_timers.schedule(self->timer_, kOtaTickMs);
+    if (anchor && anchor->anyRunning_()) return;
+    if (self->reboot_requested_.load() && !self->busy_.load()) {
+      ESP_LOGW(TAG, "OTA: restarting into the new image");
+      restartKeepingCounters_(CounterRtcRecord::kOtaReboot);
+    }
+    if (!self->trial_) return;
+    const unsigned long now_ms = millis();
+    if (g_ws_state == SKWSConnectionState::kSKWSConnected && g_connection_time &&
+        now_ms - g_connection_time >= kOtaHealthyMs) {
+      self->confirm_();
+    } else if (now_ms >= kOtaTrialMs) {
+      self->rollback_("rolled_back:not_healthy");
+    }
+  }
+
+  void confirm_() {
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    if (native_pending_) esp_ota_mark_app_valid_cancel_rollback();
+    Preferences prefs;
+    prefs.begin("ota");
+    snprintf(last_, sizeof(last_), "confirmed");
+    prefs.putString("last", last_);
+    prefs.putUChar("trial", 0);
+    prefs.end();
+    trial_ = false;
+    native_pending_ = false;
+    ESP_LOGI(TAG, "OTA: %s confirmed after %us connected", running->label,
+             (unsigned)(kOtaHealthyMs / 1000));
+  }
+
+  void rollback_(const char* why) {
+    ESP_LOGE(TAG, "OTA: %s, rolling back to %s", why, prev_[0] ? prev_ : "previous slot");
+    Preferences prefs;
+    prefs.begin("ota");
+    snprintf(last_, sizeof(last_), "%s", why);
+    prefs.putString("last", last_);
+    prefs.putUChar("trial", 0);
+    prefs.end();
+    trial_ = false;
+    delay(100);
+    saveCountersToRtc_(CounterRtcRecord::kOtaRollback);
+    if (native_pending_) esp_ota_mark_app_invalid_rollback_and_reboot();
+    const esp_partition_t* prev =
+        prev_[0] ? esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, prev_)
+                 : nullptr;
+    if (prev && esp_ota_set_boot_partition(prev) == ESP_OK) ESP.restart();
+    ESP_LOGE(TAG, "OTA: no previous image to roll back to");
+  }
+
+  SlotOtaSink  sink_;
+  DeltaPatcher patcher_;
+  uint8_t      head_[ota_patch::kHeaderBytes];
+  uint8_t      buf_[1024];
+  Update       upd_;
+  std::atomic<bool> busy_{false};
+  std::atomic<bool> reboot_requested_{false};
+  bool     trial_ = false;
+  bool     native_pending_ = false;  // bootloader rollback ενεργό
+  uint8_t  trial_boots_ = 0;
+  char     prev_[17] = "";
+  char     last_[32] = "none";
+};
+
+OtaUpdater g_ota;
+
+// POST/GET /api/anchor/ota - βλ. OtaUpdater
+static void registerOtaEndpoint() {
+  auto app = ::sensesp::SensESPApp::get();
+  if (!app) return;
+  auto server = app->get_http_server();
+  if (!server) return;
+  auto upload = std::make_shared<HTTPRequestHandler>(
+      1 << HTTP_POST, "/api/anchor/ota", [](httpd_req_t* req) { return g_ota.upload(req); });
+  server->add_handler(upload);
+  auto status = std::make_shared<HTTPRequestHandler>(
+      1 << HTTP_GET, "/api/anchor/ota", [](httpd_req_t* req) { return g_ota.status(req); });
+  server->add_handler(status);
+}
+
+void setup() {
+  relaysSafe_();
+  g_boot.mark(kBootRelaysSafe, millis());
+  heapBoot_();
+  SetupLogging();
+  if (g_heap_prev_valid) {
+    ESP_LOGW(TAG, "Reset (%s) after %us: heap free=%u min=%u largest=%u failed allocs=%u",
+             resetReasonName_(g_reset_reason), (unsigned)g_heap_prev.uptime_s,
+             (unsigned)g_heap_prev.free_bytes, (unsigned)g_heap_prev.min_free_bytes,
+             (unsigned)g_heap_prev.largest_block, (unsigned)g_heap_prev.failed);
+  }
+  g_timers.begin(millis());
+  g_ota.boot();
+
+  // Το WiFi συνδέεται όσο φορτώνονται το SensESP και τα configs
+  WiFi.onEvent([](arduino_event_id_t, arduino_event_info_t) { wifiGotIp_(); },
+               ARDUINO_EVENT_WIFI_STA_GOT_IP);
+  wifiFastConnect_();
+
+  SensESPAppBuilder builder;
+  builder.set_hostname("sensesp-anchor");
+  builder.set_wifi_access_point("SensESP-anchor", "948171");
+  ::sensesp::sensesp_app = builder.get_app();
+
+  configTime(0, 0, "pool.ntp.org");
+
+  anchor = std::make_shared<AnchorController>();
+  for (auto& ch : anchor->channels_) ch->load();
+
+  // Μετά από restart του firmware η RTC έχει την πιο πρόσφατη τιμή. Αλλιώς
+  // το journal, που είναι πιο πρόσφατο από το config (γράφεται σε κάθε παλμό).
+  const CounterRtcRecord rtc = g_counter_rtc;
+  g_counter_rtc.invalidate();
+  const bool warm = g_reset_reason == ESP_RST_SW && rtc.valid();
+  if (warm) g_counters_restored = rtc.reason;
+  const bool journal = g_journal.begin();
+  bool journal_behind[kChannels] = {};
+  for (auto& ch : anchor->channels_) {
+    CounterRecord last_count;
+    const bool in_journal = journal && g_journal.latest(ch->index_, last_count);
+    if (warm && ch->index_ < rtc.channels) {
+      const CounterRtcRecord::Channel& c = rtc.ch[ch->index_];
+      ch->chain_out_meters = c.meters;
+      ch->chain_pulse_count = c.pulses;
+      journal_behind[ch->index_] =
+          journal && (!in_journal || last_count.pulses != c.pulses || last_count.meters != c.meters);
+      ESP_LOGI(TAG, "%s: chain counter restored from RTC after %s: %.1fm (%d pulses, was %s)",
+               ch->def_.name, CounterRtcRecord::reasonName(rtc.reason), ch->chain_out_meters,
+               ch->chain_pulse_count, WindlassFsm::stateName((WindlassFsm::RunState)c.state));
+      continue;
+    }
+    if (!in_journal) continue;
+    ch->chain_out_meters = last_count.meters;
+    ch->chain_pulse_count = last_count.pulses;
+    ESP_LOGI(TAG, "%s: chain counter restored from journal: %.1fm (%d pulses)", ch->def_.name,
+             ch->chain_out_meters, ch->chain_pulse_count);
+  }
+  // Ό,τι πρόλαβε η RTC αλλά όχι το journal γράφεται από το task του journal
+  for (auto& ch : anchor->channels_) {
+    if (!journal_behind[ch->index_]) continue;
+    g_journal.submit(ch->index_, (int32_t)ch->chain_pulse_count, ch->chain_out_meters,
+                     (uint8_t)WindlassFsm::IDLE);
+  }
+  g_sessions.begin();
+  g_boot.mark(kBootConfigLoaded, millis());
+
+  for (auto& ch : anchor->channels_) {
+    String title = "Anchor Controller";
+    if (kChannels > 1) title = title + " (" + ch->def_.name + ")";
+    ConfigItem(ch)
+      ->set_title(title)
+      ->set_description("Relay control & timings for anchor windlass with chain counter")
+      ->set_sort_order(100 + ch->index_)
+      ->set_config_schema(ch->get_config_schema());
+
+    ch->setupPins();
+    ch->driver_.publish();
+  }
+  anchor->attachSignalK();
+  anchor->restoreWatch_();
+
+  g_loop_perf.set_cycles_per_us(hal::cycles_per_us());
+  g_cmd_latency.set_cycles_per_us(kCmdLatencyUnitsPerUs);
+  registerPerfEndpoint();
+  registerSessionEndpoint();
+  registerStatsEndpoint();
+  registerOtaEndpoint();
+  registerLiveEndpoints();
+  anchor->publishPreviousBoot_(resetReasonName_(g_reset_reason),
+                               g_heap_prev_valid ? &g_heap_prev : nullptr);
+
+  pinMode(LED_BUILTIN, OUTPUT);
   digitalWrite(LED_BUILTIN, LOW);
 
   if (auto app = ::sensesp::SensESPApp::get()) {
@@ -624,16 +2985,24 @@ void setup() {
       ws->connect_to(new LambdaConsumer<SKWSConnectionState>([ws](SKWSConnectionState state) {
         SKWSConnectionState prev_state = g_ws_state;
         g_ws_state = state;
+        g_loop_activity_ms = millis();
+        if (state == SKWSConnectionState::kSKWSConnected) {
+          g_ws_backoff.on_connected(millis());
+          g_timers.cancel(g_ws_watchdog_timer);
+          if (anchor) anchor->publishConnection_(g_ws_backoff.stats());
+        } else {
+          g_timers.cancel(g_initial_heartbeat_timer);
+          g_timers.cancel(g_ready_timer);
+          const uint32_t delay_ms = g_ws_backoff.on_disconnected(millis());
+          if (!g_ws_watchdog_timer.pending) g_timers.schedule(g_ws_watchdog_timer, delay_ms);
+        }
         
         switch (state) {
           case SKWSConnectionState::kSKWSDisconnected:
             ESP_LOGW(TAG, "SK WS: Disconnected");
+            if (prev_state == SKWSConnectionState::kSKWSConnected) g_ws_disconnects++;
             g_connection_time = 0;
-            if (anchor && (anchor->state == AnchorController::RUNNING_UP || 
-                          anchor->state == AnchorController::RUNNING_DOWN)) {
-              ESP_LOGW(TAG, "SAFETY: Stopping motor due to SignalK disconnection");
-              anchor->stopNow_("safety:disconnected");
-            }
+            if (anchor) anchor->stopAll_("safety:disconnected");
             break;
             
           case SKWSConnectionState::kSKWSAuthorizing:
@@ -646,7 +3015,11 @@ void setup() {
             
           case SKWSConnectionState::kSKWSConnected:
             ESP_LOGI(TAG, "SK WS: Connected");
+            g_ws_connects++;
             g_connection_time = millis();
+            g_timers.schedule(g_initial_heartbeat_timer, kInitialHeartbeatMs);
+            g_boot.mark(kBootWsConnected, g_connection_time);
+            if (!g_boot.reached(kBootReady)) g_timers.schedule(g_ready_timer, kConnectionSettlingMs);
             break;
             
           default:
@@ -657,77 +3030,73 @@ void setup() {
     }
   }
   
-  ESP_LOGI(TAG, "Anchor Windlass Controller with Chain Counter initialized");
-}
-
-void loop() {
-  event_loop()->tick();
-  if (anchor) anchor->tick();
-
-  static bool enabled_sent = false;
-  if (g_ws_state == SKWSConnectionState::kSKWSConnected && 
-      g_connection_time > 0 && 
-      !enabled_sent &&
-      (millis() - g_connection_time > 500) && 
-      (millis() - g_connection_time < 1000)) {
-    if (anchor) {
-      ESP_LOGI(TAG, "Sending initial enabled=true to SignalK");
-      anchor->sendHeartbeat(true);
-      enabled_sent = true;
-    }
-  }
-  if (g_ws_state != SKWSConnectionState::kSKWSConnected) {
-    enabled_sent = false;
-  }
+  anchor->startMotorTask();
 
-  static unsigned long last_hb = 0;
-  auto app = ::sensesp::SensESPApp::get();
-  if (app) {
-    auto ws = app->get_ws_client();
-    if (ws && g_ws_state == SKWSConnectionState::kSKWSConnected) {
-      unsigned long now = millis();
-      if (now - last_hb > 30000UL) {
-        last_hb = now;
-        if (anchor) anchor->sendHeartbeat(false);
+  // UDP transport: port και κλειδί από τις ρυθμίσεις του channel 0
+  {
+    AnchorSettings st;
+    anchor->channels_[0]->settings_.read(st);
+    if (st.udp_port > 0 && st.udp_port < 65536) {
+      if (g_udp.begin(st.udp_port, st.udp_key)) {
+        ESP_LOGI(TAG, "UDP transport on port %d (%s)", st.udp_port,
+                 st.udp_key[0] ? "commands + status" : "status only");
+      } else {
+        ESP_LOGE(TAG, "UDP transport not started on port %d", st.udp_port);
       }
     }
   }
 
-  static unsigned long last_wifi_log = 0;
-  unsigned long now_ms = millis();
-  if (now_ms - last_wifi_log > 60000UL) {
-    last_wifi_log = now_ms;
-    if (WiFi.isConnected()) {
-      ESP_LOGI(TAG, "WiFi ok: IP=%s RSSI=%d", WiFi.localIP().toString().c_str(), WiFi.RSSI());
-    } else {
-      ESP_LOGW(TAG, "WiFi disconnected");
-    }
+  // Periodic δουλειές του loop task
+  anchor->startTimers();
+  g_timers.schedule(g_wifi_log_timer, kWifiLogMs);
+  g_ws_backoff.seed(esp_random());
+  g_timers.schedule(g_ws_watchdog_timer, g_ws_backoff.on_disconnected(millis()));
+  g_timers.schedule(g_heap_timer, 0);
+  g_ota.startTimer();
+
+#if CONFIG_PM_ENABLE
+  // Με tickless idle ο πυρήνας μπαίνει σε light sleep όσο και τα δύο tasks
+  // κοιμούνται. Το prebuilt Arduino core δεν έχει CONFIG_PM_ENABLE, οπότε
+  // εκεί μένει απλώς το idle task (WFI) στα κενά.
+  esp_pm_config_esp32_t pm = {};
+  pm.max_freq_mhz = 240;
+  pm.min_freq_mhz = 80;
+  pm.light_sleep_enable = true;
+  if (esp_pm_configure(&pm) != ESP_OK) ESP_LOGW(TAG, "Light sleep not available");
+#endif
+
+  ESP_LOGI(TAG, "Anchor Windlass Controller with Chain Counter initialized");
+}
+
+void loop() {
+  g_loop_wakeups++;
+  g_loop_perf.start(hal::cycles());
+  {
+    AllocScope scope(g_heap_stats, kAllocEventLoop);
+    event_loop()->tick();
   }
+  g_loop_perf.lap(kPerfEventLoop, hal::cycles());
+  if (anchor) anchor->tick();
+  g_loop_perf.lap(kPerfAnchorTick, hal::cycles());
+  {
+    AllocScope scope(g_heap_stats, kAllocTimers);
+    g_timers.run(millis());
+  }
+  g_loop_perf.lap(kPerfTimers, hal::cycles());
+  g_loop_perf.finish(hal::cycles());
+  publishLoopStats_(millis());
 
-  static unsigned long not_connected_since = 0;
-  static uint8_t reconnect_attempts = 0;
-  if (app) {
-    auto ws = app->get_ws_client();
-    if (ws) {
-      if (g_ws_state != SKWSConnectionState::kSKWSConnected) {
-        if (not_connected_since == 0) not_connected_since = now_ms;
-        
-        if (now_ms - not_connected_since > 60000UL) {
-          ESP_LOGW(TAG, "WS watchdog: forcing reconnect (attempt %d)", reconnect_attempts + 1);
-          ws->connect();
-          not_connected_since = now_ms;
-          reconnect_attempts++;
-          
-          if (reconnect_attempts >= 8) {
-            ESP_LOGE(TAG, "WS watchdog: exceeded attempts, restarting ESP32");
-            delay(100);
-            ESP.restart();
-          }
-        }
-      } else {
-        not_connected_since = 0;
-        reconnect_attempts = 0;
-      }
-    }
+  // Ύπνος μέχρι την επόμενη προθεσμία ή μέχρι notify από το motor task
+  const unsigned long now_ms = millis();
+  uint32_t wait = g_timers.ms_until_next(now_ms);
+  if (anchor) {
+    const uint32_t due = anchor->loopMsUntilDue(now_ms);
+    if (due < wait) wait = due;
   }
-}
\ No newline at end of file
+  const bool active = g_ws_state == SKWSConnectionState::kSKWSConnected ||
+                      (anchor && anchor->led_active_) ||
+                      now_ms - g_loop_activity_ms < kEventLoopActiveMs;
+  const uint32_t poll = active ? kEventLoopActivePollMs : kEventLoopIdlePollMs;
+  if (poll < wait) wait = poll;
+  if (wait) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+}
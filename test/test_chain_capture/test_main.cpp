@@ -0,0 +1,189 @@
+// Interrupt capture του αισθητήρα αλυσίδας: SpscRing, τα pulse filters με
+// συνθετικά edge streams (καθαροί παλμοί, contact bounce, glitches, διπλοί
+// παλμοί) και η ανεξαρτησία της μέτρησης από το πόσο αργεί το loop.
+
+#include <unity.h>
+
+#include <stdio.h>
+
+#include <vector>
+
+#include "anchor_hal.h"
+#include "chain_pulse_filter.h"
+#include "spsc_ring.h"
+#include "windlass_core.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+typedef std::vector<ChainEdge> Edges;
+
+// Ένας κρίκος: ο μαγνήτης κλείνει την επαφή (LOW) για low_us και μετά
+// ανοίγει. Κάθε αλλαγή αναπηδά bounce φορές μέσα σε ~bounce_us.
+static void link(Edges& out, uint32_t t_us, uint32_t low_us, int bounce = 0,
+                 uint32_t bounce_us = 800) {
+  const uint32_t at[2] = {t_us, t_us + low_us};
+  for (int k = 0; k < 2; k++) {
+    const uint8_t level = k == 0 ? LOW : HIGH;
+    for (int b = 0; b < bounce; b++) {
+      const uint32_t dt = bounce_us * (uint32_t)(b + 1) / (uint32_t)(bounce + 1);
+      out.push_back(ChainEdge{at[k] + dt - bounce_us, (uint8_t)((b & 1) ? level : !level)});
+    }
+    out.push_back(ChainEdge{at[k], level});
+  }
+}
+
+// Τρέχει ένα stream από το filter όπως το updateChainCounter(): edges με τη
+// σειρά, poll με το τρέχον t κάθε poll_us.
+static uint32_t count(PulseFilter& f, const Edges& edges, uint32_t poll_us) {
+  f.reset(true, 0);
+  uint32_t pulses = 0, pulse_us;
+  size_t i = 0;
+  const uint32_t end = edges.empty() ? 0 : edges.back().t_us + 1000000;
+  for (uint32_t now = poll_us; now <= end; now += poll_us) {
+    while (i < edges.size() && edges[i].t_us <= now) {
+      if (f.feed(edges[i++], pulse_us)) pulses++;
+    }
+    if (f.poll(now, pulse_us)) pulses++;
+  }
+  return pulses;
+}
+
+void test_ring_fifo_overflow_and_clear(void) {
+  SpscRing<uint32_t, 8> ring;
+  uint32_t v;
+  TEST_ASSERT_TRUE(ring.empty());
+  TEST_ASSERT_FALSE(ring.pop(v));
+  for (uint32_t i = 0; i < 8; i++) TEST_ASSERT_TRUE(ring.push(i));
+  TEST_ASSERT_FALSE(ring.push(99));
+  TEST_ASSERT_EQUAL(1, ring.overflows());
+  TEST_ASSERT_EQUAL(8, ring.size());
+  for (uint32_t i = 0; i < 8; i++) {
+    TEST_ASSERT_TRUE(ring.pop(v));
+    TEST_ASSERT_EQUAL(i, v);
+  }
+  // Πολλές φορές γύρω από τον δακτύλιο: το index βγαίνει με mask
+  for (uint32_t i = 0; i < 1000; i++) {
+    TEST_ASSERT_TRUE(ring.push(i));
+    TEST_ASSERT_TRUE(ring.push(i + 1));
+    TEST_ASSERT_TRUE(ring.pop(v));
+    TEST_ASSERT_EQUAL(i, v);
+    TEST_ASSERT_TRUE(ring.pop(v));
+    TEST_ASSERT_EQUAL(i + 1, v);
+  }
+  ring.push(1);
+  ring.push(2);
+  ring.clear();
+  TEST_ASSERT_TRUE(ring.empty());
+  TEST_ASSERT_EQUAL(1, ring.overflows());
+}
+
+// Αρχική συμπεριφορά: 150ms σταθερή στάθμη, παλμοί κάτω από 300ms πετιούνται.
+void test_fixed_filter_counts_clean_and_bouncy_links(void) {
+  FixedPulseFilter f;
+  f.set_debounce_us(150000);
+  Edges clean, bouncy;
+  for (uint32_t i = 0; i < 50; i++) {
+    link(clean, 1000000 + i * 1000000, 300000);
+    link(bouncy, 1000000 + i * 1000000, 300000, 6);
+  }
+  TEST_ASSERT_EQUAL(50, count(f, clean, 2000));
+  TEST_ASSERT_EQUAL(50, count(f, bouncy, 2000));
+  TEST_ASSERT_EQUAL(0, f.rejected());
+}
+
+// Ένα σύντομο LOW ανάμεσα στους κρίκους (ο μαγνήτης τρεμοπαίζει) δεν
+// μένει 150ms, οπότε δεν γίνεται παλμός.
+void test_fixed_filter_ignores_short_glitch(void) {
+  FixedPulseFilter f;
+  f.set_debounce_us(150000);
+  Edges e;
+  link(e, 1000000, 200000);
+  link(e, 1500000, 40000, 3);
+  link(e, 2500000, 200000);
+  TEST_ASSERT_EQUAL(2, count(f, e, 2000));
+}
+
+// Adaptive: κλειδώνει στην περίοδο, κόβει bounce και διπλούς παλμούς,
+// και ακολουθεί μια αλυσίδα που επιταχύνει (freefall).
+void test_adaptive_filter_tracks_accelerating_chain(void) {
+  AdaptivePulseFilter f;
+  f.set_limits(2000, 30000, 150000);
+  Edges e;
+  uint32_t t = 1000000, period = 500000;
+  int links = 0;
+  while (period > 40000) {
+    link(e, t, period / 3, 4);
+    t += period;
+    period = period * 9 / 10;
+    links++;
+  }
+  TEST_ASSERT_EQUAL(links, count(f, e, 2000));
+  TEST_ASSERT_EQUAL(0, f.rejected());
+  TEST_ASSERT_LESS_THAN(60000u, f.period_us());
+}
+
+void test_adaptive_filter_rejects_double_pulse(void) {
+  AdaptivePulseFilter f;
+  f.set_limits(2000, 30000, 150000);
+  Edges e;
+  for (uint32_t i = 0; i < 10; i++) link(e, 1000000 + i * 200000, 60000);
+  // Ένας δεύτερος παλμός 60ms μετά τον 10ο (< 40% της περιόδου των 200ms)
+  link(e, 1000000 + 9 * 200000 + 90000, 30000);
+  TEST_ASSERT_EQUAL(10, count(f, e, 1000));
+  TEST_ASSERT_EQUAL(1, f.rejected());
+}
+
+// Μέσα από το ISR του WindlassCore: το ίδιο stream μετράει ίδια είτε το
+// loop αδειάζει την ουρά κάθε 2ms είτε κάθε 400ms (όσο χωράει στα 64).
+static int32_t coreCount(uint32_t drain_ms, uint32_t& overflows) {
+  hal::sim().reset();
+  WindlassCore core;
+  core.setupPins();
+  core.state = WindlassFsm::RUNNING_DOWN;  // μόνο ο μετρητής, χωρίς ρελέ
+  const uint32_t period_ms = 250;
+  uint32_t next_drain = drain_ms;
+  for (uint32_t ms = 1; ms <= 60000; ms++) {
+    hal::sim().advance_ms(1);
+    const uint32_t phase = ms % period_ms;
+    // LOW με bounce (3 extra edges) στην αρχή, HIGH στο 1/3 του κρίκου
+    if (phase == 0) {
+      hal::sim().set_input(core.chain_sensor_pin, LOW);
+      hal::sim().set_input(core.chain_sensor_pin, HIGH);
+      hal::sim().set_input(core.chain_sensor_pin, LOW);
+    } else if (phase == period_ms / 3) {
+      hal::sim().set_input(core.chain_sensor_pin, HIGH);
+    }
+    if (ms >= next_drain) {
+      core.updateChainCounter();
+      next_drain += drain_ms;
+    }
+  }
+  hal::sim().advance_ms(1000);
+  core.updateChainCounter();
+  overflows = core.chain_edges_.overflows();
+  return core.chain_pulse_count;
+}
+
+void test_count_does_not_depend_on_loop_latency(void) {
+  uint32_t ovf_fast, ovf_slow;
+  const int32_t fast = coreCount(2, ovf_fast);
+  const int32_t slow = coreCount(400, ovf_slow);
+  TEST_ASSERT_EQUAL(239, fast);  // ο 240ός κρίκος δεν έχει ανοίξει ακόμα
+  TEST_ASSERT_EQUAL(fast, slow);
+  TEST_ASSERT_EQUAL(0, ovf_fast);
+  TEST_ASSERT_EQUAL(0, ovf_slow);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_ring_fifo_overflow_and_clear);
+  RUN_TEST(test_fixed_filter_counts_clean_and_bouncy_links);
+  RUN_TEST(test_fixed_filter_ignores_short_glitch);
+  RUN_TEST(test_adaptive_filter_tracks_accelerating_chain);
+  RUN_TEST(test_adaptive_filter_rejects_double_pulse);
+  RUN_TEST(test_count_does_not_depend_on_loop_latency);
+  return UNITY_END();
+}
@@ -0,0 +1,172 @@
+// Scenario suite του WindlassCore στο simulated board (pio test -e native).
+// Μεγάλες κινήσεις, αλλαγές κατεύθυνσης μέσα από το neutral_ms, disconnect
+// πάνω στην παύση, stall, και το κόστος ανά tick σε εικονικό χρόνο.
+
+#include <unity.h>
+
+#include <stdio.h>
+
+#include <chrono>
+
+#include "../windlass_sim.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Μία ώρα κατέβασμα (το hold των running_down) με 2ms ticks: κάθε κρίκος
+// μετράει, το coast μετά το timeout μετράει στην ίδια κατεύθυνση.
+void test_long_run_counts_every_link(void) {
+  SimWindlass w;
+  w.begin();
+  const auto t0 = std::chrono::steady_clock::now();
+  w.command("running_down");
+  TEST_ASSERT_TRUE(w.relayOn(w.relay_down_pin));
+  TEST_ASSERT_TRUE(w.run_until_idle(3700 * 1000));
+  const double wall_s =
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  TEST_ASSERT_EQUAL_STRING("down:done", w.last_reason);
+  TEST_ASSERT_EQUAL(w.links_passed, w.chain_pulse_count);
+  TEST_ASSERT_GREATER_THAN(8900, w.chain_pulse_count);
+  TEST_ASSERT_EQUAL(0, w.both_on);
+
+  char msg[128];
+  snprintf(msg, sizeof(msg), "%llu ticks, %.0f ns/tick, %.0fx real time",
+           (unsigned long long)w.ticks, wall_s / (double)w.ticks * 1e9,
+           (double)hal::millis() / 1000.0 / wall_s);
+  TEST_MESSAGE(msg);
+}
+
+// Κάτω → πάνω: τα ρελέ σβήνουν, περιμένουν neutral_ms και μετά ανάβει το
+// πάνω. Ποτέ και τα δύο, ποτέ on μέσα στο κενό.
+void test_reversal_waits_neutral(void) {
+  SimWindlass w;
+  w.begin();
+  w.command("running_down");
+  w.run_ms(6000);
+  w.command("running_up");
+  TEST_ASSERT_FALSE(w.relayOn(w.relay_down_pin));
+  TEST_ASSERT_FALSE(w.relayOn(w.relay_up_pin));
+  w.run_ms((uint32_t)w.neutral_ms - 10);
+  TEST_ASSERT_FALSE(w.relayOn(w.relay_up_pin));
+  w.run_ms(20);
+  TEST_ASSERT_TRUE(w.relayOn(w.relay_up_pin));
+  TEST_ASSERT_EQUAL(WindlassFsm::RUNNING_UP, w.state);
+
+  w.run_ms(2000);
+  w.command("running_down");
+  w.run_ms(3000);
+  w.command("idle");
+  TEST_ASSERT_TRUE(w.run_until_idle(10000));
+
+  TEST_ASSERT_EQUAL(0, w.both_on);
+  TEST_ASSERT_GREATER_OR_EQUAL((uint32_t)w.neutral_ms * 1000u, w.reverse_gap_min_us);
+  TEST_ASSERT_EQUAL(w.links_passed, w.chain_pulse_count);
+  TEST_ASSERT_EQUAL_STRING("idle:remote", w.last_reason);
+}
+
+// Disconnect μέσα στο neutral gap: η εντολή που περίμενε δεν ξεκινάει.
+void test_disconnect_during_neutral_drops_queued_run(void) {
+  SimWindlass w;
+  w.begin();
+  w.command("running_down");
+  w.run_ms(3000);
+  w.command("running_up");
+  w.run_ms(100);
+  w.stopNow_("safety:disconnected");
+  w.run_ms(3000);
+  TEST_ASSERT_FALSE(w.relayOn(w.relay_up_pin));
+  TEST_ASSERT_FALSE(w.relayOn(w.relay_down_pin));
+  TEST_ASSERT_EQUAL(WindlassFsm::IDLE, w.state);
+  TEST_ASSERT_EQUAL_STRING("safety:disconnected", w.last_reason);
+}
+
+// freefall = default_chain_seconds, ένα δεύτερο freefall προσθέτει χρόνο.
+void test_freefall_extends_run(void) {
+  SimWindlass w;
+  w.begin();
+  w.command("freefall");
+  w.run_ms(1000);
+  w.command("freefall");
+  w.run_ms(8900);  // 1 + 4 + 5 = 10s συνολικά
+  TEST_ASSERT_TRUE(w.relayOn(w.relay_down_pin));
+  w.run_ms(200);
+  TEST_ASSERT_FALSE(w.relayOn(w.relay_down_pin));
+  TEST_ASSERT_EQUAL_STRING("down:done", w.last_reason);
+}
+
+// Ίδια εντολή μέσα στα 250ms του debounce: αγνοείται.
+void test_repeated_command_is_debounced(void) {
+  SimWindlass w;
+  w.begin();
+  w.command("freefall");
+  w.run_ms(100);
+  w.command("freefall");
+  w.run_ms(5000);
+  TEST_ASSERT_FALSE(w.relayOn(w.relay_down_pin));
+}
+
+void test_disabled_ignores_commands(void) {
+  SimWindlass w;
+  w.begin();
+  w.enabled = false;
+  w.command("running_down");
+  w.run_ms(1000);
+  TEST_ASSERT_FALSE(w.relayOn(w.relay_down_pin));
+  TEST_ASSERT_EQUAL(WindlassFsm::IDLE, w.state);
+}
+
+// Άγκυρα σφηνωμένη: κανένας παλμός, ρεύμα εκκίνησης που δεν πέφτει.
+// Locked rotor μέσα στο inrush blanking, πολύ πριν τα 300ms.
+void test_jam_at_start_stops_on_current(void) {
+  SimWindlass w;
+  w.begin();
+  w.current_sensor_pin = 34;
+  w.setupCurrent_();
+  w.link_us = 100000000;  // η αλυσίδα δεν κουνιέται
+  w.command("running_up");
+  const uint16_t locked = (uint16_t)(w.current_zero + 175000.0f / w.current_ma_per_count);
+  uint32_t ms = 0;
+  while (w.relayOn(w.relay_up_pin) && ms < 1000) {
+    // 1 kHz sampler, ένα tick ανά 2ms
+    w.pushCurrentSample_(locked);
+    w.pushCurrentSample_(locked);
+    w.run_ms(2);
+    ms += 2;
+  }
+  TEST_ASSERT_EQUAL_STRING("safety:stall", w.last_reason);
+  TEST_ASSERT_LESS_THAN(120u, ms);
+}
+
+// Κανονική κίνηση με ρεύμα κάτω από το stall: κανένα trip.
+void test_normal_current_does_not_trip(void) {
+  SimWindlass w;
+  w.begin();
+  w.current_sensor_pin = 34;
+  w.setupCurrent_();
+  w.command("freefall");
+  const uint16_t normal = (uint16_t)(w.current_zero + 60000.0f / w.current_ma_per_count);
+  for (int ms = 0; ms < 4000; ms += 2) {
+    w.pushCurrentSample_(normal);
+    w.pushCurrentSample_(normal);
+    w.run_ms(2);
+  }
+  TEST_ASSERT_EQUAL_STRING("down:run", w.last_reason);
+  TEST_ASSERT_TRUE(w.relayOn(w.relay_down_pin));
+  TEST_ASSERT_EQUAL(0, w.current_trips_[CurrentMonitor::kStall]);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_long_run_counts_every_link);
+  RUN_TEST(test_reversal_waits_neutral);
+  RUN_TEST(test_disconnect_during_neutral_drops_queued_run);
+  RUN_TEST(test_freefall_extends_run);
+  RUN_TEST(test_repeated_command_is_debounced);
+  RUN_TEST(test_disabled_ignores_commands);
+  RUN_TEST(test_jam_at_start_stops_on_current);
+  RUN_TEST(test_normal_current_does_not_trip);
+  return UNITY_END();
+}
@@ -0,0 +1,317 @@
+// Εξαντλητική σύγκριση του πίνακα του windlass_fsm με το παλιό dispatch
+// (String compares στον listener + if/else στο runDirection_), όπως ήταν
+// πριν από τον πίνακα. Δύο πυρήνες στο ίδιο simulated board, σε άλλα pins,
+// παίρνουν την ίδια εντολή από την ίδια κατάσταση και πρέπει να καταλήξουν
+// ακριβώς στο ίδιο σημείο.
+
+#include <unity.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include "anchor_hal.h"
+#include "windlass_core.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+class Probe : public WindlassCore {
+ public:
+  Probe(int up, int down, int sensor) {
+    relay_up_pin = up;
+    relay_down_pin = down;
+    chain_sensor_pin = sensor;
+  }
+  std::string reasons;  // όλα τα onRunStateChanged_ με τη σειρά
+
+ protected:
+  void onRunStateChanged_(const char* what) override {
+    reasons += what;
+    reasons += ';';
+  }
+};
+
+// Το dispatch πριν από τον πίνακα, αυτούσιο (χωρίς το connection gating του
+// listener, που δεν άλλαξε).
+class Legacy : public Probe {
+ public:
+  Legacy() : Probe(26, 27, 25) {}
+
+  void dispatch(const char* s) {
+    const std::string cmd_state = s;
+    if (cmd_state == "running_up") {
+      if (state != RUNNING_UP) {
+        legacyRunDirection_(RUNNING_UP, 3600.0f);
+      }
+    } else if (cmd_state == "running_down") {
+      if (state != RUNNING_DOWN) {
+        legacyRunDirection_(RUNNING_DOWN, 3600.0f);
+      }
+    } else if (cmd_state == "freefall") {
+      legacyRunDirection_(RUNNING_DOWN, 0.0f);
+    } else if (cmd_state == "idle") {
+      if (state != IDLE) {
+        stopNow_("idle:remote");
+      }
+    } else if (cmd_state == "reset_counter") {
+      resetChainCounter();
+    }
+  }
+
+ private:
+  void legacyRunDirection_(RunState dir, float seconds) {
+    if (!enabled) return;
+
+    if (processing_command_) return;
+    processing_command_ = true;
+
+    const unsigned long now_ms = hal::millis();
+    if (has_last_command_ && dir == last_command_dir_ &&
+        (now_ms - last_command_ms_ < command_debounce_ms_)) {
+      processing_command_ = false;
+      return;
+    }
+    last_command_ms_ = now_ms;
+    last_command_dir_ = dir;
+    has_last_command_ = true;
+
+    float dur = seconds;
+    if (dur <= 0.0f) dur = default_chain_seconds;
+
+    if ((dir == RUNNING_UP && state == RUNNING_DOWN) ||
+        (dir == RUNNING_DOWN && state == RUNNING_UP)) {
+      relaysOff_();
+      neutral_waiting = true;
+      neutral_until_ms = now_ms + (unsigned long)neutral_ms;
+      queued_dir_ = dir;
+      queued_dur_s_ = dur;
+      processing_command_ = false;
+      return;
+    }
+
+    if ((dir == RUNNING_UP && state == RUNNING_UP) ||
+        (dir == RUNNING_DOWN && state == RUNNING_DOWN)) {
+      unsigned long remaining = (op_end_ms > now_ms) ? (op_end_ms - now_ms) : 0;
+      unsigned long add_ms = (unsigned long)(dur * 1000.0f);
+      op_end_ms = now_ms + remaining + add_ms;
+      processing_command_ = false;
+      return;
+    }
+
+    if (neutral_waiting && now_ms < neutral_until_ms) {
+      queued_dir_ = dir;
+      queued_dur_s_ = dur;
+      processing_command_ = false;
+      return;
+    }
+
+    startRun_(dir, dur);
+    processing_command_ = false;
+  }
+};
+
+class Table : public Probe {
+ public:
+  Table() : Probe(12, 13, 14) {}
+  void dispatch(const char* s) { handleCommand(parseCommand(s)); }
+};
+
+// Ό,τι μπορεί να παρατηρήσει κανείς από έξω μετά από μία εντολή.
+static bool same(const Probe& a, const Probe& b, char* why, size_t n) {
+#define CMP(f)                                                    \
+  if (a.f != b.f) {                                               \
+    snprintf(why, n, "%s: legacy %g table %g", #f, (double)a.f, (double)b.f); \
+    return false;                                                 \
+  }
+  CMP(state)
+  CMP(relays_on_)
+  CMP(relay_actuations_)
+  CMP(op_end_ms)
+  CMP(op_start_ms)
+  CMP(neutral_waiting)
+  CMP(neutral_until_ms)
+  CMP(queued_dir_)
+  CMP(queued_dur_s_)
+  CMP(chain_pulse_count)
+  CMP(chain_out_meters)
+  CMP(has_last_command_)
+  CMP(last_command_dir_)
+  CMP(last_command_ms_)
+#undef CMP
+  const bool a_up = hal::digitalRead(a.relay_up_pin) == HIGH;
+  const bool b_up = hal::digitalRead(b.relay_up_pin) == HIGH;
+  const bool a_dn = hal::digitalRead(a.relay_down_pin) == HIGH;
+  const bool b_dn = hal::digitalRead(b.relay_down_pin) == HIGH;
+  if (a_up != b_up || a_dn != b_dn) {
+    snprintf(why, n, "relay pins differ");
+    return false;
+  }
+  if (a.reasons != b.reasons) {
+    snprintf(why, n, "reasons: legacy '%s' table '%s'", a.reasons.c_str(), b.reasons.c_str());
+    return false;
+  }
+  return true;
+}
+
+// Όλες οι εντολές + ονόματα που μοιάζουν (ίδιο μήκος, prefix, κεφαλαία)
+static const char* const kInputs[] = {
+    "running_up", "running_down", "freefall", "idle", "reset_counter",
+    "", "running_upx", "running_dow", "RUNNING_UP", "freefalL", "idle ", "idl",
+    "reset_counte", "reset_counterr", "running_dn__", "stop", "xxxxxxxxxxxxx",
+};
+static const int kNumInputs = sizeof(kInputs) / sizeof(kInputs[0]);
+
+// Αρχικές συνθήκες που αφήνουν ορατό ίχνος στο dispatch.
+struct Setup {
+  WindlassFsm::RunState state;
+  bool     enabled;
+  int      neutral;      // 0 = όχι, 1 = σε εξέλιξη, 2 = έληξε χωρίς tick
+  WindlassFsm::RunState queued;
+  int      last_dir;     // -1 = καμία εντολή ακόμα, αλλιώς RunState
+  uint32_t since_last_ms;
+  bool     op_expired;   // op_end_ms στο παρελθόν (extend από το τώρα)
+};
+
+static void apply(Probe& p, const Setup& s, unsigned long now_ms) {
+  p.enabled = s.enabled;
+  p.chain_pulse_count = 7;
+  p.chain_out_meters = 7.0f;
+  if (s.state == WindlassFsm::RUNNING_UP) p.relayUpOn_();
+  if (s.state == WindlassFsm::RUNNING_DOWN) p.relayDownOn_();
+  p.state = s.state;
+  p.op_start_ms = now_ms - 1000;
+  p.op_end_ms = s.op_expired ? now_ms - 10 : now_ms + 2500;
+  if (s.neutral) {
+    p.neutral_waiting = true;
+    p.neutral_until_ms = s.neutral == 1 ? now_ms + 150 : now_ms - 5;
+    p.queued_dir_ = s.queued;
+    p.queued_dur_s_ = s.queued == WindlassFsm::IDLE ? 0.0f : 5.0f;
+  }
+  if (s.last_dir >= 0) {
+    p.has_last_command_ = true;
+    p.last_command_dir_ = (WindlassFsm::RunState)s.last_dir;
+    p.last_command_ms_ = now_ms - s.since_last_ms;
+  }
+  p.reasons.clear();
+}
+
+// Κάθε κατάσταση × κάθε συνθήκη × κάθε είσοδος, μία εντολή.
+void test_single_command_matches_legacy_exhaustively(void) {
+  const WindlassFsm::RunState kStates[] = {WindlassFsm::IDLE, WindlassFsm::RUNNING_UP,
+                                           WindlassFsm::RUNNING_DOWN, WindlassFsm::FAULT};
+  const WindlassFsm::RunState kQueued[] = {WindlassFsm::IDLE, WindlassFsm::RUNNING_UP,
+                                           WindlassFsm::RUNNING_DOWN};
+  const int kLastDirs[] = {-1, WindlassFsm::RUNNING_UP, WindlassFsm::RUNNING_DOWN};
+  const uint32_t kSince[] = {0, 249, 250, 5000};
+  uint32_t cases = 0;
+  char why[160];
+
+  for (WindlassFsm::RunState st : kStates)
+    for (int en = 0; en < 2; en++)
+      for (int neutral = 0; neutral < 3; neutral++)
+        for (WindlassFsm::RunState q : kQueued)
+          for (int last : kLastDirs)
+            for (uint32_t since : kSince)
+              for (int expired = 0; expired < 2; expired++)
+                for (int in = 0; in < kNumInputs; in++) {
+                  if (!neutral && q != WindlassFsm::IDLE) continue;
+                  hal::sim().reset();
+                  hal::sim().advance_ms(100000);
+                  const unsigned long now = hal::millis();
+                  Legacy a;
+                  Table b;
+                  a.setupPins();
+                  b.setupPins();
+                  const Setup s = {st, en != 0, neutral, q, last, since, expired != 0};
+                  apply(a, s, now);
+                  apply(b, s, now);
+                  a.dispatch(kInputs[in]);
+                  b.dispatch(kInputs[in]);
+                  cases++;
+                  if (!same(a, b, why, sizeof(why))) {
+                    char msg[320];
+                    snprintf(msg, sizeof(msg),
+                             "state=%d enabled=%d neutral=%d queued=%d last=%d since=%u "
+                             "expired=%d cmd='%s': %s",
+                             (int)st, en, neutral, (int)q, last, (unsigned)since, expired,
+                             kInputs[in], why);
+                    TEST_FAIL_MESSAGE(msg);
+                  }
+                }
+  char msg[64];
+  snprintf(msg, sizeof(msg), "%u cases", (unsigned)cases);
+  TEST_MESSAGE(msg);
+}
+
+// Τυχαίες ακολουθίες εντολών με ticks ανάμεσα (neutral queue, timeouts,
+// debounce): οι δύο πυρήνες δεν αποκλίνουν ποτέ.
+void test_random_sequences_match_legacy(void) {
+  uint32_t rng = 0x2545F491u;
+  auto next = [&rng]() {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+  };
+  char why[160];
+  uint32_t steps = 0;
+  for (int seq = 0; seq < 200; seq++) {
+    hal::sim().reset();
+    Legacy a;
+    Table b;
+    a.default_chain_seconds = b.default_chain_seconds = 2.0f;
+    a.setupPins();
+    b.setupPins();
+    for (int i = 0; i < 500; i++, steps++) {
+      const uint32_t r = next();
+      // Κυρίως έγκυρες εντολές, μερικές άγνωστες
+      const int in = (r & 7) < 6 ? (int)((r >> 3) % 5) : (int)((r >> 3) % kNumInputs);
+      a.dispatch(kInputs[in]);
+      b.dispatch(kInputs[in]);
+      if (!same(a, b, why, sizeof(why))) {
+        char msg[256];
+        snprintf(msg, sizeof(msg), "seq %d step %d cmd '%s': %s", seq, i, kInputs[in], why);
+        TEST_FAIL_MESSAGE(msg);
+      }
+      // 0-700ms μέχρι την επόμενη εντολή, με tick ανά 2ms
+      const uint32_t gap = (next() % 351) * 2;
+      for (uint32_t t = 0; t < gap; t += 2) {
+        hal::sim().advance_ms(2);
+        a.tickCore_(hal::millis());
+        b.tickCore_(hal::millis());
+      }
+      if (!same(a, b, why, sizeof(why))) {
+        char msg[256];
+        snprintf(msg, sizeof(msg), "seq %d after tick %d: %s", seq, i, why);
+        TEST_FAIL_MESSAGE(msg);
+      }
+    }
+  }
+  char msg[64];
+  snprintf(msg, sizeof(msg), "%u commands", (unsigned)steps);
+  TEST_MESSAGE(msg);
+}
+
+// Ο parser: μόνο τα ακριβή ονόματα, ό,τι άλλο είναι kCmdUnknown.
+void test_parser_accepts_only_exact_names(void) {
+  for (int c = 0; c < WindlassFsm::kCmdUnknown; c++) {
+    const WindlassFsm::Command cmd = (WindlassFsm::Command)c;
+    TEST_ASSERT_EQUAL(cmd, WindlassFsm::parseCommand(WindlassFsm::commandName(cmd)));
+  }
+  for (int in = 5; in < kNumInputs; in++) {
+    TEST_ASSERT_EQUAL(WindlassFsm::kCmdUnknown, WindlassFsm::parseCommand(kInputs[in]));
+  }
+  TEST_ASSERT_EQUAL(WindlassFsm::kCmdUnknown, WindlassFsm::parseCommand(nullptr));
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_single_command_matches_legacy_exhaustively);
+  RUN_TEST(test_random_sequences_match_legacy);
+  RUN_TEST(test_parser_accepts_only_exact_names);
+  return UNITY_END();
+}
@@ -0,0 +1,251 @@
+// Host tests του CounterJournal πάνω σε flash στη RAM: torn εγγραφή, torn
+// carry-over στο επόμενο sector, δακτύλιος που γυρίζει και compaction με
+// πολλά channels. Η "διακοπή ρεύματος" κόβει μια εγγραφή σε τυχαίο byte
+// και μετά όλα τα writes αποτυγχάνουν, μέχρι το επόμενο "boot".
+
+#include <unity.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <vector>
+
+#include "counter_journal.h"
+
+// NOR flash: το erase γράφει 0xFF, το write μόνο καθαρίζει bits.
+class RamFlash : public JournalFlash {
+ public:
+  explicit RamFlash(uint32_t sectors) : mem_(sectors * kSectorSize, 0xFF) {}
+
+  bool read(uint32_t offset, void* dst, size_t len) override {
+    if (offset + len > mem_.size()) return false;
+    memcpy(dst, &mem_[offset], len);
+    reads++;
+    return true;
+  }
+
+  bool write(uint32_t offset, const void* src, size_t len) override {
+    if (dead || offset + len > mem_.size()) return false;
+    size_t n = len;
+    if (++ops == cut_at_op) {  // διακοπή μέσα στην εγγραφή
+      n = tear_bytes < len ? tear_bytes : len;
+      dead = true;
+    }
+    const uint8_t* p = static_cast<const uint8_t*>(src);
+    for (size_t i = 0; i < n; i++) mem_[offset + i] &= p[i];
+    return !dead;
+  }
+
+  bool erase_sector(uint32_t offset) override {
+    if (dead || offset + kSectorSize > mem_.size()) return false;
+    if (++ops == cut_at_op) {  // διακοπή πριν σβηστεί
+      dead = true;
+      return false;
+    }
+    memset(&mem_[offset], 0xFF, kSectorSize);
+    return true;
+  }
+
+  uint32_t size() const override { return (uint32_t)mem_.size(); }
+
+  // Επόμενο boot: το ρεύμα επανέρχεται, χωρίς προγραμματισμένη διακοπή
+  void power_on() {
+    dead = false;
+    cut_at_op = 0;
+    reads = 0;
+  }
+
+  uint32_t ops = 0;
+  uint32_t cut_at_op = 0;  // 0 = ποτέ
+  size_t   tear_bytes = 7;
+  bool     dead = false;
+  uint32_t reads = 0;
+
+ private:
+  std::vector<uint8_t> mem_;
+};
+
+static const uint32_t kSlots = CounterJournal::kSlotsPerSector;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Μισογραμμένη εγγραφή: το recovery κρατάει την προηγούμενη, τη μετράει
+// ως torn και το επόμενο append πάει στη θέση μετά από αυτή.
+void test_torn_record_falls_back_to_previous(void) {
+  RamFlash flash(4);
+  CounterJournal j;
+  CounterRecord r;
+  TEST_ASSERT_FALSE(j.recover(&flash, r));
+  for (int i = 1; i <= 10; i++) TEST_ASSERT_TRUE(j.append(i, (float)i, 2));
+
+  flash.cut_at_op = flash.ops + 1;
+  TEST_ASSERT_FALSE(j.append(11, 11.0f, 2));
+
+  flash.power_on();
+  CounterJournal boot;
+  TEST_ASSERT_TRUE(boot.recover(&flash, r));
+  TEST_ASSERT_EQUAL(10, r.pulses);
+  TEST_ASSERT_EQUAL(1, boot.stats().torn_records);
+  const uint32_t torn_slot = j.head_slot() - 1;
+  TEST_ASSERT_EQUAL(torn_slot + 1, boot.head_slot());
+
+  TEST_ASSERT_TRUE(boot.append(12, 12.0f, 0));
+  CounterJournal again;
+  TEST_ASSERT_TRUE(again.recover(&flash, r));
+  TEST_ASSERT_EQUAL(12, r.pulses);
+  TEST_ASSERT_EQUAL(0, r.run_state());
+}
+
+// Γεμάτο sector με δύο channels: η διακοπή πέφτει πάνω στο carry-over του
+// channel 1 στο νέο sector. Η τιμή του βρίσκεται στο προηγούμενο sector.
+void test_torn_carry_over_recovers_from_previous_sector(void) {
+  RamFlash flash(4);
+  CounterJournal j;
+  CounterRecord r;
+  j.recover(&flash, r);
+  TEST_ASSERT_TRUE(j.append(500, 50.0f, 1, 1));
+  // Γέμισε το sector με το channel 0
+  int32_t p0 = 0;
+  while (j.head_slot() < kSlots) {
+    p0++;
+    TEST_ASSERT_TRUE(j.append(p0, (float)p0, 2, 0));
+  }
+  const uint32_t old_sector = j.head_sector();
+
+  // Rollover: erase (1), header (2), carry-over ch0 (3), carry-over ch1 (4)
+  flash.cut_at_op = flash.ops + 4;
+  TEST_ASSERT_FALSE(j.append(p0 + 1, (float)(p0 + 1), 2, 0));
+
+  flash.power_on();
+  CounterJournal boot;
+  TEST_ASSERT_TRUE(boot.recover(&flash, r));
+  TEST_ASSERT_EQUAL((old_sector + 1) % 4, boot.head_sector());
+  CounterRecord c0, c1;
+  TEST_ASSERT_TRUE(boot.latest(0, c0));
+  TEST_ASSERT_TRUE(boot.latest(1, c1));
+  TEST_ASSERT_EQUAL(p0, c0.pulses);
+  TEST_ASSERT_EQUAL(500, c1.pulses);
+  TEST_ASSERT_EQUAL(1, boot.stats().torn_records);
+
+  // Το επόμενο append συνεχίζει στο νέο sector με μεγαλύτερο seq
+  TEST_ASSERT_TRUE(boot.append(p0 + 2, 0.0f, 0, 0));
+  CounterJournal again;
+  TEST_ASSERT_TRUE(again.recover(&flash, r));
+  TEST_ASSERT_EQUAL(p0 + 2, r.pulses);
+  TEST_ASSERT_TRUE(again.latest(1, c1));
+  TEST_ASSERT_EQUAL(500, c1.pulses);
+}
+
+// Πολλές φορές γύρω από τον δακτύλιο: κάθε sector σβήνεται ομοιόμορφα,
+// το recovery διαβάζει το πολύ N headers + δύο sectors.
+void test_wrap_around_recovers_latest_in_bounded_reads(void) {
+  const uint32_t kSectors = 4;
+  RamFlash flash(kSectors);
+  CounterJournal j;
+  CounterRecord r;
+  j.recover(&flash, r);
+  const int32_t kAppends = (int32_t)(kSectors * kSlots * 5 + 17);
+  uint32_t wraps = 0, last_sector = j.head_sector();
+  for (int32_t i = 1; i <= kAppends; i++) {
+    TEST_ASSERT_TRUE(j.append(i, i * 0.5f, 1));
+    if (j.head_sector() < last_sector) wraps++;
+    last_sector = j.head_sector();
+  }
+  TEST_ASSERT_GREATER_OR_EQUAL(4u, wraps);
+
+  flash.power_on();
+  CounterJournal boot;
+  TEST_ASSERT_TRUE(boot.recover(&flash, r));
+  TEST_ASSERT_EQUAL(kAppends, r.pulses);
+  TEST_ASSERT_EQUAL_FLOAT(kAppends * 0.5f, r.meters);
+  TEST_ASSERT_EQUAL(j.head_sector(), boot.head_sector());
+  TEST_ASSERT_EQUAL(j.head_slot(), boot.head_slot());
+  TEST_ASSERT_LESS_OR_EQUAL(kSectors + 2 * kSlots, flash.reads);
+  TEST_ASSERT_EQUAL(0, boot.stats().torn_records);
+}
+
+// Τρία channels, το 2 γράφεται μόνο στην αρχή: το compaction το
+// μεταφέρει σε κάθε νέο sector, ακόμα κι όταν σβηστεί το αρχικό του.
+void test_compaction_keeps_every_channel(void) {
+  RamFlash flash(3);
+  CounterJournal j;
+  CounterRecord r;
+  j.recover(&flash, r);
+  TEST_ASSERT_TRUE(j.append(77, 7.7f, 0, 2));
+  for (int32_t i = 1; i <= (int32_t)(kSlots * 7); i++) {
+    TEST_ASSERT_TRUE(j.append(i, (float)i, 2, 0));
+    TEST_ASSERT_TRUE(j.append(-i, (float)-i, 1, 1));
+  }
+  TEST_ASSERT_GREATER_THAN(3u, j.stats().sector_erases);
+
+  CounterJournal boot;
+  TEST_ASSERT_TRUE(boot.recover(&flash, r));
+  CounterRecord c[3];
+  for (int ch = 0; ch < 3; ch++) TEST_ASSERT_TRUE(boot.latest(ch, c[ch]));
+  TEST_ASSERT_EQUAL((int32_t)(kSlots * 7), c[0].pulses);
+  TEST_ASSERT_EQUAL(-(int32_t)(kSlots * 7), c[1].pulses);
+  TEST_ASSERT_EQUAL(77, c[2].pulses);
+  TEST_ASSERT_EQUAL_FLOAT(7.7f, c[2].meters);
+  TEST_ASSERT_EQUAL(2, c[2].channel());
+  CounterRecord none;
+  TEST_ASSERT_FALSE(boot.latest(3, none));
+}
+
+// Διακοπή σε κάθε δυνατή λειτουργία flash (write ή erase) κατά μήκος δύο
+// rollovers: μετά το boot κάθε channel έχει την τιμή του τελευταίου
+// επιτυχημένου append ή εκείνου που κόπηκε, ποτέ παλαιότερη.
+void test_power_cut_at_every_operation(void) {
+  const int kPerChannel = (int)kSlots + 40;
+  uint32_t cuts = 0;
+  for (uint32_t cut = 1;; cut++) {
+    RamFlash flash(3);
+    CounterJournal j;
+    CounterRecord r;
+    j.recover(&flash, r);
+    flash.tear_bytes = 1 + cut % 15;
+    flash.cut_at_op = cut;
+    int32_t ok[2] = {0, 0}, tried[2] = {0, 0};
+    for (int i = 1; i <= kPerChannel && !flash.dead; i++) {
+      for (int ch = 0; ch < 2 && !flash.dead; ch++) {
+        tried[ch] = i;
+        if (j.append(i, (float)i, 1, (uint8_t)ch)) ok[ch] = i;
+      }
+    }
+    if (!flash.dead) break;  // η διακοπή έπεσε μετά το τέλος: όλα τα σημεία καλύφθηκαν
+    cuts++;
+
+    flash.power_on();
+    CounterJournal boot;
+    boot.recover(&flash, r);
+    for (int ch = 0; ch < 2; ch++) {
+      CounterRecord c;
+      const bool has = boot.latest(ch, c);
+      const int32_t got = has ? c.pulses : 0;
+      if (got != ok[ch] && got != tried[ch]) {
+        char msg[96];
+        snprintf(msg, sizeof(msg), "cut at op %u: channel %d has %d, expected %d or %d",
+                 (unsigned)cut, ch, (int)got, (int)ok[ch], (int)tried[ch]);
+        TEST_FAIL_MESSAGE(msg);
+      }
+    }
+    // Και μετά τη διακοπή το journal συνεχίζει κανονικά
+    TEST_ASSERT_TRUE(boot.append(9999, 0.0f, 0, 0));
+    CounterJournal again;
+    TEST_ASSERT_TRUE(again.recover(&flash, r));
+    TEST_ASSERT_EQUAL(9999, r.pulses);
+  }
+  TEST_ASSERT_GREATER_THAN(2u * kSlots, cuts);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_torn_record_falls_back_to_previous);
+  RUN_TEST(test_torn_carry_over_recovers_from_previous_sector);
+  RUN_TEST(test_wrap_around_recovers_latest_in_bounded_reads);
+  RUN_TEST(test_compaction_keeps_every_channel);
+  RUN_TEST(test_power_cut_at_every_operation);
+  return UNITY_END();
+}
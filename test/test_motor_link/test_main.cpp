@@ -0,0 +1,230 @@
+// Stress test του mailbox (SpscRing) και του snapshot (Seqlock) ανάμεσα σε
+// std::thread, όπως το loop task και το motor task στη συσκευή: καμία
+// εντολή χαμένη ή διπλή, κανένα σκισμένο snapshot.
+
+#include <unity.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "motor_link.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static const uint32_t kItems = 2u * 1000u * 1000u;
+
+// Αναμονή για το άλλο thread. Σε host με έναν πυρήνα το yield δεν αφήνει
+// πάντα το άλλο thread να τρέξει, οπότε κάθε τόσο κοιμάται λίγο.
+static void relax(uint32_t& spins) {
+  if (++spins % 64) {
+    std::this_thread::yield();
+  } else {
+    std::this_thread::sleep_for(std::chrono::microseconds(20));
+  }
+}
+
+// Producer που ξαναδοκιμάζει όταν γεμίσει: όλα φτάνουν, με τη σειρά, μία φορά.
+void test_ring_delivers_every_item_in_order(void) {
+  static SpscRing<uint32_t, 16> ring;
+  std::thread producer([] {
+    uint32_t spins = 0;
+    for (uint32_t i = 1; i <= kItems;) {
+      if (ring.push(i)) i++;
+      else relax(spins);
+    }
+  });
+  uint32_t expect = 1, out, bad = 0, spins = 0;
+  while (expect <= kItems) {
+    if (!ring.pop(out)) {
+      relax(spins);
+      continue;
+    }
+    if (out != expect) bad++;
+    expect = out + 1;
+  }
+  producer.join();
+  TEST_ASSERT_EQUAL(0, bad);
+  TEST_ASSERT_TRUE(ring.empty());
+}
+
+// Producer σαν ISR (δεν περιμένει): ό,τι δεν χωράει μετράει overflow,
+// ό,τι περνάει φτάνει αύξον και χωρίς διπλά.
+void test_ring_overflow_accounting(void) {
+  static SpscRing<uint32_t, 8> ring;
+  std::atomic<bool> done{false};
+  std::thread producer([&done] {
+    for (uint32_t i = 1; i <= kItems; i++) ring.push(i);
+    done.store(true, std::memory_order_release);
+  });
+  uint32_t last = 0, received = 0, out, bad = 0, spins = 0;
+  for (;;) {
+    const bool finished = done.load(std::memory_order_acquire);
+    while (ring.pop(out)) {
+      if (out <= last) bad++;
+      last = out;
+      received++;
+    }
+    if (finished) break;
+    relax(spins);
+  }
+  producer.join();
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%u received, %u overflows", (unsigned)received,
+           (unsigned)ring.overflows());
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_EQUAL(0, bad);
+  TEST_ASSERT_EQUAL(kItems, received + ring.overflows());
+}
+
+// Κάθε πεδίο βγαίνει από το ίδιο n: ένα σκισμένο read θα τα ανακάτευε.
+struct Pattern {
+  uint32_t n;
+  uint32_t words[15];
+  float    f;
+  uint8_t  tail[3];
+};
+
+static void fill(Pattern& p, uint32_t n) {
+  p.n = n;
+  for (uint32_t i = 0; i < 15; i++) p.words[i] = n * 2654435761u + i;
+  p.f = (float)(n & 0xffff);
+  memset(p.tail, (int)(n & 0xff), sizeof(p.tail));
+}
+
+static bool consistent(const Pattern& p) {
+  Pattern q;
+  fill(q, p.n);
+  return memcmp(&p, &q, sizeof(Pattern)) == 0;
+}
+
+// Ένας writer χωρίς αναμονή, δύο readers (ένας με read(), ένας με
+// read_yielding() όπως το web server task): κάθε read είναι ολόκληρο και η
+// σειρά των εκδόσεων δεν πάει ποτέ πίσω.
+void test_seqlock_never_tears(void) {
+  static Seqlock<Pattern> lock;
+  std::atomic<bool> done{false};
+  std::atomic<uint32_t> torn{0}, backwards{0}, reads{0}, gave_up{0};
+
+  auto reader = [&](bool bounded) {
+    uint32_t last = 0, spins = 0;
+    Pattern p;
+    while (!done.load(std::memory_order_acquire)) {
+      if (bounded) {
+        if (!lock.read_yielding(p)) {
+          gave_up++;
+          continue;
+        }
+      } else {
+        lock.read(p);
+      }
+      if (!consistent(p)) torn++;
+      if (p.n < last) backwards++;
+      last = p.n;
+      reads++;
+      relax(spins);
+    }
+  };
+  Pattern first;
+  fill(first, 0);
+  lock.write(first);
+  std::thread r1(reader, false), r2(reader, true);
+  Pattern p;
+  for (uint32_t n = 1; n <= kItems; n++) {
+    fill(p, n);
+    lock.write(p);
+  }
+  done.store(true, std::memory_order_release);
+  r1.join();
+  r2.join();
+
+  char msg[96];
+  snprintf(msg, sizeof(msg), "%u reads, %u retries, %u bounded reads gave up",
+           (unsigned)reads.load(), (unsigned)lock.retries(), (unsigned)gave_up.load());
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_EQUAL(0, torn.load());
+  TEST_ASSERT_EQUAL(0, backwards.load());
+  TEST_ASSERT_EQUAL(2u * (kItems + 1u), lock.version());
+}
+
+// Χωρίς writer: read_yielding() διαβάζει με την πρώτη, χωρίς retries.
+void test_seqlock_bounded_read_without_writer(void) {
+  Seqlock<Pattern> lock;
+  Pattern p, q;
+  memset(&p, 0, sizeof(p));
+  memset(&q, 0xff, sizeof(q));
+  fill(p, 7);
+  lock.write(p);
+  TEST_ASSERT_TRUE(lock.read_yielding(q));
+  TEST_ASSERT_EQUAL_MEMORY(&p, &q, sizeof(Pattern));
+  TEST_ASSERT_EQUAL(0, lock.retries());
+}
+
+// Το MotorLink όπως το χρησιμοποιούν τα δύο tasks: εντολές από το loop,
+// snapshot από το motor. Το snapshot δείχνει πάντα την τελευταία εντολή που
+// εφαρμόστηκε, ποτέ κάποια που δεν στάλθηκε ακόμα.
+void test_motor_link_round_trip(void) {
+  static MotorLink link;
+  const uint32_t kCommands = 200u * 1000u;
+  std::atomic<uint32_t> sent{0};
+  std::atomic<bool> stop{false};
+
+  std::thread motor([&] {
+    MotorSnapshot s;
+    memset(&s, 0, sizeof(s));
+    MotorCommand c;
+    uint32_t spins = 0;
+    while (!stop.load(std::memory_order_acquire)) {
+      while (link.commands.pop(c)) {
+        s.seq++;
+        s.chain_pulse_count = (int32_t)c.id;
+        s.chain_out_meters = c.value;
+      }
+      link.snapshot.write(s);
+      relax(spins);
+    }
+  });
+
+  uint32_t bad = 0, last_seen = 0, spins = 0;
+  MotorSnapshot s;
+  for (uint32_t id = 1; id <= kCommands;) {
+    MotorCommand c;
+    memset(&c, 0, sizeof(c));
+    c.type = MotorCommand::kSetChainOut;
+    c.id = id;
+    c.value = (float)id;
+    if (link.post(c)) sent.store(id++, std::memory_order_release);
+    else relax(spins);
+    link.snapshot.read(s);
+    const uint32_t seen = (uint32_t)s.chain_pulse_count;
+    if (seen > sent.load(std::memory_order_acquire) || seen < last_seen ||
+        s.chain_out_meters != (float)seen || s.seq != seen) {
+      bad++;
+    }
+    last_seen = seen;
+  }
+  while ((uint32_t)s.chain_pulse_count != kCommands) {
+    relax(spins);
+    link.snapshot.read(s);
+  }
+  stop.store(true, std::memory_order_release);
+  motor.join();
+  TEST_ASSERT_EQUAL(0, bad);
+  TEST_ASSERT_EQUAL(kCommands, s.seq);
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_ring_delivers_every_item_in_order);
+  RUN_TEST(test_ring_overflow_accounting);
+  RUN_TEST(test_seqlock_never_tears);
+  RUN_TEST(test_seqlock_bounded_read_without_writer);
+  RUN_TEST(test_motor_link_round_trip);
+  return UNITY_END();
+}
@@ -0,0 +1,122 @@
+// Ακρίβεια του αυτόματου stop σε μήκος στόχο (checkTarget_) και coast
+// learning στο simulated board, με το κόστος του ChainSpeedEstimator.
+
+#include <unity.h>
+
+#include <math.h>
+#include <stdio.h>
+
+#include <chrono>
+
+#include "../windlass_sim.h"
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Μία κίνηση προς τον στόχο μέχρι να σταματήσει η αλυσίδα. Επιστρέφει
+// τελική θέση - στόχος (ό,τι κρατάει και το last_target_error_m_).
+static float runToTarget(SimWindlass& w, float target_m) {
+  w.setChainTarget(target_m);
+  w.command(target_m >= w.chain_out_meters ? "running_down" : "running_up");
+  TEST_ASSERT_TRUE(w.run_until_idle(600 * 1000));
+  w.run_ms(1500);  // κλείνει το παράθυρο coast
+  TEST_ASSERT_FALSE(w.hasChainTarget());
+  return w.chain_out_meters - target_m;
+}
+
+// Χωρίς μαθημένο coast το ρελέ κόβεται πάνω στον στόχο και η αλυσίδα τον
+// περνάει όσο κυλάει. Το coast που μετρήθηκε γίνεται η πρώτη εκτίμηση.
+void test_first_run_overshoots_by_coast(void) {
+  SimWindlass w;
+  w.begin();
+  const float err = runToTarget(w, 20.0f);
+  TEST_ASSERT_EQUAL_STRING("down:target", w.last_reason);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 2.0f, err);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 2.0f, w.last_target_error_m_);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 2.0f, w.coast_.coast_m(0));
+  TEST_ASSERT_EQUAL(w.links_passed, w.chain_pulse_count);
+}
+
+// Με μαθημένο coast ανά κατεύθυνση: κάθε stop μέσα σε έναν κρίκο.
+void test_learned_coast_lands_on_target(void) {
+  SimWindlass w;
+  w.begin();
+  const float targets[] = {20.0f, 8.0f, 35.0f, 12.0f, 30.0f, 5.0f, 25.0f, 10.0f};
+  float worst = 0.0f;
+  for (size_t i = 0; i < sizeof(targets) / sizeof(targets[0]); i++) {
+    const float err = runToTarget(w, targets[i]);
+    // Οι δύο πρώτες κινήσεις (μία ανά κατεύθυνση) μαθαίνουν το coast
+    if (i >= 2 && fabsf(err) > worst) worst = fabsf(err);
+  }
+  char msg[96];
+  snprintf(msg, sizeof(msg), "coast down %.2fm up %.2fm, worst stop error %.2fm",
+           w.coast_.coast_m(0), w.coast_.coast_m(1), worst);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 2.0f, w.coast_.coast_m(0));
+  TEST_ASSERT_FLOAT_WITHIN(0.01f, 1.0f, w.coast_.coast_m(1));
+  TEST_ASSERT_LESS_OR_EQUAL(w.chain_calibration, worst);
+  TEST_ASSERT_EQUAL(w.links_passed, w.chain_pulse_count);
+}
+
+// Ταχύτερη αλυσίδα (freefall): ίδια ακρίβεια, το coast σε κρίκους δεν αλλάζει.
+void test_fast_chain_lands_on_target(void) {
+  SimWindlass w;
+  w.begin();
+  w.link_us = 120000;
+  w.coast_.set_coast_m(0, 2.0f);
+  const float err = runToTarget(w, 40.0f);
+  TEST_ASSERT_EQUAL_STRING("down:target", w.last_reason);
+  TEST_ASSERT_LESS_OR_EQUAL(w.chain_calibration, fabsf(err));
+}
+
+// Το ETA μικραίνει όσο πλησιάζει και φτάνει στο 0 πάνω στο stop.
+void test_eta_counts_down(void) {
+  SimWindlass w;
+  w.begin();
+  w.coast_.set_coast_m(0, 2.0f);
+  w.setChainTarget(20.0f);
+  w.command("running_down");
+  w.run_ms(3000);
+  const float eta1 = w.targetEtaSeconds(hal::micros());
+  w.run_ms(2000);
+  const float eta2 = w.targetEtaSeconds(hal::micros());
+  TEST_ASSERT_FALSE(isnan(eta1));
+  TEST_ASSERT_FALSE(isnan(eta2));
+  // 1 κρίκος / 400ms = 2.5m/s: 2s κίνησης = 2s λιγότερο ETA
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, 2.0f, eta1 - eta2);
+  // Μέτρα μέχρι τον στόχο μείον coast, με την ταχύτητα της αλυσίδας
+  const float expect = (20.0f - w.chain_out_meters - 2.0f) / w.chainSpeed(hal::micros());
+  TEST_ASSERT_FLOAT_WITHIN(0.5f, expect, eta2);
+}
+
+// Κόστος του estimator ανά παλμό + ανάγνωση ταχύτητας (O(1), χωρίς heap).
+void test_speed_estimator_cost(void) {
+  ChainSpeedEstimator est;
+  const uint32_t kPulses = 20u * 1000u * 1000u;
+  volatile float sink = 0.0f;
+  uint32_t t = 0;
+  const auto t0 = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < kPulses; i++) {
+    t += 380000u + (i % 7u) * 7000u;
+    est.on_pulse(t);
+    sink = sink + est.speed(t + 1000u, 1.0f);
+  }
+  const double ns = std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - t0).count() / kPulses;
+  char msg[64];
+  snprintf(msg, sizeof(msg), "%.1f ns per pulse + speed()", ns);
+  TEST_MESSAGE(msg);
+  TEST_ASSERT_FLOAT_WITHIN(0.3f, 2.5f, est.speed(t + 1000u, 1.0f));
+}
+
+int main(int argc, char** argv) {
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_first_run_overshoots_by_coast);
+  RUN_TEST(test_learned_coast_lands_on_target);
+  RUN_TEST(test_fast_chain_lands_on_target);
+  RUN_TEST(test_eta_counts_down);
+  RUN_TEST(test_speed_estimator_cost);
+  return UNITY_END();
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+// Κοινό harness των native test suites: ένα WindlassCore πάνω στο
+// hal::sim board, με εικονική αλυσίδα που περνάει κρίκο-κρίκο από τη
+// μαγνητική επαφή όσο είναι κλειστό ένα ρελέ, και κυλάει ακόμα λίγους
+// κρίκους αφού κοπεί. Το tickCore_() τρέχει κάθε step_us, όπως το motor
+// task, και όλος ο χρόνος είναι εικονικός.
+
+#include <stdint.h>
+#include <string.h>
+
+#include "anchor_hal.h"
+#include "windlass_core.h"
+
+class SimWindlass : public WindlassCore {
+ public:
+  // Εικονική αλυσίδα
+  uint32_t link_us = 400000;      // ένας κρίκος ανά 400ms με το μοτέρ σε λειτουργία
+  uint32_t coast_links[2] = {2, 1};  // κρίκοι μετά το stop (0 = κάτω, 1 = πάνω)
+  uint32_t step_us = 2000;        // περίοδος του tickCore_() (motor task)
+
+  // Παρατηρήσεις
+  char     last_reason[32] = "";
+  uint32_t run_changes = 0;
+  int32_t  links_passed = 0;       // κρίκοι που πέρασαν πραγματικά (κάτω +, πάνω -)
+  uint32_t both_on = 0;            // writes που άφησαν και τα δύο ρελέ on
+  uint32_t reverse_gap_min_us = UINT32_MAX;  // μικρότερο κενό σε αλλαγή κατεύθυνσης
+  uint64_t ticks = 0;
+
+  void begin() {
+    hal::sim().reset();
+    hal::sim().on_write = &SimWindlass::onWrite_;
+    hal::sim().on_write_ctx = this;
+    setupPins();
+    setupCurrent_();
+  }
+
+  bool relayOn(int pin) const {
+    return (hal::digitalRead(pin) == HIGH) == relays_active_high;
+  }
+
+  void command(const char* name) { handleCommand(parseCommand(name)); }
+
+  // Τρέχει το board για ms εικονικά ms.
+  void run_ms(uint32_t ms) {
+    const uint64_t end = hal::sim().now_us + (uint64_t)ms * 1000ULL;
+    while (hal::sim().now_us < end) step_();
+  }
+
+  // Τρέχει μέχρι να σταματήσει η αλυσίδα (κανένα ρελέ, κανένα coast) ή
+  // μέχρι limit_ms. Επιστρέφει false στο όριο.
+  bool run_until_idle(uint32_t limit_ms) {
+    const uint64_t end = hal::sim().now_us + (uint64_t)limit_ms * 1000ULL;
+    while (hal::sim().now_us < end) {
+      step_();
+      if (!relays_on_ && !neutral_waiting && coast_left_ == 0 && !coast_.active() &&
+          hal::digitalRead(chain_sensor_pin) == HIGH) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ protected:
+  void onRunStateChanged_(const char* what) override {
+    strncpy(last_reason, what, sizeof(last_reason) - 1);
+    run_changes++;
+  }
+
+ private:
+  void step_() {
+    hal::SimBoard& b = hal::sim();
+    const int dir = relayOn(relay_up_pin) ? 1 : relayOn(relay_down_pin) ? 0 : -1;
+
+    // Κίνηση: ρελέ → αλυσίδα, μετά το stop συνεχίζει για τους κρίκους coast
+    if (dir >= 0) {
+      moving_dir_ = dir;
+      coast_left_ = coast_links[dir];
+    }
+    const bool rolling = dir >= 0 || coast_left_ > 0;
+
+    if (rolling) {
+      phase_us_ += step_us;
+      // Ο μαγνήτης περνάει: LOW για το 1/4 του κρίκου, ο παλμός στο LOW→HIGH
+      if (phase_us_ >= link_us) {
+        phase_us_ -= link_us;
+        b.set_input(chain_sensor_pin, LOW);
+      } else if (phase_us_ >= link_us / 4 && b.level[chain_sensor_pin] == LOW) {
+        b.set_input(chain_sensor_pin, HIGH);
+        links_passed += moving_dir_ == 0 ? 1 : -1;
+        if (dir < 0 && coast_left_ > 0) coast_left_--;
+      }
+    }
+
+    b.advance_us(step_us);
+    tickCore_(hal::millis());
+    ticks++;
+  }
+
+  static void onWrite_(void* ctx, int pin, int level, uint64_t t_us) {
+    auto* self = static_cast<SimWindlass*>(ctx);
+    (void)level;
+    if (pin != self->relay_up_pin && pin != self->relay_down_pin) return;
+    const bool up = self->relayOn(self->relay_up_pin);
+    const bool down = self->relayOn(self->relay_down_pin);
+    if (up && down) self->both_on++;
+    const int dir = up ? 1 : down ? 0 : -1;
+    const int prev = self->wired_dir_;
+    self->wired_dir_ = dir;
+    if (dir == prev) return;
+    if (dir < 0) {
+      self->last_off_us_ = t_us;
+      return;
+    }
+    if (self->last_on_dir_ >= 0 && dir != self->last_on_dir_) {
+      const uint64_t gap = prev >= 0 ? 0 : t_us - self->last_off_us_;
+      if (gap < self->reverse_gap_min_us) self->reverse_gap_min_us = (uint32_t)gap;
+    }
+    self->last_on_dir_ = dir;
+  }
+
+  uint32_t phase_us_ = 0;
+  uint32_t coast_left_ = 0;
+  int      moving_dir_ = -1;
+  int      wired_dir_ = -1;   // ό,τι δείχνουν τα ρελέ μετά το τελευταίο write
+  int      last_on_dir_ = -1;
+  uint64_t last_off_us_ = 0;
+};
@@ -0,0 +1,314 @@
+// Host tool: το anchor watch (include/anchor_watch.h) πάνω σε καταγεγραμμένα
+// ή συνθετικά tracks, με το κόστος ανά fix.
+//
+//   g++ -std=gnu++11 -O2 -Iinclude tools/anchor_watch_replay.cpp -o anchor_watch_replay
+//   ./anchor_watch_replay                     # συνθετικά σενάρια + benchmark
+//   ./anchor_watch_replay --track track.csv [--chain 40] [--margin 10]
+//                         [--anchor 37.9381,23.6712]
+//
+// Track: t_s,lat,lon[,chain_m] ανά γραμμή (headers και κενές γραμμές
+// αγνοούνται). Χωρίς στήλη αλυσίδας μετράει το --chain. Χωρίς --anchor και
+// με αλυσίδα ήδη κάτω, η άγκυρα βγαίνει από το swing circle, όπως μετά από
+// reboot χωρίς αποθηκευμένη θέση.
+//
+// Συνθετικά σενάρια (1 fix/s, GPS θόρυβος 1.5m):
+//   swing       2 ώρες με τον άνεμο να γυρίζει ±60°: κανένα alarm
+//   drag        η άγκυρα σέρνεται στα 30 λεπτά: alarm στο πρώτο fix έξω
+//               από την ακτίνα και το πολύ 10s μετά το πραγματικό
+//   reboot      άγνωστη άγκυρα: εκτίμηση από τον κύκλο, σφάλμα < 5m
+//   glitch      fixes 500m μακριά για 1-2 δευτερόλεπτα: κανένα alarm
+// Exit code 1 αν κάποιο αποτυγχάνει.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "anchor_watch.h"
+
+namespace {
+
+constexpr double kLat0 = 37.9381, kLon0 = 23.6712;   // Πειραιάς
+constexpr double kMPerDegLat = 111194.93;
+
+struct Fix {
+  double t_s;
+  double lat, lon;
+  float  chain_m;
+  bool   running;
+  double true_dist;  // χωρίς θόρυβο, από το σημείο που έπεσε η άγκυρα (συνθετικά)
+};
+typedef std::vector<Fix> Track;
+
+double now_s() {
+  using namespace std::chrono;
+  return duration_cast<duration<double>>(steady_clock::now().time_since_epoch()).count();
+}
+
+class Rng {
+ public:
+  double uniform() {
+    s_ ^= s_ << 13;
+    s_ ^= s_ >> 7;
+    s_ ^= s_ << 17;
+    return (double)(s_ >> 11) / 9007199254740992.0;
+  }
+  double gauss() {
+    const double u = uniform() + 1e-12, v = uniform();
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+  }
+
+ private:
+  uint64_t s_ = 0x2545F4914F6CDD1DULL;
+};
+
+// Μέτρα (ανατολικά, βόρεια) από το (kLat0, kLon0) → lat/lon
+void to_latlon(double x, double y, double& lat, double& lon) {
+  lat = kLat0 + y / kMPerDegLat;
+  lon = kLon0 + x / (kMPerDegLat * cos(kLat0 * M_PI / 180.0));
+}
+
+struct SwingParams {
+  double hours;
+  bool   drop;         // ξεκινάει με την άγκυρα πάνω και ποντάρει
+  double drag_at_s;    // <0 = δεν σέρνει
+  double drag_mps;
+  bool   glitches;
+};
+
+// Το σκάφος στρίβει γύρω από την άγκυρα με τον άνεμο. Η GPS κεραία είναι
+// στην απόσταση της αλυσίδας στο οριζόντιο (8m βάθος) μείον το πόσο
+// κρεμάει η αλυσίδα στον ελαφρύ αέρα.
+Track swing(const SwingParams& p) {
+  Track t;
+  Rng rng;
+  const float chain = 40.0f;
+  const double horiz = sqrt(chain * chain - 8.0 * 8.0);
+  double ax = 0.0, ay = 0.0;  // άγκυρα
+  const double total = p.hours * 3600.0;
+  const double deploy_s = p.drop ? 60.0 : 0.0;
+  for (double s = 0.0; s < total; s += 1.0) {
+    const double wind = 60.0 * sin(2.0 * M_PI * s / 600.0) + 20.0 * sin(2.0 * M_PI * s / 97.0);
+    const double rad = (200.0 + wind) * M_PI / 180.0;  // ο άνεμος από ΝΔ
+    double reach = horiz * (0.85 + 0.1 * sin(2.0 * M_PI * s / 45.0));
+    float c = chain;
+    bool running = false;
+    if (s < deploy_s) {  // 20s πάνω από την άγκυρα, μετά 40m σε 40s
+      c = s < 20.0 ? 0.0f : (float)(s - 20.0);
+      running = s >= 20.0;
+      reach *= c / chain;
+    }
+    if (p.drag_at_s >= 0.0 && s > p.drag_at_s) {
+      ax -= p.drag_mps * sin(rad);
+      ay -= p.drag_mps * cos(rad);
+    }
+    const double x = ax - reach * sin(rad), y = ay - reach * cos(rad);
+    Fix f;
+    f.t_s = s;
+    f.chain_m = c;
+    f.running = running;
+    f.true_dist = sqrt(x * x + y * y);
+    double nx = x + 1.5 * rng.gauss(), ny = y + 1.5 * rng.gauss();
+    if (p.glitches && fmod(s, 900.0) < 2.0 && s > deploy_s) nx += 500.0;
+    to_latlon(nx, ny, f.lat, f.lon);
+    t.push_back(f);
+  }
+  return t;
+}
+
+struct Outcome {
+  long   first_alarm = -1;       // index του fix
+  long   first_outside = -1;     // πρώτο fix (με θόρυβο) έξω από την ακτίνα
+  long   first_true_outside = -1;
+  int    alarms = 0;
+  double max_dist = 0.0;
+  AnchorWatch::Source source = AnchorWatch::kNone;
+  double anchor_err = NAN;       // m από το (kLat0, kLon0)
+  float  swing_r = NAN;
+};
+
+Outcome run(const Track& t, AnchorWatch& w, bool verbose) {
+  Outcome o;
+  AnchorWatch::State prev = w.state();
+  for (size_t i = 0; i < t.size(); i++) {
+    const Fix& f = t[i];
+    const uint32_t ms = (uint32_t)(f.t_s * 1000.0);
+    w.update(f.chain_m, f.running, ms);
+    w.on_fix(f.lat, f.lon, ms);
+    const float d = w.distance_m();
+    if (!isnan(d) && d > o.max_dist) o.max_dist = d;
+    const bool watching = w.state() == AnchorWatch::kWatching || w.state() == AnchorWatch::kDrag;
+    if (o.first_outside < 0 && watching && d > w.alarm_radius_m()) o.first_outside = (long)i;
+    if (o.first_true_outside < 0 && !f.running && f.true_dist > w.alarm_radius_m()) {
+      o.first_true_outside = (long)i;
+    }
+    if (w.state() != prev) {
+      if (w.state() == AnchorWatch::kDrag) {
+        o.alarms++;
+        if (o.first_alarm < 0) o.first_alarm = (long)i;
+      }
+      if (verbose) {
+        printf("  %8.0fs  %-8s  chain %5.1fm  radius %5.1fm  dist %6.1fm\n", f.t_s,
+               AnchorWatch::stateName(w.state()), f.chain_m, w.alarm_radius_m(), d);
+      }
+      prev = w.state();
+    }
+  }
+  o.source = w.source();
+  if (w.has_anchor()) {
+    const double dy = (w.anchor_lat() - kLat0) * kMPerDegLat;
+    const double dx = (w.anchor_lon() - kLon0) * kMPerDegLat * cos(kLat0 * M_PI / 180.0);
+    o.anchor_err = sqrt(dx * dx + dy * dy);
+  }
+  o.swing_r = w.swing_radius_m();
+  return o;
+}
+
+bool run_synthetic() {
+  bool ok = true;
+  {
+    AnchorWatch w;
+    const Outcome o = run(swing({2.0, true, -1.0, 0.0, false}), w, false);
+    const bool pass = o.alarms == 0 && o.source == AnchorWatch::kDropped && o.anchor_err < 5.0;
+    printf("%-8s alarms %d  max dist %5.1fm / radius %4.1fm  anchor %s (%.1fm off)  "
+           "swing r %5.1fm  %s\n",
+           "swing", o.alarms, o.max_dist, w.alarm_radius_m(), AnchorWatch::sourceName(o.source), o.anchor_err,
+           o.swing_r, pass ? "ok" : "FAIL");
+    ok &= pass;
+  }
+  {
+    AnchorWatch w;
+    const Outcome o = run(swing({1.0, true, 1800.0, 0.3, false}), w, false);
+    const long late = o.first_alarm - o.first_true_outside;
+    const bool pass = o.first_alarm >= 0 && o.first_alarm == o.first_outside && late <= 10;
+    printf("%-8s alarm at %lds, first fix outside %lds, true crossing %lds (%+lds)  %s\n", "drag",
+           o.first_alarm, o.first_outside, o.first_true_outside, late, pass ? "ok" : "FAIL");
+    ok &= pass;
+  }
+  {
+    AnchorWatch w;
+    const Track t = swing({1.0, false, -1.0, 0.0, false});
+    const Outcome o = run(t, w, false);
+    const bool pass = o.alarms == 0 && o.source == AnchorWatch::kFitted && o.anchor_err < 5.0;
+    printf("%-8s anchor %s, %.1fm from the true position, swing r %5.1fm  %s\n", "reboot",
+           AnchorWatch::sourceName(o.source), o.anchor_err, o.swing_r, pass ? "ok" : "FAIL");
+    ok &= pass;
+  }
+  {
+    AnchorWatch w;
+    const Outcome o = run(swing({1.0, true, -1.0, 0.0, true}), w, false);
+    const bool pass = o.alarms == 0 && w.rejected() > 0;
+    printf("%-8s alarms %d, %u fixes rejected  %s\n", "glitch", o.alarms, (unsigned)w.rejected(),
+           pass ? "ok" : "FAIL");
+    ok &= pass;
+  }
+  return ok;
+}
+
+// Κόστος του on_fix() με το ring γεμάτο: στο 1 Hz (ένα fix στα
+// kRingIntervalMs μπαίνει στο ring και ξαναλύνει το fit) και το χειρότερο
+// fix, όταν κάθε fix μπαίνει στο ring
+void benchmark() {
+  const Track t = swing({2.0, true, -1.0, 0.0, false});
+  const size_t kFixes = 5u * 1000u * 1000u;
+  for (int worst = 0; worst < 2; worst++) {
+    AnchorWatch w;
+    for (const Fix& f : t) {
+      w.update(f.chain_m, f.running, (uint32_t)(f.t_s * 1000.0));
+      if (f.t_s > 120.0) break;
+    }
+    const uint32_t step = worst ? AnchorWatch::kRingIntervalMs : 1000;
+    volatile float sink = 0.0f;
+    uint32_t ms = 200000;
+    const double t0 = now_s();
+    for (size_t n = 0; n < kFixes;) {
+      for (size_t i = 120; i < t.size() && n < kFixes; i++, n++) {
+        ms += step;
+        w.on_fix(t[i].lat, t[i].lon, ms);
+        sink += w.distance_m();
+      }
+    }
+    const double secs = now_s() - t0;
+    printf("per fix%s: %.0f ns (%.1f Mfixes/s)\n", worst ? " into the ring" : ", 1 Hz",
+           secs / kFixes * 1e9, kFixes / secs / 1e6);
+  }
+  printf("ring %d fixes every %us, %zu bytes per watch\n", AnchorWatch::kFixes,
+         (unsigned)(AnchorWatch::kRingIntervalMs / 1000), sizeof(AnchorWatch));
+}
+
+bool read_track(const char* path, float chain, Track& out) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    Fix x = {};
+    float c = chain;
+    const int n = sscanf(line, "%lf,%lf,%lf,%f", &x.t_s, &x.lat, &x.lon, &c);
+    if (n < 3) continue;  // header ή κενή γραμμή
+    x.chain_m = c;
+    out.push_back(x);
+  }
+  fclose(f);
+  return true;
+}
+
+int replay(const char* path, float chain, float margin, bool has_anchor, double alat,
+           double alon) {
+  Track t;
+  if (!read_track(path, chain, t) || t.empty()) {
+    fprintf(stderr, "cannot read track %s\n", path);
+    return 1;
+  }
+  // Χρόνος από το πρώτο fix
+  const double t0 = t[0].t_s;
+  for (Fix& f : t) f.t_s -= t0;
+  AnchorWatch w;
+  w.configure(true, margin);
+  if (has_anchor) w.restore_anchor(alat, alon);
+  const double c0 = now_s();
+  const Outcome o = run(t, w, true);
+  const double secs = now_s() - c0;
+  printf("%s: %zu fixes (%.1f h), %u rejected, %d drag alarm(s), max dist %.1fm\n", path,
+         t.size(), t.back().t_s / 3600.0, (unsigned)w.rejected(), o.alarms, o.max_dist);
+  if (w.has_anchor()) {
+    printf("anchor %s at %.6f,%.6f  swing r %.1fm  offset %.1fm\n", AnchorWatch::sourceName(w.source()),
+           w.anchor_lat(), w.anchor_lon(), w.swing_radius_m(), w.swing_offset_m());
+  }
+  printf("%.0f ns per fix\n", secs / t.size() * 1e9);
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* track = nullptr;
+  float chain = 40.0f, margin = 10.0f;
+  bool has_anchor = false;
+  double alat = 0.0, alon = 0.0;
+  for (int i = 1; i < argc; i++) {
+    const bool has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--track") && has_value) {
+      track = argv[++i];
+    } else if (!strcmp(argv[i], "--chain") && has_value) {
+      chain = (float)atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--margin") && has_value) {
+      margin = (float)atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--anchor") && has_value &&
+               sscanf(argv[i + 1], "%lf,%lf", &alat, &alon) == 2) {
+      has_anchor = true;
+      i++;
+    } else {
+      fprintf(stderr,
+              "usage: %s [--track file.csv] [--chain m] [--margin m] [--anchor lat,lon]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (track) return replay(track, chain, margin, has_anchor, alat, alon);
+  const bool ok = run_synthetic();
+  benchmark();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,265 @@
+// Host tool: τρέχει το φίλτρο ρεύματος του μοτέρ (include/current_monitor.h)
+// πάνω σε καταγεγραμμένα ή συνθετικά traces και μετράει το throughput του.
+//
+//   g++ -std=gnu++11 -O2 -Iinclude tools/current_bench.cpp -o current_bench
+//   ./current_bench                       # συνθετικά σενάρια + benchmark
+//   ./current_bench --trace run.csv [--zero 2048] [--ma-per-count 100]
+//                   [--stall 120] [--overload 180]
+//
+// Trace: ένα δείγμα ανά γραμμή στα kSampleHz, raw ADC counts (αν η γραμμή
+// έχει πολλά πεδία χωρισμένα με κόμμα, μετράει το τελευταίο). Το run
+// ξεκινάει στο πρώτο δείγμα, όπως όταν κλείνει το ρελέ.
+//
+// Τα συνθετικά σενάρια έχουν αναμενόμενο αποτέλεσμα: κανονική και βαριά
+// κίνηση χωρίς trip, stall, locked rotor και βραχυκύκλωμα με trip μέσα σε
+// όριο χρόνου. Τα traces χωρίς παλμό αλυσίδας είναι κινήσεις όπου ο
+// αισθητήρας δεν έχει δει ακόμα παλμό μέσα στο blanking.
+// Exit code 1 αν κάποιο αποτυγχάνει.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "current_monitor.h"
+
+namespace {
+
+typedef std::vector<uint16_t> Trace;
+
+struct Params {
+  int   zero = 2048;
+  float ma_per_count = 100.0f;
+  float stall_a = 120.0f;
+  float overload_a = 180.0f;
+};
+
+double now_s() {
+  using namespace std::chrono;
+  return duration_cast<duration<double>>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Ρεύμα σε A ανά δείγμα, με ripple του μοτέρ και θόρυβο του ADC
+class TraceGen {
+ public:
+  explicit TraceGen(const Params& p) : p_(p) {}
+
+  uint16_t sample(float amps, uint32_t i) {
+    const float ripple = 4.0f * sinf((float)i * 0.9f);
+    const float noise = ((float)(next_() % 2001) - 1000.0f) / 1000.0f * 3.0f;
+    float counts = (float)p_.zero + (amps + ripple + noise) * 1000.0f / p_.ma_per_count;
+    if (counts < 0.0f) counts = 0.0f;
+    if (counts > 4095.0f) counts = 4095.0f;
+    return (uint16_t)(counts + 0.5f);
+  }
+
+ private:
+  uint32_t next_() {
+    rng_ ^= rng_ << 13;
+    rng_ ^= rng_ >> 17;
+    rng_ ^= rng_ << 5;
+    return rng_;
+  }
+
+  Params   p_;
+  uint32_t rng_ = 0x12345678u;
+};
+
+// Εκκίνηση: inrush που σβήνει εκθετικά προς το ρεύμα φορτίου
+float inrush(float peak_a, float load_a, uint32_t i) {
+  return load_a + (peak_a - load_a) * expf(-(float)i / 60.0f);
+}
+
+struct Scenario {
+  const char* name;
+  CurrentMonitor::Trip expect;
+  uint32_t event_ms;   // πότε ξεκινάει το σφάλμα (για το latency)
+  uint32_t max_latency_ms;
+  Trace    trace;
+  bool     pulse;      // παλμός αλυσίδας στο pulse_ms (το μοτέρ γύρισε)
+  uint32_t pulse_ms;
+};
+
+std::vector<Scenario> synthetic(const Params& p) {
+  const uint32_t hz = CurrentMonitor::kSampleHz;
+  std::vector<Scenario> out;
+  TraceGen gen(p);
+
+  {  // Κανονικό κατέβασμα/ανέβασμα: inrush 150A → 60A, 20s
+    Scenario s = {"normal run", CurrentMonitor::kNone, 0, 0, Trace(), false, 0};
+    for (uint32_t i = 0; i < 20 * hz; i++) s.trace.push_back(gen.sample(inrush(150, 60, i), i));
+    out.push_back(s);
+  }
+  {  // Βαριά ανάκτηση (άγκυρα στον βυθό): 100A με διακυμάνσεις, 30s
+    Scenario s = {"heavy load", CurrentMonitor::kNone, 0, 0, Trace(), false, 0};
+    for (uint32_t i = 0; i < 30 * hz; i++) {
+      const float swell = 10.0f * sinf((float)i * 2.0f * (float)M_PI / 1500.0f);
+      s.trace.push_back(gen.sample(inrush(170, 100, i) + swell, i));
+    }
+    out.push_back(s);
+  }
+  {  // Μπλόκαρε το gypsy στα 4s: 60A → 150A σε 20ms
+    Scenario s = {"jam mid-run", CurrentMonitor::kStall, 4000, 80, Trace(), false, 0};
+    for (uint32_t i = 0; i < 6 * hz; i++) {
+      float a = inrush(150, 60, i);
+      if (i >= 4000) a = i < 4020 ? 60.0f + 90.0f * (float)(i - 4000) / 20.0f : 150.0f;
+      s.trace.push_back(gen.sample(a, i));
+    }
+    out.push_back(s);
+  }
+  {  // Άγκυρα σφηνωμένη στο ρολό: το μοτέρ δεν γυρίζει ποτέ, μένει στο ρεύμα
+     // εκκίνησης (χωρίς back-EMF), λίγο κάτω καθώς ζεσταίνεται το τύλιγμα.
+     // Locked rotor μέσα στο inrush blanking, κανένας παλμός.
+    Scenario s = {"jam at start", CurrentMonitor::kStall, 0, 100, Trace(), false, 0};
+    for (uint32_t i = 0; i < 2 * hz; i++) s.trace.push_back(gen.sample(inrush(175, 165, i), i));
+    out.push_back(s);
+  }
+  {  // Μπλόκαρε στο ρολό, αλλά ένα κομμάτι αλυσίδας πέρασε στην αρχή (παλμός):
+     // μόνο το κανονικό stall, μετά το blanking
+    Scenario s = {"jam past pulse", CurrentMonitor::kStall, 0, 400, Trace(), true, 20};
+    for (uint32_t i = 0; i < 2 * hz; i++) s.trace.push_back(gen.sample(inrush(175, 165, i), i));
+    out.push_back(s);
+  }
+  {  // Βραχυκύκλωμα στα 2s: ο αισθητήρας στο τέρμα της κλίμακας
+    Scenario s = {"short", CurrentMonitor::kOverload, 2000, 10, Trace(), false, 0};
+    for (uint32_t i = 0; i < 3 * hz; i++) {
+      s.trace.push_back(i < 2000 ? gen.sample(inrush(150, 60, i), i) : (uint16_t)4095);
+    }
+    out.push_back(s);
+  }
+  return out;
+}
+
+CurrentConfig config_of(const Params& p) {
+  return CurrentMonitor::makeConfig(p.zero, p.ma_per_count, p.stall_a, p.overload_a);
+}
+
+// Ένα run από την αρχή του trace. Επιστρέφει το δείγμα του trip ή -1.
+// pulse_at: δείγμα του πρώτου παλμού αλυσίδας, -1 = κανένας.
+long run(const Params& p, const Trace& t, CurrentMonitor::Trip& trip, CurrentMonitor& m,
+         long pulse_at = -1) {
+  m.configure(config_of(p));
+  m.start_run();
+  trip = CurrentMonitor::kNone;
+  for (size_t i = 0; i < t.size(); i++) {
+    if ((long)i == pulse_at) m.note_rotation();
+    trip = m.feed(t[i]);
+    if (trip != CurrentMonitor::kNone) return (long)i;
+  }
+  return -1;
+}
+
+const char* trip_name(CurrentMonitor::Trip t) {
+  return t == CurrentMonitor::kNone ? "none" : CurrentMonitor::tripReason(t);
+}
+
+bool run_synthetic(const Params& p) {
+  const double ms_per_sample = 1000.0 / CurrentMonitor::kSampleHz;
+  bool ok = true;
+  for (const Scenario& s : synthetic(p)) {
+    CurrentMonitor m;
+    CurrentMonitor::Trip trip;
+    const long pulse_at = s.pulse ? (long)(s.pulse_ms * CurrentMonitor::kSampleHz / 1000) : -1;
+    const long at = run(p, s.trace, trip, m, pulse_at);
+    bool pass = trip == s.expect;
+    printf("%-14s %-16s", s.name, trip_name(trip));
+    if (at >= 0) {
+      const double latency = (at + 1) * ms_per_sample - s.event_ms;
+      printf(" at %6.0fms  latency %4.0fms", (at + 1) * ms_per_sample, latency);
+      if (latency > s.max_latency_ms) pass = false;
+    } else {
+      printf(" %29s", "");
+    }
+    printf("  peak %5.1fA  %s\n", m.peak_ma() / 1000.0, pass ? "ok" : "FAIL");
+    ok &= pass;
+  }
+  return ok;
+}
+
+// Throughput του feed() σε δείγματα/s, με όλα τα σενάρια στη σειρά και
+// χωρίς trip (τα όρια ανεβαίνουν), ώστε να μετράει το ίδιο το φίλτρο
+void benchmark(const Params& p) {
+  Trace all;
+  for (const Scenario& s : synthetic(p)) all.insert(all.end(), s.trace.begin(), s.trace.end());
+  Params no_trip = p;
+  no_trip.stall_a = 1e6f;
+  no_trip.overload_a = 1e6f;
+  CurrentMonitor m;
+  m.configure(config_of(no_trip));
+  m.start_run();
+  const size_t kSamples = 50u * 1000u * 1000u;
+  volatile uint32_t sink = 0;
+  const double t0 = now_s();
+  for (size_t n = 0; n < kSamples;) {
+    for (size_t i = 0; i < all.size() && n < kSamples; i++, n++) sink += m.feed(all[i]);
+  }
+  const double secs = now_s() - t0;
+  printf("throughput: %.1f Msamples/s (%.1f ns/sample, %u samples/s per channel on target)\n",
+         kSamples / secs / 1e6, secs / kSamples * 1e9, (unsigned)CurrentMonitor::kSampleHz);
+}
+
+bool read_trace(const char* path, Trace& out) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  char line[256];
+  while (fgets(line, sizeof(line), f)) {
+    const char* v = strrchr(line, ',');
+    v = v ? v + 1 : line;
+    char* end;
+    const long raw = strtol(v, &end, 10);
+    if (end == v) continue;  // header ή κενή γραμμή
+    out.push_back((uint16_t)(raw < 0 ? 0 : raw > 4095 ? 4095 : raw));
+  }
+  fclose(f);
+  return true;
+}
+
+int replay(const Params& p, const char* path) {
+  Trace t;
+  if (!read_trace(path, t) || t.empty()) {
+    fprintf(stderr, "cannot read trace %s\n", path);
+    return 1;
+  }
+  CurrentMonitor m;
+  CurrentMonitor::Trip trip;
+  const long at = run(p, t, trip, m);
+  printf("%s: %zu samples (%.1fs), trip %s", path, t.size(),
+         (double)t.size() / CurrentMonitor::kSampleHz, trip_name(trip));
+  if (at >= 0) printf(" at %ldms", (at + 1) * 1000L / (long)CurrentMonitor::kSampleHz);
+  printf(", rms %.1fA, peak %.1fA\n", m.rms_ma() / 1000.0, m.peak_ma() / 1000.0);
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Params p;
+  const char* trace = nullptr;
+  for (int i = 1; i < argc; i++) {
+    const bool has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--trace") && has_value) {
+      trace = argv[++i];
+    } else if (!strcmp(argv[i], "--zero") && has_value) {
+      p.zero = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--ma-per-count") && has_value) {
+      p.ma_per_count = (float)atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--stall") && has_value) {
+      p.stall_a = (float)atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--overload") && has_value) {
+      p.overload_a = (float)atof(argv[++i]);
+    } else {
+      fprintf(stderr,
+              "usage: %s [--trace file.csv] [--zero counts] [--ma-per-count mA]\n"
+              "          [--stall A] [--overload A]\n",
+              argv[0]);
+      return 2;
+    }
+  }
+  if (trace) return replay(p, trace);
+  const bool ok = run_synthetic(p);
+  benchmark(p);
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,269 @@
+// Host tool: το SkDeltaEncoder (include/sk_delta_encoder.h) απέναντι στο
+// παλιό JsonDocument + String ανά αποστολή, για τα τέσσερα frames των
+// senders: bytes, δεσμεύσεις heap και ns ανά frame.
+//
+//   pio pkg install -e esp32dev      # φέρνει το ArduinoJson στο .pio/libdeps
+//   g++ -std=gnu++11 -O2 -Iinclude -I.pio/libdeps/esp32dev/ArduinoJson/src
+//       tools/encoder_bench.cpp -o encoder_bench
+//   ./encoder_bench [--frames 200000]
+//
+// Το ArduinoJson path είναι αντίγραφο του κώδικα πριν το encoder, με
+// std::string στη θέση του Arduino String (μεγαλώνει κι αυτό με realloc
+// καθώς γράφει το serializeJson) και gmtime/strftime για το timestamp.
+// Οι δεσμεύσεις μετράνε κάθε operator new και κάθε malloc του
+// JsonDocument (μέσω counting Allocator). Η ώρα προχωράει ένα δευτερόλεπτο
+// ανά 10 frames. Χωρίς ArduinoJson στο include path τρέχει μόνο το encoder.
+// Exit code 1 αν το encoder δεσμεύει μνήμη ανά frame ή δεν χωράει.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <chrono>
+#include <new>
+#include <string>
+
+#include "sk_delta_encoder.h"
+
+#if defined(__has_include)
+#if __has_include(<ArduinoJson.h>)
+#include <ArduinoJson.h>
+#define HAVE_ARDUINOJSON 1
+#endif
+#endif
+
+namespace {
+
+uint64_t g_allocs = 0;
+uint64_t g_alloc_bytes = 0;
+
+}  // namespace
+
+void* operator new(size_t n) {
+  g_allocs++;
+  g_alloc_bytes += n;
+  if (void* p = malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+namespace {
+
+double now_s() {
+  using namespace std::chrono;
+  return duration_cast<duration<double>>(steady_clock::now().time_since_epoch()).count();
+}
+
+// Οι τιμές που στέλνουν οι senders
+struct Values {
+  float   chain_out = 37.5f;
+  int32_t chain_pulses = 150;
+  bool    enabled = true;
+  const char* last_command = "down:run";
+};
+
+enum Frame { kChain, kBool, kString, kHeartbeat, kFrames };
+const char* const kNames[kFrames] = {"chain update", "delta bool", "delta string",
+                                     "heartbeat"};
+
+struct Result {
+  size_t bytes = 0;
+  double allocs = 0;
+  double alloc_bytes = 0;
+  double ns = 0;
+  bool   ok = true;
+};
+
+// ---------- Νέο path: ένα encoder, ένα reserved payload ----------
+class EncoderPath {
+ public:
+  EncoderPath() { payload_.reserve(tx_.capacity()); }
+
+  size_t send(Frame f, const Values& v, time_t now) {
+    switch (f) {
+      case kChain:
+        tx_.begin();
+        tx_.add(SK_ANCHOR_PATH("chainOut"), v.chain_out);
+        tx_.add(SK_ANCHOR_PATH("chainPulses"), v.chain_pulses);
+        break;
+      case kBool:
+        tx_.begin(false);
+        tx_.add(SK_ANCHOR_PATH("enabled"), v.enabled);
+        break;
+      case kString:
+        tx_.begin(false);
+        tx_.add(SK_ANCHOR_PATH("lastCommand"), v.last_command);
+        break;
+      default:
+        tx_.begin();
+        tx_.add(SK_ANCHOR_PATH("enabled"), v.enabled);
+        tx_.add(SK_ANCHOR_PATH("lastUpdate"), ts_.render(now));
+        tx_.add(SK_ANCHOR_PATH("chainOut"), v.chain_out);
+        break;
+    }
+    const char* frame = tx_.finish();
+    if (!frame) return 0;
+    payload_.assign(frame, tx_.length());  // όπως το tx_payload_ στο sendFrame_()
+    return payload_.size();
+  }
+  const std::string& payload() const { return payload_; }
+
+ private:
+  SkDeltaEncoder<512> tx_;
+  SkTimestampCache    ts_;
+  std::string         payload_;
+};
+
+#ifdef HAVE_ARDUINOJSON
+// Forwards στο malloc όπως ο DefaultAllocator, μετρώντας.
+class CountingAllocator : public ArduinoJson::Allocator {
+ public:
+  void* allocate(size_t n) override {
+    g_allocs++;
+    g_alloc_bytes += n;
+    return malloc(n);
+  }
+  void deallocate(void* p) override { free(p); }
+  void* reallocate(void* p, size_t n) override {
+    g_allocs++;
+    g_alloc_bytes += n;
+    return realloc(p, n);
+  }
+};
+
+// ---------- Παλιό path: JsonDocument + String ανά αποστολή ----------
+class ArduinoJsonPath {
+ public:
+  size_t send(Frame f, const Values& v, time_t now) {
+    JsonDocument doc(&alloc_);
+    JsonObject root = doc.to<JsonObject>();
+    root["context"] = "vessels.self";
+    JsonArray updates = root["updates"].to<JsonArray>();
+    JsonObject upd = updates.add<JsonObject>();
+    if (f == kChain || f == kHeartbeat) {
+      JsonObject src = upd["source"].to<JsonObject>();
+      src["label"] = "signalk-anchoralarm-akat";
+    }
+    JsonArray values = upd["values"].to<JsonArray>();
+    switch (f) {
+      case kChain: {
+        JsonObject v1 = values.add<JsonObject>();
+        v1["path"] = "sensors.akat.anchor.chainOut";
+        v1["value"] = v.chain_out;
+        JsonObject v2 = values.add<JsonObject>();
+        v2["path"] = "sensors.akat.anchor.chainPulses";
+        v2["value"] = v.chain_pulses;
+        break;
+      }
+      case kBool: {
+        JsonObject e = values.add<JsonObject>();
+        e["path"] = "sensors.akat.anchor.enabled";
+        e["value"] = v.enabled;
+        break;
+      }
+      case kString: {
+        JsonObject e = values.add<JsonObject>();
+        e["path"] = "sensors.akat.anchor.lastCommand";
+        e["value"] = std::string(v.last_command);
+        break;
+      }
+      default: {
+        JsonObject v1 = values.add<JsonObject>();
+        v1["path"] = "sensors.akat.anchor.enabled";
+        v1["value"] = v.enabled;
+        JsonObject v2 = values.add<JsonObject>();
+        v2["path"] = "sensors.akat.anchor.lastUpdate";
+        v2["value"] = isoTimestamp_(now);
+        JsonObject v3 = values.add<JsonObject>();
+        v3["path"] = "sensors.akat.anchor.chainOut";
+        v3["value"] = v.chain_out;
+        break;
+      }
+    }
+    std::string payload;
+    serializeJson(doc, payload);
+    last_ = payload.size();
+    return last_;
+  }
+
+ private:
+  // Το isoTimestamp() πριν το SkTimestampCache
+  static std::string isoTimestamp_(time_t now) {
+    struct tm* tm_info = gmtime(&now);
+    char buf[30];
+    strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", tm_info);
+    return std::string(buf);
+  }
+
+  CountingAllocator alloc_;
+  size_t last_ = 0;
+};
+#endif
+
+template <typename Path>
+Result measure(Path& path, Frame f, uint32_t frames) {
+  Values v;
+  const time_t t0 = 1767225600;  // 2026-01-01
+  Result r;
+  r.bytes = path.send(f, v, t0);  // ζέσταμα: το encoder δεσμεύει μόνο εδώ
+  const uint64_t a0 = g_allocs, b0 = g_alloc_bytes;
+  size_t sink = 0;
+  const double s0 = now_s();
+  for (uint32_t i = 0; i < frames; i++) {
+    v.chain_pulses = (int32_t)(150 + i % 7);
+    v.chain_out = v.chain_pulses * 0.25f;
+    const size_t n = path.send(f, v, t0 + i / 10);
+    if (n == 0) r.ok = false;
+    sink += n;
+  }
+  const double secs = now_s() - s0;
+  r.allocs = (double)(g_allocs - a0) / frames;
+  r.alloc_bytes = (double)(g_alloc_bytes - b0) / frames;
+  r.ns = secs / frames * 1e9;
+  if (sink == 0) r.ok = false;
+  return r;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  uint32_t frames = 200000;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--frames") && i + 1 < argc) {
+      frames = (uint32_t)strtoul(argv[++i], nullptr, 10);
+    } else {
+      fprintf(stderr, "usage: %s [--frames 200000]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (frames == 0) frames = 1;
+
+  bool ok = true;
+  EncoderPath enc;
+#ifdef HAVE_ARDUINOJSON
+  ArduinoJsonPath aj;
+  printf("%-13s %15s %23s %21s %17s\n", "frame", "bytes aj/enc", "allocs/frame aj/enc",
+         "heap B/frame aj/enc", "ns/frame aj/enc");
+#else
+  printf("ArduinoJson.h not on the include path: encoder only "
+         "(-I.pio/libdeps/esp32dev/ArduinoJson/src)\n");
+  printf("%-13s %6s %13s %13s %9s\n", "frame", "bytes", "allocs/frame", "heap B/frame",
+         "ns/frame");
+#endif
+  for (int f = 0; f < kFrames; f++) {
+    const Result e = measure(enc, (Frame)f, frames);
+#ifdef HAVE_ARDUINOJSON
+    const Result a = measure(aj, (Frame)f, frames);
+    printf("%-13s %7zu / %-5zu %13.2f / %-7.2f %11.0f / %-7.0f %8.0f / %-6.0f\n", kNames[f],
+           a.bytes, e.bytes, a.allocs, e.allocs, a.alloc_bytes, e.alloc_bytes, a.ns, e.ns);
+#else
+    printf("%-13s %6zu %13.2f %13.0f %9.0f\n", kNames[f], e.bytes, e.allocs, e.alloc_bytes,
+           e.ns);
+#endif
+    if (!e.ok || e.allocs != 0.0) ok = false;
+  }
+  printf("heartbeat: %s\n", enc.payload().c_str());
+  return ok ? 0 : 1;
+}
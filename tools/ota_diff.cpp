@@ -0,0 +1,380 @@
+// Host tool: φτιάχνει ένα delta OTA patch (include/ota_patch.h) ανάμεσα σε
+// δύο firmware images και το ελέγχει με τον ίδιο DeltaPatcher που τρέχει
+// στο ESP32, σε chunks τυχαίου μεγέθους όπως από το WiFi.
+//
+//   g++ -std=gnu++11 -O2 -Iinclude tools/ota_diff.cpp -o ota_diff
+//   ./ota_diff old.bin new.bin update.aop   # patch + έλεγχος + μέγεθος/throughput
+//   ./ota_diff --apply old.bin update.aop out.bin
+//   ./ota_diff --selftest                   # συνθετικά images, χωρίς αρχεία
+//
+// Τα images είναι τα .pio/build/esp32dev/firmware.bin της τρέχουσας και της
+// νέας έκδοσης. Το patch ανεβαίνει με
+//   curl --data-binary @update.aop http://sensesp-anchor.local/api/anchor/ota
+//
+// Generator: hash των 8 bytes κάθε θέσης του παλιού image. Κάθε byte του
+// νέου κωδικοποιείται ως διαφορά πάνω στην τρέχουσα ευθυγράμμιση (old = new
+// + offset). Σε κάθε ασυμφωνία δοκιμάζεται η ευθυγράμμιση που δίνει το
+// hash, και αλλάζει αν ταιριάζει καλύτερα στα επόμενα kProbe bytes. Ό,τι
+// πέφτει έξω από το παλιό image γίνεται extra.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <vector>
+
+#include "ota_patch.h"
+
+namespace {
+
+typedef std::vector<uint8_t> Bytes;
+
+bool read_file(const char* path, Bytes& out) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+bool write_file(const char* path, const Bytes& data) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  const bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+  return fclose(f) == 0 && ok;
+}
+
+double now_s() {
+  using namespace std::chrono;
+  return duration_cast<duration<double>>(steady_clock::now().time_since_epoch()).count();
+}
+
+void put_varint(Bytes& out, uint32_t v) {
+  while (v >= 0x80) {
+    out.push_back((uint8_t)(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back((uint8_t)v);
+}
+
+// ---- Generator ----
+class PatchBuilder {
+ public:
+  static constexpr size_t   kHashBytes = 8;
+  static constexpr int      kHashBits = 22;
+  static constexpr size_t   kProbe = 32;      // bytes για τη σύγκριση ευθυγραμμίσεων
+  static constexpr size_t   kMinGain = 8;     // ένα control κοστίζει ~3-6 bytes
+  static constexpr size_t   kMinZeroRun = 3;  // μικρότερα κενά μένουν μέσα στα lits
+
+  PatchBuilder(const Bytes& old_img, const Bytes& new_img) : old_(old_img), new_(new_img) {
+    table_.assign((size_t)1 << kHashBits, -1);
+    for (size_t i = 0; i + kHashBytes <= old_.size(); i++) table_[hash_(&old_[i])] = (int32_t)i;
+  }
+
+  Bytes build() {
+    Bytes patch(ota_patch::kHeaderBytes);
+    memcpy(patch.data(), ota_patch::kMagic, 4);
+    ota_patch::put_u32(&patch[4], (uint32_t)old_.size());
+    ota_patch::put_u32(&patch[8], ota_patch::crc32(0, old_.data(), old_.size()));
+    ota_patch::put_u32(&patch[12], (uint32_t)new_.size());
+    ota_patch::put_u32(&patch[16], ota_patch::crc32(0, new_.data(), new_.size()));
+
+    int64_t offset = 0;          // old = new + offset
+    size_t block_start = 0;      // αρχή του diff block στο νέο image
+    int64_t block_offset = 0;
+    int64_t old_pos = 0;         // θέση του applier στο παλιό image
+    size_t i = 0;
+    while (i < new_.size()) {
+      const bool in_old = in_old_(i, offset);
+      if (in_old && old_[i + offset] == new_[i]) {
+        i++;
+        continue;
+      }
+      int64_t better;
+      if (find_better_(i, offset, better)) {
+        emit_(patch, block_start, i, block_offset, old_pos, better);
+        offset = better;
+        block_start = i;
+        block_offset = offset;
+        continue;
+      }
+      if (!in_old) {
+        // Έξω από το παλιό image: το diff block κλείνει, τα bytes γίνονται extra
+        size_t j = i + 1;
+        while (j < new_.size() && !in_old_(j, offset) && !match_at_(j)) j++;
+        emit_(patch, block_start, i, block_offset, old_pos, offset, j - i);
+        i = j;
+        block_start = i;
+        block_offset = offset;
+        continue;
+      }
+      i++;
+    }
+    emit_(patch, block_start, i, block_offset, old_pos, offset);
+    return patch;
+  }
+
+  uint32_t controls() const { return controls_; }
+  uint32_t zero_bytes() const { return zero_bytes_; }
+  uint32_t lit_bytes() const { return lit_bytes_; }
+  uint32_t extra_bytes() const { return extra_bytes_; }
+
+ private:
+  static uint32_t hash_(const uint8_t* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return (uint32_t)((v * 0x9E3779B97F4A7C15ULL) >> (64 - kHashBits));
+  }
+
+  bool in_old_(size_t i, int64_t offset) const {
+    const int64_t o = (int64_t)i + offset;
+    return o >= 0 && o < (int64_t)old_.size();
+  }
+
+  size_t matches_(size_t i, int64_t offset, size_t n) const {
+    size_t m = 0;
+    for (size_t k = 0; k < n && i + k < new_.size(); k++) {
+      if (in_old_(i + k, offset) && old_[i + k + offset] == new_[i + k]) m++;
+    }
+    return m;
+  }
+
+  bool match_at_(size_t i) const {
+    if (i + kHashBytes > new_.size()) return false;
+    const int32_t c = table_[hash_(&new_[i])];
+    return c >= 0 && memcmp(&old_[c], &new_[i], kHashBytes) == 0;
+  }
+
+  // Μια ευθυγράμμιση από το hash που ταιριάζει καλύτερα στα επόμενα bytes
+  bool find_better_(size_t i, int64_t offset, int64_t& better) const {
+    if (i + kHashBytes > new_.size()) return false;
+    const int32_t c = table_[hash_(&new_[i])];
+    if (c < 0 || memcmp(&old_[c], &new_[i], kHashBytes) != 0) return false;
+    const int64_t cand = (int64_t)c - (int64_t)i;
+    if (cand == offset) return false;
+    if (matches_(i, cand, kProbe) < matches_(i, offset, kProbe) + kMinGain) return false;
+    better = cand;
+    return true;
+  }
+
+  // Control για το diff block [start, end) με offset, extra bytes μετά και
+  // seek ώστε ο applier να βρεθεί στην επόμενη ευθυγράμμιση.
+  void emit_(Bytes& patch, size_t start, size_t end, int64_t offset, int64_t& old_pos,
+             int64_t next_offset, size_t extra = 0) {
+    if (start == end && !extra) return;  // το seek γίνεται με το επόμενο block
+    // Ο applier είναι στο old_pos· το diff block θέλει να ξεκινά στο start + offset
+    if (start != end && old_pos != (int64_t)start + offset) {
+      // Μόνο seek (κενό control) για να φτάσει εκεί
+      put_control_(patch, 0, 0, (int64_t)start + offset - old_pos);
+      old_pos = (int64_t)start + offset;
+    }
+    const size_t diff_len = end - start;
+    const int64_t after_diff = old_pos + (int64_t)diff_len;
+    const size_t next = end + extra;
+    int64_t target = (int64_t)next + next_offset;
+    if (target < 0) target = 0;
+    if (target > (int64_t)old_.size()) target = (int64_t)old_.size();
+    put_control_(patch, (uint32_t)diff_len, (uint32_t)extra, target - after_diff);
+    put_diff_(patch, start, end, offset);
+    patch.insert(patch.end(), new_.begin() + end, new_.begin() + next);
+    extra_bytes_ += (uint32_t)extra;
+    old_pos = target;
+  }
+
+  void put_control_(Bytes& patch, uint32_t diff_len, uint32_t extra, int64_t seek) {
+    put_varint(patch, diff_len);
+    put_varint(patch, extra);
+    put_varint(patch, ota_patch::zigzag((int32_t)seek));
+    controls_++;
+  }
+
+  // tokens: zeros, lits, lits bytes
+  void put_diff_(Bytes& patch, size_t start, size_t end, int64_t offset) {
+    size_t i = start;
+    while (i < end) {
+      size_t zeros = 0;
+      while (i + zeros < end && diff_(i + zeros, offset) == 0) zeros++;
+      size_t j = i + zeros;
+      size_t lits = 0;
+      while (j + lits < end) {
+        if (diff_(j + lits, offset) == 0) {
+          size_t run = 0;
+          while (j + lits + run < end && diff_(j + lits + run, offset) == 0) run++;
+          if (run >= kMinZeroRun || j + lits + run == end) break;
+          lits += run;
+        } else {
+          lits++;
+        }
+      }
+      put_varint(patch, (uint32_t)zeros);
+      put_varint(patch, (uint32_t)lits);
+      for (size_t k = 0; k < lits; k++) patch.push_back(diff_(j + k, offset));
+      zero_bytes_ += (uint32_t)zeros;
+      lit_bytes_ += (uint32_t)lits;
+      i = j + lits;
+    }
+  }
+
+  uint8_t diff_(size_t i, int64_t offset) const {
+    return (uint8_t)(new_[i] - old_[i + offset]);
+  }
+
+  const Bytes& old_;
+  const Bytes& new_;
+  std::vector<int32_t> table_;
+  uint32_t controls_ = 0;
+  uint32_t zero_bytes_ = 0;
+  uint32_t lit_bytes_ = 0;
+  uint32_t extra_bytes_ = 0;
+};
+
+// ---- Applier backends (RAM) ----
+class MemSource : public OtaSource {
+ public:
+  explicit MemSource(const Bytes& b) : b_(b) {}
+  bool read(uint32_t offset, void* dst, size_t len) override {
+    if ((uint64_t)offset + len > b_.size()) return false;
+    memcpy(dst, b_.data() + offset, len);
+    return true;
+  }
+
+ private:
+  const Bytes& b_;
+};
+
+class MemSink : public OtaSink {
+ public:
+  bool write(const void* src, size_t len) override {
+    const uint8_t* p = static_cast<const uint8_t*>(src);
+    out.insert(out.end(), p, p + len);
+    return true;
+  }
+  Bytes out;
+};
+
+// Εφαρμόζει το patch σε chunks 1..max_chunk bytes (TCP segments)
+DeltaPatcher::Status apply(const Bytes& old_img, const Bytes& patch, Bytes& out,
+                           size_t max_chunk, double& secs) {
+  static DeltaPatcher patcher;  // ~4.5KB, όπως στο firmware
+  MemSource src(old_img);
+  MemSink sink;
+  const double t0 = now_s();
+  patcher.begin(&src, (uint32_t)old_img.size(), &sink);
+  DeltaPatcher::Status st = DeltaPatcher::kRunning;
+  size_t pos = 0;
+  while (pos < patch.size() && st == DeltaPatcher::kRunning) {
+    size_t n = max_chunk > 1 ? 1 + (size_t)rand() % max_chunk : 1;
+    if (n > patch.size() - pos) n = patch.size() - pos;
+    st = patcher.feed(patch.data() + pos, n);
+    pos += n;
+  }
+  secs = now_s() - t0;
+  out.swap(sink.out);
+  return st;
+}
+
+int diff_and_check(const Bytes& old_img, const Bytes& new_img, const char* out_path) {
+  const double t0 = now_s();
+  PatchBuilder builder(old_img, new_img);
+  const Bytes patch = builder.build();
+  const double gen_s = now_s() - t0;
+  printf("old %zu bytes, new %zu bytes -> patch %zu bytes (%.1f%% of new), %.2fs\n",
+         old_img.size(), new_img.size(), patch.size(), 100.0 * patch.size() / new_img.size(),
+         gen_s);
+  printf("  %u controls, %u unchanged, %u changed, %u new bytes\n", builder.controls(),
+         builder.zero_bytes(), builder.lit_bytes(), builder.extra_bytes());
+
+  Bytes out;
+  double apply_s = 0.0;
+  const DeltaPatcher::Status st = apply(old_img, patch, out, 1460, apply_s);
+  const bool same = st == DeltaPatcher::kDone && out == new_img;
+  printf("apply: %s, %s, %.1f MB/s output (%.3fs)\n", DeltaPatcher::statusName(st),
+         same ? "identical" : "MISMATCH", new_img.size() / apply_s / 1e6, apply_s);
+  if (out_path && !write_file(out_path, patch)) {
+    fprintf(stderr, "cannot write %s\n", out_path);
+    return 1;
+  }
+  return same ? 0 : 1;
+}
+
+// Συνθετικό "firmware": κώδικας με 32-bit διευθύνσεις, ένα μπλοκ που
+// μετακινείται, εισαγωγές και αλλαγμένες σταθερές.
+int selftest() {
+  srand(1);
+  Bytes old_img(1200 * 1024);
+  for (size_t i = 0; i < old_img.size(); i++) {
+    old_img[i] = (uint8_t)(i % 4 == 3 ? 0x40 : rand() % 256);
+  }
+  Bytes new_img(old_img.begin(), old_img.begin() + 300000);
+  Bytes added(2345);
+  for (auto& b : added) b = (uint8_t)(rand() % 256);
+  new_img.insert(new_img.end(), added.begin(), added.end());
+  new_img.insert(new_img.end(), old_img.begin() + 300000, old_img.end());
+  // Ό,τι ακολουθεί την εισαγωγή έχει διευθύνσεις που άλλαξαν (κάθε 64 bytes)
+  for (size_t i = 300000 + added.size(); i + 4 <= new_img.size(); i += 64) new_img[i] += 0x24;
+  for (int k = 0; k < 200; k++) new_img[(size_t)rand() % new_img.size()] ^= 0x5A;
+
+  int fails = 0;
+  printf("selftest: synthetic images\n");
+  fails += diff_and_check(old_img, new_img, nullptr);
+  printf("selftest: identical images\n");
+  fails += diff_and_check(old_img, old_img, nullptr);
+  printf("selftest: unrelated images\n");
+  Bytes other(500 * 1024);
+  for (auto& b : other) b = (uint8_t)(rand() % 256);
+  fails += diff_and_check(old_img, other, nullptr);
+
+  // Λάθος source και κομμένο patch πρέπει να απορρίπτονται
+  PatchBuilder builder(old_img, new_img);
+  Bytes patch = builder.build();
+  Bytes out;
+  double secs;
+  Bytes wrong = old_img;
+  wrong[1000] ^= 1;
+  const DeltaPatcher::Status ws = apply(wrong, patch, out, 1460, secs);
+  printf("selftest: wrong source -> %s\n", DeltaPatcher::statusName(ws));
+  fails += ws != DeltaPatcher::kWrongSource;
+  patch.resize(patch.size() / 2);
+  const DeltaPatcher::Status ts = apply(old_img, patch, out, 1460, secs);
+  printf("selftest: truncated patch -> %s\n", DeltaPatcher::statusName(ts));
+  fails += ts != DeltaPatcher::kRunning;
+  printf("selftest: %s\n", fails ? "FAILED" : "ok");
+  return fails ? 1 : 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc == 2 && !strcmp(argv[1], "--selftest")) return selftest();
+  if (argc == 5 && !strcmp(argv[1], "--apply")) {
+    Bytes old_img, patch, out;
+    if (!read_file(argv[2], old_img) || !read_file(argv[3], patch)) {
+      fprintf(stderr, "cannot read input\n");
+      return 1;
+    }
+    double secs;
+    const DeltaPatcher::Status st = apply(old_img, patch, out, 1460, secs);
+    printf("apply: %s, %zu bytes, %.1f MB/s\n", DeltaPatcher::statusName(st), out.size(),
+           out.size() / secs / 1e6);
+    if (st != DeltaPatcher::kDone || !write_file(argv[4], out)) return 1;
+    return 0;
+  }
+  if (argc < 3) {
+    fprintf(stderr,
+            "usage: %s old.bin new.bin [patch.aop]\n"
+            "       %s --apply old.bin patch.aop out.bin\n"
+            "       %s --selftest\n",
+            argv[0], argv[0], argv[0]);
+    return 2;
+  }
+  Bytes old_img, new_img;
+  if (!read_file(argv[1], old_img) || !read_file(argv[2], new_img)) {
+    fprintf(stderr, "cannot read input\n");
+    return 1;
+  }
+  return diff_and_check(old_img, new_img, argc > 3 ? argv[3] : nullptr);
+}
@@ -0,0 +1,205 @@
+// Host tool: μέγιστος ρυθμός παλμών και σφάλμα μέτρησης των pulse filters
+// (include/chain_pulse_filter.h) πάνω σε συνθετικά ή καταγεγραμμένα edges.
+//
+//   g++ -std=gnu++11 -O2 -Iinclude tools/pulse_bench.cpp -o pulse_bench
+//   ./pulse_bench                         # sweep ρυθμού × bounce profile
+//   ./pulse_bench --edges run.csv [--links N] [--poll-ms 2]
+//
+// Sweep: για κάθε ρυθμό η αλυσίδα ξεκινάει από 1 παλμό/s, επιταχύνει σε
+// 10 κρίκους και κρατάει τον ρυθμό για 300 κρίκους, με ±5% jitter στην
+// περίοδο και τον μαγνήτη κλειστό για το μισό κρίκο. Κάθε αλλαγή
+// στάθμης αναπηδά όπως ορίζει το profile. Τα edges περνάνε από το filter με
+// τη σειρά και poll() κάθε --poll-ms, όπως στο motor task. "Max rate" είναι
+// ο μεγαλύτερος ρυθμός χωρίς κανένα λάθος σε αυτόν και σε όλους τους
+// μικρότερους (150Hz είναι το πάνω όριο του sweep). Exit code 1 αν το
+// adaptive δεν φτάνει 10× το fixed.
+//
+// Edges CSV: μία γραμμή ανά edge "t_us,level" (όπως το ISR), και
+// --links ο πραγματικός αριθμός κρίκων για το σφάλμα.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "chain_pulse_filter.h"
+
+namespace {
+
+typedef std::vector<ChainEdge> Edges;
+
+struct Profile {
+  const char* name;
+  int      bounces;     // επιπλέον edges ανά αλλαγή στάθμης
+  uint32_t bounce_us;   // διάρκεια του bounce
+  uint32_t glitch_per_1000;  // σύντομα LOW μέσα στο HIGH (‰ ανά κρίκο)
+};
+
+const Profile kProfiles[] = {
+  {"clean", 0, 0, 0},
+  {"reed bounce", 4, 600, 0},
+  {"heavy bounce", 10, 2500, 0},
+  {"bounce+glitch", 6, 1500, 50},
+};
+
+class Rng {
+ public:
+  uint32_t next() {
+    s_ ^= s_ << 13;
+    s_ ^= s_ >> 17;
+    s_ ^= s_ << 5;
+    return s_;
+  }
+  // [-1, 1]
+  float unit() { return (float)(next() % 20001) / 10000.0f - 1.0f; }
+
+ private:
+  uint32_t s_ = 0x9E3779B9u;
+};
+
+void change(Edges& out, uint32_t t_us, uint8_t level, const Profile& p, Rng& rng) {
+  for (int b = 0; b < p.bounces; b++) {
+    const uint32_t dt = p.bounce_us * (uint32_t)b / (uint32_t)p.bounces;
+    out.push_back(ChainEdge{t_us + dt, (uint8_t)((b & 1) ? !level : level)});
+  }
+  const uint32_t settle = p.bounces ? p.bounce_us + rng.next() % 100 : 0;
+  out.push_back(ChainEdge{t_us + settle, level});
+}
+
+// Επιτάχυνση από 1Hz σε rate_hz και μετά σταθερός ρυθμός. Επιστρέφει τους κρίκους.
+uint32_t synth(Edges& out, float rate_hz, uint32_t hold_links, const Profile& p, Rng& rng) {
+  const uint32_t kRamp = 10;
+  uint32_t t = 100000, links = 0;
+  for (uint32_t i = 0; i < kRamp + hold_links; i++, links++) {
+    const float start = rate_hz < 1.0f ? rate_hz : 1.0f;
+    const float f = i < kRamp ? start * powf(rate_hz / start, (float)i / kRamp) : rate_hz;
+    uint32_t period = (uint32_t)(1e6f / f * (1.0f + 0.05f * rng.unit()));
+    change(out, t, 0, p, rng);
+    change(out, t + period / 2, 1, p, rng);
+    if (p.glitch_per_1000 && rng.next() % 1000 < p.glitch_per_1000) {
+      const uint32_t g = t + period * 3 / 4;
+      out.push_back(ChainEdge{g, 0});
+      out.push_back(ChainEdge{g + 300, 1});
+    }
+    t += period;
+  }
+  return links;
+}
+
+uint32_t run(PulseFilter& f, const Edges& edges, uint32_t poll_us) {
+  f.reset(true, 0);
+  uint32_t pulses = 0, pulse_us;
+  size_t i = 0;
+  const uint32_t end = edges.empty() ? 0 : edges.back().t_us + 2000000;
+  for (uint32_t now = poll_us; now <= end; now += poll_us) {
+    while (i < edges.size() && edges[i].t_us <= now) {
+      if (f.feed(edges[i++], pulse_us)) pulses++;
+    }
+    if (f.poll(now, pulse_us)) pulses++;
+  }
+  return pulses;
+}
+
+// Όπως το WindlassCore::setupChainSensor() με pulse_debounce_ms = 150
+void configure(FixedPulseFilter& fixed, AdaptivePulseFilter& adaptive) {
+  fixed.set_debounce_us(150000);
+  adaptive.set_limits(2000, 30000, 150000);
+}
+
+float max_rate(PulseFilter& f, const Profile& p, uint32_t poll_us, float& err_at_2x) {
+  static const float kRates[] = {1, 1.5f, 2, 3, 4, 5, 6, 8, 10, 12, 15, 20, 25, 30, 35, 40,
+                                 50, 60, 70, 80, 100, 120, 150};
+  float best = 0.0f;
+  bool ok = true;
+  err_at_2x = NAN;
+  for (size_t k = 0; k < sizeof(kRates) / sizeof(kRates[0]); k++) {
+    Rng rng;
+    Edges e;
+    const uint32_t links = synth(e, kRates[k], 300, p, rng);
+    const uint32_t got = run(f, e, poll_us);
+    const float err = 100.0f * ((float)got - (float)links) / (float)links;
+    if (ok && got == links) best = kRates[k];
+    else ok = false;
+    if (best > 0.0f && isnan(err_at_2x) && kRates[k] >= best * 2.0f) err_at_2x = err;
+  }
+  return best;
+}
+
+bool sweep(uint32_t poll_us) {
+  FixedPulseFilter fixed;
+  AdaptivePulseFilter adaptive;
+  configure(fixed, adaptive);
+  printf("%-14s %14s %14s %8s   (error at 2x the fixed max rate)\n", "profile",
+         "fixed max Hz", "adaptive max Hz", "ratio");
+  bool ok = true;
+  for (const Profile& p : kProfiles) {
+    float fe, ae;
+    const float fr = max_rate(fixed, p, poll_us, fe);
+    const float ar = max_rate(adaptive, p, poll_us, ae);
+    const float ratio = fr > 0.0f ? ar / fr : 0.0f;
+    // Σφάλμα του fixed στο 2× του ορίου του: πόσο χάνει μια γρήγορη αλυσίδα
+    printf("%-14s %14.1f %14.1f %7.1fx   fixed %+.0f%%\n", p.name, fr, ar, ratio, fe);
+    if (ratio < 10.0f) ok = false;
+  }
+  return ok;
+}
+
+bool read_edges(const char* path, Edges& out) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  char line[128];
+  while (fgets(line, sizeof(line), f)) {
+    char* end;
+    const unsigned long t = strtoul(line, &end, 10);
+    if (end == line || *end != ',') continue;  // header ή κενή γραμμή
+    out.push_back(ChainEdge{(uint32_t)t, (uint8_t)(atoi(end + 1) ? 1 : 0)});
+  }
+  fclose(f);
+  return true;
+}
+
+int replay(const char* path, long links, uint32_t poll_us) {
+  Edges e;
+  if (!read_edges(path, e) || e.empty()) {
+    fprintf(stderr, "cannot read edges %s\n", path);
+    return 1;
+  }
+  FixedPulseFilter fixed;
+  AdaptivePulseFilter adaptive;
+  configure(fixed, adaptive);
+  PulseFilter* filters[] = {&fixed, &adaptive};
+  printf("%s: %zu edges over %.1fs\n", path, e.size(), (e.back().t_us - e.front().t_us) / 1e6);
+  for (PulseFilter* f : filters) {
+    const uint32_t got = run(*f, e, poll_us);
+    printf("  %-9s %6u pulses, %u rejected", f->name(), (unsigned)got, (unsigned)f->rejected());
+    if (links > 0) printf(", error %+ld (%+.1f%%)", (long)got - links, 100.0 * ((long)got - links) / links);
+    printf("\n");
+  }
+  return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* edges = nullptr;
+  long links = 0;
+  uint32_t poll_us = 2000;
+  for (int i = 1; i < argc; i++) {
+    const bool has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--edges") && has_value) {
+      edges = argv[++i];
+    } else if (!strcmp(argv[i], "--links") && has_value) {
+      links = atol(argv[++i]);
+    } else if (!strcmp(argv[i], "--poll-ms") && has_value) {
+      poll_us = (uint32_t)(atof(argv[++i]) * 1000.0);
+    } else {
+      fprintf(stderr, "usage: %s [--edges file.csv [--links N]] [--poll-ms 2]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (poll_us == 0) poll_us = 1;
+  if (edges) return replay(edges, links, poll_us);
+  return sweep(poll_us) ? 0 : 1;
+}
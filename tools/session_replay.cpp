@@ -0,0 +1,290 @@
+// Host tool: αποκωδικοποιεί ένα export του session log και προαιρετικά το
+// ξαναπαίζει στον WindlassCore πάνω στο hal::sim().
+//
+//   curl -o s.asl http://sensesp-anchor.local/api/anchor/sessions
+//   g++ -std=gnu++11 -O2 -Iinclude tools/session_replay.cpp -o session_replay
+//   ./session_replay s.asl                 # runs, παλμοί, λόγοι stop
+//   ./session_replay s.asl --records       # κάθε εγγραφή
+//   ./session_replay s.asl --replay        # μέσα από τον simulator
+//
+// Στο --replay κάθε run ξεκινάει με startRun_(), κάθε παλμός γίνεται edge
+// στο pin του αισθητήρα τη στιγμή που καταγράφηκε και κάθε stop καλεί
+// stopNow_() με τον ίδιο λόγο. Πριν από κάθε run και στο τέλος ο μετρητής
+// του core (μαζί με τους παλμούς του coast) συγκρίνεται με αυτόν του log.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <deque>
+#include <vector>
+
+#include "session_log.h"
+#include "windlass_core.h"
+
+namespace {
+
+typedef SessionDecoder::Record Record;
+
+const char* dir_name(uint8_t d) {
+  return d == WindlassFsm::RUNNING_UP ? "up" : d == WindlassFsm::RUNNING_DOWN ? "down" : "-";
+}
+
+void print_time(const Record& r) {
+  if (r.wall_s) {
+    const time_t t = (time_t)r.wall_s;
+    char buf[32];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", gmtime(&t));
+    printf("%s ", buf);
+  } else {
+    printf("+%10.3fs ", (double)r.t_us / 1e6);
+  }
+}
+
+bool read_file(const char* path, std::vector<uint8_t>& out) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return false;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+  fclose(f);
+  return true;
+}
+
+// ---- Replay μέσα από τον simulator ----
+class ReplayCore : public WindlassCore {
+ public:
+  const char* last_event = "";
+  void onRunStateChanged_(const char* what) override { last_event = what; }
+};
+
+// Ο filter μετράει τον παλμό όταν η επαφή ξανανοίξει και μείνει σταθερή,
+// οπότε ο χρόνος που καταγράφηκε είναι το τέλος του. Στο replay η επαφή
+// κλείνει τη στιγμή της εγγραφής και όλα τα υπόλοιπα events έρχονται
+// kLagUs αργότερα, ώστε να βρουν τον μετρητή όπως τον βρήκαν και τότε.
+class Replayer {
+ public:
+  static constexpr uint32_t kStepUs = 2000;     // όπως το kMotorPeriodMs
+  static constexpr uint32_t kHoldUs = 100000;   // διάρκεια "κλειστής" επαφής
+  static constexpr uint32_t kLagUs = 150000;    // > kHoldUs + παράθυρο του filter
+
+  explicit Replayer(float cal) {
+    core_.chain_calibration = cal;
+    core_.setupPins();
+  }
+
+  void feed(const Record& r) {
+    if (r.tag == session_log::kClock) {
+      // Μετά από reboot το uptime ξαναρχίζει: συνέχισε μετά το τωρινό sim time
+      if (r.t_us + offset_us_ < now_()) offset_us_ = now_() - r.t_us;
+    }
+    const uint64_t t = r.t_us + offset_us_;
+    advance_to_(t);
+    Pending p;
+    p.r = r;
+    p.at_us = t + kLagUs;
+    // Παλμός χωρίς κίνηση (η αρχή του run σβήστηκε, ή τράβηγμα με το χέρι):
+    // ο core δεν θα τον μετρούσε, μπαίνει απευθείας στον μετρητή
+    p.pressed = r.tag == session_log::kPulse &&
+                (core_.state != WindlassFsm::IDLE || core_.coast_.active() || pending_starts_);
+    if (p.pressed) {
+      hal::sim().set_input(core_.chain_sensor_pin, LOW);
+      release_at_ = now_() + kHoldUs;
+    }
+    if (r.tag == session_log::kRunStart) pending_starts_++;
+    delayed_.push_back(p);
+  }
+
+  void finish() {
+    advance_to_(now_() + kLagUs + 5000000ULL);
+    check_();
+    printf("replay: %u runs, %u pulses (%u outside a run, %u filter rejects), "
+           "%u counter mismatches, %u runs without stop\n", stats_.runs, stats_.pulses,
+           stats_.untracked_pulses, (unsigned)core_.pulse_filter_->rejected(), stats_.mismatches,
+           stats_.runs_without_stop);
+  }
+
+ private:
+  struct Stats {
+    unsigned runs, pulses, untracked_pulses, mismatches, runs_without_stop;
+  };
+
+  uint64_t now_() const { return hal::sim().now_us; }
+
+  void set_count_(int32_t pulses) {
+    core_.chain_pulse_count = pulses;
+    core_.chain_out_meters = pulses * core_.chain_calibration;
+  }
+
+  struct Pending {
+    Record   r;
+    uint64_t at_us;
+    bool     pressed;  // kPulse: η επαφή έκλεισε στον simulator
+  };
+
+  void apply_(const Pending& p) {
+    const Record& r = p.r;
+    switch (r.tag) {
+      case session_log::kPulse:
+        log_count_ += r.dir == WindlassFsm::RUNNING_DOWN ? 1 : -1;
+        if (log_count_ < 0) log_count_ = 0;
+        if (p.pressed) {
+          stats_.pulses++;
+        } else {
+          set_count_(log_count_);
+          stats_.untracked_pulses++;
+        }
+        break;
+      case session_log::kClock:
+        check_();
+        log_count_ = r.pulses;
+        if (core_.state == WindlassFsm::IDLE) set_count_(r.pulses);
+        break;
+      case session_log::kRunStart:
+        check_();
+        if (core_.state != WindlassFsm::IDLE) stats_.runs_without_stop++;
+        // Το log μπορεί να έχει reset/set του μετρητή ανάμεσα στα runs
+        log_count_ = r.pulses;
+        set_count_(r.pulses);
+        core_.startRun_((WindlassFsm::RunState)r.dir, 3600.0f);
+        pending_starts_--;
+        stats_.runs++;
+        break;
+      case session_log::kStop:
+        snprintf(reason_, sizeof(reason_), "%s", r.reason);
+        if (core_.state != WindlassFsm::IDLE) core_.stopNow_(reason_);
+        break;
+    }
+  }
+
+  // Τρέχει τον core ανά kStepUs, αφήνει την επαφή και εφαρμόζει τα
+  // καθυστερημένα events στην ώρα τους.
+  void advance_to_(uint64_t t_us) {
+    // Μεγάλο κενό χωρίς κίνηση: πήδα (ώρες στην άγκυρα)
+    if (core_.state == WindlassFsm::IDLE && !core_.coast_.active() && release_at_ == 0 &&
+        delayed_.empty() && t_us > now_() + 10000000ULL) {
+      hal::sim().now_us = t_us;
+      next_step_ = t_us;
+    }
+    while (now_() < t_us || (!delayed_.empty() && delayed_.front().at_us <= t_us)) {
+      if (next_step_ < now_()) next_step_ = now_();
+      uint64_t next = next_step_ < t_us ? next_step_ : t_us;
+      if (release_at_ && release_at_ <= next) {
+        hal::sim().now_us = release_at_;
+        hal::sim().set_input(core_.chain_sensor_pin, HIGH);
+        release_at_ = 0;
+        continue;
+      }
+      if (!delayed_.empty() && delayed_.front().at_us <= next) {
+        if (delayed_.front().at_us > now_()) hal::sim().now_us = delayed_.front().at_us;
+        apply_(delayed_.front());
+        delayed_.pop_front();
+        continue;
+      }
+      hal::sim().now_us = next;
+      if (next == next_step_) {
+        core_.tickCore_(hal::millis());
+        next_step_ += kStepUs;
+      }
+    }
+  }
+
+  // Ο μετρητής του core (μαζί με τους παλμούς του coast) πρέπει να
+  // συμφωνεί με το log πριν από κάθε run.
+  void check_() {
+    if (core_.chain_pulse_count == log_count_) return;
+    stats_.mismatches++;
+    printf("  mismatch after %s: log %" PRId32 " pulses, replay %d\n", core_.last_event,
+           log_count_, core_.chain_pulse_count);
+    set_count_(log_count_);
+  }
+
+  ReplayCore core_;
+  Stats    stats_ = Stats();
+  std::deque<Pending> delayed_;
+  char     reason_[session_log::kMaxReason + 1];
+  int32_t  log_count_ = 0;
+  unsigned pending_starts_ = 0;
+  uint64_t offset_us_ = 0;
+  uint64_t next_step_ = 0;
+  uint64_t release_at_ = 0;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <export.asl> [--records] [--replay] [--cal m/pulse]\n", argv[0]);
+    return 2;
+  }
+  bool records = false, replay = false;
+  float cal = 1.0f;
+  for (int i = 2; i < argc; i++) {
+    if (!strcmp(argv[i], "--records")) records = true;
+    else if (!strcmp(argv[i], "--replay")) replay = true;
+    else if (!strcmp(argv[i], "--cal") && i + 1 < argc) cal = (float)atof(argv[++i]);
+  }
+  std::vector<uint8_t> data;
+  if (!read_file(argv[1], data)) {
+    fprintf(stderr, "cannot read %s\n", argv[1]);
+    return 1;
+  }
+
+  SessionDecoder dec(data.data(), data.size());
+  Replayer* rp = replay ? new Replayer(cal) : nullptr;
+  Record r;
+  Record start = Record();
+  bool in_run = false;
+  uint32_t run_pulses = 0, segments = 0, last_segment = 0;
+  uint64_t last_pulse_us = 0, period_sum_us = 0;
+  while (dec.next(r)) {
+    if (r.segment != last_segment) {
+      segments++;
+      last_segment = r.segment;
+    }
+    if (records) {
+      print_time(r);
+      printf("seg %u %-9s %-4s pulses %" PRId32 " %s\n", (unsigned)r.segment,
+             r.tag == session_log::kClock ? "clock" : r.tag == session_log::kRunStart ? "run"
+             : r.tag == session_log::kPulse ? "pulse" : "stop",
+             dir_name(r.dir), r.pulses, r.reason);
+    }
+    if (rp) rp->feed(r);
+    if (records) continue;
+
+    switch (r.tag) {
+      case session_log::kRunStart:
+        start = r;
+        in_run = true;
+        run_pulses = 0;
+        period_sum_us = 0;
+        last_pulse_us = r.t_us;
+        break;
+      case session_log::kPulse:
+        if (!in_run) break;
+        if (run_pulses) period_sum_us += r.t_us - last_pulse_us;
+        last_pulse_us = r.t_us;
+        run_pulses++;
+        break;
+      case session_log::kStop:
+        if (!in_run) break;
+        in_run = false;
+        print_time(start);
+        printf("%-4s %3u pulses in %6.1fs (%" PRId32 " -> %" PRId32 "), period %5.0fms, %s\n",
+               dir_name(start.dir), run_pulses, (double)(r.t_us - start.t_us) / 1e6,
+               start.pulses, r.pulses,
+               run_pulses > 1 ? (double)period_sum_us / (run_pulses - 1) / 1000.0 : 0.0,
+               r.reason);
+        break;
+    }
+  }
+  printf("%zu bytes, %u segments, %u unreadable spans skipped\n", data.size(), segments,
+         (unsigned)dec.skipped());
+  if (rp) {
+    rp->finish();
+    delete rp;
+  }
+  return 0;
+}
@@ -0,0 +1,1665 @@
+// Host tool: τοπικός Signal K server (stand-in) για το υποσύνολο του
+// πρωτοκόλλου που χρησιμοποιεί το SKWSClient του SensESP, και μέτρηση του
+// latency των εντολών από την άφιξη του frame μέχρι την αλλαγή των ρελέ.
+//
+//   g++ -std=gnu++11 -O2 -pthread -Iinclude tools/sk_standin.cpp -o sk_standin
+//   ./sk_standin                               # self-test με εικονική συσκευή
+//   ./sk_standin --port 3000 --latency 100 [--moves] [--prefix sensors.akat.anchor.]
+//   ./sk_standin --port 3000 --soak 14400 [--rate 2] [--mix both|put|delta] [--moves]
+//                [--script cmds.txt] [--disconnect-every 600 --hold 5]
+//                [--record deltas.log] [--stats-port 80 --stats-every 60]
+//
+// Υποσύνολο: access request (εγκρίνεται αμέσως), έλεγχος token (426 =
+// έγκυρο), discovery στο /signalk, WebSocket στο /signalk/v1/stream με
+// hello, subscriptions, deltas και PUT requests/responses. Οι deltas προς
+// ένα subscribed path φεύγουν το πολύ μία φορά ανά period, όπως τα
+// throttled subscriptions ενός πραγματικού server.
+//
+// --latency: η συσκευή έχει για Signal K server αυτό το μηχάνημα. Στέλνει
+// N εντολές state ως PUT και N ως delta προς τον listener, μία τη φορά, και
+// για κάθε μία μετράει PUT → response, frame → commandAck και το latencyUs
+// της συσκευής (dispatch → ρελέ). Χωρίς --moves στέλνει μόνο idle: ασφαλές
+// σε κανονική εγκατάσταση, αλλά τα ρελέ δεν αλλάζουν και το latencyUs
+// μένει null. Με --moves εναλλάξ running_down/idle, μόνο σε πάγκο.
+//
+// --soak: εντολές για S δευτερόλεπτα, --rate ανά δευτερόλεπτο (PUT, delta
+// ή εναλλάξ) ή από script, και απότομες αποσυνδέσεις (RST, χωρίς close
+// frame) κάθε --disconnect-every, με τον server "κάτω" για --hold. Κάθε
+// frame της συσκευής γράφεται στο --record ("ms<TAB>frame"). Το
+// /api/anchor/stats της συσκευής διαβάζεται κάθε --stats-every για heap,
+// reboots και watchdog reconnects. Η αναφορά: εντολές χωρίς commandAck
+// (dropped, ή χαμένες γύρω από αποσύνδεση), διπλά ack ids, ίδια frames
+// μέσα σε 500ms, χρόνοι επανασύνδεσης και η πορεία του heap ανά ώρα.
+// Script: μία εντολή ανά γραμμή, επαναλαμβάνεται μέχρι το τέλος:
+//   0.0  put   state  "running_down"
+//   0.5  delta state  "idle"
+//   30   disconnect 5
+//
+// Η εικονική συσκευή τρέχει WindlassCore + MotorDriver πάνω στο simulated
+// board του anchor_hal.h, συνδέεται όπως το SKWSClient και απαντάει με τα
+// ίδια commandAck deltas (SkDeltaEncoder) με το firmware, και σερβίρει ένα
+// /api/anchor/stats με heap = 320KB μείον τα ζωντανά bytes του process.
+// Το self-test ελέγχει ότι κάθε εντολή επιβεβαιώνεται, ότι το PUT δεν
+// περιμένει το period του listener, και τρέχει ένα σύντομο soak με
+// αποσυνδέσεις.
+
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <new>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "motor_link.h"
+#include "sk_delta_encoder.h"
+
+namespace {
+
+std::atomic<int64_t> g_live_bytes{0};
+
+}  // namespace
+
+// Ζωντανά bytes του process για το heap της εικονικής συσκευής
+void* operator new(size_t n) {
+  char* p = (char*)malloc(n + 16);
+  if (!p) throw std::bad_alloc();
+  memcpy(p, &n, sizeof(n));
+  g_live_bytes += (int64_t)n;
+  return p + 16;
+}
+void operator delete(void* p) noexcept {
+  if (!p) return;
+  char* b = (char*)p - 16;
+  size_t n;
+  memcpy(&n, b, sizeof(n));
+  g_live_bytes -= (int64_t)n;
+  free(b);
+}
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+
+namespace {
+
+uint64_t now_us() {
+  using namespace std::chrono;
+  return (uint64_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t host_random() {
+  static uint32_t s = (uint32_t)now_us() | 1;
+  s ^= s << 13;
+  s ^= s >> 17;
+  s ^= s << 5;
+  return s;
+}
+
+// ---------- SHA-1 και base64 για το Sec-WebSocket-Accept ----------
+inline uint32_t rol(uint32_t v, int n) { return (v << n) | (v >> (32 - n)); }
+
+void sha1(const uint8_t* data, size_t len, uint8_t out[20]) {
+  uint32_t h[5] = {0x67452301u, 0xEFCDAB89u, 0x98BADCFEu, 0x10325476u, 0xC3D2E1F0u};
+  std::vector<uint8_t> m(data, data + len);
+  m.push_back(0x80);
+  while (m.size() % 64 != 56) m.push_back(0);
+  const uint64_t bits = (uint64_t)len * 8;
+  for (int i = 7; i >= 0; i--) m.push_back((uint8_t)(bits >> (i * 8)));
+  for (size_t off = 0; off < m.size(); off += 64) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+      const uint8_t* p = &m[off + 4 * i];
+      w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+    }
+    for (int i = 16; i < 80; i++) w[i] = rol(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+      uint32_t f, k;
+      if (i < 20) {
+        f = (b & c) | (~b & d);
+        k = 0x5A827999u;
+      } else if (i < 40) {
+        f = b ^ c ^ d;
+        k = 0x6ED9EBA1u;
+      } else if (i < 60) {
+        f = (b & c) | (b & d) | (c & d);
+        k = 0x8F1BBCDCu;
+      } else {
+        f = b ^ c ^ d;
+        k = 0xCA62C1D6u;
+      }
+      const uint32_t t = rol(a, 5) + f + e + k + w[i];
+      e = d;
+      d = c;
+      c = rol(b, 30);
+      b = a;
+      a = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+  }
+  for (int i = 0; i < 20; i++) out[i] = (uint8_t)(h[i / 4] >> (24 - 8 * (i % 4)));
+}
+
+std::string base64(const uint8_t* p, size_t n) {
+  static const char kAlphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string out;
+  for (size_t i = 0; i < n; i += 3) {
+    const uint32_t v = (uint32_t)p[i] << 16 | (i + 1 < n ? (uint32_t)p[i + 1] << 8 : 0) |
+                       (i + 2 < n ? p[i + 2] : 0);
+    out += kAlphabet[v >> 18 & 63];
+    out += kAlphabet[v >> 12 & 63];
+    out += i + 1 < n ? kAlphabet[v >> 6 & 63] : '=';
+    out += i + 2 < n ? kAlphabet[v & 63] : '=';
+  }
+  return out;
+}
+
+std::string ws_accept(const std::string& key) {
+  const std::string s = key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+  uint8_t digest[20];
+  sha1((const uint8_t*)s.data(), s.size(), digest);
+  return base64(digest, sizeof(digest));
+}
+
+// ---------- JSON χωρίς parser ----------
+// Η τιμή του πρώτου "key" μετά το from: string χωρίς τα εισαγωγικά (οι
+// δικές μας τιμές δεν έχουν escapes) ή το literal (αριθμός, true, null).
+// Επιστρέφει τη θέση μετά την τιμή, npos αν λείπει.
+size_t json_value(const std::string& s, const char* key, std::string& out, size_t from = 0) {
+  const std::string k = std::string("\"") + key + "\":";
+  size_t p = s.find(k, from);
+  if (p == std::string::npos) return p;
+  p += k.size();
+  while (p < s.size() && s[p] == ' ') p++;
+  if (p < s.size() && s[p] == '"') {
+    const size_t e = s.find('"', p + 1);
+    if (e == std::string::npos) return e;
+    out.assign(s, p + 1, e - p - 1);
+    return e + 1;
+  }
+  size_t e = p;
+  while (e < s.size() && s[e] != ',' && s[e] != '}' && s[e] != ']') e++;
+  out.assign(s, p, e - p);
+  return e;
+}
+
+std::string json_string(const std::string& v) { return "\"" + v + "\""; }
+
+// ---------- TCP ----------
+int tcp_listen(uint16_t port) {
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  const int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in a = {};
+  a.sin_family = AF_INET;
+  a.sin_port = htons(port);
+  a.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(fd, (sockaddr*)&a, sizeof(a)) < 0 || listen(fd, 8) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int tcp_connect(const char* host, uint16_t port) {
+  sockaddr_in a = {};
+  a.sin_family = AF_INET;
+  a.sin_port = htons(port);
+  if (inet_pton(AF_INET, host, &a.sin_addr) != 1) return -1;
+  const int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+  if (connect(fd, (sockaddr*)&a, sizeof(a)) < 0) {
+    close(fd);
+    return -1;
+  }
+  const int one = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return fd;
+}
+
+bool wait_readable(int fd, uint64_t timeout_us) {
+  pollfd p = {fd, POLLIN, 0};
+  return poll(&p, 1, (int)((timeout_us + 999) / 1000)) > 0;
+}
+
+// Μία TCP σύνδεση με buffer εισόδου: HTTP μηνύματα και WebSocket frames.
+class Conn {
+ public:
+  explicit Conn(int fd = -1) : fd_(fd) {}
+
+  int  fd() const { return fd_; }
+  bool open() const { return fd_ >= 0; }
+  void close_() {
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+    rx_.clear();
+    frag_.clear();
+  }
+  // Κλείσιμο με RST, χωρίς close frame (σαν να χάθηκε το WiFi)
+  void abort_() {
+    if (fd_ >= 0) {
+      linger l = {1, 0};
+      setsockopt(fd_, SOL_SOCKET, SO_LINGER, &l, sizeof(l));
+    }
+    close_();
+  }
+
+  // Ό,τι έφτασε μέσα σε timeout_us. false αν η σύνδεση έκλεισε.
+  bool fill(uint64_t timeout_us) {
+    if (fd_ < 0) return false;
+    if (!wait_readable(fd_, timeout_us)) return true;
+    char buf[4096];
+    const ssize_t n = recv(fd_, buf, sizeof(buf), 0);
+    if (n <= 0) {  // ό,τι ήρθε πριν το κλείσιμο μένει στο rx
+      close(fd_);
+      fd_ = -1;
+      return false;
+    }
+    rx_.append(buf, (size_t)n);
+    return true;
+  }
+
+  bool send_raw(const std::string& s) {
+    size_t off = 0;
+    while (fd_ >= 0 && off < s.size()) {
+      const ssize_t n = send(fd_, s.data() + off, s.size() - off, MSG_NOSIGNAL);
+      if (n <= 0) {
+        close_();
+        return false;
+      }
+      off += (size_t)n;
+    }
+    return fd_ >= 0;
+  }
+
+  // Κεφαλίδες HTTP μέχρι το \r\n\r\n και το body (Content-Length ή, σε
+  // απάντηση με Connection: close, μέχρι να κλείσει).
+  bool read_http(std::string& head, std::string& body, uint64_t timeout_us,
+                 bool until_close = false) {
+    const uint64_t end = now_us() + timeout_us;
+    size_t p;
+    while ((p = rx_.find("\r\n\r\n")) == std::string::npos) {
+      if (now_us() >= end || !fill(end - now_us())) return false;
+    }
+    head.assign(rx_, 0, p + 2);
+    size_t want = 0;
+    const std::string len = header(head, "content-length");
+    if (!len.empty()) want = (size_t)strtoul(len.c_str(), nullptr, 10);
+    while (rx_.size() < p + 4 + want || until_close) {
+      if (now_us() >= end) break;
+      if (!fill(end - now_us())) break;
+    }
+    body.assign(rx_, p + 4, until_close ? std::string::npos : want);
+    rx_.erase(0, std::min(rx_.size(), p + 4 + body.size()));
+    return true;
+  }
+
+  // Header χωρίς διάκριση πεζών/κεφαλαίων, "" αν λείπει
+  static std::string header(const std::string& head, const char* name) {
+    const size_t n = strlen(name);
+    for (size_t p = head.find("\r\n"); p != std::string::npos; p = head.find("\r\n", p + 2)) {
+      const size_t line = p + 2;
+      if (head.size() > line + n && head[line + n] == ':' &&
+          strncasecmp(head.c_str() + line, name, n) == 0) {
+        size_t v = line + n + 1;
+        while (v < head.size() && head[v] == ' ') v++;
+        return head.substr(v, head.find("\r\n", v) - v);
+      }
+    }
+    return "";
+  }
+
+  // Ένα ολόκληρο μήνυμα από το rx (τα fragments ενώνονται). false αν
+  // δεν έχει φτάσει ακόμα.
+  bool take_frame(int& opcode, std::string& payload) {
+    for (;;) {
+      if (rx_.size() < 2) return false;
+      const uint8_t b0 = (uint8_t)rx_[0], b1 = (uint8_t)rx_[1];
+      size_t len = b1 & 0x7f, hdr = 2;
+      if (len == 126) {
+        if (rx_.size() < 4) return false;
+        len = (size_t)(uint8_t)rx_[2] << 8 | (uint8_t)rx_[3];
+        hdr = 4;
+      } else if (len == 127) {
+        if (rx_.size() < 10) return false;
+        len = 0;
+        for (int i = 2; i < 10; i++) len = len << 8 | (uint8_t)rx_[i];
+        hdr = 10;
+      }
+      const bool masked = (b1 & 0x80) != 0;
+      const size_t start = hdr + (masked ? 4 : 0);
+      if (rx_.size() < start + len) return false;
+      std::string data(rx_, start, len);
+      if (masked) {
+        for (size_t i = 0; i < len; i++) data[i] = (char)(data[i] ^ rx_[hdr + i % 4]);
+      }
+      rx_.erase(0, start + len);
+      const int op = b0 & 0x0f;
+      const bool fin = (b0 & 0x80) != 0;
+      if (op >= 8) {  // control frames ανάμεσα σε fragments
+        opcode = op;
+        payload.swap(data);
+        return true;
+      }
+      if (op != 0) frag_op_ = op;
+      frag_ += data;
+      if (!fin) continue;
+      opcode = frag_op_;
+      payload.swap(frag_);
+      frag_.clear();
+      return true;
+    }
+  }
+
+  // Server → client χωρίς mask, client → server με mask (RFC 6455)
+  bool send_frame(int opcode, const std::string& payload, bool mask) {
+    std::string f;
+    f += (char)(0x80 | opcode);
+    const size_t n = payload.size();
+    const char m = mask ? (char)0x80 : 0;
+    if (n < 126) {
+      f += (char)(m | (char)n);
+    } else if (n < 65536) {
+      f += (char)(m | 126);
+      f += (char)(n >> 8);
+      f += (char)n;
+    } else {
+      f += (char)(m | 127);
+      for (int i = 7; i >= 0; i--) f += (char)((uint64_t)n >> (i * 8));
+    }
+    if (!mask) return send_raw(f + payload);
+    const uint32_t key = host_random();
+    char k[4];
+    memcpy(k, &key, 4);
+    f.append(k, 4);
+    for (size_t i = 0; i < n; i++) f += (char)(payload[i] ^ k[i % 4]);
+    return send_raw(f);
+  }
+
+  size_t buffered() const { return rx_.size(); }
+
+ private:
+  int         fd_;
+  std::string rx_;
+  std::string frag_;
+  int         frag_op_ = 1;
+};
+
+std::string http_response(int code, const char* reason, const std::string& body,
+                          const char* extra = "") {
+  char head[256];
+  snprintf(head, sizeof(head),
+           "HTTP/1.1 %d %s\r\nContent-Type: application/json\r\nContent-Length: %zu\r\n"
+           "Connection: close\r\n%s\r\n",
+           code, reason, body.size(), extra);
+  return head + body;
+}
+
+// ---------- Stand-in server ----------
+class Standin {
+ public:
+  // Ένα commandAck της συσκευής
+  struct Ack {
+    uint64_t    t_us;
+    uint32_t    id;
+    std::string source;
+    std::string command;
+    int64_t     latency_us;  // -1 = null (τα ρελέ δεν άλλαξαν)
+  };
+
+  struct Stats {
+    uint32_t http_requests;
+    uint32_t access_requests;
+    uint32_t ws_connects;
+    uint32_t frames_rx;
+    uint64_t bytes_rx;
+    uint32_t puts_sent;
+    uint32_t put_responses;
+    uint32_t deltas_sent;
+    uint32_t disconnects;       // όλες, μαζί με τις drop()
+    uint32_t dropped;           // από drop()
+    uint32_t refused;           // συνδέσεις μέσα στο hold
+    uint32_t duplicate_frames;  // ίδιο frame μέσα σε kDuplicateUs
+  };
+
+  // Δύο ίδια frames της συσκευής πιο κοντά από αυτό μετράνε ως διπλά
+  static constexpr uint64_t kDuplicateUs = 500000;
+
+  // Τι έγινε με ένα delta()
+  enum DeltaResult { kDeltaNotSubscribed, kDeltaQueued, kDeltaReplaced };
+
+  bool listen(uint16_t port) {
+    fd_ = tcp_listen(port);
+    start_us_ = now_us();
+    return fd_ >= 0;
+  }
+
+  uint16_t port() const {
+    sockaddr_in a;
+    socklen_t len = sizeof(a);
+    getsockname(fd_, (sockaddr*)&a, &len);
+    return ntohs(a.sin_port);
+  }
+
+  bool connected() const { return ws_.open(); }
+  uint64_t connected_at_us() const { return connected_at_us_; }
+  const Stats& stats() const { return stats_; }
+  const std::vector<Ack>& acks() const { return acks_; }
+
+  bool subscribed(const std::string& path) const { return subs_.count(path) != 0; }
+  const std::vector<uint64_t>& connect_times() const { return connect_us_; }
+  const std::vector<uint64_t>& disconnect_times() const { return disconnect_us_; }
+  // Η IP της συσκευής από την τελευταία σύνδεση WebSocket
+  const std::string& peer() const { return peer_; }
+
+  // Κάθε frame της συσκευής ως "ms<TAB>frame", και οι συνδέσεις ως σχόλια
+  void record_to(FILE* f) { record_ = f; }
+
+  // Ο server "πέφτει": η σύνδεση κόβεται με RST χωρίς close frame και κάθε
+  // νέα σύνδεση απορρίπτεται για hold_us.
+  void drop(uint64_t hold_us) {
+    if (ws_.open()) {
+      ws_.abort_();
+      stats_.dropped++;
+      disconnected_();
+    }
+    refuse_until_us_ = now_us() + hold_us;
+  }
+
+  // Ένα πέρασμα: νέες συνδέσεις και HTTP, frames της συσκευής, deltas που
+  // ήρθε η ώρα τους. Περιμένει το πολύ timeout_us.
+  void poll(uint64_t timeout_us) {
+    const uint64_t now = now_us();
+    for (auto& s : subs_) {
+      Sub& sub = s.second;
+      if (!sub.pending) continue;
+      if (sub.next_us <= now) {
+        sendDelta_(s.first, sub.value);
+        sub.pending = false;
+        sub.next_us = now + sub.period_ms * 1000ULL;
+      } else if (sub.next_us - now < timeout_us) {
+        timeout_us = sub.next_us - now;
+      }
+    }
+
+    pollfd p[2] = {{fd_, POLLIN, 0}, {ws_.fd(), POLLIN, 0}};
+    const nfds_t n = ws_.open() ? 2 : 1;
+    if (::poll(p, n, (int)((timeout_us + 999) / 1000)) <= 0) return;
+    if (p[0].revents & POLLIN) accept_();
+    if (n == 2 && (p[1].revents & (POLLIN | POLLHUP | POLLERR))) {
+      if (!ws_.fill(0)) {
+        disconnected_();
+        return;
+      }
+      int op;
+      std::string text;
+      while (ws_.take_frame(op, text)) {
+        if (op == 1) {
+          onText_(text);
+        } else if (op == 8) {
+          ws_.close_();
+          disconnected_();
+          return;
+        } else if (op == 9) {
+          ws_.send_frame(10, text, false);
+        }
+      }
+    }
+  }
+
+  // PUT προς τη συσκευή. Επιστρέφει το requestId (0 = χωρίς σύνδεση).
+  uint32_t put(const std::string& path, const std::string& json_value) {
+    if (!ws_.open()) return 0;
+    const uint32_t id = ++request_id_;
+    char head[64];
+    snprintf(head, sizeof(head), "{\"context\":\"vessels.self\",\"requestId\":\"%u\",",
+             (unsigned)id);
+    ws_.send_frame(1, head + ("\"put\":{\"path\":\"" + path + "\",\"value\":" + json_value + "}}"),
+                   false);
+    stats_.puts_sent++;
+    return id;
+  }
+
+  // Χρόνος του PUT response (0 = δεν ήρθε ακόμα)
+  uint64_t put_response_us(uint32_t id) const {
+    auto it = put_response_us_.find(id);
+    return it == put_response_us_.end() ? 0 : it->second;
+  }
+
+  // Delta σε subscribed path: φεύγει στο επόμενο period. Ένα δεύτερο
+  // delta μέσα στο ίδιο period αντικαθιστά το πρώτο (kDeltaReplaced), όπως
+  // σε throttled subscription.
+  DeltaResult delta(const std::string& path, const std::string& json_value) {
+    auto it = subs_.find(path);
+    if (it == subs_.end() || !ws_.open()) return kDeltaNotSubscribed;
+    const bool replaced = it->second.pending;
+    it->second.pending = true;
+    it->second.value = json_value;
+    return replaced ? kDeltaReplaced : kDeltaQueued;
+  }
+
+ private:
+  struct Sub {
+    uint32_t    period_ms = 0;
+    uint64_t    next_us = 0;
+    bool        pending = false;
+    std::string value;
+  };
+
+  struct Recent {
+    uint64_t t_us;
+    size_t   hash;
+    size_t   size;
+  };
+
+  void accept_() {
+    const int fd = accept(fd_, nullptr, nullptr);
+    if (fd < 0) return;
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    Conn c(fd);
+    if (now_us() < refuse_until_us_) {
+      c.abort_();
+      stats_.refused++;
+      return;
+    }
+    std::string head, body;
+    if (!c.read_http(head, body, 1000000)) {
+      c.close_();
+      return;
+    }
+    stats_.http_requests++;
+    handleHttp_(c, head, body);
+  }
+
+  // Το HTTP που χρειάζεται το SKWSClient πριν και για το WebSocket
+  void handleHttp_(Conn& c, const std::string& head, const std::string& body) {
+    const size_t sp = head.find(' ');
+    const std::string method = head.substr(0, sp);
+    const std::string path = head.substr(sp + 1, head.find(' ', sp + 1) - sp - 1);
+    const std::string auth = Conn::header(head, "authorization");
+    const bool upgrade = strcasecmp(Conn::header(head, "upgrade").c_str(), "websocket") == 0;
+    char buf[320];
+
+    if (method == "GET" && path == "/signalk") {
+      snprintf(buf, sizeof(buf),
+               "{\"endpoints\":{\"v1\":{\"version\":\"1.7.0\",\"signalk-http\":\"/signalk/v1/api/\","
+               "\"signalk-ws\":\"/signalk/v1/stream\"}},"
+               "\"server\":{\"id\":\"sk-standin\",\"version\":\"1.0.0\"}}");
+      c.send_raw(http_response(200, "OK", buf));
+    } else if (method == "POST" && path == "/signalk/v1/access/requests") {
+      (void)body;
+      const uint32_t id = ++access_id_;
+      stats_.access_requests++;
+      snprintf(buf, sizeof(buf),
+               "{\"state\":\"PENDING\",\"requestId\":\"%u\",\"href\":\"/signalk/v1/requests/%u\"}",
+               (unsigned)id, (unsigned)id);
+      c.send_raw(http_response(202, "Accepted", buf));
+    } else if (method == "GET" && path.compare(0, 20, "/signalk/v1/requests") == 0) {
+      const unsigned id = (unsigned)strtoul(path.c_str() + 21, nullptr, 10);
+      snprintf(buf, sizeof(buf),
+               "{\"state\":\"COMPLETED\",\"requestId\":\"%u\",\"statusCode\":200,"
+               "\"accessRequest\":{\"permission\":\"APPROVED\",\"token\":\"standin-%u\"}}",
+               id, id);
+      c.send_raw(http_response(200, "OK", buf));
+    } else if (method == "GET" && path.compare(0, 18, "/signalk/v1/stream") == 0 && upgrade) {
+      const std::string key = Conn::header(head, "sec-websocket-key");
+      if (ws_.open()) {  // η συσκευή ξανασυνδέθηκε: η παλιά σύνδεση είναι νεκρή
+        ws_.close_();
+        disconnected_();
+      }
+      c.send_raw("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+                 "Connection: Upgrade\r\nSec-WebSocket-Accept: " + ws_accept(key) + "\r\n\r\n");
+      sockaddr_in a;
+      socklen_t len = sizeof(a);
+      char ip[INET_ADDRSTRLEN] = "";
+      if (getpeername(c.fd(), (sockaddr*)&a, &len) == 0) {
+        inet_ntop(AF_INET, &a.sin_addr, ip, sizeof(ip));
+      }
+      peer_ = ip;
+      ws_ = c;
+      c = Conn();
+      connected_at_us_ = now_us();
+      connect_us_.push_back(connected_at_us_);
+      stats_.ws_connects++;
+      mark_("connect");
+      ws_.send_frame(1,
+                     "{\"name\":\"sk-standin\",\"version\":\"1.0.0\","
+                     "\"self\":\"vessels.urn:mrn:signalk:uuid:sk-standin\","
+                     "\"roles\":[\"master\",\"main\"]}",
+                     false);
+      return;
+    } else if (method == "GET" && path.compare(0, 18, "/signalk/v1/stream") == 0) {
+      // Το SKWSClient ελέγχει το token εδώ: 426 = έγκυρο, 401 = ζήτα νέο
+      const bool ok = auth.compare(0, 15, "Bearer standin-") == 0;
+      c.send_raw(ok ? http_response(426, "Upgrade Required", "")
+                    : http_response(401, "Unauthorized", ""));
+    } else {
+      c.send_raw(http_response(404, "Not Found", "{}"));
+    }
+    c.close_();
+  }
+
+  void disconnected_() {
+    subs_.clear();
+    recent_.clear();
+    disconnect_us_.push_back(now_us());
+    stats_.disconnects++;
+    mark_("disconnect");
+  }
+
+  void mark_(const char* what) {
+    if (!record_) return;
+    fprintf(record_, "# %llu %s\n", (unsigned long long)((now_us() - start_us_) / 1000), what);
+  }
+
+  // Ίδιο frame (hash και μήκος) ξανά μέσα σε kDuplicateUs
+  void checkDuplicate_(const std::string& text, uint64_t t) {
+    while (!recent_.empty() && t - recent_.front().t_us > kDuplicateUs) recent_.pop_front();
+    const Recent r = {t, std::hash<std::string>()(text), text.size()};
+    for (const Recent& o : recent_) {
+      if (o.hash == r.hash && o.size == r.size) {
+        stats_.duplicate_frames++;
+        break;
+      }
+    }
+    recent_.push_back(r);
+  }
+
+  void onText_(const std::string& text) {
+    const uint64_t t = now_us();
+    stats_.frames_rx++;
+    stats_.bytes_rx += text.size();
+    if (record_) {
+      fprintf(record_, "%llu\t%s\n", (unsigned long long)((t - start_us_) / 1000), text.c_str());
+    }
+    checkDuplicate_(text, t);
+    std::string v;
+
+    if (text.find("\"subscribe\"") != std::string::npos) {
+      size_t p = 0;
+      std::string path, period;
+      while ((p = json_value(text, "path", path, p)) != std::string::npos) {
+        Sub& s = subs_[path];
+        const size_t q = json_value(text, "period", period, p);
+        const size_t next = text.find("\"path\"", p);
+        s.period_ms = q != std::string::npos && (next == std::string::npos || q < next)
+                          ? (uint32_t)strtoul(period.c_str(), nullptr, 10)
+                          : 0;
+      }
+      return;
+    }
+    if (text.find("\"updates\"") == std::string::npos) {
+      // PUT response: {"requestId":"7","state":"COMPLETED","statusCode":200}
+      if (json_value(text, "requestId", v) != std::string::npos) {
+        const uint32_t id = (uint32_t)strtoul(v.c_str(), nullptr, 10);
+        std::string state;
+        json_value(text, "state", state);
+        if (state != "PENDING" && put_response_us_.count(id) == 0) {
+          put_response_us_[id] = t;
+          stats_.put_responses++;
+        }
+      }
+      return;
+    }
+    // commandAck μέσα σε delta
+    const size_t at = text.find("commandAck\"");
+    if (at != std::string::npos) {
+      Ack a;
+      a.t_us = t;
+      json_value(text, "id", v, at);
+      a.id = (uint32_t)strtoul(v.c_str(), nullptr, 10);
+      json_value(text, "command", a.command, at);
+      json_value(text, "source", a.source, at);
+      json_value(text, "latencyUs", v, at);
+      a.latency_us = v == "null" || v.empty() ? -1 : (int64_t)strtoll(v.c_str(), nullptr, 10);
+      acks_.push_back(a);
+    }
+  }
+
+  void sendDelta_(const std::string& path, const std::string& json_value) {
+    ws_.send_frame(1,
+                   "{\"context\":\"vessels.self\",\"updates\":[{\"source\":{\"label\":"
+                   "\"sk-standin\"},\"values\":[{\"path\":\"" + path + "\",\"value\":" +
+                       json_value + "}]}]}",
+                   false);
+    stats_.deltas_sent++;
+  }
+
+  int      fd_ = -1;
+  Conn     ws_;
+  uint64_t start_us_ = 0;
+  uint64_t connected_at_us_ = 0;
+  uint64_t refuse_until_us_ = 0;
+  FILE*    record_ = nullptr;
+  std::string peer_;
+  uint32_t access_id_ = 0;
+  uint32_t request_id_ = 0;
+  Stats    stats_ = {};
+  std::map<std::string, Sub> subs_;
+  std::map<uint32_t, uint64_t> put_response_us_;
+  std::vector<Ack> acks_;
+  std::vector<uint64_t> connect_us_;
+  std::vector<uint64_t> disconnect_us_;
+  std::deque<Recent> recent_;
+};
+
+// ---------- Εικονική συσκευή ----------
+// Η ροή του SKWSClient: access request → token → έλεγχος token (426) →
+// WebSocket → subscriptions. Οι PUT εφαρμόζονται αμέσως, οι deltas των
+// listeners μόνο μετά το settling των 2s από τη σύνδεση, όπως στο firmware.
+// Μετά από RST ξαναπροσπαθεί κάθε kRetryMs. Το /api/anchor/stats είναι
+// στο http_port(), με τα πεδία που διαβάζει το soak.
+class SimDevice {
+ public:
+  struct Core : WindlassCore {};
+
+  static constexpr uint32_t kSettleMs = 2000;
+  static constexpr uint32_t kRetryMs = 1000;
+  static constexpr int64_t  kHeapBytes = 320 * 1024;
+
+  struct Stats {
+    uint32_t connects;
+    uint32_t disconnects;
+    uint32_t commands[2];  // listener, put
+    uint32_t ignored;      // listener μέσα στο settling
+    uint32_t unknown;
+    uint32_t acks;
+  };
+
+  SimDevice(const char* host, uint16_t port) : host_(host), port_(port) {
+    http_fd_ = tcp_listen(0);
+  }
+  ~SimDevice() {
+    if (http_fd_ >= 0) close(http_fd_);
+  }
+
+  uint16_t http_port() const {
+    sockaddr_in a;
+    socklen_t len = sizeof(a);
+    getsockname(http_fd_, (sockaddr*)&a, &len);
+    return ntohs(a.sin_port);
+  }
+
+  void run(const std::atomic<bool>& stop) {
+    t0_us_ = now_us();
+    clock_();
+    core_.setupPins();
+    driver_.publish();
+    while (!stop.load()) {
+      const uint32_t now = clock_();
+      if (!ws_.open()) {
+        link_.link_up.store(false);
+        if (now >= retry_at_ms_) connect_();
+        else std::this_thread::sleep_for(std::chrono::milliseconds(2));
+      } else {
+        const bool alive = ws_.fill(2000);
+        int op;
+        std::string text;
+        while (ws_.take_frame(op, text)) {
+          if (op == 1) onText_(text);
+          else if (op == 8) ws_.close_();
+          else if (op == 9 && ws_.open()) ws_.send_frame(10, text, true);
+        }
+        if (!alive || !ws_.open()) {
+          ws_.close_();
+          stats_.disconnects++;
+          retry_at_ms_ = clock_() + kRetryMs;
+        }
+      }
+      serveHttp_();
+      step_();
+    }
+    ws_.close_();
+  }
+
+  const Stats& stats() const { return stats_; }
+
+ private:
+  uint32_t clock_() {
+    hal::sim().now_us = now_us() - t0_us_;
+    return hal::millis();
+  }
+
+  // Ένα HTTP request σε νέα σύνδεση (Connection: close). Επιστρέφει τον κωδικό.
+  int http_(const char* method, const std::string& path, const std::string& body,
+            std::string& reply) {
+    Conn c(tcp_connect(host_, port_));
+    if (!c.open()) return -1;
+    std::string req = std::string(method) + " " + path + " HTTP/1.1\r\nHost: " + host_ +
+                      "\r\nConnection: close\r\n";
+    if (!token_.empty()) req += "Authorization: Bearer " + token_ + "\r\n";
+    if (!body.empty()) {
+      char len[96];
+      snprintf(len, sizeof(len), "Content-Type: application/json\r\nContent-Length: %zu\r\n",
+               body.size());
+      req += len;
+    }
+    c.send_raw(req + "\r\n" + body);
+    std::string head;
+    if (!c.read_http(head, reply, 1000000, true)) return -1;
+    c.close_();
+    return atoi(head.c_str() + head.find(' ') + 1);
+  }
+
+  void connect_() {
+    retry_at_ms_ = clock_() + kRetryMs;
+    std::string reply, v;
+    if (token_.empty()) {
+      if (http_("POST", "/signalk/v1/access/requests",
+                "{\"clientId\":\"sk-standin-sim\",\"description\":\"Simulated windlass\","
+                "\"permissions\":\"readwrite\"}",
+                reply) != 202 ||
+          json_value(reply, "href", v) == std::string::npos) {
+        return;
+      }
+      if (http_("GET", v, "", reply) != 200) return;
+      json_value(reply, "permission", v);
+      if (v != "APPROVED") return;
+      json_value(reply, "token", token_);
+    }
+    const int code = http_("GET", "/signalk/v1/stream", "", reply);
+    if (code == 401) token_.clear();
+    if (code != 426) return;
+
+    Conn c(tcp_connect(host_, port_));
+    if (!c.open()) return;
+    uint8_t nonce[16];
+    for (int i = 0; i < 16; i++) nonce[i] = (uint8_t)host_random();
+    const std::string key = base64(nonce, sizeof(nonce));
+    c.send_raw("GET /signalk/v1/stream?subscribe=none HTTP/1.1\r\nHost: " + std::string(host_) +
+               "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: " + key +
+               "\r\nSec-WebSocket-Version: 13\r\nAuthorization: Bearer " + token_ + "\r\n\r\n");
+    std::string head, body;
+    if (!c.read_http(head, body, 1000000) || head.find(" 101 ") == std::string::npos ||
+        Conn::header(head, "sec-websocket-accept") != ws_accept(key)) {
+      c.close_();
+      return;
+    }
+    ws_ = c;
+    connected_ms_ = clock_();
+    link_.link_up.store(true);
+    stats_.connects++;
+    // Οι listeners του firmware, με το listen delay τους ως period
+    ws_.send_frame(1,
+                   "{\"context\":\"vessels.self\",\"subscribe\":["
+                   "{\"path\":\"" SK_ANCHOR_PREFIX "state\",\"period\":300},"
+                   "{\"path\":\"" SK_ANCHOR_PREFIX "defaultChainSeconds\",\"period\":500},"
+                   "{\"path\":\"" SK_ANCHOR_PREFIX "chainOutSet\",\"period\":500},"
+                   "{\"path\":\"" SK_ANCHOR_PREFIX "chainTargetSet\",\"period\":500},"
+                   "{\"path\":\"" SK_ANCHOR_PREFIX "resetChainCounter\",\"period\":500}]}",
+                   true);
+  }
+
+  void onText_(const std::string& text) {
+    std::string path, value;
+    const size_t put = text.find("\"put\"");
+    if (put != std::string::npos) {
+      std::string rid;
+      json_value(text, "requestId", rid);
+      json_value(text, "path", path, put);
+      json_value(text, "value", value, put);
+      command_(path, value, MotorCommand::kSrcPut);
+      ws_.send_frame(1, "{\"requestId\":\"" + rid + "\",\"state\":\"COMPLETED\",\"statusCode\":200}",
+                     true);
+      return;
+    }
+    if (text.find("\"updates\"") == std::string::npos) return;
+    size_t p = 0;
+    while ((p = json_value(text, "path", path, p)) != std::string::npos) {
+      p = json_value(text, "value", value, p);
+      if (clock_() - connected_ms_ < kSettleMs) {
+        stats_.ignored++;
+        continue;
+      }
+      command_(path, value, MotorCommand::kSrcListener);
+      if (p == std::string::npos) break;
+    }
+  }
+
+  // Ό,τι κάνουν οι handlers του AnchorController για κάθε path
+  void command_(const std::string& path, const std::string& value, MotorCommand::Source src) {
+    const std::string prefix = SK_ANCHOR_PREFIX;
+    if (path.compare(0, prefix.size(), prefix) != 0) return;
+    const std::string leaf = path.substr(prefix.size());
+    MotorCommand::Type type;
+    uint8_t arg = 0;
+    float v = (float)atof(value.c_str());
+    if (leaf == "state") {
+      const WindlassFsm::Command cmd = WindlassFsm::parseCommand(value.c_str());
+      if (cmd == WindlassFsm::kCmdUnknown) {
+        stats_.unknown++;
+        return;
+      }
+      type = MotorCommand::kFsm;
+      arg = (uint8_t)cmd;
+    } else if (leaf == "chainOutSet") {
+      type = MotorCommand::kSetChainOut;
+      arg = 1;
+    } else if (leaf == "chainTargetSet") {
+      type = MotorCommand::kSetTarget;
+    } else if (leaf == "resetChainCounter" && value == "true") {
+      type = MotorCommand::kResetCounter;
+    } else {
+      return;
+    }
+    stats_.commands[src == MotorCommand::kSrcPut ? 1 : 0]++;
+    clock_();
+    link_.post(MotorLink::make(type, arg, v, nullptr, src, next_id_++));
+    step_();  // το motor task ξυπνάει με την εντολή
+  }
+
+  void step_() {
+    const uint32_t now = clock_();
+    link_.loop_alive_ms.store(now);
+    driver_.step(now);
+    CommandAck a;
+    while (link_.acks.pop(a)) sendAck_(a);
+    const char* what;
+    while (link_.events.pop(what)) {
+      if (!ws_.open()) continue;
+      enc_.begin();
+      enc_.add(SK_ANCHOR_PATH("lastCommand"), what);
+      if (enc_.finish()) ws_.send_frame(1, enc_.c_str(), true);
+    }
+    if (ws_.open() && now - telemetry_ms_ >= 1000) {
+      telemetry_ms_ = now;
+      MotorSnapshot s;
+      link_.snapshot.read(s);
+      enc_.begin();
+      enc_.add(SK_ANCHOR_PATH("chainOut"), s.chain_out_meters);
+      enc_.add(SK_ANCHOR_PATH("chainPulses"), s.chain_pulse_count);
+      enc_.add(SK_ANCHOR_PATH("state"), WindlassFsm::stateName(s.state));
+      if (enc_.finish()) ws_.send_frame(1, enc_.c_str(), true);
+    }
+  }
+
+  // Το /api/anchor/stats με τα πεδία του firmware που διαβάζει το soak. Το
+  // heap είναι kHeapBytes μείον ό,τι έχει δεσμεύσει όλο το process.
+  void serveHttp_() {
+    if (http_fd_ < 0 || !wait_readable(http_fd_, 0)) return;
+    Conn c(accept(http_fd_, nullptr, nullptr));
+    std::string head, body;
+    if (!c.open() || !c.read_http(head, body, 1000000)) {
+      c.close_();
+      return;
+    }
+    if (head.compare(0, 22, "GET /api/anchor/stats ") != 0) {
+      c.send_raw(http_response(404, "Not Found", "{}"));
+      c.close_();
+      return;
+    }
+    const int64_t free_bytes = kHeapBytes - g_live_bytes.load();
+    if (min_free_ == 0 || free_bytes < min_free_) min_free_ = free_bytes;
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+             "{\"uptimeMs\":%u,\"heap\":{\"free\":%lld,\"minFree\":%lld,\"largest\":%lld},"
+             "\"ws\":{\"state\":\"%s\",\"connects\":%u,\"disconnects\":%u,"
+             "\"watchdogReconnects\":0},"
+             "\"commands\":{\"listener\":%u,\"put\":%u,\"acked\":%u,\"ignored\":%u,"
+             "\"unknown\":%u,\"lastId\":%u}}",
+             (unsigned)clock_(), (long long)free_bytes, (long long)min_free_,
+             (long long)free_bytes, ws_.open() ? "connected" : "disconnected",
+             (unsigned)stats_.connects, (unsigned)stats_.disconnects,
+             (unsigned)stats_.commands[0], (unsigned)stats_.commands[1], (unsigned)stats_.acks,
+             (unsigned)stats_.ignored, (unsigned)stats_.unknown, (unsigned)(next_id_ - 1));
+    c.send_raw(http_response(200, "OK", buf));
+    c.close_();
+  }
+
+  // Το commandAck όπως το onCommandAck_() του firmware (χωρίς wall clock)
+  void sendAck_(const CommandAck& a) {
+    stats_.acks++;
+    if (!ws_.open()) return;
+    enc_.begin();
+    enc_.begin_object(SK_ANCHOR_PATH("commandAck"));
+    enc_.member("id", a.id);
+    enc_.member("command", a.type == MotorCommand::kFsm
+                               ? WindlassFsm::commandName((WindlassFsm::Command)a.arg)
+                               : "other");
+    enc_.member("source", a.source == MotorCommand::kSrcPut ? "put" : "listener");
+    enc_.member("result", WindlassCore::outcomeName(a.outcome));
+    enc_.member("state", WindlassFsm::stateName(a.state));
+    enc_.member("receivedAt", (const char*)nullptr);
+    enc_.member("actuatedAt", (const char*)nullptr);
+    if (a.actuated) enc_.member("latencyUs", a.actuated_us - a.received_us);
+    else enc_.member("latencyUs", (const char*)nullptr);
+    enc_.end_object();
+    if (enc_.finish()) ws_.send_frame(1, enc_.c_str(), true);
+  }
+
+  const char* host_;
+  uint16_t    port_;
+  int         http_fd_ = -1;
+  int64_t     min_free_ = 0;
+  uint64_t    t0_us_ = 0;
+  Conn        ws_;
+  std::string token_;
+  uint32_t    retry_at_ms_ = 0;
+  uint32_t    connected_ms_ = 0;
+  uint32_t    telemetry_ms_ = 0;
+  uint32_t    next_id_ = 1;
+  Stats       stats_ = {};
+  Core        core_;
+  MotorLink   link_;
+  MotorDriver driver_{core_, link_};
+  SkDeltaEncoder<512> enc_;
+};
+
+// ---------- Latency ----------
+double percentile(std::vector<double> v, double p) {
+  if (v.empty()) return 0.0;
+  std::sort(v.begin(), v.end());
+  size_t i = (size_t)(p / 100.0 * (double)(v.size() - 1) + 0.5);
+  return v[std::min(i, v.size() - 1)];
+}
+
+struct PathResult {
+  uint32_t sent = 0;
+  uint32_t acked = 0;
+  std::vector<double> response_ms;  // PUT → PUT response
+  std::vector<double> ack_ms;       // frame → commandAck
+  std::vector<double> relay_us;     // latencyUs της συσκευής
+};
+
+template <typename Pred>
+bool wait_for(Standin& s, uint64_t timeout_us, Pred done) {
+  const uint64_t end = now_us() + timeout_us;
+  while (!done()) {
+    if (now_us() >= end) return false;
+    s.poll(std::min<uint64_t>(end - now_us(), 5000));
+  }
+  return true;
+}
+
+// Μία εντολή και αναμονή για το ack της (και το PUT response)
+void send_one(Standin& s, const std::string& path, const char* value, bool put, PathResult& r) {
+  const size_t acks_before = s.acks().size();
+  const char* source = put ? "put" : "listener";
+  r.sent++;
+  const uint64_t t0 = now_us();
+  uint32_t rid = 0;
+  if (put) rid = s.put(path, json_string(value));
+  else s.delta(path, json_string(value));
+  size_t found = 0;
+  const bool ok = wait_for(s, 2000000, [&] {
+    for (size_t i = acks_before; i < s.acks().size(); i++) {
+      if (s.acks()[i].source == source) {
+        found = i + 1;
+        break;
+      }
+    }
+    return found && (!put || s.put_response_us(rid));
+  });
+  if (!ok) return;
+  const Standin::Ack& a = s.acks()[found - 1];
+  r.acked++;
+  r.ack_ms.push_back((a.t_us - t0) / 1000.0);
+  if (put) r.response_ms.push_back((s.put_response_us(rid) - t0) / 1000.0);
+  if (a.latency_us >= 0) r.relay_us.push_back((double)a.latency_us);
+}
+
+void report(const char* name, const PathResult& r) {
+  printf("%-8s acked %3u/%-3u  ack p50 %7.2fms p95 %7.2fms max %7.2fms", name,
+         (unsigned)r.acked, (unsigned)r.sent, percentile(r.ack_ms, 50), percentile(r.ack_ms, 95),
+         percentile(r.ack_ms, 100));
+  if (!r.response_ms.empty()) printf("  response p50 %.2fms", percentile(r.response_ms, 50));
+  if (!r.relay_us.empty()) printf("  relay p50 %.0fus", percentile(r.relay_us, 50));
+  printf("\n");
+}
+
+const uint64_t kNeutralGapUs = 500000;
+
+// Περιμένει τη συσκευή, μετά N εντολές ως PUT και N ως delta
+bool latency(Standin& s, const std::string& prefix, uint32_t count, bool moves,
+             uint64_t wait_us, PathResult& put, PathResult& listener) {
+  const std::string path = prefix + "state";
+  if (!wait_for(s, wait_us, [&] { return s.connected() && s.subscribed(path); })) {
+    fprintf(stderr, "no device subscribed to %s\n", path.c_str());
+    return false;
+  }
+  printf("device connected, waiting for the listener settling period\n");
+  wait_for(s, (SimDevice::kSettleMs + 500) * 1000ULL, [] { return false; });
+  for (int pass = 0; pass < 2; pass++) {
+    const bool use_put = pass == 0;
+    for (uint32_t i = 0; i < count; i++) {
+      const bool start = moves && i % 2 == 0;
+      // Μια εκκίνηση μέσα στο neutral delay (400ms από το stop) περιμένει
+      // χωρίς να αλλάξει ρελέ, οπότε δεν θα είχε latencyUs
+      if (start && (i > 0 || pass > 0)) wait_for(s, kNeutralGapUs, [] { return false; });
+      send_one(s, path, start ? "running_down" : "idle", use_put, use_put ? put : listener);
+    }
+    if (moves && count % 2) send_one(s, path, "idle", use_put, use_put ? put : listener);
+  }
+  report("put", put);
+  report("listener", listener);
+  return true;
+}
+
+// ---------- Soak ----------
+struct SoakOptions {
+  double      seconds = 3600;
+  double      rate_hz = 2;
+  int         mix = 2;  // 0 put, 1 delta, 2 εναλλάξ
+  bool        moves = false;
+  std::string prefix = SK_ANCHOR_PREFIX;
+  const char* script = nullptr;
+  double      disconnect_every_s = 0;
+  double      hold_s = 5;
+  std::string stats_host;  // κενό = η IP της συσκευής
+  uint16_t    stats_port = 80;
+  double      stats_every_s = 60;
+};
+
+// Μία γραμμή του script: "t_s put|delta leaf json" ή "t_s disconnect hold_s"
+struct ScriptLine {
+  double      t_s;
+  int         kind;  // 0 put, 1 delta, 2 disconnect
+  std::string leaf;
+  std::string value;
+  double      hold_s;
+};
+
+bool read_script(const char* path, std::vector<ScriptLine>& out) {
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  char line[512], kind[16], leaf[128];
+  while (fgets(line, sizeof(line), f)) {
+    ScriptLine l;
+    int used = 0;
+    if (line[0] == '#' || sscanf(line, "%lf %15s %n", &l.t_s, kind, &used) < 2) continue;
+    const char* rest = line + used;
+    if (!strcmp(kind, "disconnect")) {
+      l.kind = 2;
+      l.hold_s = atof(rest);
+    } else if ((!strcmp(kind, "put") || !strcmp(kind, "delta")) &&
+               sscanf(rest, "%127s %n", leaf, &used) == 1) {
+      l.kind = kind[0] == 'p' ? 0 : 1;
+      l.leaf = leaf;
+      l.value = rest + used;
+      while (!l.value.empty() && isspace((unsigned char)l.value.back())) l.value.pop_back();
+      if (l.value.empty()) continue;
+    } else {
+      continue;
+    }
+    out.push_back(l);
+  }
+  fclose(f);
+  std::stable_sort(out.begin(), out.end(),
+                   [](const ScriptLine& a, const ScriptLine& b) { return a.t_s < b.t_s; });
+  return true;
+}
+
+// Ένα δείγμα του /api/anchor/stats
+struct HeapSample {
+  uint64_t t_us;
+  uint32_t uptime_ms;
+  int64_t  free_bytes;
+  int64_t  min_free;
+  int64_t  largest;
+  uint32_t watchdog;
+};
+
+bool fetch_stats(const std::string& host, uint16_t port, HeapSample& h) {
+  Conn c(tcp_connect(host.c_str(), port));
+  if (!c.open()) return false;
+  c.send_raw("GET /api/anchor/stats HTTP/1.1\r\nHost: " + host + "\r\nConnection: close\r\n\r\n");
+  std::string head, body, v;
+  const bool ok = c.read_http(head, body, 2000000, true) && head.find(" 200 ") != std::string::npos;
+  c.close_();
+  const size_t heap = body.find("\"heap\"");
+  if (!ok || json_value(body, "uptimeMs", v) == std::string::npos || heap == std::string::npos) {
+    return false;
+  }
+  h.t_us = now_us();
+  h.uptime_ms = (uint32_t)strtoul(v.c_str(), nullptr, 10);
+  json_value(body, "free", v, heap);
+  h.free_bytes = strtoll(v.c_str(), nullptr, 10);
+  json_value(body, "minFree", v, heap);
+  h.min_free = strtoll(v.c_str(), nullptr, 10);
+  json_value(body, "largest", v, heap);
+  h.largest = strtoll(v.c_str(), nullptr, 10);
+  h.watchdog = json_value(body, "watchdogReconnects", v) != std::string::npos
+                   ? (uint32_t)strtoul(v.c_str(), nullptr, 10)
+                   : 0;
+  return true;
+}
+
+// Οι εντολές που έστειλε το soak και τα commandAck που ήρθαν
+class Soak {
+ public:
+  // Ack που έρχεται αργότερα από αυτό δεν αντιστοιχεί στην εντολή
+  static constexpr uint64_t kAckWindowUs = 2500000;
+  // Χωρίς ack και με αποσύνδεση μέσα σε τόσο: χάθηκε με τη σύνδεση
+  static constexpr uint64_t kLostWindowUs = 2500000;
+  static constexpr uint64_t kGraceUs = 3000000;
+
+  struct Report {
+    uint32_t sent[2];  // put, delta
+    uint32_t skipped;  // χωρίς σύνδεση, subscription ή μέσα στο settling
+    uint32_t coalesced;
+    uint32_t acked;
+    uint32_t dropped;
+    uint32_t lost;     // γύρω από αποσύνδεση
+    uint32_t duplicate_acks;
+    uint32_t reboots;
+    uint32_t watchdog;
+    std::vector<double> reconnect_ms;
+    std::vector<HeapSample> heap;
+  };
+
+  Soak(Standin& s, const SoakOptions& o) : s_(s), o_(o) {}
+  ~Soak() {
+    if (fetch_.joinable()) fetch_.join();
+  }
+
+  bool run() {
+    std::vector<ScriptLine> script;
+    if (o_.script && (!read_script(o_.script, script) || script.empty())) {
+      fprintf(stderr, "cannot read script %s\n", o_.script);
+      return false;
+    }
+    const double script_len = script.empty() ? 0.0 : script.back().t_s + 1.0;
+    const uint64_t start = now_us();
+    const uint64_t end = start + (uint64_t)(o_.seconds * 1e6);
+    const uint64_t cmd_every = (uint64_t)(1e6 / (o_.rate_hz > 0 ? o_.rate_hz : 1));
+    const uint64_t disc_every = (uint64_t)(o_.disconnect_every_s * 1e6);
+    const uint64_t stats_every = (uint64_t)(o_.stats_every_s * 1e6);
+    uint64_t next_cmd = start, next_disc = disc_every ? start + disc_every : 0;
+    uint64_t next_stats = stats_every ? start : 0;
+    uint32_t generated = 0;
+    size_t line = 0;
+    double loop_s = 0;
+
+    for (uint64_t now = now_us(); now < end; now = now_us()) {
+      s_.poll(2000);
+      match_();
+      collect_();
+      now = now_us();
+      if (script.empty() && now >= next_cmd) {
+        const int kind = o_.mix == 2 ? (int)(generated % 2) : o_.mix;
+        const uint32_t n = o_.mix == 2 ? generated / 2 : generated;
+        const bool start_cmd = o_.moves && n % 2 == 0;
+        send_(kind, "state", json_string(start_cmd ? "running_down" : "idle"));
+        generated++;
+        next_cmd += cmd_every;
+      } else if (!script.empty() && now >= start + (uint64_t)((loop_s + script[line].t_s) * 1e6)) {
+        const ScriptLine& l = script[line];
+        if (l.kind == 2) s_.drop((uint64_t)(l.hold_s * 1e6));
+        else send_(l.kind, l.leaf, l.value);
+        if (++line == script.size()) {
+          line = 0;
+          loop_s += script_len;
+        }
+      }
+      if (next_disc && now >= next_disc) {
+        s_.drop((uint64_t)(o_.hold_s * 1e6));
+        next_disc += disc_every;
+      }
+      if (next_stats && now >= next_stats) {
+        sample_();
+        progress_(now - start);
+        next_stats += stats_every;
+      }
+    }
+    const uint64_t grace_end = now_us() + kGraceUs;
+    while (now_us() < grace_end) {
+      s_.poll(5000);
+      match_();
+      collect_();
+    }
+    if (stats_every) {
+      if (!fetch_.joinable()) sample_();
+      wait_for(s_, 5000000, [&] { return collect_(); });
+    }
+    finish_();
+    return true;
+  }
+
+  const Report& report() const { return r_; }
+
+  bool passed() const { return r_.dropped == 0 && r_.duplicate_acks == 0 && r_.reboots == 0; }
+
+  void print() const {
+    const Standin::Stats& st = s_.stats();
+    printf("commands  put %u, delta %u, skipped %u, coalesced %u\n", (unsigned)r_.sent[0],
+           (unsigned)r_.sent[1], (unsigned)r_.skipped, (unsigned)r_.coalesced);
+    printf("acks      %u acked, %u dropped, %u lost around disconnects, %u duplicate ids, "
+           "%u/%u put responses\n",
+           (unsigned)r_.acked, (unsigned)r_.dropped, (unsigned)r_.lost,
+           (unsigned)r_.duplicate_acks, (unsigned)st.put_responses, (unsigned)st.puts_sent);
+    printf("frames    %u (%llu bytes), %u duplicates within %llums\n", (unsigned)st.frames_rx,
+           (unsigned long long)st.bytes_rx, (unsigned)st.duplicate_frames,
+           (unsigned long long)(Standin::kDuplicateUs / 1000));
+    printf("links     %u disconnects (%u injected), %u reconnects p50 %.0fms max %.0fms, "
+           "%u refused\n",
+           (unsigned)st.disconnects, (unsigned)st.dropped, (unsigned)r_.reconnect_ms.size(),
+           percentile(r_.reconnect_ms, 50), percentile(r_.reconnect_ms, 100),
+           (unsigned)st.refused);
+    if (r_.heap.empty()) {
+      printf("heap      no /api/anchor/stats samples\n");
+    } else {
+      const HeapSample& a = r_.heap.front();
+      const HeapSample& b = r_.heap.back();
+      int64_t lo = a.free_bytes, min_free = a.min_free, largest = a.largest;
+      for (const HeapSample& h : r_.heap) {
+        lo = std::min(lo, h.free_bytes);
+        min_free = std::min(min_free, h.min_free);
+        largest = std::min(largest, h.largest);
+      }
+      const double hours = (b.t_us - a.t_us) / 3.6e9;
+      printf("heap      free %lld -> %lld (lowest %lld, minFree %lld, largest block >= %lld)",
+             (long long)a.free_bytes, (long long)b.free_bytes, (long long)lo,
+             (long long)min_free, (long long)largest);
+      if (hours > 0) printf(", %+.0f B/h", (b.free_bytes - a.free_bytes) / hours);
+      printf(", %zu samples\n", r_.heap.size());
+    }
+    printf("device    %u reboots, %u watchdog reconnects\n", (unsigned)r_.reboots,
+           (unsigned)r_.watchdog);
+  }
+
+ private:
+  struct Sent {
+    uint64_t t_us;
+    int      kind;  // 0 put, 1 delta
+    bool     acked;
+    bool     coalesced;  // αντικαταστάθηκε πριν φύγει
+  };
+
+  void send_(int kind, const std::string& leaf, const std::string& value) {
+    const std::string path = o_.prefix + leaf;
+    const uint64_t now = now_us();
+    // Deltas στο settling της συσκευής αγνοούνται σκόπιμα: δεν μετράνε
+    const bool settling = now - s_.connected_at_us() < (SimDevice::kSettleMs + 500) * 1000ULL;
+    if (!s_.connected() || (kind == 1 && (settling || !s_.subscribed(path)))) {
+      r_.skipped++;
+      return;
+    }
+    r_.sent[kind]++;
+    if (kind == 0) {
+      s_.put(path, value);
+    } else if (s_.delta(path, value) == Standin::kDeltaReplaced) {
+      // Το προηγούμενο delta δεν έφυγε ποτέ: δεν περιμένουμε ack γι' αυτό
+      for (size_t i = sent_.size(); i-- > 0;) {
+        if (sent_[i].kind == 1 && !sent_[i].acked && !sent_[i].coalesced) {
+          sent_[i].coalesced = true;
+          break;
+        }
+      }
+      r_.coalesced++;
+    }
+    sent_.push_back(Sent{now, kind, false, false});
+  }
+
+  // Κάθε νέο ack στην παλαιότερη εντολή της ίδιας πηγής χωρίς ack, μέσα στο
+  // kAckWindowUs. Ένα id που ξαναέρχεται είναι διπλό, εκτός αν η συσκευή
+  // ξεκίνησε από την αρχή (id 1).
+  void match_() {
+    const std::vector<Standin::Ack>& acks = s_.acks();
+    for (; ack_pos_ < acks.size(); ack_pos_++) {
+      const Standin::Ack& a = acks[ack_pos_];
+      if (a.id <= 1) ids_.clear();
+      if (!ids_.insert(a.id).second) {
+        r_.duplicate_acks++;
+        continue;
+      }
+      const int kind = a.source == "put" ? 0 : 1;
+      for (size_t i = cursor_[kind]; i < sent_.size(); i++) {
+        Sent& c = sent_[i];
+        if (c.kind != kind || c.acked || c.coalesced || c.t_us + kAckWindowUs < a.t_us) continue;
+        if (c.t_us > a.t_us) break;
+        c.acked = true;
+        r_.acked++;
+        break;
+      }
+      while (cursor_[kind] < sent_.size() &&
+             (sent_[cursor_[kind]].kind != kind || sent_[cursor_[kind]].acked ||
+              sent_[cursor_[kind]].coalesced ||
+              sent_[cursor_[kind]].t_us + kAckWindowUs < a.t_us)) {
+        cursor_[kind]++;
+      }
+    }
+  }
+
+  // Το stats διαβάζεται σε δικό του thread: ο server συνεχίζει να
+  // εξυπηρετεί όσο η συσκευή απαντάει (ή ξανασυνδέεται).
+  void sample_() {
+    const std::string host = o_.stats_host.empty() ? s_.peer() : o_.stats_host;
+    if (host.empty() || fetch_.joinable()) return;
+    const uint16_t port = o_.stats_port;
+    fetch_ = std::thread([this, host, port] {
+      fetch_ok_ = fetch_stats(host, port, fetch_result_);
+      fetched_.store(true);
+    });
+  }
+
+  // true αν τελείωσε ένα διάβασμα του stats
+  bool collect_() {
+    if (!fetched_.load()) return false;
+    fetch_.join();
+    fetched_.store(false);
+    if (!fetch_ok_) return true;
+    const HeapSample& h = fetch_result_;
+    if (!r_.heap.empty()) {
+      const HeapSample& last = r_.heap.back();
+      if (h.uptime_ms < last.uptime_ms) {
+        r_.reboots++;
+        r_.watchdog += last.watchdog;
+      }
+    }
+    r_.heap.push_back(h);
+    return true;
+  }
+
+  void progress_(uint64_t elapsed_us) {
+    const Standin::Stats& st = s_.stats();
+    printf("[%6.0fs] commands %u acked %u | frames %u dup %u | disconnects %u", elapsed_us / 1e6,
+           (unsigned)(r_.sent[0] + r_.sent[1]), (unsigned)r_.acked, (unsigned)st.frames_rx,
+           (unsigned)st.duplicate_frames, (unsigned)st.disconnects);
+    if (!r_.heap.empty()) {
+      printf(" | heap free %lld minFree %lld", (long long)r_.heap.back().free_bytes,
+             (long long)r_.heap.back().min_free);
+    }
+    printf("\n");
+    fflush(stdout);
+  }
+
+  void finish_() {
+    const std::vector<uint64_t>& down = s_.disconnect_times();
+    const std::vector<uint64_t>& up = s_.connect_times();
+    for (uint64_t d : down) {
+      auto it = std::upper_bound(up.begin(), up.end(), d);
+      if (it != up.end()) r_.reconnect_ms.push_back((*it - d) / 1000.0);
+    }
+    for (const Sent& c : sent_) {
+      if (c.acked || c.coalesced) continue;
+      auto it = std::lower_bound(down.begin(), down.end(), c.t_us);
+      if (it != down.end() && *it - c.t_us < kLostWindowUs) r_.lost++;
+      else r_.dropped++;
+    }
+    if (!r_.heap.empty()) r_.watchdog += r_.heap.back().watchdog;
+  }
+
+  Standin&          s_;
+  const SoakOptions o_;
+  Report            r_ = {};
+  std::vector<Sent> sent_;
+  size_t            cursor_[2] = {0, 0};
+  size_t            ack_pos_ = 0;
+  std::set<uint32_t> ids_;
+  std::thread       fetch_;
+  std::atomic<bool> fetched_{false};
+  bool              fetch_ok_ = false;
+  HeapSample        fetch_result_ = {};
+};
+
+int selftest(uint32_t count) {
+  bool ok = true;
+  const bool rfc = ws_accept("dGhlIHNhbXBsZSBub25jZQ==") == "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=";
+  printf("websocket accept key (RFC 6455 example): %s\n", rfc ? "ok" : "FAIL");
+  ok &= rfc;
+
+  Standin s;
+  if (!s.listen(0)) {
+    fprintf(stderr, "cannot listen\n");
+    return 1;
+  }
+  SimDevice dev("127.0.0.1", s.port());
+  std::atomic<bool> stop(false);
+  std::thread th([&] { dev.run(stop); });
+
+  PathResult put, listener;
+  if (latency(s, SK_ANCHOR_PREFIX, count, true, 10000000, put, listener)) {
+    const bool all = put.acked == put.sent && listener.acked == listener.sent;
+    printf("every command acknowledged: %s\n", all ? "ok" : "FAIL");
+    const bool relays = put.relay_us.size() == put.sent && listener.relay_us.size() == listener.sent;
+    printf("relay latency reported for every move and stop: %s\n", relays ? "ok" : "FAIL");
+    // Το PUT δεν περιμένει το period (300ms) της subscription
+    const bool faster = percentile(put.ack_ms, 95) < percentile(listener.ack_ms, 50);
+    printf("put p95 below listener p50: %s\n", faster ? "ok" : "FAIL");
+    ok &= all && relays && faster;
+  } else {
+    ok = false;
+  }
+
+  // Σύντομο soak: PUT και deltas στα 20Hz, RST κάθε 5s με τον server κάτω
+  // για 0.5s. Η μνήμη αναφέρεται, δεν ελέγχεται (το heap είναι του host).
+  printf("soak: 15s at 20Hz, a dropped connection every 5s\n");
+  SoakOptions o;
+  o.seconds = 15;
+  o.rate_hz = 20;
+  o.disconnect_every_s = 5;
+  o.hold_s = 0.5;
+  o.stats_host = "127.0.0.1";
+  o.stats_port = dev.http_port();
+  o.stats_every_s = 1;
+  const uint32_t dropped_before = s.stats().dropped;
+  Soak soak(s, o);
+  if (soak.run()) {
+    soak.print();
+    const Soak::Report& r = soak.report();
+    const bool clean = soak.passed() && s.stats().duplicate_frames == 0;
+    printf("no dropped commands, duplicate acks or duplicate frames: %s\n", clean ? "ok" : "FAIL");
+    const uint32_t injected = s.stats().dropped - dropped_before;
+    const bool back = injected >= 2 && r.reconnect_ms.size() >= injected && s.connected();
+    printf("reconnected after every dropped connection: %s\n", back ? "ok" : "FAIL");
+    const bool sampled = r.heap.size() >= 10;
+    printf("device stats sampled: %s\n", sampled ? "ok" : "FAIL");
+    ok &= clean && back && sampled;
+  } else {
+    ok = false;
+  }
+  printf("server: %u http requests, %u access requests, %u ws connects, %u frames\n",
+         (unsigned)s.stats().http_requests, (unsigned)s.stats().access_requests,
+         (unsigned)s.stats().ws_connects, (unsigned)s.stats().frames_rx);
+
+  stop.store(true);
+  th.join();
+  return ok ? 0 : 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int port = -1;
+  uint32_t count = 0;
+  bool moves = false;
+  std::string prefix = SK_ANCHOR_PREFIX;
+  SoakOptions soak;
+  bool do_soak = false;
+  const char* record = nullptr;
+  for (int i = 1; i < argc; i++) {
+    const bool has_value = i + 1 < argc;
+    if (!strcmp(argv[i], "--port") && has_value) {
+      port = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--latency") && has_value) {
+      count = (uint32_t)atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--moves")) {
+      moves = true;
+    } else if (!strcmp(argv[i], "--prefix") && has_value) {
+      prefix = argv[++i];
+    } else if (!strcmp(argv[i], "--soak") && has_value) {
+      do_soak = true;
+      soak.seconds = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--rate") && has_value) {
+      soak.rate_hz = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--mix") && has_value) {
+      const char* m = argv[++i];
+      soak.mix = !strcmp(m, "put") ? 0 : !strcmp(m, "delta") ? 1 : 2;
+    } else if (!strcmp(argv[i], "--script") && has_value) {
+      soak.script = argv[++i];
+    } else if (!strcmp(argv[i], "--disconnect-every") && has_value) {
+      soak.disconnect_every_s = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--hold") && has_value) {
+      soak.hold_s = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--record") && has_value) {
+      record = argv[++i];
+    } else if (!strcmp(argv[i], "--stats-host") && has_value) {
+      soak.stats_host = argv[++i];
+    } else if (!strcmp(argv[i], "--stats-port") && has_value) {
+      soak.stats_port = (uint16_t)atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--stats-every") && has_value) {
+      soak.stats_every_s = atof(argv[++i]);
+    } else {
+      fprintf(stderr,
+              "usage: %s                                   (self-test)\n"
+              "       %s --port 3000 --latency N [--moves] [--prefix sensors.akat.anchor.]\n"
+              "       %s --port 3000 --soak SECONDS [--rate 2] [--mix both|put|delta] [--moves]\n"
+              "          [--script FILE] [--disconnect-every S --hold S] [--record FILE]\n"
+              "          [--stats-host IP] [--stats-port 80] [--stats-every 60]\n",
+              argv[0], argv[0], argv[0]);
+      return 2;
+    }
+  }
+
+  if (port < 0) return selftest(count ? count : 10);
+
+  Standin s;
+  if (!s.listen((uint16_t)port)) {
+    fprintf(stderr, "cannot listen on port %d\n", port);
+    return 1;
+  }
+  printf("Signal K stand-in on port %u\n", (unsigned)s.port());
+  if (do_soak) {
+    FILE* rec = nullptr;
+    if (record && !(rec = fopen(record, "w"))) {
+      fprintf(stderr, "cannot write %s\n", record);
+      return 1;
+    }
+    s.record_to(rec);
+    soak.moves = moves;
+    soak.prefix = prefix;
+    const std::string path = prefix + "state";
+    if (!wait_for(s, 300000000ULL, [&] { return s.connected() && s.subscribed(path); })) {
+      fprintf(stderr, "no device subscribed to %s\n", path.c_str());
+      return 1;
+    }
+    Soak run(s, soak);
+    const bool done = run.run();
+    if (rec) fclose(rec);
+    if (!done) return 1;
+    run.print();
+    return run.passed() && s.stats().duplicate_frames == 0 ? 0 : 1;
+  }
+  PathResult put, listener;
+  if (!latency(s, prefix, count ? count : 50, moves, 300000000ULL, put, listener)) return 1;
+  return put.acked == put.sent && listener.acked == listener.sent ? 0 : 1;
+}
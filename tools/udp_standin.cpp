@@ -0,0 +1,489 @@
+// Host tool: το UDP transport (include/udp_link.h) πάνω σε πραγματικά
+// sockets στο Linux. Μετράει latency και αντοχή σε απώλειες πακέτων.
+//
+//   g++ -std=gnu++11 -O2 -pthread -Iinclude tools/udp_standin.cpp -o udp_standin
+//   ./udp_standin                                  # self-test σε localhost
+//   ./udp_standin --device 7447 --key secret       # εικονική συσκευή
+//   ./udp_standin --client 192.168.1.50 7447 --key secret [--loss 0.2]
+//                 [--count 200] [--retry-ms 20]
+//
+// Η εικονική συσκευή τρέχει τον ίδιο UdpLink με το firmware, πάνω σε
+// WindlassCore + MotorDriver με το simulated board του anchor_hal.h.
+// Ο client στέλνει stop (ασφαλές και σε πραγματική συσκευή) με retry μέχρι
+// το ack και πετάει τυχαία --loss των πακέτων και προς τις δύο κατευθύνσεις.
+// Το self-test τρέχει και τα δύο σε threads για απώλειες 0-50% και ελέγχει
+// ότι κάθε εντολή εκτελέστηκε ακριβώς μία φορά, ότι ένα παλιό frame
+// (replay) και ένα frame με λάθος MAC απορρίπτονται.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "udp_link.h"
+
+namespace {
+
+uint64_t now_us() {
+  using namespace std::chrono;
+  return (uint64_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t host_random() {
+  static uint32_t s = (uint32_t)now_us() | 1;
+  s ^= s << 13;
+  s ^= s >> 17;
+  s ^= s << 5;
+  return s;
+}
+
+int udp_socket(uint16_t port) {
+  const int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  if (fd < 0) return -1;
+  sockaddr_in a = {};
+  a.sin_family = AF_INET;
+  a.sin_port = htons(port);
+  a.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(fd, (sockaddr*)&a, sizeof(a)) < 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+uint16_t local_port(int fd) {
+  sockaddr_in a;
+  socklen_t len = sizeof(a);
+  getsockname(fd, (sockaddr*)&a, &len);
+  return ntohs(a.sin_port);
+}
+
+// Περιμένει datagram το πολύ timeout_us. Επιστρέφει το μήκος ή -1.
+int recv_wait(int fd, uint8_t* buf, size_t cap, uint64_t timeout_us, sockaddr_in* from = nullptr) {
+  fd_set rd;
+  FD_ZERO(&rd);
+  FD_SET(fd, &rd);
+  timeval tv;
+  tv.tv_sec = (time_t)(timeout_us / 1000000);
+  tv.tv_usec = (suseconds_t)(timeout_us % 1000000);
+  if (select(fd + 1, &rd, nullptr, nullptr, &tv) <= 0) return -1;
+  sockaddr_in a;
+  socklen_t len = sizeof(a);
+  const int n = (int)recvfrom(fd, buf, cap, 0, (sockaddr*)&a, &len);
+  if (from) *from = a;
+  return n;
+}
+
+// ---------- Εικονική συσκευή ----------
+class SimDevice {
+ public:
+  struct Core : WindlassCore {};
+
+  bool begin(uint16_t port, const char* passphrase) {
+    fd_ = udp_socket(port);
+    if (fd_ < 0) return false;
+    link_.link_up.store(true);
+    core_.setupPins();
+    driver_.publish();
+    uint8_t key[16];
+    udp_wire::derive_key(passphrase, key);
+    MotorLink* links[1] = {&link_};
+    udp_.begin(key, passphrase[0] != '\0', links, 1, &SimDevice::send_, nullptr, &host_random,
+               this);
+    t0_us_ = now_us();
+    return true;
+  }
+
+  uint16_t port() const { return local_port(fd_); }
+  const UdpLink& udp() const { return udp_; }
+  // Σαν να έπεσε/ξαναήρθε η σύνδεση Signal K του loop task
+  void set_link_up(bool up) { link_.link_up.store(up); }
+
+  // Ένα πέρασμα: datagram (αν ήρθε), motor step κάθε 2ms, acks/status
+  void run_once() {
+    const uint32_t now_ms = clock_();
+    uint32_t wait_ms = udp_.ms_until_due(now_ms);
+    if (wait_ms > 2) wait_ms = 2;
+    uint8_t buf[256];
+    sockaddr_in from;
+    const int n = recv_wait(fd_, buf, sizeof(buf), wait_ms * 1000ULL, &from);
+    if (n > 0) {
+      udp_.on_datagram(from.sin_addr.s_addr, ntohs(from.sin_port), buf, (size_t)n, clock_());
+    }
+    link_.loop_alive_ms.store(clock_());
+    driver_.step(clock_());
+    udp_.poll(clock_(), true);
+  }
+
+  void run(const std::atomic<bool>& stop) {
+    while (!stop.load()) run_once();
+  }
+
+ private:
+  // Το simulated board ακολουθεί τον πραγματικό χρόνο
+  uint32_t clock_() {
+    hal::sim().now_us = now_us() - t0_us_;
+    return hal::millis();
+  }
+
+  static void send_(void* ctx, uint32_t addr, uint16_t port, const uint8_t* p, size_t n) {
+    auto* self = static_cast<SimDevice*>(ctx);
+    sockaddr_in to = {};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(port);
+    to.sin_addr.s_addr = addr;
+    sendto(self->fd_, p, n, 0, (sockaddr*)&to, sizeof(to));
+  }
+
+  int         fd_ = -1;
+  uint64_t    t0_us_ = 0;
+  Core        core_;
+  MotorLink   link_;
+  MotorDriver driver_{core_, link_};
+  UdpLink     udp_;
+};
+
+// ---------- Client ----------
+class Client {
+ public:
+  struct Result {
+    uint32_t sent;          // εντολές
+    uint32_t acked;
+    uint32_t attempts;      // datagrams εντολών (με τα retries)
+    uint32_t duplicate_acks;
+    std::vector<double> rtt_ms;
+    std::vector<uint32_t> device_us;
+  };
+
+  bool begin(const char* host, uint16_t port, const char* passphrase, double loss,
+             uint32_t retry_ms) {
+    fd_ = udp_socket(0);
+    if (fd_ < 0) return false;
+    dev_ = {};
+    dev_.sin_family = AF_INET;
+    dev_.sin_port = htons(port);
+    if (inet_pton(AF_INET, host, &dev_.sin_addr) != 1) return false;
+    udp_wire::derive_key(passphrase, key_);
+    session_ = host_random();
+    loss_ = loss;
+    retry_us_ = retry_ms * 1000ULL;
+    return true;
+  }
+
+  // HELLO μέχρι να έρθει status με nonce
+  bool hello(uint64_t timeout_us = 2000000) {
+    const uint64_t end = now_us() + timeout_us;
+    while (now_us() < end) {
+      uint8_t buf[64];
+      size_t n = UdpFrame::header(buf, UdpFrame::kHello, ++seq_, session_);
+      n = UdpFrame::seal(key_, buf, n);
+      send_(buf, n);
+      const uint64_t until = std::min(end, now_us() + retry_us_);
+      while (now_us() < until) {
+        if (receive_(until - now_us()) && have_nonce_) return true;
+      }
+    }
+    return false;
+  }
+
+  // Μία εντολή με retries μέχρι το ack. false αν δεν ήρθε ack.
+  bool command(uint8_t op, uint8_t arg, float value, Result& r, uint64_t timeout_us = 2000000) {
+    UdpFrame::Command c;
+    c.cmd_id = ++cmd_id_;
+    c.channel = 0;
+    c.op = op;
+    c.arg = arg;
+    c.value = value;
+    r.sent++;
+    const uint64_t t0 = now_us();
+    const uint64_t end = t0 + timeout_us;
+    while (now_us() < end) {
+      c.nonce = nonce_;
+      uint8_t buf[64];
+      size_t n = UdpFrame::header(buf, UdpFrame::kCommand, ++seq_, session_);
+      n += UdpFrame::putCommand(buf + n, c);
+      n = UdpFrame::seal(key_, buf, n);
+      memcpy(last_frame_, buf, n);
+      last_frame_len_ = n;
+      r.attempts++;
+      send_(buf, n);
+      const uint64_t until = std::min(end, now_us() + retry_us_);
+      while (now_us() < until) {
+        if (!receive_(until - now_us())) continue;
+        if (!got_ack_ || ack_.cmd_id != c.cmd_id) continue;
+        if (ack_.result == UdpFrame::kBadNonce) {  // η συσκευή ξεκίνησε ξανά: νέο nonce
+          have_nonce_ = false;
+          hello(end - now_us());
+          break;
+        }
+        r.acked++;
+        if (ack_.flags & UdpFrame::kAckDuplicate) r.duplicate_acks++;
+        r.rtt_ms.push_back((now_us() - t0) / 1000.0);
+        if (ack_.flags & UdpFrame::kAckActuated) r.device_us.push_back(ack_.latency_us);
+        last_result_ = ack_.result;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Το τελευταίο command frame όπως στάλθηκε (για το replay test)
+  void replay_last() { ::sendto(fd_, last_frame_, last_frame_len_, 0, (sockaddr*)&dev_, sizeof(dev_)); }
+  void send_corrupt() {
+    uint8_t buf[64];
+    memcpy(buf, last_frame_, last_frame_len_);
+    buf[UdpFrame::kHeaderLen] ^= 0x55;
+    ::sendto(fd_, buf, last_frame_len_, 0, (sockaddr*)&dev_, sizeof(dev_));
+  }
+
+  uint8_t last_result() const { return last_result_; }
+  const UdpFrame::ChannelStatus& status() const { return status_; }
+  size_t status_bytes() const { return status_bytes_; }
+
+ private:
+  bool drop_() { return loss_ > 0.0 && (host_random() % 10000) < loss_ * 10000.0; }
+
+  void send_(const uint8_t* p, size_t n) {
+    if (drop_()) return;
+    ::sendto(fd_, p, n, 0, (sockaddr*)&dev_, sizeof(dev_));
+  }
+
+  // Ένα datagram από τη συσκευή. true αν ήταν έγκυρο (και δεν "χάθηκε").
+  bool receive_(uint64_t timeout_us) {
+    uint8_t buf[256];
+    const int n = recv_wait(fd_, buf, sizeof(buf), timeout_us);
+    if (n <= 0 || drop_()) return false;
+    UdpFrame::Header h;
+    const int len = UdpFrame::open(key_, buf, (size_t)n, h);
+    if (len < 0) return false;
+    got_ack_ = false;
+    if (h.type == UdpFrame::kStatus && len >= (int)UdpFrame::kStatusLen) {
+      nonce_ = udp_wire::get_u32(buf + UdpFrame::kHeaderLen + 4);
+      have_nonce_ = true;
+      status_bytes_ = (size_t)n;
+      if (buf[UdpFrame::kHeaderLen + 8] >= 1 &&
+          len >= (int)(UdpFrame::kStatusLen + UdpFrame::kStatusChannelLen)) {
+        UdpFrame::getChannel(buf + UdpFrame::kHeaderLen + UdpFrame::kStatusLen, status_);
+      }
+    } else if (h.type == UdpFrame::kAck && len >= (int)UdpFrame::kAckLen) {
+      UdpFrame::getAck(buf + UdpFrame::kHeaderLen, ack_);
+      got_ack_ = true;
+    }
+    return true;
+  }
+
+  int         fd_ = -1;
+  sockaddr_in dev_;
+  uint8_t     key_[16];
+  uint32_t    session_ = 0;
+  uint32_t    seq_ = 0;
+  uint32_t    cmd_id_ = 0;
+  uint32_t    nonce_ = 0;
+  bool        have_nonce_ = false;
+  double      loss_ = 0.0;
+  uint64_t    retry_us_ = 20000;
+  bool        got_ack_ = false;
+  UdpFrame::Ack ack_ = {};
+  uint8_t     last_result_ = 0;
+  UdpFrame::ChannelStatus status_ = {};
+  size_t      status_bytes_ = 0;
+  uint8_t     last_frame_[64];
+  size_t      last_frame_len_ = 0;
+};
+
+double percentile(std::vector<double> v, double p) {
+  if (v.empty()) return 0.0;
+  std::sort(v.begin(), v.end());
+  size_t i = (size_t)(p / 100.0 * (double)(v.size() - 1) + 0.5);
+  return v[std::min(i, v.size() - 1)];
+}
+
+void report(double loss, const Client::Result& r) {
+  double attempts = r.sent ? (double)r.attempts / r.sent : 0.0;
+  std::vector<double> dev;
+  for (uint32_t us : r.device_us) dev.push_back(us);
+  printf("loss %3.0f%%  acked %4u/%-4u  rtt p50 %6.2fms p95 %6.2fms max %7.2fms  "
+         "tries %.2f  dup acks %u",
+         loss * 100.0, (unsigned)r.acked, (unsigned)r.sent, percentile(r.rtt_ms, 50),
+         percentile(r.rtt_ms, 95), percentile(r.rtt_ms, 100), attempts,
+         (unsigned)r.duplicate_acks);
+  if (!dev.empty()) printf("  relay p50 %.0fus", percentile(dev, 50));
+  printf("\n");
+}
+
+int selftest(uint32_t count, uint32_t retry_ms) {
+  SimDevice dev;
+  if (!dev.begin(0, "standin")) {
+    fprintf(stderr, "cannot bind device socket\n");
+    return 1;
+  }
+  std::atomic<bool> stop(false);
+  std::thread th([&] { dev.run(stop); });
+  bool ok = true;
+
+  const double losses[] = {0.0, 0.1, 0.3, 0.5};
+  uint32_t executed_before = 0;
+  for (double loss : losses) {
+    Client c;
+    c.begin("127.0.0.1", dev.port(), "standin", loss, retry_ms);
+    Client::Result r = {};
+    if (!c.hello()) {
+      printf("loss %3.0f%%  no status from device\n", loss * 100.0);
+      ok = false;
+      continue;
+    }
+    // Εναλλάξ κίνηση και stop: κάθε εκτέλεση αλλάζει τα ρελέ
+    for (uint32_t i = 0; i < count; i++) {
+      if (i % 2 == 0) c.command(UdpFrame::kOpFsm, WindlassFsm::kCmdRunDown, 0.0f, r);
+      else c.command(UdpFrame::kOpStop, 0, 0.0f, r);
+    }
+    c.command(UdpFrame::kOpStop, 0, 0.0f, r);
+    report(loss, r);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const uint32_t executed = dev.udp().stats().commands - executed_before;
+    executed_before = dev.udp().stats().commands;
+    if (executed != r.acked || r.acked != r.sent) {
+      printf("  executed %u for %u acked commands - FAIL\n", (unsigned)executed,
+             (unsigned)r.acked);
+      ok = false;
+    }
+  }
+
+  // Replay και λάθος MAC
+  {
+    Client c;
+    c.begin("127.0.0.1", dev.port(), "standin", 0.0, retry_ms);
+    Client::Result r = {};
+    c.hello();
+    c.command(UdpFrame::kOpStop, 0, 0.0f, r);
+    const UdpLink::Stats before = dev.udp().stats();
+    c.replay_last();
+    c.send_corrupt();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const UdpLink::Stats after = dev.udp().stats();
+    const bool pass = after.replayed == before.replayed + 1 && after.bad == before.bad + 1 &&
+                      after.commands == before.commands;
+    printf("replay/forged frames rejected: %s\n", pass ? "ok" : "FAIL");
+    ok &= pass;
+    printf("status frame: %zu bytes for 1 channel\n", c.status_bytes());
+  }
+
+  // Το ack λέει τι έκανε το motor task: ok, ignored (ήδη σε κίνηση), refused
+  // (χωρίς σύνδεση το motor task σταματάει κάθε κίνηση)
+  {
+    Client c;
+    c.begin("127.0.0.1", dev.port(), "standin", 0.0, retry_ms);
+    Client::Result r = {};
+    c.hello();
+    uint8_t got[4] = {0xff, 0xff, 0xff, 0xff};
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));  // πέρα από το command debounce
+    if (c.command(UdpFrame::kOpFsm, WindlassFsm::kCmdRunDown, 0.0f, r)) got[0] = c.last_result();
+    if (c.command(UdpFrame::kOpFsm, WindlassFsm::kCmdRunDown, 0.0f, r)) got[1] = c.last_result();
+    c.command(UdpFrame::kOpStop, 0, 0.0f, r);
+    dev.set_link_up(false);
+    if (c.command(UdpFrame::kOpFsm, WindlassFsm::kCmdRunDown, 0.0f, r)) got[2] = c.last_result();
+    dev.set_link_up(true);
+    if (c.command(UdpFrame::kOpStop, 0, 0.0f, r)) got[3] = c.last_result();
+    const bool pass = got[0] == UdpFrame::kOk && got[1] == UdpFrame::kIgnored &&
+                      got[2] == UdpFrame::kRefused && got[3] == UdpFrame::kOk &&
+                      dev.udp().stats().not_run >= 2;
+    printf("ack results: %s %s %s %s: %s\n", UdpFrame::resultName(got[0]),
+           UdpFrame::resultName(got[1]), UdpFrame::resultName(got[2]),
+           UdpFrame::resultName(got[3]), pass ? "ok" : "FAIL");
+    ok &= pass;
+  }
+
+  // Χωρίς κλειδί: status ναι, εντολές όχι
+  {
+    Client c;
+    c.begin("127.0.0.1", dev.port(), "wrong", 0.0, retry_ms);
+    const bool pass = !c.hello(200000);
+    printf("wrong passphrase ignored: %s\n", pass ? "ok" : "FAIL");
+    ok &= pass;
+  }
+
+  stop.store(true);
+  th.join();
+  return ok ? 0 : 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const char* key = "standin";
+  const char* host = nullptr;
+  int device_port = -1, client_port = 0;
+  double loss = 0.0;
+  uint32_t count = 200, retry_ms = 20;
+  for (int i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "--device") && i + 1 < argc) {
+      device_port = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--client") && i + 2 < argc) {
+      host = argv[++i];
+      client_port = atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--key") && i + 1 < argc) {
+      key = argv[++i];
+    } else if (!strcmp(argv[i], "--loss") && i + 1 < argc) {
+      loss = atof(argv[++i]);
+    } else if (!strcmp(argv[i], "--count") && i + 1 < argc) {
+      count = (uint32_t)atoi(argv[++i]);
+    } else if (!strcmp(argv[i], "--retry-ms") && i + 1 < argc) {
+      retry_ms = (uint32_t)atoi(argv[++i]);
+    } else {
+      fprintf(stderr,
+              "usage: %s                                   (self-test)\n"
+              "       %s --device PORT [--key K]\n"
+              "       %s --client HOST PORT [--key K] [--loss 0..1] [--count N] [--retry-ms MS]\n",
+              argv[0], argv[0], argv[0]);
+      return 2;
+    }
+  }
+
+  if (device_port >= 0) {
+    SimDevice dev;
+    if (!dev.begin((uint16_t)device_port, key)) {
+      fprintf(stderr, "cannot bind port %d\n", device_port);
+      return 1;
+    }
+    printf("simulated windlass on udp port %u\n", (unsigned)dev.port());
+    std::atomic<bool> stop(false);
+    dev.run(stop);
+    return 0;
+  }
+
+  if (host) {
+    Client c;
+    if (!c.begin(host, (uint16_t)client_port, key, loss, retry_ms)) {
+      fprintf(stderr, "bad address %s\n", host);
+      return 1;
+    }
+    if (!c.hello()) {
+      fprintf(stderr, "no status from %s:%d (port, passphrase?)\n", host, client_port);
+      return 1;
+    }
+    printf("device: chain %.1fm, state %u, status frame %zu bytes\n", c.status().chain_out,
+           (unsigned)c.status().state, c.status_bytes());
+    Client::Result r = {};
+    for (uint32_t i = 0; i < count; i++) {
+      if (!c.command(UdpFrame::kOpStop, 0, 0.0f, r)) continue;
+      if (c.last_result() != UdpFrame::kOk) {
+        fprintf(stderr, "device answered %s\n", UdpFrame::resultName(c.last_result()));
+        return 1;
+      }
+    }
+    report(loss, r);
+    return r.acked == r.sent ? 0 : 1;
+  }
+
+  return selftest(count, retry_ms);
+}